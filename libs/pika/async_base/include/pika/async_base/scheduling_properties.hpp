@@ -40,6 +40,53 @@ namespace pika::execution::experimental {
     {
     } get_hint{};
 
+    // with_deadline sets the time by which work should run. Deadline aware
+    // schedulers run the work with the earliest deadline first, other
+    // schedulers ignore it.
+    inline constexpr struct with_deadline_t final
+      : pika::functional::tag<with_deadline_t>
+    {
+    } with_deadline{};
+
+    inline constexpr struct get_deadline_t final
+      : pika::functional::tag<get_deadline_t>
+    {
+    } get_deadline{};
+
+    // with_inline_if_same_pool allows schedulers to run work inline on the
+    // calling thread instead of spawning new work, if the calling thread
+    // already runs on the right thread pool. Schedulers which always spawn
+    // work ignore it.
+    inline constexpr struct with_inline_if_same_pool_t final
+      : pika::functional::tag<with_inline_if_same_pool_t>
+    {
+    } with_inline_if_same_pool{};
+
+    inline constexpr struct get_inline_if_same_pool_t final
+      : pika::functional::tag<get_inline_if_same_pool_t>
+    {
+    } get_inline_if_same_pool{};
+
+    // with_data_locality takes a pointer and a length in bytes, and hints that
+    // work should run close to the NUMA domain holding the pages of that
+    // range. The placement of the pages is looked up when the property is
+    // applied, which takes a few system calls. Apply it once per data range
+    // and reuse the resulting scheduler instead of applying it for every
+    // task. Schedulers which can't place work ignore it.
+    inline constexpr struct with_data_locality_t final
+      : pika::functional::tag<with_data_locality_t>
+    {
+    } with_data_locality{};
+
+    // with_stop_token attaches a stop token to work. Work which hasn't
+    // started when stop is requested is dropped, or completed with
+    // set_stopped by senders, without running it. Schedulers which can't
+    // cancel work ignore it.
+    inline constexpr struct with_stop_token_t final
+      : pika::functional::tag<with_stop_token_t>
+    {
+    } with_stop_token{};
+
     // with_annotation uses tag_fallback as the base class to allow an
     // out-of-line fallback implementation for executors that don't support
     // annotations by themselves. See annotating_executor.
@@ -589,6 +589,118 @@ namespace pika::detail {
                 std::to_string(num_high_priority_queues));
         }
 
+        if (vm.count("pika:warm-restart"))
+        {
+            ini_config.emplace_back("pika.warm_restart!=1");
+        }
+
+        if (vm.count("pika:metrics-export"))
+        {
+            ini_config.emplace_back("pika.metrics.export!=1");
+
+            std::string shm_name = vm["pika:metrics-export"].as<std::string>();
+            if (!shm_name.empty())
+            {
+                ini_config.emplace_back("pika.metrics.shm_name!=" + shm_name);
+            }
+        }
+
+        if (vm.count("pika:metrics-interval"))
+        {
+            ini_config.emplace_back("pika.metrics.interval!=" +
+                std::to_string(vm["pika:metrics-interval"].as<std::size_t>()));
+        }
+
+        if (vm.count("pika:elasticity"))
+        {
+            ini_config.emplace_back("pika.elasticity.enabled!=1");
+
+            std::string pools = vm["pika:elasticity"].as<std::string>();
+            if (!pools.empty())
+            {
+                ini_config.emplace_back("pika.elasticity.pools!=" + pools);
+            }
+        }
+
+        if (vm.count("pika:elasticity-min-threads"))
+        {
+            ini_config.emplace_back("pika.elasticity.min_threads!=" +
+                std::to_string(
+                    vm["pika:elasticity-min-threads"].as<std::size_t>()));
+        }
+
+        if (vm.count("pika:elasticity-max-threads"))
+        {
+            ini_config.emplace_back("pika.elasticity.max_threads!=" +
+                std::to_string(
+                    vm["pika:elasticity-max-threads"].as<std::size_t>()));
+        }
+
+        if (vm.count("pika:elasticity-interval"))
+        {
+            ini_config.emplace_back("pika.elasticity.interval!=" +
+                std::to_string(
+                    vm["pika:elasticity-interval"].as<std::size_t>()));
+        }
+
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+        if (vm.count("pika:timeline"))
+        {
+            ini_config.emplace_back("pika.timeline.enabled!=1");
+
+            std::string file = vm["pika:timeline"].as<std::string>();
+            if (!file.empty())
+            {
+                ini_config.emplace_back("pika.timeline.file!=" + file);
+            }
+        }
+
+        if (vm.count("pika:timeline-format"))
+        {
+            ini_config.emplace_back("pika.timeline.format!=" +
+                vm["pika:timeline-format"].as<std::string>());
+        }
+
+        if (vm.count("pika:timeline-signal"))
+        {
+            ini_config.emplace_back("pika.timeline.signal!=" +
+                std::to_string(vm["pika:timeline-signal"].as<int>()));
+        }
+#else
+        if (vm.count("pika:timeline") || vm.count("pika:timeline-format") ||
+            vm.count("pika:timeline-signal"))
+        {
+            throw pika::detail::command_line_error(
+                "Command line option error: can't enable the task timeline "
+                "while it was disabled at configuration time. Please "
+                "re-configure pika using the option "
+                "-DPIKA_WITH_TASK_TIMELINE=On.");
+        }
+#endif
+
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        if (vm.count("pika:latency-histograms"))
+        {
+            ini_config.emplace_back("pika.latency_histograms.enabled!=1");
+
+            std::string file = vm["pika:latency-histograms"].as<std::string>();
+            if (!file.empty())
+            {
+                ini_config.emplace_back(
+                    "pika.latency_histograms.file!=" + file);
+            }
+        }
+#else
+        if (vm.count("pika:latency-histograms"))
+        {
+            throw pika::detail::command_line_error(
+                "Command line option error: can't enable the task latency "
+                "histograms while they were disabled at configuration time. "
+                "Please re-configure pika using the option "
+                "-DPIKA_WITH_TASK_LATENCY_HISTOGRAMS=On.");
+        }
+#endif
+
         enable_logging_settings(vm, ini_config);
 
         if (debug_clp)
@@ -415,8 +415,9 @@ namespace pika::detail {
                 ("pika:queuing", value<std::string>(),
                   "the queue scheduling policy to use, options are "
                   "'local', 'local-priority-fifo','local-priority-lifo', "
-                  "'abp-priority-fifo', 'abp-priority-lifo', 'static', and "
-                  "'static-priority' (default: 'local-priority'; "
+                  "'abp-priority-fifo', 'abp-priority-lifo', 'static', "
+                  "'static-priority', 'shared-priority', and 'deadline' "
+                  "(default: 'local-priority'; "
                   "all option values can be abbreviated)")
                 ("pika:high-priority-threads", value<std::size_t>(),
                   "the number of operating system threads maintaining a high "
@@ -428,6 +429,48 @@ namespace pika::detail {
                   "allowed values: 0 - no NUMA sensitivity, 1 - allow only for "
                   "boundary cores to steal across NUMA domains, 2 - "
                   "no cross boundary stealing is allowed (default value: 0)")
+                ("pika:warm-restart",
+                  "keep the runtime parked with its worker threads, stacks, "
+                  "and schedulers after pika::stop, a following pika::start "
+                  "or pika::init with the same arguments resumes it instead "
+                  "of creating a new runtime")
+                ("pika:metrics-export", value<std::string>()->implicit_value(""),
+                  "periodically publish a snapshot of all thread pool and "
+                  "worker statistics into the POSIX shared memory segment "
+                  "with the given name (default: /pika-metrics.<pid>)")
+                ("pika:metrics-interval", value<std::size_t>(),
+                  "the interval in milliseconds between two snapshots "
+                  "published by --pika:metrics-export (default: 100)")
+                ("pika:elasticity", value<std::string>()->implicit_value(""),
+                  "suspend workers of the given comma separated list of "
+                  "thread pools (default: all pools) after they have been "
+                  "idle for a while and resume them when tasks queue up")
+                ("pika:elasticity-min-threads", value<std::size_t>(),
+                  "the minimum number of running workers per pool managed "
+                  "by --pika:elasticity (default: 1)")
+                ("pika:elasticity-max-threads", value<std::size_t>(),
+                  "the maximum number of running workers per pool managed "
+                  "by --pika:elasticity (default: all workers)")
+                ("pika:elasticity-interval", value<std::size_t>(),
+                  "the interval in milliseconds between two decisions of "
+                  "--pika:elasticity (default: 10)")
+                ("pika:timeline", value<std::string>()->implicit_value(""),
+                  "record the execution of all tasks on the worker threads "
+                  "and write the timeline to the given file at shutdown "
+                  "(default: pika-timeline.<pid>.json or "
+                  "pika-timeline.<pid>.perfetto-trace)")
+                ("pika:timeline-format", value<std::string>(),
+                  "the format of the file written by --pika:timeline, "
+                  "either 'chrome' (trace event JSON, default) or "
+                  "'perfetto' (Perfetto protobuf)")
+                ("pika:timeline-signal", value<int>(),
+                  "additionally write the timeline recorded so far when "
+                  "the process receives the given signal")
+                ("pika:latency-histograms",
+                  value<std::string>()->implicit_value(""),
+                  "record histograms of the queue wait and execution times "
+                  "of tasks per annotation and write their percentiles to "
+                  "the given file at shutdown (default: standard output)")
             ;
 
             options_description config_options("pika configuration options");
@@ -0,0 +1,107 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/concurrency/cache_line_data.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pika::concurrency::detail {
+    /// \brief A counter split into shards which are updated independently.
+    ///
+    /// Each shard lives on its own cache line. Threads update the shard they
+    /// own, typically the shard with the index of the worker thread, so that
+    /// concurrent updates do not contend on a single cache line. The value of
+    /// the counter is the sum of all shards and is only computed when the
+    /// counter is read. The sum is not a snapshot: shards updated while the
+    /// counter is read may or may not be taken into account.
+    ///
+    /// Updates using a shard index which is out of range go to the last shard.
+    /// Threads without a shard of their own, e.g. threads which are not worker
+    /// threads, can use std::size_t(-1).
+    class sharded_counter
+    {
+    public:
+        explicit sharded_counter(std::size_t num_shards = 1)
+          : shards_(num_shards)
+        {
+            PIKA_ASSERT(num_shards != 0);
+        }
+
+        sharded_counter(sharded_counter&&) = default;
+        sharded_counter& operator=(sharded_counter&&) = default;
+
+        std::size_t num_shards() const noexcept
+        {
+            return shards_.size();
+        }
+
+        void add(std::size_t shard, std::int64_t n,
+            std::memory_order order = std::memory_order_relaxed) noexcept
+        {
+            get_shard(shard).fetch_add(n, order);
+        }
+
+        void increment(std::size_t shard) noexcept
+        {
+            add(shard, 1);
+        }
+
+        void decrement(std::size_t shard) noexcept
+        {
+            add(shard, -1);
+        }
+
+        /// Returns the sum of all shards.
+        std::int64_t load(
+            std::memory_order order = std::memory_order_seq_cst) const noexcept
+        {
+            std::int64_t sum = 0;
+            for (auto const& shard : shards_)
+            {
+                sum += shard.data_.load(order);
+            }
+            return sum;
+        }
+
+        /// Returns the value of a single shard.
+        std::int64_t load(std::size_t shard,
+            std::memory_order order = std::memory_order_seq_cst) const noexcept
+        {
+            return get_shard(shard).load(order);
+        }
+
+        /// Sets all shards to zero. Concurrent updates may be lost.
+        void reset() noexcept
+        {
+            for (auto& shard : shards_)
+            {
+                shard.data_.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        std::atomic<std::int64_t>& get_shard(std::size_t shard) noexcept
+        {
+            return shards_[(std::min)(shard, shards_.size() - 1)].data_;
+        }
+
+        std::atomic<std::int64_t> const& get_shard(
+            std::size_t shard) const noexcept
+        {
+            return shards_[(std::min)(shard, shards_.size() - 1)].data_;
+        }
+
+        std::vector<cache_line_data<std::atomic<std::int64_t>>> shards_;
+    };
+}    // namespace pika::concurrency::detail
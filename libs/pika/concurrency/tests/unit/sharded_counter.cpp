@@ -0,0 +1,87 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/concurrency/detail/sharded_counter.hpp>
+#include <pika/testing.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using pika::concurrency::detail::sharded_counter;
+
+void test_basic()
+{
+    sharded_counter c(4);
+    PIKA_TEST_EQ(c.num_shards(), std::size_t(4));
+    PIKA_TEST_EQ(c.load(), std::int64_t(0));
+
+    c.increment(0);
+    c.increment(1);
+    c.increment(1);
+    c.decrement(3);
+    c.add(2, 10);
+    PIKA_TEST_EQ(c.load(), std::int64_t(12));
+    PIKA_TEST_EQ(c.load(std::size_t(1)), std::int64_t(2));
+    PIKA_TEST_EQ(c.load(std::size_t(3)), std::int64_t(-1));
+
+    // shard indices out of range go to the last shard
+    c.increment(std::size_t(-1));
+    c.increment(4);
+    PIKA_TEST_EQ(c.load(std::size_t(3)), std::int64_t(1));
+    PIKA_TEST_EQ(c.load(), std::int64_t(14));
+
+    // shards may go negative as long as the sum is meaningful
+    c.decrement(0);
+    c.decrement(0);
+    PIKA_TEST_EQ(c.load(std::size_t(0)), std::int64_t(-1));
+    PIKA_TEST_EQ(c.load(), std::int64_t(12));
+
+    c.reset();
+    PIKA_TEST_EQ(c.load(), std::int64_t(0));
+
+    sharded_counter moved(std::move(c));
+    moved.increment(2);
+    PIKA_TEST_EQ(moved.load(), std::int64_t(1));
+}
+
+void test_concurrent()
+{
+    constexpr std::size_t num_threads = 4;
+    constexpr std::int64_t num_increments = 100000;
+
+    // one shard per thread and one for threads without a shard
+    sharded_counter c(num_threads + 1);
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t != num_threads + 2; ++t)
+    {
+        threads.emplace_back([&c, t] {
+            for (std::int64_t i = 0; i != num_increments; ++i)
+            {
+                c.increment(t < num_threads ? t : std::size_t(-1));
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    PIKA_TEST_EQ(c.load(),
+        static_cast<std::int64_t>(num_threads + 2) * num_increments);
+    PIKA_TEST_EQ(c.load(num_threads), 2 * num_increments);
+}
+
+int main()
+{
+    test_basic();
+    test_concurrent();
+
+    return pika::util::report_errors();
+}
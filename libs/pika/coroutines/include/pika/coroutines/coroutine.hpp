@@ -58,8 +58,8 @@ namespace pika::threads::coroutines::detail {
         using result_type = impl_type::result_type;
         using arg_type = impl_type::arg_type;
 
-        using functor_type =
-            util::detail::unique_function<result_type(arg_type)>;
+        using functor_type = util::detail::unique_function<
+            result_type(arg_type), thread_function_storage_size>;
 
         coroutine(functor_type&& f, thread_id_type id,
             std::ptrdiff_t stack_size = default_stack_size)
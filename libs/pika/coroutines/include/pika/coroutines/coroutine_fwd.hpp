@@ -32,9 +32,18 @@
 
 #include <pika/config.hpp>
 
+#include <cstddef>
+
 namespace pika::threads::coroutines::detail {
     class coroutine_self;
     class coroutine_impl;
     class coroutine;
     class stackless_coroutine;
+
+    // The size of the inline storage of the functions run by coroutines.
+    // These usually wrap a callable with a few captures, e.g. a receiver and
+    // some indices, and are created for every task, so they get more inline
+    // storage than other type-erased functions.
+    inline constexpr std::size_t thread_function_storage_size =
+        PIKA_HAVE_THREAD_FUNCTION_STORAGE_SIZE * sizeof(void*);
 }    // namespace pika::threads::coroutines::detail
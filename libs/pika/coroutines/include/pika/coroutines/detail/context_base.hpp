@@ -44,6 +44,7 @@
 #include <pika/coroutines/detail/context_impl.hpp>
 
 #include <pika/assert.hpp>
+#include <pika/coroutines/detail/fiber_local_storage.hpp>
 #include <pika/coroutines/detail/swap_context.hpp>    //for swap hints
 #include <pika/coroutines/detail/tss.hpp>
 #include <pika/coroutines/thread_id_type.hpp>
@@ -94,6 +95,7 @@ namespace pika::threads::coroutines::detail {
 
         void reset_tss()
         {
+            m_fiber_locals.reset();
 #if defined(PIKA_HAVE_THREAD_LOCAL_STORAGE)
             delete_tss_storage(m_thread_data);
 #else
@@ -247,6 +249,11 @@ namespace pika::threads::coroutines::detail {
 #endif
         }
 
+        fiber_local_storage& get_fiber_local_storage() noexcept
+        {
+            return m_fiber_locals;
+        }
+
 #if defined(PIKA_HAVE_THREAD_LOCAL_STORAGE)
         tss_storage* get_thread_tss_data(bool create_if_needed) const
         {
@@ -364,6 +371,7 @@ namespace pika::threads::coroutines::detail {
 #else
         mutable std::size_t m_thread_data;
 #endif
+        fiber_local_storage m_fiber_locals;
 
         // This is used to generate a meaningful exception trace.
         std::exception_ptr m_type_info;
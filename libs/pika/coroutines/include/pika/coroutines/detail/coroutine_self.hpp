@@ -33,6 +33,7 @@
 #include <pika/assert.hpp>
 #include <pika/coroutines/detail/coroutine_accessor.hpp>
 #include <pika/coroutines/detail/coroutine_impl.hpp>
+#include <pika/coroutines/detail/fiber_local_storage.hpp>
 #include <pika/coroutines/thread_enums.hpp>
 #include <pika/coroutines/thread_id_type.hpp>
 #include <pika/functional/function.hpp>
@@ -132,6 +133,8 @@ namespace pika::threads::coroutines::detail {
         virtual tss_storage* get_thread_tss_data() = 0;
         virtual tss_storage* get_or_create_thread_tss_data() = 0;
 
+        virtual fiber_local_storage& get_fiber_local_storage() = 0;
+
         virtual std::size_t& get_continuation_recursion_count() = 0;
 
         // access coroutines context object
@@ -89,6 +89,12 @@ namespace pika::threads::coroutines::detail {
 #endif
         }
 
+        fiber_local_storage& get_fiber_local_storage() override
+        {
+            PIKA_ASSERT(pimpl_);
+            return pimpl_->get_fiber_local_storage();
+        }
+
         std::size_t& get_continuation_recursion_count() override
         {
             PIKA_ASSERT(pimpl_);
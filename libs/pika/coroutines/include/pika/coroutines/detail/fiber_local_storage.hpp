@@ -0,0 +1,98 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace pika::threads::coroutines::detail {
+    using fiber_local_cleanup_function = void (*)(void*);
+
+    /// Returns a new key for fiber-local storage. Keys are dense indices
+    /// starting at zero and are never reused, they are meant to be allocated
+    /// once per long-lived fiber-local variable.
+    PIKA_EXPORT std::size_t allocate_fiber_local_key() noexcept;
+
+    /// Per-coroutine storage for fiber-local variables, indexed by keys
+    /// returned by allocate_fiber_local_key. The first slots are stored
+    /// inline, slots for larger keys are stored in an overflow array which is
+    /// allocated on first use and kept when the coroutine is reused. Each
+    /// slot stores the function to clean up its value together with the
+    /// value.
+    class fiber_local_storage
+    {
+    public:
+        static constexpr std::size_t num_inline_slots = 8;
+
+        fiber_local_storage() = default;
+
+        ~fiber_local_storage()
+        {
+            reset();
+        }
+
+        fiber_local_storage(fiber_local_storage const&) = delete;
+        fiber_local_storage(fiber_local_storage&&) = delete;
+        fiber_local_storage& operator=(fiber_local_storage const&) = delete;
+        fiber_local_storage& operator=(fiber_local_storage&&) = delete;
+
+        void* get(std::size_t key) const noexcept
+        {
+            if (key < num_inline_slots)
+            {
+                return inline_slots_[key].value;
+            }
+
+            key -= num_inline_slots;
+            return key < overflow_slots_.size() ? overflow_slots_[key].value :
+                                                  nullptr;
+        }
+
+        // Store a new value for the given key and return the previous one.
+        // The previous value is not cleaned up.
+        void* set(std::size_t key, void* value,
+            fiber_local_cleanup_function cleanup = nullptr)
+        {
+            slot& s = key < num_inline_slots ? inline_slots_[key] :
+                                               get_overflow_slot(key);
+            if (key >= num_used_)
+            {
+                num_used_ = key + 1;
+            }
+
+            s.cleanup = cleanup;
+            return std::exchange(s.value, value);
+        }
+
+        // Clean up all values. Values set by the cleanup functions are
+        // cleaned up as well.
+        void reset()
+        {
+            while (num_used_ != 0)
+            {
+                reset_slots(std::exchange(num_used_, 0));
+            }
+        }
+
+    private:
+        struct slot
+        {
+            void* value = nullptr;
+            fiber_local_cleanup_function cleanup = nullptr;
+        };
+
+        PIKA_EXPORT slot& get_overflow_slot(std::size_t key);
+        PIKA_EXPORT void reset_slots(std::size_t num_slots);
+
+        std::size_t num_used_ = 0;
+        slot inline_slots_[num_inline_slots];
+        std::vector<slot> overflow_slots_;
+    };
+}    // namespace pika::threads::coroutines::detail
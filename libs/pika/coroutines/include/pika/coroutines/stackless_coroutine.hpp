@@ -10,7 +10,9 @@
 #include <pika/config.hpp>
 #include <pika/assert.hpp>
 #include <pika/coroutines/coroutine.hpp>
+#include <pika/coroutines/coroutine_fwd.hpp>
 #include <pika/coroutines/detail/coroutine_self.hpp>
+#include <pika/coroutines/detail/fiber_local_storage.hpp>
 #include <pika/coroutines/detail/tss.hpp>
 #include <pika/coroutines/thread_enums.hpp>
 #include <pika/coroutines/thread_id_type.hpp>
@@ -53,8 +55,8 @@ namespace pika::threads::coroutines::detail {
             std::pair<threads::detail::thread_schedule_state, thread_id_type>;
         using arg_type = threads::detail::thread_restart_state;
 
-        using functor_type =
-            util::detail::unique_function<result_type(arg_type)>;
+        using functor_type = util::detail::unique_function<
+            result_type(arg_type), thread_function_storage_size>;
 
         stackless_coroutine(functor_type&& f, thread_id_type id,
             std::ptrdiff_t /*stack_size*/ = default_stack_size)
@@ -120,6 +122,11 @@ namespace pika::threads::coroutines::detail {
 #endif
         }
 
+        fiber_local_storage& get_fiber_local_storage() noexcept
+        {
+            return fiber_locals_;
+        }
+
 #if defined(PIKA_HAVE_THREAD_LOCAL_STORAGE)
         tss_storage* get_thread_tss_data(bool create_if_needed) const
         {
@@ -149,6 +156,7 @@ namespace pika::threads::coroutines::detail {
 
         void reset_tss()
         {
+            fiber_locals_.reset();
 #if defined(PIKA_HAVE_THREAD_LOCAL_STORAGE)
             delete_tss_storage(thread_data_);
 #else
@@ -221,6 +229,7 @@ namespace pika::threads::coroutines::detail {
 #else
         mutable std::size_t thread_data_;
 #endif
+        fiber_local_storage fiber_locals_;
         std::size_t continuation_recursion_count_;
     };
 }    // namespace pika::threads::coroutines::detail
@@ -0,0 +1,52 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+#include <pika/coroutines/detail/fiber_local_storage.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace pika::threads::coroutines::detail {
+    std::size_t allocate_fiber_local_key() noexcept
+    {
+        static std::atomic<std::size_t> next_key(0);
+        return next_key.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    fiber_local_storage::slot& fiber_local_storage::get_overflow_slot(
+        std::size_t key)
+    {
+        key -= num_inline_slots;
+        if (key >= overflow_slots_.size())
+        {
+            overflow_slots_.resize(key + 1);
+        }
+        return overflow_slots_[key];
+    }
+
+    void fiber_local_storage::reset_slots(std::size_t num_slots)
+    {
+        for (std::size_t i = 0; i != num_slots; ++i)
+        {
+            slot& s = i < num_inline_slots ?
+                inline_slots_[i] :
+                overflow_slots_[i - num_inline_slots];
+            if (s.value == nullptr)
+            {
+                continue;
+            }
+
+            // the cleanup function may set the same slot again
+            void* value = std::exchange(s.value, nullptr);
+            if (auto cleanup = std::exchange(s.cleanup, nullptr))
+            {
+                cleanup(value);
+            }
+        }
+    }
+}    // namespace pika::threads::coroutines::detail
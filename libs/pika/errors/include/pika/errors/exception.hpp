@@ -112,6 +112,13 @@ namespace pika {
         PIKA_EXPORT void set_custom_exception_info_handler(
             custom_exception_info_handler_type f);
 
+        // Enable or disable calling the custom exception info handler for
+        // exceptions with the given error. Exceptions for which it is disabled
+        // only carry the function, file, and line they were thrown from.
+        PIKA_EXPORT void set_exception_info_enabled(
+            pika::error e, bool enabled) noexcept;
+        PIKA_EXPORT bool get_exception_info_enabled(pika::error e) noexcept;
+
         using pre_exception_handler_type = std::function<void()>;
 
         PIKA_EXPORT void set_pre_exception_handler(
@@ -148,6 +148,32 @@ namespace pika {
             custom_exception_info_handler = f;
         }
 
+        // Zero-initialized, i.e. exception info is enabled for all errors
+        // before any dynamic initialization has happened.
+        static std::atomic<bool> exception_info_disabled[static_cast<int>(
+            pika::error::last_error)];
+
+        void set_exception_info_enabled(pika::error e, bool enabled) noexcept
+        {
+            int const e_int = static_cast<int>(e);
+            if (e_int >= 0 && e_int < static_cast<int>(pika::error::last_error))
+            {
+                exception_info_disabled[e_int].store(
+                    !enabled, std::memory_order_relaxed);
+            }
+        }
+
+        bool get_exception_info_enabled(pika::error e) noexcept
+        {
+            int const e_int = static_cast<int>(e);
+            if (e_int >= 0 && e_int < static_cast<int>(pika::error::last_error))
+            {
+                return !exception_info_disabled[e_int].load(
+                    std::memory_order_relaxed);
+            }
+            return true;
+        }
+
         static pre_exception_handler_type pre_exception_handler;
 
         void set_pre_exception_handler(pre_exception_handler_type f)
@@ -242,7 +268,9 @@ namespace pika::detail {
 
     inline bool is_of_lightweight_pika_category(pika::exception const& e)
     {
-        return e.get_error_code().category() == get_lightweight_pika_category();
+        return e.get_error_code().category() ==
+            get_lightweight_pika_category() ||
+            !get_exception_info_enabled(e.get_error());
     }
 
     ///////////////////////////////////////////////////////////////////////////
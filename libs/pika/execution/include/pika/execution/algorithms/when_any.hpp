@@ -0,0 +1,386 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+#include <pika/execution_base/p2300_forward.hpp>
+#endif
+
+#include <pika/concepts/concepts.hpp>
+#include <pika/datastructures/variant.hpp>
+#include <pika/execution/algorithms/detail/helpers.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/functional/bind_front.hpp>
+#include <pika/functional/detail/tag_fallback_invoke.hpp>
+#include <pika/functional/invoke_fused.hpp>
+#include <pika/synchronization/stop_token.hpp>
+#include <pika/type_support/detail/with_result_of.hpp>
+#include <pika/type_support/pack.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pika::when_any_detail {
+    template <typename Tuple>
+    struct decay_tuple
+    {
+        using type = pika::util::detail::transform_t<Tuple, std::decay>;
+    };
+
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+    template <typename... Ts>
+    using value_signature_t =
+        pika::execution::experimental::set_value_t(std::decay_t<Ts>...);
+
+    template <typename Error>
+    struct error_signature
+    {
+        using type =
+            pika::execution::experimental::set_error_t(std::decay_t<Error>);
+    };
+#endif
+
+    template <typename... Senders>
+    struct when_any_sender_impl
+    {
+        struct when_any_sender_type;
+    };
+
+    template <typename... Senders>
+    using when_any_sender =
+        typename when_any_sender_impl<Senders...>::when_any_sender_type;
+
+    template <typename... Senders>
+    struct when_any_sender_impl<Senders...>::when_any_sender_type
+    {
+        static_assert(sizeof...(Senders) > 0,
+            "when_any expects at least one predecessor sender");
+
+        std::tuple<Senders...> senders;
+        pika::stop_source stop_source;
+
+        template <typename... Senders_>
+        explicit constexpr when_any_sender_type(
+            pika::stop_source stop_source, Senders_&&... senders)
+          : senders(PIKA_FORWARD(Senders_, senders)...)
+          , stop_source(PIKA_MOVE(stop_source))
+        {
+        }
+
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+        // This sender sends the values of any of the predecessor senders
+        template <template <typename...> class Tuple,
+            template <typename...> class Variant>
+        using value_types = pika::util::detail::unique_concat_t<
+            pika::util::detail::transform_t<
+                pika::execution::experimental::value_types_of_t<Senders,
+                    pika::execution::experimental::detail::empty_env, Tuple,
+                    Variant>,
+                decay_tuple>...>;
+
+        // This sender sends any error types sent by the predecessor senders
+        // or std::exception_ptr
+        template <template <typename...> class Variant>
+        using error_types = pika::util::detail::unique_concat_t<
+            pika::util::detail::transform_t<
+                pika::execution::experimental::error_types_of_t<Senders,
+                    pika::execution::experimental::detail::empty_env, Variant>,
+                std::decay>...,
+            Variant<std::exception_ptr>>;
+
+        static constexpr bool sends_done = true;
+
+        using completion_signatures = pika::util::detail::change_pack_t<
+            pika::execution::experimental::completion_signatures,
+            pika::util::detail::unique_concat_t<
+                pika::execution::experimental::value_types_of_t<Senders,
+                    pika::execution::experimental::detail::empty_env,
+                    value_signature_t, pika::util::detail::pack>...,
+                pika::util::detail::transform_t<
+                    pika::execution::experimental::error_types_of_t<Senders,
+                        pika::execution::experimental::detail::empty_env,
+                        pika::util::detail::pack>,
+                    error_signature>...,
+                pika::util::detail::pack<
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr),
+                    pika::execution::experimental::set_stopped_t()>>>;
+#else
+        // This sender sends the values of any of the predecessor senders
+        template <template <typename...> class Tuple,
+            template <typename...> class Variant>
+        using value_types = pika::util::detail::unique_concat_t<
+            pika::util::detail::transform_t<
+                typename pika::execution::experimental::sender_traits<
+                    Senders>::template value_types<Tuple, Variant>,
+                decay_tuple>...>;
+
+        // This sender sends any error types sent by the predecessor senders
+        // or std::exception_ptr
+        template <template <typename...> class Variant>
+        using error_types = pika::util::detail::unique_concat_t<
+            pika::util::detail::transform_t<
+                typename pika::execution::experimental::sender_traits<
+                    Senders>::template error_types<Variant>,
+                std::decay>...,
+            Variant<std::exception_ptr>>;
+
+        static constexpr bool sends_done = true;
+#endif
+
+        template <typename Receiver>
+        struct operation_state
+        {
+            struct when_any_receiver
+            {
+                operation_state& op_state;
+
+                template <typename Error>
+                friend void
+                tag_invoke(pika::execution::experimental::set_error_t,
+                    when_any_receiver&& r, Error&& error) noexcept
+                {
+                    if (r.op_state.set_winner())
+                    {
+                        try
+                        {
+                            r.op_state.result.template emplace<error_type>(
+                                error_type(PIKA_FORWARD(Error, error)));
+                        }
+                        catch (...)
+                        {
+                            r.op_state.result.template emplace<error_type>(
+                                error_type(std::current_exception()));
+                        }
+                        r.op_state.stop_source.request_stop();
+                    }
+
+                    r.op_state.finish();
+                }
+
+                // Predecessors which have been stopped don't win
+                friend void tag_invoke(
+                    pika::execution::experimental::set_stopped_t,
+                    when_any_receiver&& r) noexcept
+                {
+                    r.op_state.finish();
+                };
+
+                template <typename... Ts>
+                friend void
+                tag_invoke(pika::execution::experimental::set_value_t,
+                    when_any_receiver&& r, Ts&&... ts) noexcept
+                {
+                    if (r.op_state.set_winner())
+                    {
+                        try
+                        {
+                            r.op_state.result.template emplace<value_type>(
+                                value_type(std::tuple<std::decay_t<Ts>...>(
+                                    PIKA_FORWARD(Ts, ts)...)));
+                        }
+                        catch (...)
+                        {
+                            r.op_state.result.template emplace<error_type>(
+                                error_type(std::current_exception()));
+                        }
+                        r.op_state.stop_source.request_stop();
+                    }
+
+                    r.op_state.finish();
+                }
+
+                friend constexpr pika::execution::experimental::detail::
+                    empty_env
+                    tag_invoke(pika::execution::experimental::get_env_t,
+                        when_any_receiver const&) noexcept
+                {
+                    return {};
+                }
+            };
+
+            std::decay_t<Receiver> receiver;
+            pika::stop_source stop_source;
+
+            // Number of predecessor senders that have not yet called any of
+            // the set signals
+            std::atomic<std::size_t> predecessors_remaining{
+                sizeof...(Senders)};
+
+            // Set by the first predecessor sender calling set_value or
+            // set_error
+            std::atomic<bool> winner_found{false};
+
+            // The values or the error sent by the winner. monostate means
+            // that all predecessors have been stopped.
+            using value_type =
+                value_types<std::tuple, pika::detail::variant>;
+            using error_type = error_types<pika::detail::variant>;
+            pika::detail::variant<pika::detail::monostate, error_type,
+                value_type>
+                result;
+
+            // The operation states are stored in optionals to handle the
+            // non-movability and non-copyability of them
+            std::tuple<std::optional<
+                pika::execution::experimental::connect_result_t<Senders,
+                    when_any_receiver>>...>
+                op_states;
+
+            template <typename Receiver_, typename Senders_, std::size_t... Is>
+            operation_state(Receiver_&& receiver,
+                pika::stop_source stop_source, Senders_&& senders,
+                pika::util::detail::index_pack<Is...>)
+              : receiver(PIKA_FORWARD(Receiver_, receiver))
+              , stop_source(PIKA_MOVE(stop_source))
+            {
+                (std::get<Is>(op_states).emplace(
+                     pika::detail::with_result_of([&]() {
+                         return pika::execution::experimental::connect(
+                             std::get<Is>(PIKA_FORWARD(Senders_, senders)),
+                             when_any_receiver{*this});
+                     })),
+                    ...);
+            }
+
+            operation_state(operation_state&&) = delete;
+            operation_state& operator=(operation_state&&) = delete;
+            operation_state(operation_state const&) = delete;
+            operation_state& operator=(operation_state const&) = delete;
+
+            bool set_winner() noexcept
+            {
+                return !winner_found.exchange(true, std::memory_order_acq_rel);
+            }
+
+            // The receiver is only signalled once all predecessors have
+            // completed since the operation states of the losers are owned
+            // by this operation state
+            void finish() noexcept
+            {
+                if (--predecessors_remaining != 0)
+                {
+                    return;
+                }
+
+                if (pika::detail::holds_alternative<value_type>(result))
+                {
+                    pika::detail::visit(
+                        [this](auto&& ts) {
+                            pika::util::detail::invoke_fused(
+                                pika::util::detail::bind_front(
+                                    pika::execution::experimental::set_value,
+                                    PIKA_MOVE(receiver)),
+                                PIKA_FORWARD(decltype(ts), ts));
+                        },
+                        PIKA_MOVE(pika::detail::get<value_type>(result)));
+                }
+                else if (pika::detail::holds_alternative<error_type>(result))
+                {
+                    pika::detail::visit(
+                        [this](auto&& error) {
+                            pika::execution::experimental::set_error(
+                                PIKA_MOVE(receiver),
+                                PIKA_FORWARD(decltype(error), error));
+                        },
+                        PIKA_MOVE(pika::detail::get<error_type>(result)));
+                }
+                else
+                {
+                    pika::execution::experimental::set_stopped(
+                        PIKA_MOVE(receiver));
+                }
+            }
+
+            template <std::size_t... Is>
+            void start(pika::util::detail::index_pack<Is...>) noexcept
+            {
+                (pika::execution::experimental::start(
+                     *std::get<Is>(op_states)),
+                    ...);
+            }
+
+            friend void tag_invoke(pika::execution::experimental::start_t,
+                operation_state& os) noexcept
+            {
+                os.start(pika::util::detail::make_index_pack_t<sizeof...(
+                        Senders)>{});
+            }
+        };
+
+        template <typename Receiver>
+        friend auto tag_invoke(pika::execution::experimental::connect_t,
+            when_any_sender_type&& s, Receiver&& receiver)
+        {
+            return operation_state<Receiver>(PIKA_FORWARD(Receiver, receiver),
+                PIKA_MOVE(s.stop_source), PIKA_MOVE(s.senders),
+                pika::util::detail::make_index_pack_t<sizeof...(Senders)>{});
+        }
+
+        template <typename Receiver>
+        friend auto tag_invoke(pika::execution::experimental::connect_t,
+            when_any_sender_type& s, Receiver&& receiver)
+        {
+            return operation_state<Receiver>(PIKA_FORWARD(Receiver, receiver),
+                s.stop_source, s.senders,
+                pika::util::detail::make_index_pack_t<sizeof...(Senders)>{});
+        }
+    };
+}    // namespace pika::when_any_detail
+
+namespace pika::execution::experimental {
+    /// when_any starts all predecessor senders and sends the values or the
+    /// error of the first one to complete with set_value or set_error. It
+    /// sends set_stopped if all predecessors have been stopped.
+    ///
+    /// When a stop_source is passed, stop is requested on it as soon as the
+    /// first predecessor has completed. Predecessors which are scheduled on
+    /// a scheduler using the token of the same source (see with_stop_token)
+    /// and which haven't started running yet are then completed with
+    /// set_stopped without running them. The successor is signalled once
+    /// all predecessors have completed.
+    inline constexpr struct when_any_t final
+      : pika::functional::detail::tag_fallback<when_any_t>
+    {
+    private:
+        // clang-format off
+        template <typename... Senders,
+            PIKA_CONCEPT_REQUIRES_(
+                pika::util::detail::all_of_v<is_sender<Senders>...>
+            )>
+        // clang-format on
+        friend constexpr PIKA_FORCEINLINE auto
+        tag_fallback_invoke(when_any_t, Senders&&... senders)
+        {
+            return when_any_detail::when_any_sender<std::decay_t<Senders>...>{
+                pika::stop_source(pika::nostopstate),
+                PIKA_FORWARD(Senders, senders)...};
+        }
+
+        // clang-format off
+        template <typename... Senders,
+            PIKA_CONCEPT_REQUIRES_(
+                pika::util::detail::all_of_v<is_sender<Senders>...>
+            )>
+        // clang-format on
+        friend constexpr PIKA_FORCEINLINE auto tag_fallback_invoke(when_any_t,
+            pika::stop_source stop_source, Senders&&... senders)
+        {
+            return when_any_detail::when_any_sender<std::decay_t<Senders>...>{
+                PIKA_MOVE(stop_source), PIKA_FORWARD(Senders, senders)...};
+        }
+    } when_any{};
+}    // namespace pika::execution::experimental
@@ -0,0 +1,337 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+#include <pika/execution_base/p2300_forward.hpp>
+#endif
+
+#include <pika/concepts/concepts.hpp>
+#include <pika/datastructures/variant.hpp>
+#include <pika/execution/algorithms/detail/helpers.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/functional/detail/tag_fallback_invoke.hpp>
+#include <pika/functional/invoke.hpp>
+#include <pika/type_support/detail/with_result_of.hpp>
+#include <pika/type_support/pack.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pika::when_each_detail {
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+    template <typename Error>
+    struct error_signature
+    {
+        using type =
+            pika::execution::experimental::set_error_t(std::decay_t<Error>);
+    };
+#endif
+
+    template <typename Sender, typename F>
+    struct when_each_sender_impl
+    {
+        struct when_each_sender_type;
+    };
+
+    template <typename Sender, typename F>
+    using when_each_sender =
+        typename when_each_sender_impl<Sender, F>::when_each_sender_type;
+
+    template <typename Sender, typename F>
+    struct when_each_sender_impl<Sender, F>::when_each_sender_type
+    {
+        using senders_type = std::vector<Sender>;
+        senders_type senders;
+        PIKA_NO_UNIQUE_ADDRESS F f;
+
+        template <typename Senders, typename F_>
+        explicit constexpr when_each_sender_type(Senders&& senders, F_&& f)
+          : senders(PIKA_FORWARD(Senders, senders))
+          , f(PIKA_FORWARD(F_, f))
+        {
+        }
+
+        // The values of the predecessors are consumed by f, so this sender
+        // sends nothing
+        template <template <typename...> class Tuple,
+            template <typename...> class Variant>
+        using value_types = Variant<Tuple<>>;
+
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+        // This sender sends any error types sent by the predecessor senders
+        // or std::exception_ptr
+        template <template <typename...> class Variant>
+        using error_types = pika::util::detail::unique_concat_t<
+            pika::util::detail::transform_t<
+                pika::execution::experimental::error_types_of_t<Sender,
+                    pika::execution::experimental::detail::empty_env, Variant>,
+                std::decay>,
+            Variant<std::exception_ptr>>;
+
+        static constexpr bool sends_done = true;
+
+        using completion_signatures = pika::util::detail::change_pack_t<
+            pika::execution::experimental::completion_signatures,
+            pika::util::detail::unique_concat_t<
+                pika::util::detail::transform_t<
+                    pika::execution::experimental::error_types_of_t<Sender,
+                        pika::execution::experimental::detail::empty_env,
+                        pika::util::detail::pack>,
+                    error_signature>,
+                pika::util::detail::pack<
+                    pika::execution::experimental::set_value_t(),
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr),
+                    pika::execution::experimental::set_stopped_t()>>>;
+#else
+        // This sender sends any error types sent by the predecessor senders
+        // or std::exception_ptr
+        template <template <typename...> class Variant>
+        using error_types = pika::util::detail::unique_concat_t<
+            pika::util::detail::transform_t<
+                typename pika::execution::experimental::sender_traits<
+                    Sender>::template error_types<Variant>,
+                std::decay>,
+            Variant<std::exception_ptr>>;
+
+        static constexpr bool sends_done = true;
+#endif
+
+        template <typename Receiver>
+        struct operation_state
+        {
+            struct when_each_receiver
+            {
+                operation_state& op_state;
+
+                template <typename Error>
+                friend void
+                tag_invoke(pika::execution::experimental::set_error_t,
+                    when_each_receiver&& r, Error&& error) noexcept
+                {
+                    if (!r.op_state.set_stopped_error_called.exchange(true))
+                    {
+                        try
+                        {
+                            r.op_state.error = PIKA_FORWARD(Error, error);
+                        }
+                        catch (...)
+                        {
+                            // NOLINTNEXTLINE(bugprone-throw-keyword-missing)
+                            r.op_state.error = std::current_exception();
+                        }
+                    }
+
+                    r.op_state.finish();
+                }
+
+                friend void tag_invoke(
+                    pika::execution::experimental::set_stopped_t,
+                    when_each_receiver&& r) noexcept
+                {
+                    r.op_state.set_stopped_error_called = true;
+                    r.op_state.finish();
+                };
+
+                template <typename... Ts>
+                friend void
+                tag_invoke(pika::execution::experimental::set_value_t,
+                    when_each_receiver&& r, Ts&&... ts) noexcept
+                {
+                    // Values arriving after an error are dropped
+                    if (!r.op_state.set_stopped_error_called)
+                    {
+                        try
+                        {
+                            PIKA_INVOKE(r.op_state.f, PIKA_FORWARD(Ts, ts)...);
+                        }
+                        catch (...)
+                        {
+                            if (!r.op_state.set_stopped_error_called.exchange(
+                                    true))
+                            {
+                                // NOLINTNEXTLINE(bugprone-throw-keyword-missing)
+                                r.op_state.error = std::current_exception();
+                            }
+                        }
+                    }
+
+                    r.op_state.finish();
+                }
+
+                friend constexpr pika::execution::experimental::detail::
+                    empty_env
+                    tag_invoke(pika::execution::experimental::get_env_t,
+                        when_each_receiver const&) noexcept
+                {
+                    return {};
+                }
+            };
+
+            std::size_t const num_predecessors;
+            std::decay_t<Receiver> receiver;
+            PIKA_NO_UNIQUE_ADDRESS F f;
+
+            // Number of predecessor senders that have not yet called any of
+            // the set signals.
+            std::atomic<std::size_t> predecessors_remaining{num_predecessors};
+
+            // The first error sent by any predecessor sender or thrown by f
+            // is stored in a optional of a variant of the error_types
+            using error_types_storage_type =
+                std::optional<error_types<pika::detail::variant>>;
+            error_types_storage_type error;
+
+            // Set to true when set_stopped or set_error has been called
+            std::atomic<bool> set_stopped_error_called{false};
+
+            // The operation states are stored in an array of optionals of
+            // the operation states to handle the non-movability and
+            // non-copyability of them
+            using operation_state_type =
+                pika::execution::experimental::connect_result_t<Sender,
+                    when_each_receiver>;
+            using operation_states_storage_type =
+                std::unique_ptr<std::optional<operation_state_type>[]>;
+            operation_states_storage_type op_states = nullptr;
+
+            template <typename Receiver_, typename F_>
+            operation_state(
+                Receiver_&& receiver, senders_type senders, F_&& f)
+              : num_predecessors(senders.size())
+              , receiver(PIKA_FORWARD(Receiver_, receiver))
+              , f(PIKA_FORWARD(F_, f))
+            {
+                op_states =
+                    std::make_unique<std::optional<operation_state_type>[]>(
+                        num_predecessors);
+                std::size_t i = 0;
+                for (auto&& sender : senders)
+                {
+                    op_states[i].emplace(pika::detail::with_result_of([&]() {
+                        return pika::execution::experimental::connect(
+                            PIKA_MOVE(sender), when_each_receiver{*this});
+                    }));
+                    ++i;
+                }
+            }
+
+            operation_state(operation_state&&) = delete;
+            operation_state& operator=(operation_state&&) = delete;
+            operation_state(operation_state const&) = delete;
+            operation_state& operator=(operation_state const&) = delete;
+
+            void finish() noexcept
+            {
+                if (--predecessors_remaining == 0)
+                {
+                    if (!set_stopped_error_called)
+                    {
+                        pika::execution::experimental::set_value(
+                            PIKA_MOVE(receiver));
+                    }
+                    else if (error)
+                    {
+                        pika::detail::visit(
+                            [this](auto&& error) {
+                                pika::execution::experimental::set_error(
+                                    PIKA_MOVE(receiver),
+                                    PIKA_FORWARD(decltype(error), error));
+                            },
+                            PIKA_MOVE(error.value()));
+                    }
+                    else
+                    {
+                        pika::execution::experimental::set_stopped(
+                            PIKA_MOVE(receiver));
+                    }
+                }
+            }
+
+            friend void tag_invoke(pika::execution::experimental::start_t,
+                operation_state& os) noexcept
+            {
+                // If there are no predecessors we can signal the
+                // continuation as soon as start is called.
+                if (os.num_predecessors == 0)
+                {
+                    pika::execution::experimental::set_value(
+                        PIKA_MOVE(os.receiver));
+                }
+                // Otherwise we start all the operation states and wait for
+                // the predecessors to signal completion.
+                else
+                {
+                    for (std::size_t i = 0; i < os.num_predecessors; ++i)
+                    {
+                        pika::execution::experimental::start(
+                            os.op_states.get()[i].value());
+                    }
+                }
+            }
+        };
+
+        template <typename Receiver>
+        friend auto tag_invoke(pika::execution::experimental::connect_t,
+            when_each_sender_type&& s, Receiver&& receiver)
+        {
+            return operation_state<Receiver>(PIKA_FORWARD(Receiver, receiver),
+                PIKA_MOVE(s.senders), PIKA_MOVE(s.f));
+        }
+
+        template <typename Receiver>
+        friend auto tag_invoke(pika::execution::experimental::connect_t,
+            when_each_sender_type& s, Receiver&& receiver)
+        {
+            return operation_state<Receiver>(
+                PIKA_FORWARD(Receiver, receiver), s.senders, s.f);
+        }
+    };
+}    // namespace pika::when_each_detail
+
+namespace pika::execution::experimental {
+    /// when_each starts all senders in a vector and calls f with the values
+    /// sent by each of them in the order in which they complete, without
+    /// collecting the values. f is called on the execution context of the
+    /// completing sender and may thus be called concurrently. The returned
+    /// sender sends nothing once all senders have completed and f has
+    /// returned, the first error sent by a sender or thrown by f, or
+    /// set_stopped if any sender has been stopped.
+    inline constexpr struct when_each_t final
+      : pika::functional::detail::tag_fallback<when_each_t>
+    {
+    private:
+        template <typename Sender, typename F,
+            PIKA_CONCEPT_REQUIRES_(is_sender_v<Sender>)>
+        friend constexpr PIKA_FORCEINLINE auto tag_fallback_invoke(
+            when_each_t, std::vector<Sender>&& senders, F&& f)
+        {
+            return when_each_detail::when_each_sender<Sender, std::decay_t<F>>{
+                PIKA_MOVE(senders), PIKA_FORWARD(F, f)};
+        }
+
+        template <typename Sender, typename F,
+            PIKA_CONCEPT_REQUIRES_(is_sender_v<Sender>)>
+        friend constexpr PIKA_FORCEINLINE auto tag_fallback_invoke(
+            when_each_t, std::vector<Sender> const& senders, F&& f)
+        {
+            return when_each_detail::when_each_sender<Sender, std::decay_t<F>>{
+                senders, PIKA_FORWARD(F, f)};
+        }
+    } when_each{};
+}    // namespace pika::execution::experimental
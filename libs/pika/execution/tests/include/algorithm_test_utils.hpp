@@ -6,6 +6,7 @@
 
 #include <pika/functional/tag_invoke.hpp>
 #include <pika/modules/execution.hpp>
+#include <pika/synchronization/stop_token.hpp>
 #include <pika/testing.hpp>
 
 #include <atomic>
@@ -15,6 +16,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #pragma once
 
@@ -450,6 +452,74 @@ struct custom_type_non_default_constructible_non_copyable
         custom_type_non_default_constructible_non_copyable const&) = delete;
 };
 
+// Sends x when the completions queued in the given vector are run, or
+// set_stopped if stop has been requested on the token by then. This mimics
+// work scheduled on a scheduler with a stop token.
+struct queued_sender
+{
+    std::vector<std::function<void()>>& queue;
+    pika::stop_token stop_token;
+    int x;
+
+    template <template <typename...> class Tuple,
+        template <typename...> class Variant>
+    using value_types = Variant<Tuple<int>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<>;
+
+    static constexpr bool sends_done = true;
+
+    using completion_signatures =
+        pika::execution::experimental::completion_signatures<
+            pika::execution::experimental::set_value_t(int),
+            pika::execution::experimental::set_stopped_t()>;
+
+    template <typename R>
+    struct operation_state
+    {
+        std::vector<std::function<void()>>& queue;
+        pika::stop_token stop_token;
+        int x;
+        std::decay_t<R> r;
+
+        friend void tag_invoke(pika::execution::experimental::start_t,
+            operation_state& os) noexcept
+        {
+            os.queue.push_back([&os] {
+                if (os.stop_token.stop_requested())
+                {
+                    pika::execution::experimental::set_stopped(
+                        std::move(os.r));
+                }
+                else
+                {
+                    pika::execution::experimental::set_value(
+                        std::move(os.r), os.x);
+                }
+            });
+        }
+    };
+
+    template <typename R>
+    friend operation_state<R> tag_invoke(
+        pika::execution::experimental::connect_t, queued_sender s, R&& r)
+    {
+        return {s.queue, std::move(s.stop_token), s.x, std::forward<R>(r)};
+    }
+};
+
+// Runs and clears the completions queued by queued_senders, last one first
+inline void run_queued(std::vector<std::function<void()>>& queue)
+{
+    auto q = std::move(queue);
+    queue.clear();
+    for (auto it = q.rbegin(); it != q.rend(); ++it)
+    {
+        (*it)();
+    }
+}
+
 struct scheduler
 {
     std::reference_wrapper<std::atomic<bool>> schedule_called;
@@ -0,0 +1,245 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+#include <pika/modules/execution.hpp>
+#include <pika/synchronization/stop_token.hpp>
+#include <pika/testing.hpp>
+
+#include "algorithm_test_utils.hpp"
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+
+struct stopped_receiver
+{
+    std::atomic<bool>& set_stopped_called;
+
+    template <typename E>
+    friend void tag_invoke(ex::set_error_t, stopped_receiver&&, E&&) noexcept
+    {
+        PIKA_TEST(false);
+    }
+
+    friend void tag_invoke(ex::set_stopped_t, stopped_receiver&& r) noexcept
+    {
+        r.set_stopped_called = true;
+    };
+
+    template <typename... Ts>
+    friend void tag_invoke(
+        ex::set_value_t, stopped_receiver&&, Ts&&...) noexcept
+    {
+        PIKA_TEST(false);
+    }
+
+    friend constexpr ex::detail::empty_env tag_invoke(
+        ex::get_env_t, stopped_receiver const&) noexcept
+    {
+        return {};
+    }
+};
+
+struct int_or_string_callback
+{
+    int& x;
+    std::string& str;
+
+    void operator()(int y)
+    {
+        x = y;
+    }
+
+    void operator()(std::string s)
+    {
+        str = std::move(s);
+    }
+};
+
+int main()
+{
+    // Success path
+    {
+        std::atomic<bool> set_value_called{false};
+        auto s = ex::when_any(ex::just(42));
+        auto f = [](int x) { PIKA_TEST_EQ(x, 42); };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        auto s = ex::when_any(ex::just(42), ex::just(43), ex::just(44));
+        auto f = [](int x) { PIKA_TEST_EQ(x, 42); };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        auto s = ex::when_any(ex::just(), ex::just());
+        auto f = [] {};
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        int x = 42;
+        auto s = ex::when_any(const_reference_sender<int>{x});
+        auto f = [](int x) { PIKA_TEST_EQ(x, 42); };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+    }
+
+    // The predecessors may send different types
+    {
+        std::atomic<bool> set_value_called{false};
+        int x = 0;
+        std::string str;
+        auto s = ex::when_any(ex::just(std::string("hello")), ex::just(42),
+            ex::unique_any_sender<int>(ex::just(43)));
+        auto r = callback_receiver<int_or_string_callback>{
+            int_or_string_callback{x, str}, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+        PIKA_TEST_EQ(x, 0);
+        PIKA_TEST_EQ(str, std::string("hello"));
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        auto s = ex::when_any(
+            ex::just(custom_type_non_default_constructible_non_copyable{42}));
+        auto f = [](custom_type_non_default_constructible_non_copyable x) {
+            PIKA_TEST_EQ(x.x, 42);
+        };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+    }
+
+    // Stop is requested on the first completion, and the successor is only
+    // signalled once the losers have completed
+    {
+        std::atomic<bool> set_value_called{false};
+        std::vector<std::function<void()>> queue;
+        pika::stop_source stop_source;
+        auto s = ex::when_any(stop_source,
+            queued_sender{queue, stop_source.get_token(), 1}, ex::just(42),
+            queued_sender{queue, stop_source.get_token(), 2});
+        auto f = [](int x) { PIKA_TEST_EQ(x, 42); };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(stop_source.stop_requested());
+        PIKA_TEST(!set_value_called);
+        PIKA_TEST_EQ(queue.size(), std::size_t(2));
+        run_queued(queue);
+        PIKA_TEST(set_value_called);
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        std::vector<std::function<void()>> queue;
+        pika::stop_source stop_source;
+        auto s = ex::when_any(stop_source,
+            queued_sender{queue, stop_source.get_token(), 1},
+            queued_sender{queue, stop_source.get_token(), 2});
+        // the last queued sender completes first
+        auto f = [](int x) { PIKA_TEST_EQ(x, 2); };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(!stop_source.stop_requested());
+        run_queued(queue);
+        PIKA_TEST(stop_source.stop_requested());
+        PIKA_TEST(set_value_called);
+    }
+
+    // Stopped predecessors don't win
+    {
+        std::atomic<bool> set_stopped_called{false};
+        std::vector<std::function<void()>> queue;
+        pika::stop_source stop_source;
+        auto s = ex::when_any(queued_sender{queue, stop_source.get_token(), 1},
+            queued_sender{queue, stop_source.get_token(), 2});
+        auto os = ex::connect(
+            std::move(s), stopped_receiver{set_stopped_called});
+        ex::start(os);
+        stop_source.request_stop();
+        run_queued(queue);
+        PIKA_TEST(set_stopped_called);
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        std::vector<std::function<void()>> queue;
+        pika::stop_source stop_source;
+        pika::stop_source other_stop_source;
+        other_stop_source.request_stop();
+        auto s = ex::when_any(stop_source,
+            queued_sender{queue, stop_source.get_token(), 1},
+            queued_sender{queue, other_stop_source.get_token(), 2});
+        auto f = [](int x) { PIKA_TEST_EQ(x, 1); };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        run_queued(queue);
+        PIKA_TEST(set_value_called);
+    }
+
+    // Failure path
+    {
+        std::atomic<bool> set_error_called{false};
+        auto s = ex::when_any(error_sender<int>{}, ex::just(42));
+        auto r = error_callback_receiver<decltype(check_exception_ptr)>{
+            check_exception_ptr, set_error_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_error_called);
+    }
+
+    {
+        std::atomic<bool> set_error_called{false};
+        auto s = ex::when_any(const_reference_error_sender<int>{});
+        auto r = error_callback_receiver<decltype(check_exception_ptr)>{
+            check_exception_ptr, set_error_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_error_called);
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        auto s = ex::when_any(ex::just(42), error_sender<int>{});
+        auto f = [](int x) { PIKA_TEST_EQ(x, 42); };
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+    }
+
+    test_adl_isolation(ex::when_any(my_namespace::my_sender{}));
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+#include <pika/modules/execution.hpp>
+#include <pika/synchronization/stop_token.hpp>
+#include <pika/testing.hpp>
+
+#include "algorithm_test_utils.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+
+int main()
+{
+    // Success path
+    {
+        std::atomic<bool> set_value_called{false};
+        std::size_t calls = 0;
+        auto s = ex::when_each(
+            std::vector<decltype(ex::just(42))>{}, [&](int) { ++calls; });
+        auto f = [] {};
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+        PIKA_TEST_EQ(calls, std::size_t(0));
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        int sum = 0;
+        auto s =
+            ex::when_each(std::vector{ex::just(1), ex::just(2), ex::just(3)},
+                [&](int x) { sum += x; });
+        auto f = [] {};
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+        PIKA_TEST_EQ(sum, 6);
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        std::size_t calls = 0;
+        std::vector<ex::unique_any_sender<>> senders;
+        senders.emplace_back(ex::just());
+        senders.emplace_back(ex::just());
+        auto s = ex::when_each(std::move(senders), [&]() { ++calls; });
+        auto f = [] {};
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+        PIKA_TEST_EQ(calls, std::size_t(2));
+    }
+
+    {
+        std::atomic<bool> set_value_called{false};
+        int sum = 0;
+        std::vector<ex::unique_any_sender<
+            custom_type_non_default_constructible_non_copyable>>
+            senders;
+        senders.emplace_back(
+            ex::just(custom_type_non_default_constructible_non_copyable{42}));
+        senders.emplace_back(
+            ex::just(custom_type_non_default_constructible_non_copyable{43}));
+        auto s = ex::when_each(std::move(senders),
+            [&](custom_type_non_default_constructible_non_copyable x) {
+                sum += x.x;
+            });
+        auto f = [] {};
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_value_called);
+        PIKA_TEST_EQ(sum, 85);
+    }
+
+    // f is called in completion order, as soon as each sender completes
+    {
+        std::atomic<bool> set_value_called{false};
+        std::vector<std::function<void()>> queue;
+        std::vector<int> order;
+        std::vector<queued_sender> senders;
+        for (int i = 0; i < 4; ++i)
+        {
+            senders.push_back(queued_sender{queue, pika::stop_token(), i});
+        }
+        auto s = ex::when_each(
+            std::move(senders), [&](int x) { order.push_back(x); });
+        auto f = [] {};
+        auto r = callback_receiver<decltype(f)>{f, set_value_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(order.empty());
+        queue.back()();
+        queue.pop_back();
+        PIKA_TEST_EQ(order.size(), std::size_t(1));
+        PIKA_TEST_EQ(order[0], 3);
+        PIKA_TEST(!set_value_called);
+        run_queued(queue);
+        PIKA_TEST(set_value_called);
+        PIKA_TEST(order == (std::vector<int>{3, 2, 1, 0}));
+    }
+
+    // Failure path
+    {
+        std::atomic<bool> set_error_called{false};
+        std::vector<ex::unique_any_sender<int>> senders;
+        senders.emplace_back(error_sender<int>{});
+        senders.emplace_back(ex::just(42));
+        std::size_t calls = 0;
+        auto s = ex::when_each(std::move(senders), [&](int) { ++calls; });
+        auto r = error_callback_receiver<decltype(check_exception_ptr)>{
+            check_exception_ptr, set_error_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_error_called);
+        // values arriving after the error are dropped
+        PIKA_TEST_EQ(calls, std::size_t(0));
+    }
+
+    {
+        std::atomic<bool> set_error_called{false};
+        auto s = ex::when_each(std::vector{ex::just(1), ex::just(2)},
+            [](int) { throw std::runtime_error("error"); });
+        auto r = error_callback_receiver<decltype(check_exception_ptr)>{
+            check_exception_ptr, set_error_called};
+        auto os = ex::connect(std::move(s), std::move(r));
+        ex::start(os);
+        PIKA_TEST(set_error_called);
+    }
+
+    test_adl_isolation(ex::when_each(
+        std::vector{my_namespace::my_sender{}}, [](auto&&...) {}));
+
+    return 0;
+}
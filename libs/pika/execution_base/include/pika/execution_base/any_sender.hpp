@@ -311,6 +311,11 @@ namespace pika::detail {
 }    // namespace pika::detail
 
 namespace pika::execution::experimental::detail {
+    // The size of the inline storage of unique_any_sender and any_sender.
+    // Senders which are larger are allocated separately.
+    inline constexpr std::size_t any_sender_storage_size =
+        PIKA_HAVE_ANY_SENDER_STORAGE_SIZE * sizeof(void*);
+
     struct any_operation_state_base
     {
         virtual ~any_operation_state_base() = default;
@@ -738,8 +743,8 @@ namespace pika::execution::experimental {
         using base_type = detail::unique_any_sender_base<Ts...>;
         template <typename Sender>
         using impl_type = detail::unique_any_sender_impl<Sender, Ts...>;
-        using storage_type =
-            pika::detail::movable_sbo_storage<base_type, 4 * sizeof(void*)>;
+        using storage_type = pika::detail::movable_sbo_storage<base_type,
+            detail::any_sender_storage_size>;
 
         storage_type storage{};
 
@@ -820,8 +825,8 @@ namespace pika::execution::experimental {
         using base_type = detail::any_sender_base<Ts...>;
         template <typename Sender>
         using impl_type = detail::any_sender_impl<Sender, Ts...>;
-        using storage_type =
-            pika::detail::copyable_sbo_storage<base_type, 4 * sizeof(void*)>;
+        using storage_type = pika::detail::copyable_sbo_storage<base_type,
+            detail::any_sender_storage_size>;
 
         storage_type storage{};
 
@@ -0,0 +1,566 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/async_base/scheduling_properties.hpp>
+#include <pika/concurrency/spinlock.hpp>
+#include <pika/coroutines/thread_enums.hpp>
+#include <pika/datastructures/detail/small_vector.hpp>
+#include <pika/errors/error_code.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/executors/thread_pool_scheduler.hpp>
+#include <pika/functional/invoke.hpp>
+#include <pika/functional/unique_function.hpp>
+#include <pika/memory/intrusive_ptr.hpp>
+#include <pika/threading_base/thread_helpers.hpp>
+#include <pika/threading_base/thread_num_tss.hpp>
+#include <pika/threading_base/thread_pool_base.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace pika::execution::experimental {
+    namespace detail {
+        // A task submitted to a dependency_tracker. pending counts the
+        // predecessors which have not finished yet, plus one while the task
+        // is being submitted.
+        struct dependency_task
+        {
+            std::atomic<std::size_t> count{1};
+            std::atomic<std::size_t> pending{1};
+            std::atomic<bool> finished{false};
+            pika::concurrency::detail::spinlock mtx;
+            pika::detail::small_vector<
+                pika::memory::intrusive_ptr<dependency_task>, 4>
+                successors;
+            pika::util::detail::unique_function<void()> f;
+
+            // Returns false if this task has already finished, in which case
+            // successor doesn't have to wait for it
+            bool add_successor(
+                pika::memory::intrusive_ptr<dependency_task> successor)
+            {
+                std::lock_guard<pika::concurrency::detail::spinlock> l(mtx);
+                if (finished.load(std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                successors.push_back(PIKA_MOVE(successor));
+                return true;
+            }
+
+            friend void intrusive_ptr_add_ref(dependency_task* p) noexcept
+            {
+                p->count.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            friend void intrusive_ptr_release(dependency_task* p) noexcept
+            {
+                if (p->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    delete p;
+                }
+            }
+        };
+
+        // The tasks which last accessed a data_handle
+        struct data_handle_state_base
+        {
+            pika::memory::intrusive_ptr<dependency_task> last_writer;
+            pika::detail::small_vector<
+                pika::memory::intrusive_ptr<dependency_task>, 4>
+                readers;
+        };
+
+        template <typename T>
+        struct data_handle_state : data_handle_state_base
+        {
+            template <typename... Ts>
+            explicit data_handle_state(std::in_place_t, Ts&&... ts)
+              : value(PIKA_FORWARD(Ts, ts)...)
+            {
+            }
+
+            T value;
+        };
+    }    // namespace detail
+
+    enum class access_mode
+    {
+        in,
+        out,
+        inout,
+    };
+
+    template <typename T, access_mode Mode>
+    class data_access;
+
+    /// \brief A value whose accesses are ordered by a dependency_tracker.
+    ///
+    /// Copies of a data_handle refer to the same value. The value may only be
+    /// accessed directly with get() when no tasks accessing it are pending.
+    template <typename T>
+    class data_handle
+    {
+    public:
+        data_handle()
+          : state_(std::make_shared<detail::data_handle_state<T>>(
+                std::in_place))
+        {
+        }
+
+        template <typename... Ts>
+        explicit data_handle(std::in_place_t, Ts&&... ts)
+          : state_(std::make_shared<detail::data_handle_state<T>>(
+                std::in_place, PIKA_FORWARD(Ts, ts)...))
+        {
+        }
+
+        template <typename U,
+            typename Enable = std::enable_if_t<
+                !std::is_same_v<std::decay_t<U>, data_handle> &&
+                std::is_constructible_v<T, U>>>
+        explicit data_handle(U&& u)
+          : data_handle(std::in_place, PIKA_FORWARD(U, u))
+        {
+        }
+
+        T& get() const noexcept
+        {
+            return state_->value;
+        }
+
+    private:
+        template <typename U, access_mode Mode>
+        friend class data_access;
+
+        std::shared_ptr<detail::data_handle_state<T>> state_;
+    };
+
+    /// An access to a data_handle by a task. Tasks receive a const reference
+    /// to values accessed with in, and a reference otherwise.
+    template <typename T, access_mode Mode>
+    class data_access
+    {
+    public:
+        using reference = std::conditional_t<Mode == access_mode::in, T const&,
+            T&>;
+
+        static constexpr access_mode mode = Mode;
+
+        explicit data_access(data_handle<T> const& h) noexcept
+          : state_(h.state_)
+        {
+        }
+
+        detail::data_handle_state_base& get_state() const noexcept
+        {
+            return *state_;
+        }
+
+        reference get() const noexcept
+        {
+            return state_->value;
+        }
+
+    private:
+        std::shared_ptr<detail::data_handle_state<T>> state_;
+    };
+
+    template <typename T>
+    data_access<T, access_mode::in> in(data_handle<T> const& h) noexcept
+    {
+        return data_access<T, access_mode::in>(h);
+    }
+
+    template <typename T>
+    data_access<T, access_mode::out> out(data_handle<T> const& h) noexcept
+    {
+        return data_access<T, access_mode::out>(h);
+    }
+
+    template <typename T>
+    data_access<T, access_mode::inout> inout(data_handle<T> const& h) noexcept
+    {
+        return data_access<T, access_mode::inout>(h);
+    }
+
+    /// \brief Runs tasks in the order implied by the data they access.
+    ///
+    /// Tasks are submitted together with the data_handles they read (in),
+    /// write (out), or read and write (inout). A task runs after the last
+    /// task writing any of its data, and a task writing data additionally
+    /// runs after all tasks reading the data since the last write. The graph
+    /// of tasks is built incrementally from the last writer and the readers
+    /// of each data_handle, without creating futures or an async_rw_mutex
+    /// state per access.
+    ///
+    /// Tasks becoming ready when a task finishes are placed on the worker
+    /// thread which ran the finished task, so that they find the data they
+    /// depend on in cache.
+    ///
+    /// Tasks can only be submitted from one thread at a time. If tasks
+    /// throw, the remaining tasks are skipped, and the first exception is
+    /// sent by the sender returned by when_done. The tracker has to outlive
+    /// the tasks submitted to it.
+    class dependency_tracker
+    {
+    public:
+        explicit dependency_tracker(thread_pool_scheduler sched)
+          : sched_(PIKA_MOVE(sched))
+        {
+        }
+
+        // Running tasks refer to the tracker by address
+        dependency_tracker(dependency_tracker&&) = delete;
+        dependency_tracker(dependency_tracker const&) = delete;
+        dependency_tracker& operator=(dependency_tracker&&) = delete;
+        dependency_tracker& operator=(dependency_tracker const&) = delete;
+
+        ~dependency_tracker()
+        {
+            PIKA_ASSERT(outstanding_.load(std::memory_order_acquire) == 0);
+        }
+
+        /// Submit a task calling f with the values of accesses, after all
+        /// tasks previously submitted with conflicting accesses to the same
+        /// data have finished.
+        template <typename F, typename... Ts, access_mode... Modes>
+        void submit(F&& f, data_access<Ts, Modes>... accesses)
+        {
+            pika::memory::intrusive_ptr<detail::dependency_task> task(
+                new detail::dependency_task, false);
+            task->f = [f = PIKA_FORWARD(F, f), accesses...]() mutable {
+                PIKA_INVOKE(f, accesses.get()...);
+            };
+
+            (add_access(task, accesses.get_state(), Modes), ...);
+
+            outstanding_.fetch_add(1, std::memory_order_relaxed);
+            if (task->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                spawn(PIKA_MOVE(task), std::nullopt);
+            }
+        }
+
+        std::size_t num_outstanding() const noexcept
+        {
+            return outstanding_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        using task_ptr = pika::memory::intrusive_ptr<detail::dependency_task>;
+
+        static void add_dependency(task_ptr const& task, task_ptr const& pred)
+        {
+            // A task may access the same data more than once
+            if (!pred || pred == task)
+            {
+                return;
+            }
+
+            task->pending.fetch_add(1, std::memory_order_relaxed);
+            if (!pred->add_successor(task))
+            {
+                task->pending.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        static void add_access(task_ptr const& task,
+            detail::data_handle_state_base& state, access_mode mode)
+        {
+            if (mode == access_mode::in)
+            {
+                add_dependency(task, state.last_writer);
+
+                // Readers which have finished don't have to be waited for by
+                // the next writer
+                auto& readers = state.readers;
+                readers.erase(std::remove_if(readers.begin(), readers.end(),
+                                  [](task_ptr const& r) {
+                                      return r->finished.load(
+                                          std::memory_order_acquire);
+                                  }),
+                    readers.end());
+                if (readers.empty() || readers.back() != task)
+                {
+                    readers.push_back(task);
+                }
+                return;
+            }
+
+            if (state.readers.empty())
+            {
+                add_dependency(task, state.last_writer);
+            }
+            else
+            {
+                for (task_ptr const& r : state.readers)
+                {
+                    add_dependency(task, r);
+                }
+                state.readers.clear();
+            }
+            state.last_writer = task;
+        }
+
+        void set_exception(std::exception_ptr ep) noexcept
+        {
+            std::lock_guard<pika::concurrency::detail::spinlock> l(mtx_);
+            if (!has_exception_.load(std::memory_order_relaxed))
+            {
+                exception_ = PIKA_MOVE(ep);
+                has_exception_.store(true, std::memory_order_release);
+            }
+        }
+
+        void spawn(task_ptr task,
+            std::optional<std::size_t> worker) noexcept
+        {
+            try
+            {
+                auto run_task = [this, task]() mutable {
+                    run(PIKA_MOVE(task));
+                };
+                if (worker)
+                {
+                    with_hint(sched_,
+                        pika::execution::thread_schedule_hint(
+                            static_cast<std::int16_t>(*worker)))
+                        .execute(PIKA_MOVE(run_task), "dependency_tracker");
+                }
+                else
+                {
+                    sched_.execute(PIKA_MOVE(run_task), "dependency_tracker");
+                }
+            }
+            catch (...)
+            {
+                set_exception(std::current_exception());
+                run(PIKA_MOVE(task));
+            }
+        }
+
+        void run(task_ptr task) noexcept
+        {
+            if (!has_exception_.load(std::memory_order_acquire))
+            {
+                try
+                {
+                    task->f();
+                }
+                catch (...)
+                {
+                    set_exception(std::current_exception());
+                }
+            }
+
+            // The function holds on to the data it accesses, which in turn
+            // refers to this task
+            task->f.reset();
+
+            decltype(task->successors) successors;
+            {
+                std::lock_guard<pika::concurrency::detail::spinlock> l(
+                    task->mtx);
+                task->finished.store(true, std::memory_order_release);
+                successors = PIKA_MOVE(task->successors);
+            }
+
+            // Tasks may also run inline on the submitting thread if spawning
+            // fails
+            std::optional<std::size_t> worker;
+            pika::error_code ec(pika::throwmode::lightweight);
+            if (pika::this_thread::get_pool(ec) == sched_.get_thread_pool() &&
+                !ec)
+            {
+                worker = pika::get_local_worker_thread_num();
+            }
+
+            for (task_ptr& s : successors)
+            {
+                if (s->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    spawn(PIKA_MOVE(s), worker);
+                }
+            }
+
+            successors.clear();
+            task.reset();
+
+            finish_task();
+        }
+
+        struct waiter_base
+        {
+            virtual ~waiter_base() = default;
+            virtual void complete(std::exception_ptr ep) noexcept = 0;
+
+            waiter_base* next = nullptr;
+        };
+
+        // Waiters may destroy the tracker as soon as they have been
+        // completed. The last task therefore only decrements the count under
+        // the lock, and doesn't touch the tracker after releasing it.
+        void finish_task() noexcept
+        {
+            std::size_t n = outstanding_.load(std::memory_order_relaxed);
+            while (n > 1)
+            {
+                if (outstanding_.compare_exchange_weak(
+                        n, n - 1, std::memory_order_acq_rel))
+                {
+                    return;
+                }
+            }
+
+            waiter_base* waiters = nullptr;
+            std::exception_ptr ep;
+            {
+                std::lock_guard<pika::concurrency::detail::spinlock> l(mtx_);
+                if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                {
+                    return;
+                }
+                waiters = std::exchange(waiters_, nullptr);
+                if (waiters != nullptr)
+                {
+                    ep = take_exception();
+                }
+            }
+
+            while (waiters != nullptr)
+            {
+                waiter_base* next = waiters->next;
+                waiters->complete(ep);
+                waiters = next;
+            }
+        }
+
+        std::exception_ptr take_exception() noexcept
+        {
+            if (!has_exception_.load(std::memory_order_relaxed))
+            {
+                return {};
+            }
+            has_exception_.store(false, std::memory_order_relaxed);
+            return std::exchange(exception_, nullptr);
+        }
+
+        template <typename Receiver>
+        struct operation_state : waiter_base
+        {
+            dependency_tracker& tracker;
+            PIKA_NO_UNIQUE_ADDRESS std::decay_t<Receiver> receiver;
+
+            template <typename Receiver_>
+            operation_state(dependency_tracker& tracker, Receiver_&& receiver)
+              : tracker(tracker)
+              , receiver(PIKA_FORWARD(Receiver_, receiver))
+            {
+            }
+
+            operation_state(operation_state&&) = delete;
+            operation_state(operation_state const&) = delete;
+            operation_state& operator=(operation_state&&) = delete;
+            operation_state& operator=(operation_state const&) = delete;
+
+            void complete(std::exception_ptr ep) noexcept override
+            {
+                if (ep)
+                {
+                    pika::execution::experimental::set_error(
+                        PIKA_MOVE(receiver), PIKA_MOVE(ep));
+                }
+                else
+                {
+                    pika::execution::experimental::set_value(
+                        PIKA_MOVE(receiver));
+                }
+            }
+
+            void start() noexcept
+            {
+                std::exception_ptr ep;
+                {
+                    std::lock_guard<pika::concurrency::detail::spinlock> l(
+                        tracker.mtx_);
+                    if (tracker.outstanding_.load(std::memory_order_acquire) !=
+                        0)
+                    {
+                        this->next = std::exchange(tracker.waiters_, this);
+                        return;
+                    }
+                    ep = tracker.take_exception();
+                }
+                complete(PIKA_MOVE(ep));
+            }
+
+            friend void tag_invoke(start_t, operation_state& os) noexcept
+            {
+                os.start();
+            }
+        };
+
+        struct when_done_sender
+        {
+            dependency_tracker* tracker;
+
+            template <template <typename...> class Tuple,
+                template <typename...> class Variant>
+            using value_types = Variant<Tuple<>>;
+
+            template <template <typename...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+
+            static constexpr bool sends_done = false;
+
+            using completion_signatures =
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_value_t(),
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr)>;
+
+            template <typename Receiver>
+            friend operation_state<Receiver>
+            tag_invoke(connect_t, when_done_sender s, Receiver&& receiver)
+            {
+                return {*s.tracker, PIKA_FORWARD(Receiver, receiver)};
+            }
+        };
+
+    public:
+        /// Return a sender which completes the next time all submitted tasks
+        /// have finished after it has been started. The sender sends the
+        /// first exception thrown by the tasks since the last completion, if
+        /// any.
+        when_done_sender when_done() noexcept
+        {
+            return {this};
+        }
+
+    private:
+        thread_pool_scheduler sched_;
+        std::atomic<std::size_t> outstanding_{0};
+        std::atomic<bool> has_exception_{false};
+        std::exception_ptr exception_;
+        pika::concurrency::detail::spinlock mtx_;
+        waiter_base* waiters_ = nullptr;
+    };
+}    // namespace pika::execution::experimental
@@ -0,0 +1,662 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#if defined(PIKA_HAVE_CXX20_COROUTINES)
+#include <pika/assert.hpp>
+#include <pika/async_base/scheduling_properties.hpp>
+#include <pika/concepts/concepts.hpp>
+#include <pika/coroutines/thread_enums.hpp>
+#include <pika/execution/algorithms/detail/helpers.hpp>
+#include <pika/execution/algorithms/execute.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/executors/thread_pool_scheduler.hpp>
+#include <pika/type_support/pack.hpp>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace pika::execution::experimental {
+    template <typename T = void>
+    class task;
+
+    namespace detail {
+        template <typename T>
+        inline constexpr bool is_task_v = false;
+
+        template <typename T>
+        inline constexpr bool is_task_v<task<T>> = true;
+
+        template <typename T, template <typename...> class Tuple,
+            template <typename...> class Variant>
+        struct task_value_types
+        {
+            using type = Variant<Tuple<T>>;
+        };
+
+        template <template <typename...> class Tuple,
+            template <typename...> class Variant>
+        struct task_value_types<void, Tuple, Variant>
+        {
+            using type = Variant<Tuple<>>;
+        };
+
+        // Task frames run on stackless pika threads. They never suspend the
+        // pika thread they run on, co_await ends the work item instead.
+        inline thread_pool_scheduler make_task_scheduler(
+            thread_pool_scheduler const& sched)
+        {
+            return pika::execution::experimental::with_stacksize(
+                sched, pika::execution::thread_stacksize::nostack);
+        }
+
+        // The state shared by the promises of all task<T>. A task is resumed
+        // either by the task awaiting it (continuation) or, if it is the
+        // outermost task, completes the operation state it was started by
+        // (complete).
+        struct task_promise_base
+        {
+            struct final_awaiter
+            {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<Promise> h) noexcept
+                {
+                    task_promise_base& p = h.promise();
+                    if (p.continuation)
+                    {
+                        return p.continuation;
+                    }
+
+                    // Completing the operation state may destroy this frame,
+                    // it must not be accessed afterwards.
+                    p.complete(p.complete_data);
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            final_awaiter final_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception() noexcept
+            {
+                exception = std::current_exception();
+            }
+
+            // Resume the task on its scheduler. The task is resumed inline if
+            // the work can't be scheduled, e.g. because the runtime is
+            // shutting down.
+            void schedule_resume(std::coroutine_handle<> h) noexcept
+            {
+                try
+                {
+                    pika::execution::experimental::execute(
+                        scheduler, [h]() { h.resume(); });
+                }
+                catch (...)
+                {
+                    h.resume();
+                }
+            }
+
+            // Called when an awaited sender completed with set_stopped. The
+            // stop signal is propagated through all awaiting tasks to the
+            // operation state of the outermost task. The suspended frames
+            // are destroyed together with the outermost task.
+            void complete_stopped() noexcept
+            {
+                stopped = true;
+                if (parent != nullptr)
+                {
+                    parent->complete_stopped();
+                }
+                else
+                {
+                    complete(complete_data);
+                }
+            }
+
+            thread_pool_scheduler scheduler =
+                make_task_scheduler(thread_pool_scheduler{});
+            std::coroutine_handle<> continuation;
+            task_promise_base* parent = nullptr;
+            void (*complete)(void*) noexcept = nullptr;
+            void* complete_data = nullptr;
+            std::exception_ptr exception;
+            bool stopped = false;
+        };
+
+        ///////////////////////////////////////////////////////////////////////
+        // Awaits a sender sending at most one value. The sender is connected
+        // to a receiver which stores the result in the awaiter, which lives
+        // in the frame of the awaiting coroutine. Senders completing inline
+        // resume the coroutine without being rescheduled, otherwise the
+        // coroutine is resumed on its scheduler.
+        template <typename Sender>
+        struct sender_awaiter
+        {
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+            using result_type = std::decay_t<single_result_t<
+                pika::execution::experimental::value_types_of_t<Sender,
+                    pika::execution::experimental::detail::empty_env,
+                    pika::util::detail::pack, pika::util::detail::pack>>>;
+#else
+            using result_type = std::decay_t<
+                single_result_t<typename pika::execution::experimental::
+                        sender_traits<Sender>::template value_types<
+                            pika::util::detail::pack,
+                            pika::util::detail::pack>>>;
+#endif
+            static constexpr bool is_void_result = std::is_void_v<result_type>;
+
+            struct void_value_type
+            {
+            };
+
+            struct stopped_type
+            {
+            };
+
+            using value_type = std::conditional_t<is_void_result,
+                void_value_type, result_type>;
+
+            struct receiver
+            {
+                sender_awaiter* awaiter;
+
+                template <typename Error>
+                friend void tag_invoke(
+                    pika::execution::experimental::set_error_t, receiver&& r,
+                    Error&& error) noexcept
+                {
+                    if constexpr (std::is_same_v<std::decay_t<Error>,
+                                      std::exception_ptr>)
+                    {
+                        r.awaiter->result.template emplace<2>(
+                            PIKA_FORWARD(Error, error));
+                    }
+                    else
+                    {
+                        r.awaiter->result.template emplace<2>(
+                            std::make_exception_ptr(
+                                PIKA_FORWARD(Error, error)));
+                    }
+                    r.awaiter->completed();
+                }
+
+                friend void tag_invoke(
+                    pika::execution::experimental::set_stopped_t,
+                    receiver&& r) noexcept
+                {
+                    r.awaiter->result.template emplace<3>();
+                    r.awaiter->completed();
+                }
+
+                template <typename... Ts>
+                friend void tag_invoke(
+                    pika::execution::experimental::set_value_t, receiver&& r,
+                    Ts&&... ts) noexcept
+                {
+                    try
+                    {
+                        r.awaiter->result.template emplace<1>(
+                            PIKA_FORWARD(Ts, ts)...);
+                    }
+                    catch (...)
+                    {
+                        r.awaiter->result.template emplace<2>(
+                            std::current_exception());
+                    }
+                    r.awaiter->completed();
+                }
+
+                friend constexpr pika::execution::experimental::detail::
+                    empty_env
+                    tag_invoke(pika::execution::experimental::get_env_t,
+                        receiver const&) noexcept
+                {
+                    return {};
+                }
+            };
+
+            using operation_state_type =
+                pika::execution::experimental::connect_result_t<Sender,
+                    receiver>;
+
+            enum class state
+            {
+                starting,
+                suspended,
+                completed,
+            };
+
+            // The awaiter is returned by await_transform as a prvalue and is
+            // thus constructed in place in the coroutine frame, its address
+            // is stable.
+            explicit sender_awaiter(Sender&& sender)
+              : op_state(pika::execution::experimental::connect(
+                    PIKA_FORWARD(Sender, sender), receiver{this}))
+            {
+            }
+
+            sender_awaiter(sender_awaiter&&) = delete;
+            sender_awaiter& operator=(sender_awaiter&&) = delete;
+            sender_awaiter(sender_awaiter const&) = delete;
+            sender_awaiter& operator=(sender_awaiter const&) = delete;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            template <typename Promise>
+            bool await_suspend(std::coroutine_handle<Promise> h) noexcept
+            {
+                handle = h;
+                promise = &h.promise();
+                pika::execution::experimental::start(op_state);
+
+                if (s.exchange(state::suspended) == state::starting)
+                {
+                    return true;
+                }
+
+                // The sender completed inline. Resume right away unless it
+                // was stopped, which may destroy this frame.
+                if (result.index() == 3)
+                {
+                    promise->complete_stopped();
+                    return true;
+                }
+                return false;
+            }
+
+            result_type await_resume()
+            {
+                if (result.index() == 2)
+                {
+                    std::rethrow_exception(PIKA_MOVE(std::get<2>(result)));
+                }
+
+                PIKA_ASSERT(result.index() == 1);
+                if constexpr (!is_void_result)
+                {
+                    return PIKA_MOVE(std::get<1>(result));
+                }
+            }
+
+            void completed() noexcept
+            {
+                if (s.exchange(state::completed) == state::suspended)
+                {
+                    if (result.index() == 3)
+                    {
+                        promise->complete_stopped();
+                    }
+                    else
+                    {
+                        promise->schedule_resume(handle);
+                    }
+                }
+            }
+
+            std::atomic<state> s{state::starting};
+            std::coroutine_handle<> handle;
+            task_promise_base* promise = nullptr;
+            std::variant<std::monostate, value_type, std::exception_ptr,
+                stopped_type>
+                result;
+            operation_state_type op_state;
+        };
+
+        // Moves the awaiting task to another scheduler
+        struct scheduler_awaiter
+        {
+            thread_pool_scheduler scheduler;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            template <typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> h) noexcept
+            {
+                task_promise_base& p = h.promise();
+                p.scheduler = make_task_scheduler(scheduler);
+                p.schedule_resume(h);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        ///////////////////////////////////////////////////////////////////////
+        template <typename Derived>
+        struct task_promise_await_transform
+        {
+            // Awaiting a task starts it inline on the current scheduler
+            template <typename U>
+            decltype(auto) await_transform(task<U>&& t) noexcept
+            {
+                return PIKA_MOVE(t);
+            }
+
+            // Awaiting a scheduler moves the task to that scheduler
+            scheduler_awaiter await_transform(
+                thread_pool_scheduler const& sched) noexcept
+            {
+                return scheduler_awaiter{sched};
+            }
+
+            // clang-format off
+            template <typename Sender,
+                PIKA_CONCEPT_REQUIRES_(
+                    pika::execution::experimental::is_sender_v<Sender> &&
+                    !is_task_v<std::decay_t<Sender>>
+                )>
+            // clang-format on
+            sender_awaiter<Sender> await_transform(Sender&& sender)
+            {
+                return sender_awaiter<Sender>(PIKA_FORWARD(Sender, sender));
+            }
+
+            // Other awaitables are awaited unchanged
+            // clang-format off
+            template <typename Awaitable,
+                PIKA_CONCEPT_REQUIRES_(
+                    !pika::execution::experimental::is_sender_v<Awaitable> &&
+                    !std::is_same_v<std::decay_t<Awaitable>,
+                        thread_pool_scheduler>
+                )>
+            // clang-format on
+            Awaitable&& await_transform(Awaitable&& awaitable) noexcept
+            {
+                return PIKA_FORWARD(Awaitable, awaitable);
+            }
+        };
+
+        template <typename T>
+        struct task_promise
+          : task_promise_base
+          , task_promise_await_transform<task_promise<T>>
+        {
+            task<T> get_return_object() noexcept;
+
+            template <typename U>
+            void return_value(U&& u)
+            {
+                value.emplace(PIKA_FORWARD(U, u));
+            }
+
+            T get_value()
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+
+                PIKA_ASSERT(value);
+                return PIKA_MOVE(*value);
+            }
+
+            std::optional<T> value;
+        };
+
+        template <>
+        struct task_promise<void>
+          : task_promise_base
+          , task_promise_await_transform<task_promise<void>>
+        {
+            task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void get_value()
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+            }
+        };
+    }    // namespace detail
+
+    /// A coroutine type whose frames run as stackless work items on a
+    /// thread_pool_scheduler. A task is lazy, it starts running when it is
+    /// awaited by another task or when it is started as a sender. It
+    /// completes with its return value, with the exception escaping its body
+    /// as error, or stopped if an awaited sender completes with set_stopped.
+    ///
+    /// Any sender with a single value (or no value) can be awaited in a task.
+    /// The task is suspended without holding a stack while the sender is
+    /// running, and resumed on the scheduler of the task when the sender
+    /// completes, unless the sender completes inline. Awaiting another task
+    /// runs it inline on the same scheduler. Awaiting a thread_pool_scheduler
+    /// moves the task to that scheduler. The outermost task runs on the
+    /// default thread pool unless moved.
+    ///
+    /// Since task frames run on stackless pika threads the body of a task
+    /// must not suspend the underlying pika thread, e.g. by yielding or by
+    /// blocking on a pika::mutex or a future. It must co_await instead.
+    template <typename T>
+    class task
+    {
+    public:
+        using promise_type = detail::task_promise<T>;
+
+        task(task&& other) noexcept
+          : handle(std::exchange(other.handle, {}))
+        {
+        }
+
+        task& operator=(task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle)
+                {
+                    handle.destroy();
+                }
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        task(task const&) = delete;
+        task& operator=(task const&) = delete;
+
+        ~task()
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+        }
+
+        template <template <typename...> class Tuple,
+            template <typename...> class Variant>
+        using value_types = typename detail::task_value_types<T, Tuple,
+            Variant>::type;
+
+        template <template <typename...> class Variant>
+        using error_types = Variant<std::exception_ptr>;
+
+        static constexpr bool sends_done = true;
+
+        using completion_signatures =
+            pika::execution::experimental::completion_signatures<
+                detail::result_type_signature_helper_t<T>,
+                pika::execution::experimental::set_error_t(
+                    std::exception_ptr),
+                pika::execution::experimental::set_stopped_t()>;
+
+    private:
+        friend promise_type;
+
+        explicit task(std::coroutine_handle<promise_type> handle) noexcept
+          : handle(handle)
+        {
+        }
+
+        template <typename Receiver>
+        struct operation_state
+        {
+            std::coroutine_handle<promise_type> handle;
+            PIKA_NO_UNIQUE_ADDRESS std::decay_t<Receiver> receiver;
+
+            template <typename Receiver_>
+            operation_state(std::coroutine_handle<promise_type> handle,
+                Receiver_&& receiver)
+              : handle(handle)
+              , receiver(PIKA_FORWARD(Receiver_, receiver))
+            {
+            }
+
+            operation_state(operation_state&&) = delete;
+            operation_state& operator=(operation_state&&) = delete;
+            operation_state(operation_state const&) = delete;
+            operation_state& operator=(operation_state const&) = delete;
+
+            ~operation_state()
+            {
+                if (handle)
+                {
+                    handle.destroy();
+                }
+            }
+
+            static void complete(void* data) noexcept
+            {
+                auto& os = *static_cast<operation_state*>(data);
+                auto& p = os.handle.promise();
+                if (p.stopped)
+                {
+                    pika::execution::experimental::set_stopped(
+                        PIKA_MOVE(os.receiver));
+                }
+                else if (p.exception)
+                {
+                    pika::execution::experimental::set_error(
+                        PIKA_MOVE(os.receiver), p.exception);
+                }
+                else if constexpr (std::is_void_v<T>)
+                {
+                    pika::execution::experimental::set_value(
+                        PIKA_MOVE(os.receiver));
+                }
+                else
+                {
+                    pika::execution::experimental::set_value(
+                        PIKA_MOVE(os.receiver), PIKA_MOVE(*p.value));
+                }
+            }
+
+            void start() noexcept
+            {
+                PIKA_ASSERT(handle);
+                auto& p = handle.promise();
+                p.complete = &complete;
+                p.complete_data = this;
+                p.schedule_resume(handle);
+            }
+
+            friend void tag_invoke(pika::execution::experimental::start_t,
+                operation_state& os) noexcept
+            {
+                os.start();
+            }
+        };
+
+        template <typename Receiver>
+        friend operation_state<Receiver> tag_invoke(
+            pika::execution::experimental::connect_t, task&& t,
+            Receiver&& receiver)
+        {
+            PIKA_ASSERT(t.handle);
+            return {std::exchange(t.handle, {}),
+                PIKA_FORWARD(Receiver, receiver)};
+        }
+
+        // Awaiting a task from another task transfers control to the awaited
+        // task and back without going through the scheduler.
+        struct awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<Promise> h) noexcept
+            {
+                auto& p = handle.promise();
+                detail::task_promise_base& parent = h.promise();
+                p.scheduler = parent.scheduler;
+                p.continuation = h;
+                p.parent = &parent;
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().get_value();
+            }
+        };
+
+    public:
+        awaiter operator co_await() && noexcept
+        {
+            PIKA_ASSERT(handle);
+            return awaiter{handle};
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    namespace detail {
+        template <typename T>
+        task<T> task_promise<T>::get_return_object() noexcept
+        {
+            return task<T>(
+                std::coroutine_handle<task_promise<T>>::from_promise(*this));
+        }
+
+        inline task<void> task_promise<void>::get_return_object() noexcept
+        {
+            return task<void>(
+                std::coroutine_handle<task_promise<void>>::from_promise(*this));
+        }
+    }    // namespace detail
+}    // namespace pika::execution::experimental
+#endif
@@ -0,0 +1,426 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/async_base/scheduling_properties.hpp>
+#include <pika/coroutines/thread_enums.hpp>
+#include <pika/errors/throw_exception.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/executors/thread_pool_scheduler.hpp>
+#include <pika/functional/unique_function.hpp>
+#include <pika/threading_base/thread_pool_base.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pika::execution::experimental {
+    /// \brief A graph of tasks which is recorded once and run repeatedly.
+    ///
+    /// Iterative codes often build the same graph of work in every
+    /// iteration. A task_graph records the tasks, the tasks they depend on,
+    /// and the schedulers they run on. Running the graph reuses the recorded
+    /// structure: the dependency counters are allocated once, and the worker
+    /// thread each task is placed on is computed when the graph is run for
+    /// the first time.
+    ///
+    /// Tasks whose scheduler has no scheduling hint are placed on the worker
+    /// of their dependency if they have exactly one dependency, and
+    /// round-robin over the workers of their pool otherwise. A task which
+    /// becomes ready on a worker on which it is also placed runs on the same
+    /// pika thread, without spawning a new thread.
+    ///
+    /// Tasks can only be added before the graph is run for the first time,
+    /// and the graph can only be run once at a time. If tasks throw, the
+    /// remaining tasks are skipped and the first exception is sent to the
+    /// receiver.
+    class task_graph
+    {
+    public:
+        using node_id = std::size_t;
+
+        task_graph() = default;
+
+        // Running graphs are referred to by address
+        task_graph(task_graph&&) = delete;
+        task_graph(task_graph const&) = delete;
+        task_graph& operator=(task_graph&&) = delete;
+        task_graph& operator=(task_graph const&) = delete;
+
+        ~task_graph()
+        {
+            PIKA_ASSERT(!running_);
+        }
+
+        /// Add a task calling f on sched after all tasks in dependencies
+        /// have finished. Returns the id of the new task.
+        template <typename F>
+        node_id add(thread_pool_scheduler const& sched, F&& f,
+            std::initializer_list<node_id> dependencies = {})
+        {
+            return add(sched, PIKA_FORWARD(F, f), dependencies.begin(),
+                dependencies.end());
+        }
+
+        template <typename F>
+        node_id add(thread_pool_scheduler const& sched, F&& f,
+            std::vector<node_id> const& dependencies)
+        {
+            return add(sched, PIKA_FORWARD(F, f), dependencies.begin(),
+                dependencies.end());
+        }
+
+        std::size_t size() const noexcept
+        {
+            return nodes_.size();
+        }
+
+        /// Return the scheduler task id runs on, including the placement of
+        /// the task if the graph has been run.
+        thread_pool_scheduler const& get_scheduler(node_id id) const
+        {
+            PIKA_ASSERT(id < nodes_.size());
+            return nodes_[id].scheduler;
+        }
+
+    private:
+        template <typename F, typename Iterator>
+        node_id add(thread_pool_scheduler const& sched, F&& f,
+            Iterator first, Iterator last)
+        {
+            if (finalized_)
+            {
+                PIKA_THROW_EXCEPTION(pika::error::invalid_status,
+                    "task_graph::add",
+                    "tasks can't be added after the graph has been run");
+            }
+
+            node_id const id = nodes_.size();
+            node& n = nodes_.emplace_back(sched, PIKA_FORWARD(F, f));
+            for (; first != last; ++first)
+            {
+                if (*first >= id)
+                {
+                    nodes_.pop_back();
+                    PIKA_THROW_EXCEPTION(pika::error::bad_parameter,
+                        "task_graph::add",
+                        "dependency {} of task {} has not been added yet",
+                        *first, id);
+                }
+                n.dependencies.push_back(*first);
+            }
+            return id;
+        }
+
+        // Compute the successors of all tasks and their placement. Tasks
+        // only depend on tasks added before them, i.e. the ids are in
+        // topological order.
+        void finalize()
+        {
+            if (finalized_)
+            {
+                return;
+            }
+
+            std::size_t const num_nodes = nodes_.size();
+            successor_offsets_.assign(num_nodes + 1, 0);
+            for (node const& n : nodes_)
+            {
+                for (node_id dep : n.dependencies)
+                {
+                    ++successor_offsets_[dep + 1];
+                }
+            }
+            for (std::size_t i = 0; i != num_nodes; ++i)
+            {
+                successor_offsets_[i + 1] += successor_offsets_[i];
+            }
+
+            successors_.resize(successor_offsets_[num_nodes]);
+            std::vector<std::size_t> next(
+                successor_offsets_.begin(), successor_offsets_.end() - 1);
+            std::unordered_map<threads::detail::thread_pool_base*, std::size_t>
+                next_worker;
+            for (node_id id = 0; id != num_nodes; ++id)
+            {
+                node& n = nodes_[id];
+                for (node_id dep : n.dependencies)
+                {
+                    successors_[next[dep]++] = id;
+                }
+
+                if (n.dependencies.empty())
+                {
+                    roots_.push_back(id);
+                }
+
+                if (get_hint(n.scheduler).mode !=
+                    pika::execution::thread_schedule_hint_mode::none)
+                {
+                    continue;
+                }
+
+                threads::detail::thread_pool_base* pool =
+                    n.scheduler.get_thread_pool();
+                std::int16_t worker = 0;
+                if (n.dependencies.size() == 1 &&
+                    nodes_[n.dependencies[0]].scheduler.get_thread_pool() ==
+                        pool)
+                {
+                    worker = get_hint(nodes_[n.dependencies[0]].scheduler).hint;
+                }
+                else
+                {
+                    std::size_t& w = next_worker[pool];
+                    worker = static_cast<std::int16_t>(w);
+                    w = (w + 1) % pool->get_os_thread_count();
+                }
+                n.scheduler = with_hint(n.scheduler,
+                    pika::execution::thread_schedule_hint(worker));
+            }
+
+            counters_.reset(new std::atomic<std::size_t>[num_nodes]);
+            finalized_ = true;
+        }
+
+        struct node
+        {
+            template <typename F>
+            node(thread_pool_scheduler const& sched, F&& f)
+              : scheduler(sched)
+              , f(PIKA_FORWARD(F, f))
+            {
+            }
+
+            thread_pool_scheduler scheduler;
+            pika::util::detail::unique_function<void()> f;
+            std::vector<node_id> dependencies;
+        };
+
+        template <typename Receiver>
+        struct operation_state
+        {
+            task_graph& graph;
+            PIKA_NO_UNIQUE_ADDRESS std::decay_t<Receiver> receiver;
+            std::atomic<std::size_t> remaining{0};
+            std::atomic<bool> has_exception{false};
+            std::exception_ptr exception;
+
+            template <typename Receiver_>
+            operation_state(task_graph& graph, Receiver_&& receiver)
+              : graph(graph)
+              , receiver(PIKA_FORWARD(Receiver_, receiver))
+            {
+            }
+
+            operation_state(operation_state&&) = delete;
+            operation_state(operation_state const&) = delete;
+            operation_state& operator=(operation_state&&) = delete;
+            operation_state& operator=(operation_state const&) = delete;
+
+            void set_exception(std::exception_ptr ep) noexcept
+            {
+                if (!has_exception.exchange(true, std::memory_order_acq_rel))
+                {
+                    exception = PIKA_MOVE(ep);
+                }
+            }
+
+            void complete() noexcept
+            {
+                graph.running_.store(false, std::memory_order_release);
+                if (has_exception.load(std::memory_order_acquire))
+                {
+                    pika::execution::experimental::set_error(
+                        PIKA_MOVE(receiver), PIKA_MOVE(exception));
+                }
+                else
+                {
+                    pika::execution::experimental::set_value(
+                        PIKA_MOVE(receiver));
+                }
+            }
+
+            void spawn(node_id id) noexcept
+            {
+                try
+                {
+                    graph.nodes_[id].scheduler.execute(
+                        [this, id]() { run(id); }, "task_graph");
+                }
+                catch (...)
+                {
+                    set_exception(std::current_exception());
+                    run(id);
+                }
+            }
+
+            // Run id and all successors placed on the same worker which
+            // become ready
+            void run(node_id id) noexcept
+            {
+                while (true)
+                {
+                    node& n = graph.nodes_[id];
+                    if (!has_exception.load(std::memory_order_relaxed))
+                    {
+                        try
+                        {
+                            n.f();
+                        }
+                        catch (...)
+                        {
+                            set_exception(std::current_exception());
+                        }
+                    }
+
+                    node_id next = id;
+                    for (std::size_t i = graph.successor_offsets_[id];
+                         i != graph.successor_offsets_[id + 1]; ++i)
+                    {
+                        node_id const s = graph.successors_[i];
+                        if (graph.counters_[s].fetch_sub(
+                                1, std::memory_order_acq_rel) != 1)
+                        {
+                            continue;
+                        }
+
+                        if (next == id &&
+                            graph.nodes_[s].scheduler == n.scheduler)
+                        {
+                            next = s;
+                        }
+                        else
+                        {
+                            spawn(s);
+                        }
+                    }
+
+                    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    {
+                        PIKA_ASSERT(next == id);
+                        complete();
+                        return;
+                    }
+
+                    if (next == id)
+                    {
+                        return;
+                    }
+                    id = next;
+                }
+            }
+
+            void start() noexcept
+            {
+                [[maybe_unused]] bool const was_running =
+                    graph.running_.exchange(true, std::memory_order_acquire);
+                PIKA_ASSERT_MSG(!was_running,
+                    "a task_graph can only be run once at a time");
+
+                try
+                {
+                    graph.finalize();
+                }
+                catch (...)
+                {
+                    graph.running_.store(false, std::memory_order_release);
+                    pika::execution::experimental::set_error(
+                        PIKA_MOVE(receiver), std::current_exception());
+                    return;
+                }
+
+                std::size_t const num_nodes = graph.nodes_.size();
+                if (num_nodes == 0)
+                {
+                    complete();
+                    return;
+                }
+
+                for (std::size_t i = 0; i != num_nodes; ++i)
+                {
+                    graph.counters_[i].store(
+                        graph.nodes_[i].dependencies.size(),
+                        std::memory_order_relaxed);
+                }
+                // The extra count keeps the operation state alive until all
+                // roots have been spawned
+                remaining.store(num_nodes + 1, std::memory_order_release);
+
+                for (node_id id : graph.roots_)
+                {
+                    spawn(id);
+                }
+
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    complete();
+                }
+            }
+
+            friend void tag_invoke(start_t, operation_state& os) noexcept
+            {
+                os.start();
+            }
+        };
+
+        struct run_sender
+        {
+            task_graph* graph;
+
+            template <template <typename...> class Tuple,
+                template <typename...> class Variant>
+            using value_types = Variant<Tuple<>>;
+
+            template <template <typename...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+
+            static constexpr bool sends_done = false;
+
+            using completion_signatures =
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_value_t(),
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr)>;
+
+            template <typename Receiver>
+            friend operation_state<Receiver>
+            tag_invoke(connect_t, run_sender s, Receiver&& receiver)
+            {
+                return {*s.graph, PIKA_FORWARD(Receiver, receiver)};
+            }
+        };
+
+    public:
+        /// Return a sender which runs all tasks of the graph when started,
+        /// and completes when all tasks have finished.
+        run_sender run() noexcept
+        {
+            return {this};
+        }
+
+    private:
+        std::vector<node> nodes_;
+        std::vector<node_id> roots_;
+        std::vector<std::size_t> successor_offsets_;
+        std::vector<node_id> successors_;
+        std::unique_ptr<std::atomic<std::size_t>[]> counters_;
+        std::atomic<bool> running_{false};
+        bool finalized_ = false;
+    };
+}    // namespace pika::execution::experimental
@@ -15,35 +15,50 @@
 #include <pika/execution/executors/execution_parameters.hpp>
 #include <pika/execution_base/receiver.hpp>
 #include <pika/execution_base/sender.hpp>
+#include <pika/synchronization/stop_token.hpp>
 #include <pika/threading_base/annotated_function.hpp>
 #include <pika/threading_base/register_thread.hpp>
+#include <pika/threading_base/scoped_annotation.hpp>
+#include <pika/threading_base/thread_data.hpp>
 #include <pika/threading_base/thread_description.hpp>
+#include <pika/threading_base/thread_num_tss.hpp>
+#include <pika/threading_base/thread_pool_base.hpp>
+#include <pika/topology/topology.hpp>
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <string>
 #include <type_traits>
 #include <utility>
 
 namespace pika::execution::experimental {
-    struct thread_pool_scheduler
+    /// A scheduler spawning work on a thread pool. HasStopToken is true for
+    /// schedulers created with with_stop_token. Their senders complete with
+    /// set_stopped if stop has been requested before the work started.
+    template <bool HasStopToken>
+    struct basic_thread_pool_scheduler
     {
-        constexpr thread_pool_scheduler() = default;
-        explicit thread_pool_scheduler(
+        constexpr basic_thread_pool_scheduler() = default;
+        explicit basic_thread_pool_scheduler(
             pika::threads::detail::thread_pool_base* pool)
           : pool_(pool)
         {
         }
 
         /// \cond NOINTERNAL
-        bool operator==(thread_pool_scheduler const& rhs) const noexcept
+        bool operator==(basic_thread_pool_scheduler const& rhs) const noexcept
         {
             return pool_ == rhs.pool_ && priority_ == rhs.priority_ &&
                 stacksize_ == rhs.stacksize_ &&
-                schedulehint_ == rhs.schedulehint_;
+                schedulehint_ == rhs.schedulehint_ &&
+                deadline_ == rhs.deadline_ &&
+                inline_if_same_pool_ == rhs.inline_if_same_pool_ &&
+                stop_token_ == rhs.stop_token_;
         }
 
-        bool operator!=(thread_pool_scheduler const& rhs) const noexcept
+        bool operator!=(basic_thread_pool_scheduler const& rhs) const noexcept
         {
             return !(*this == rhs);
         }
@@ -55,9 +70,9 @@ namespace pika::execution::experimental {
         }
 
         // support with_priority property
-        friend thread_pool_scheduler tag_invoke(
+        friend basic_thread_pool_scheduler tag_invoke(
             pika::execution::experimental::with_priority_t,
-            thread_pool_scheduler const& scheduler,
+            basic_thread_pool_scheduler const& scheduler,
             pika::execution::thread_priority priority)
         {
             auto sched_with_priority = scheduler;
@@ -67,15 +82,15 @@ namespace pika::execution::experimental {
 
         friend pika::execution::thread_priority tag_invoke(
             pika::execution::experimental::get_priority_t,
-            thread_pool_scheduler const& scheduler)
+            basic_thread_pool_scheduler const& scheduler)
         {
             return scheduler.priority_;
         }
 
         // support with_stacksize property
-        friend thread_pool_scheduler tag_invoke(
+        friend basic_thread_pool_scheduler tag_invoke(
             pika::execution::experimental::with_stacksize_t,
-            thread_pool_scheduler const& scheduler,
+            basic_thread_pool_scheduler const& scheduler,
             pika::execution::thread_stacksize stacksize)
         {
             auto sched_with_stacksize = scheduler;
@@ -85,15 +100,15 @@ namespace pika::execution::experimental {
 
         friend pika::execution::thread_stacksize tag_invoke(
             pika::execution::experimental::get_stacksize_t,
-            thread_pool_scheduler const& scheduler)
+            basic_thread_pool_scheduler const& scheduler)
         {
             return scheduler.stacksize_;
         }
 
         // support with_hint property
-        friend thread_pool_scheduler tag_invoke(
+        friend basic_thread_pool_scheduler tag_invoke(
             pika::execution::experimental::with_hint_t,
-            thread_pool_scheduler const& scheduler,
+            basic_thread_pool_scheduler const& scheduler,
             pika::execution::thread_schedule_hint hint)
         {
             auto sched_with_hint = scheduler;
@@ -103,24 +118,98 @@ namespace pika::execution::experimental {
 
         friend pika::execution::thread_schedule_hint tag_invoke(
             pika::execution::experimental::get_hint_t,
-            thread_pool_scheduler const& scheduler)
+            basic_thread_pool_scheduler const& scheduler)
         {
             return scheduler.schedulehint_;
         }
 
+        // support with_data_locality property
+        friend basic_thread_pool_scheduler tag_invoke(
+            pika::execution::experimental::with_data_locality_t,
+            basic_thread_pool_scheduler const& scheduler, void const* data,
+            std::size_t len)
+        {
+            auto sched_with_hint = scheduler;
+
+            // Keep the previous hint if the domain of the data is unknown
+            int const domain =
+                threads::detail::create_topology().get_numa_domain(data, len);
+            if (domain >= 0)
+            {
+                std::size_t const thread_num =
+                    scheduler.pool_->get_numa_domain_thread(
+                        static_cast<std::size_t>(domain));
+                if (thread_num != std::size_t(-1))
+                {
+                    sched_with_hint.schedulehint_ =
+                        pika::execution::thread_schedule_hint(
+                            static_cast<std::int16_t>(thread_num));
+                }
+            }
+
+            return sched_with_hint;
+        }
+
+        // support with_deadline property
+        friend basic_thread_pool_scheduler tag_invoke(
+            pika::execution::experimental::with_deadline_t,
+            basic_thread_pool_scheduler const& scheduler,
+            std::chrono::steady_clock::time_point deadline)
+        {
+            auto sched_with_deadline = scheduler;
+            sched_with_deadline.deadline_ = deadline;
+            return sched_with_deadline;
+        }
+
+        friend std::chrono::steady_clock::time_point tag_invoke(
+            pika::execution::experimental::get_deadline_t,
+            basic_thread_pool_scheduler const& scheduler)
+        {
+            return scheduler.deadline_;
+        }
+
+        // support with_inline_if_same_pool property
+        friend basic_thread_pool_scheduler tag_invoke(
+            pika::execution::experimental::with_inline_if_same_pool_t,
+            basic_thread_pool_scheduler const& scheduler,
+            bool inline_if_same_pool)
+        {
+            auto sched_with_inline = scheduler;
+            sched_with_inline.inline_if_same_pool_ = inline_if_same_pool;
+            return sched_with_inline;
+        }
+
+        friend bool tag_invoke(
+            pika::execution::experimental::get_inline_if_same_pool_t,
+            basic_thread_pool_scheduler const& scheduler)
+        {
+            return scheduler.inline_if_same_pool_;
+        }
+
+        // support with_stop_token property
+        friend basic_thread_pool_scheduler<true> tag_invoke(
+            pika::execution::experimental::with_stop_token_t,
+            basic_thread_pool_scheduler const& scheduler,
+            pika::stop_token stop_token)
+        {
+            return scheduler.with_stop_token(PIKA_MOVE(stop_token));
+        }
+
         // support with_annotation property
-        friend constexpr thread_pool_scheduler tag_invoke(
+        friend basic_thread_pool_scheduler tag_invoke(
             pika::execution::experimental::with_annotation_t,
-            thread_pool_scheduler const& scheduler, char const* annotation)
+            basic_thread_pool_scheduler const& scheduler,
+            char const* annotation)
         {
             auto sched_with_annotation = scheduler;
             sched_with_annotation.annotation_ = annotation;
             return sched_with_annotation;
         }
 
-        friend thread_pool_scheduler tag_invoke(
+        friend basic_thread_pool_scheduler tag_invoke(
             pika::execution::experimental::with_annotation_t,
-            thread_pool_scheduler const& scheduler, std::string annotation)
+            basic_thread_pool_scheduler const& scheduler,
+            std::string annotation)
         {
             auto sched_with_annotation = scheduler;
             sched_with_annotation.annotation_ =
@@ -131,25 +220,92 @@ namespace pika::execution::experimental {
         // support get_annotation property
         friend constexpr char const* tag_invoke(
             pika::execution::experimental::get_annotation_t,
-            thread_pool_scheduler const& scheduler) noexcept
+            basic_thread_pool_scheduler const& scheduler) noexcept
         {
             return scheduler.annotation_;
         }
 
+        // The maximum number of work items which are run inline, nested on the
+        // stack of the same pika thread, before new work is spawned again.
+        static constexpr std::size_t max_inline_depth = 16;
+
         template <typename F>
         void execute(F&& f, char const* fallback_annotation) const
         {
+            if constexpr (HasStopToken)
+            {
+                execute(PIKA_FORWARD(F, f), [] {}, fallback_annotation);
+            }
+            else
+            {
+                if (threads::detail::thread_data* self = can_execute_inline())
+                {
+                    execute_inline(
+                        self, PIKA_FORWARD(F, f), fallback_annotation);
+                    return;
+                }
+
+                pika::detail::thread_description desc(f, fallback_annotation);
+                threads::detail::thread_init_data data(
+                    threads::detail::make_thread_function_nullary(
+                        PIKA_FORWARD(F, f)),
+                    desc, priority_, schedulehint_, stacksize_);
+                data.deadline = deadline_;
+                threads::detail::register_work(data, pool_);
+            }
+        }
+
+        // Runs f, or on_stopped instead if the stop token of the scheduler
+        // has been signalled before f started running.
+        template <typename F, typename OnStopped>
+        void execute(F&& f, OnStopped&& on_stopped,
+            char const* fallback_annotation) const
+        {
+            static_assert(HasStopToken,
+                "on_stopped requires a scheduler with a stop token");
+
+            if (threads::detail::thread_data* self = can_execute_inline())
+            {
+                if (stop_token_.stop_requested())
+                {
+                    pool_->increment_elided_work_count(
+                        threads::detail::get_local_thread_num_tss());
+                    PIKA_FORWARD(OnStopped, on_stopped)();
+                    return;
+                }
+
+                execute_inline(self, PIKA_FORWARD(F, f), fallback_annotation);
+                return;
+            }
+
             pika::detail::thread_description desc(f, fallback_annotation);
+            if (!stop_token_.stop_possible())
+            {
+                threads::detail::thread_init_data data(
+                    threads::detail::make_thread_function_nullary(
+                        PIKA_FORWARD(F, f)),
+                    desc, priority_, schedulehint_, stacksize_);
+                data.deadline = deadline_;
+                threads::detail::register_work(data, pool_);
+                return;
+            }
+
+            using function_type = stoppable_function<std::decay_t<F>,
+                std::decay_t<OnStopped>>;
             threads::detail::thread_init_data data(
-                threads::detail::make_thread_function_nullary(
-                    PIKA_FORWARD(F, f)),
+                stoppable_thread_function<function_type>{
+                    {function_type{pool_, stop_token_, PIKA_FORWARD(F, f),
+                        PIKA_FORWARD(OnStopped, on_stopped)}}},
                 desc, priority_, schedulehint_, stacksize_);
+            data.deadline = deadline_;
+            data.stop_requested =
+                &stoppable_thread_function<function_type>::stop_requested;
             threads::detail::register_work(data, pool_);
         }
 
         template <typename F>
         friend void
-        tag_invoke(execute_t, thread_pool_scheduler const& sched, F&& f)
+        tag_invoke(execute_t, basic_thread_pool_scheduler const& sched, F&& f)
         {
             sched.execute(PIKA_FORWARD(F, f), sched.get_fallback_annotation());
         }
@@ -180,12 +336,33 @@ namespace pika::execution::experimental {
             {
                 pika::detail::try_catch_exception_ptr(
                     [&]() {
-                        os.scheduler.execute(
-                            [receiver = PIKA_MOVE(os.receiver)]() mutable {
-                                pika::execution::experimental::set_value(
-                                    PIKA_MOVE(receiver));
-                            },
-                            os.fallback_annotation);
+                        if constexpr (HasStopToken)
+                        {
+                            // The receiver is moved out of the operation
+                            // state before completing, as completing may
+                            // destroy the operation state
+                            os.scheduler.execute(
+                                [&os]() {
+                                    auto receiver = PIKA_MOVE(os.receiver);
+                                    pika::execution::experimental::set_value(
+                                        PIKA_MOVE(receiver));
+                                },
+                                [&os]() {
+                                    auto receiver = PIKA_MOVE(os.receiver);
+                                    pika::execution::experimental::set_stopped(
+                                        PIKA_MOVE(receiver));
+                                },
+                                os.fallback_annotation);
+                        }
+                        else
+                        {
+                            os.scheduler.execute(
+                                [receiver = PIKA_MOVE(os.receiver)]() mutable {
+                                    pika::execution::experimental::set_value(
+                                        PIKA_MOVE(receiver));
+                                },
+                                os.fallback_annotation);
+                        }
                     },
                     [&](std::exception_ptr ep) {
                         pika::execution::experimental::set_error(
@@ -213,13 +390,19 @@ namespace pika::execution::experimental {
             template <template <typename...> class Variant>
             using error_types = Variant<std::exception_ptr>;
 
-            static constexpr bool sends_done = false;
+            // Sends done if stop has been requested before the work started
+            static constexpr bool sends_done = HasStopToken;
 
-            using completion_signatures =
+            using completion_signatures = std::conditional_t<HasStopToken,
                 pika::execution::experimental::completion_signatures<
                     pika::execution::experimental::set_value_t(),
                     pika::execution::experimental::set_error_t(
-                        std::exception_ptr)>;
+                        std::exception_ptr),
+                    pika::execution::experimental::set_stopped_t()>,
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_value_t(),
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr)>>;
 
             template <typename Receiver>
             friend operation_state<Scheduler, Receiver>
@@ -248,14 +431,14 @@ namespace pika::execution::experimental {
             }
         };
 
-        friend sender<thread_pool_scheduler> tag_invoke(
-            schedule_t, thread_pool_scheduler&& sched)
+        friend sender<basic_thread_pool_scheduler> tag_invoke(
+            schedule_t, basic_thread_pool_scheduler&& sched)
         {
             return {PIKA_MOVE(sched)};
         }
 
-        friend sender<thread_pool_scheduler> tag_invoke(
-            schedule_t, thread_pool_scheduler const& sched)
+        friend sender<basic_thread_pool_scheduler> tag_invoke(
+            schedule_t, basic_thread_pool_scheduler const& sched)
         {
             return {sched};
         }
@@ -281,20 +464,24 @@ namespace pika::execution::experimental {
 #if !defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
         template <typename Sender, PIKA_CONCEPT_REQUIRES_(is_sender_v<Sender>)>
         friend auto tag_invoke(schedule_from_t,
-            thread_pool_scheduler&& scheduler, Sender&& predecessor_sender)
+            basic_thread_pool_scheduler&& scheduler,
+            Sender&& predecessor_sender)
         {
             return schedule_from_detail::schedule_from_sender<Sender,
-                thread_pool_scheduler>{PIKA_FORWARD(Sender, predecessor_sender),
+                basic_thread_pool_scheduler>{
+                PIKA_FORWARD(Sender, predecessor_sender),
                 with_annotation(
                     PIKA_MOVE(scheduler), scheduler.get_fallback_annotation())};
         }
 
         template <typename Sender, PIKA_CONCEPT_REQUIRES_(is_sender_v<Sender>)>
         friend auto tag_invoke(schedule_from_t,
-            thread_pool_scheduler const& scheduler, Sender&& predecessor_sender)
+            basic_thread_pool_scheduler const& scheduler,
+            Sender&& predecessor_sender)
         {
             return schedule_from_detail::schedule_from_sender<Sender,
-                thread_pool_scheduler>{PIKA_FORWARD(Sender, predecessor_sender),
+                basic_thread_pool_scheduler>{
+                PIKA_FORWARD(Sender, predecessor_sender),
                 with_annotation(
                     scheduler, scheduler.get_fallback_annotation())};
         }
@@ -303,6 +490,166 @@ namespace pika::execution::experimental {
 
     private:
         /// \cond NOINTERNAL
+        template <bool>
+        friend struct basic_thread_pool_scheduler;
+
+        basic_thread_pool_scheduler<true> with_stop_token(
+            pika::stop_token stop_token) const
+        {
+            basic_thread_pool_scheduler<true> sched(pool_);
+            sched.priority_ = priority_;
+            sched.stacksize_ = stacksize_;
+            sched.schedulehint_ = schedulehint_;
+            sched.deadline_ = deadline_;
+            sched.annotation_ = annotation_;
+            sched.inline_if_same_pool_ = inline_if_same_pool_;
+            sched.stop_token_ = PIKA_MOVE(stop_token);
+            return sched;
+        }
+
+        // Returns the calling pika thread if work can be run inline on it.
+        // This is the case if inlining has been enabled, the calling thread
+        // runs on the same pool with the same priority, and the work doesn't
+        // need to be scheduled in a particular way by the pool.
+        threads::detail::thread_data* can_execute_inline() const noexcept
+        {
+            if (!inline_if_same_pool_ ||
+                schedulehint_.mode !=
+                    pika::execution::thread_schedule_hint_mode::none ||
+                deadline_ != (std::chrono::steady_clock::time_point::max)())
+            {
+                return nullptr;
+            }
+
+            threads::detail::thread_data* self =
+                threads::detail::get_self_id_data();
+            if (self == nullptr ||
+                self->get_inline_depth() >= max_inline_depth ||
+                self->get_scheduler_base()->get_parent_pool() != pool_ ||
+                self->get_priority() != get_effective_priority() ||
+                !has_sufficient_stack(self))
+            {
+                return nullptr;
+            }
+
+            return self;
+        }
+
+        pika::execution::thread_priority get_effective_priority() const noexcept
+        {
+            return priority_ == pika::execution::thread_priority::default_ ?
+                pika::execution::thread_priority::normal :
+                priority_;
+        }
+
+        // Stackless threads can't suspend, so only stackless work is run
+        // inline on them. Other work is only run inline if the stack of the
+        // calling thread is at least as large as the one requested.
+        bool has_sufficient_stack(
+            threads::detail::thread_data* self) const noexcept
+        {
+            if (stacksize_ == pika::execution::thread_stacksize::nostack ||
+                stacksize_ == pika::execution::thread_stacksize::current)
+            {
+                return true;
+            }
+
+            return !self->is_stackless() &&
+                self->get_scheduler_base()->get_stack_size(stacksize_) <=
+                self->get_stack_size();
+        }
+
+        // The function run on a new thread for work with a stop token. The
+        // stop token is checked once more when the thread starts running.
+        template <typename F, typename OnStopped>
+        struct stoppable_function
+        {
+            pika::threads::detail::thread_pool_base* pool;
+            pika::stop_token stop_token;
+            F f;
+            OnStopped on_stopped;
+
+            void operator()()
+            {
+                if (stop_token.stop_requested())
+                {
+                    on_stopped();
+                    return;
+                }
+                f();
+            }
+        };
+
+        // The thread function for work with a stop token. The schedulers call
+        // it with thread_restart_state::abort instead of creating a thread if
+        // stop was requested while the work was staged. This happens on the
+        // worker OS thread, once the queue operation has finished.
+        template <typename F>
+        struct stoppable_thread_function
+        {
+            threads::detail::thread_function_nullary<F> f;
+
+            static bool stop_requested(
+                threads::detail::thread_function_type const& func)
+            {
+                auto const* self =
+                    func.template target<stoppable_thread_function>();
+                return self != nullptr && self->f.f.stop_token.stop_requested();
+            }
+
+            threads::detail::thread_result_type operator()(
+                threads::detail::thread_restart_state state)
+            {
+                if (state == threads::detail::thread_restart_state::abort)
+                {
+                    f.f.pool->increment_elided_work_count(
+                        threads::detail::get_local_thread_num_tss());
+                    f.f.on_stopped();
+                    return threads::detail::thread_result_type(
+                        threads::detail::thread_schedule_state::terminated,
+                        threads::detail::invalid_thread_id);
+                }
+                return f(state);
+            }
+        };
+
+        struct reset_inline_depth
+        {
+            threads::detail::thread_data* self;
+            std::size_t depth;
+
+            ~reset_inline_depth()
+            {
+                self->set_inline_depth(depth);
+            }
+        };
+
+        template <typename F>
+        void execute_inline(threads::detail::thread_data* self, F&& f,
+            char const* fallback_annotation) const
+        {
+            pool_->increment_inline_execution_count(
+                threads::detail::get_local_thread_num_tss());
+
+            std::size_t const depth = self->get_inline_depth();
+            self->set_inline_depth(depth + 1);
+            reset_inline_depth reset{self, depth};
+
+#if defined(PIKA_HAVE_THREAD_DESCRIPTION)
+            pika::detail::thread_description desc(f, fallback_annotation);
+            if (desc.kind() ==
+                pika::detail::thread_description::data_type_description)
+            {
+                pika::scoped_annotation annotate(desc.get_description());
+                PIKA_FORWARD(F, f)();
+                return;
+            }
+#else
+            PIKA_UNUSED(fallback_annotation);
+#endif
+            PIKA_FORWARD(F, f)();
+        }
+
         char const* get_fallback_annotation() const
         {
             // Scheduler annotations have priority
@@ -339,7 +686,15 @@ namespace pika::execution::experimental {
         pika::execution::thread_stacksize stacksize_ =
             pika::execution::thread_stacksize::small_;
         pika::execution::thread_schedule_hint schedulehint_{};
+        std::chrono::steady_clock::time_point deadline_ =
+            (std::chrono::steady_clock::time_point::max)();
         char const* annotation_ = nullptr;
+        bool inline_if_same_pool_ = false;
+        pika::stop_token stop_token_;
         /// \endcond
     };
+
+    /// The scheduler spawning work without a stop token. with_stop_token
+    /// returns a basic_thread_pool_scheduler<true>.
+    using thread_pool_scheduler = basic_thread_pool_scheduler<false>;
 }    // namespace pika::execution::experimental
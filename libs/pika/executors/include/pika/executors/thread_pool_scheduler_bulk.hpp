@@ -22,14 +22,21 @@
 #include <pika/execution_base/sender.hpp>
 #include <pika/executors/thread_pool_scheduler.hpp>
 #include <pika/functional/bind_front.hpp>
+#include <pika/functional/invoke.hpp>
+#include <pika/functional/invoke_fused.hpp>
 #include <pika/functional/tag_invoke.hpp>
+#include <pika/functional/traits/get_function_annotation.hpp>
+#include <pika/iterator_support/counting_shape.hpp>
 #include <pika/iterator_support/counting_iterator.hpp>
 #include <pika/iterator_support/traits/is_iterator.hpp>
 #include <pika/iterator_support/traits/is_range.hpp>
 #include <pika/threading_base/annotated_function.hpp>
 #include <pika/threading_base/register_thread.hpp>
 #include <pika/threading_base/thread_description.hpp>
+#include <pika/type_support/pack.hpp>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -41,7 +48,127 @@
 #include <utility>
 #include <vector>
 
+namespace pika::execution::experimental {
+    /// \brief A bulk function which only depends on its own index.
+    ///
+    /// An element-wise function only accesses the data belonging to the
+    /// index it is called with, and only depends on the previous bulk stage
+    /// having processed the same index. Consecutive element-wise bulk stages
+    /// with integral shapes on a thread_pool_scheduler are fused into one
+    /// bulk region: each chunk of indices is processed by all stages in
+    /// order, without joining and spawning tasks between the stages. Stages
+    /// which are not marked element-wise run in a separate region after all
+    /// indices of the previous stage have been processed. Other schedulers
+    /// call the wrapped function as usual.
+    template <typename F>
+    struct elementwise_function
+    {
+        PIKA_NO_UNIQUE_ADDRESS F f;
+
+        template <typename... Ts>
+        constexpr auto operator()(Ts&&... ts)
+            -> decltype(PIKA_INVOKE(f, PIKA_FORWARD(Ts, ts)...))
+        {
+            return PIKA_INVOKE(f, PIKA_FORWARD(Ts, ts)...);
+        }
+
+        template <typename... Ts>
+        constexpr auto operator()(Ts&&... ts) const
+            -> decltype(PIKA_INVOKE(f, PIKA_FORWARD(Ts, ts)...))
+        {
+            return PIKA_INVOKE(f, PIKA_FORWARD(Ts, ts)...);
+        }
+    };
+
+    template <typename F>
+    constexpr elementwise_function<std::decay_t<F>> elementwise(F&& f)
+    {
+        return {PIKA_FORWARD(F, f)};
+    }
+}    // namespace pika::execution::experimental
+
 namespace pika::thread_pool_bulk_detail {
+    template <typename F>
+    inline constexpr bool is_elementwise_v = false;
+
+    template <typename F>
+    inline constexpr bool is_elementwise_v<
+        pika::execution::experimental::elementwise_function<F>> = true;
+
+    /// Element-wise bulk stages fused into one bulk region. The stages are
+    /// called in order on each chunk of indices. Stage k is only called for
+    /// the indices below sizes[k], i.e. the stages may have different sizes.
+    template <typename Size, typename... Fs>
+    struct fused_stages
+    {
+        using size_type = Size;
+
+        std::array<Size, sizeof...(Fs)> sizes;
+        std::tuple<Fs...> fs;
+
+        template <typename Ts>
+        void operator()(Size begin, Size end, Ts& ts)
+        {
+            run_chunk(begin, end, ts,
+                pika::util::detail::make_index_pack_t<sizeof...(Fs)>{});
+        }
+
+    private:
+        template <typename Ts, std::size_t... Is>
+        void run_chunk(Size begin, Size end, Ts& ts,
+            pika::util::detail::index_pack<Is...>)
+        {
+            (run_stage(std::get<Is>(fs), sizes[Is], begin, end, ts), ...);
+        }
+
+        template <typename F, typename Ts>
+        static void run_stage(F& f, Size size, Size begin, Size end, Ts& ts)
+        {
+            end = (std::min)(end, size);
+            for (Size i = begin; i < end; ++i)
+            {
+                pika::util::detail::invoke_fused(
+                    pika::util::detail::bind_front(f, i), ts);
+            }
+        }
+    };
+
+    template <typename F>
+    inline constexpr bool is_fused_stages_v = false;
+
+    template <typename Size, typename... Fs>
+    inline constexpr bool is_fused_stages_v<fused_stages<Size, Fs...>> = true;
+
+    // Bulk functions which can be followed by a fused element-wise stage
+    template <typename F>
+    inline constexpr bool is_fusable_v =
+        is_elementwise_v<F> || is_fused_stages_v<F>;
+
+    template <typename Size, typename F, typename G>
+    fused_stages<Size, std::decay_t<F>, std::decay_t<G>> append_stage(
+        Size n, F&& f, Size m, G&& g)
+    {
+        return {{{n, m}}, {PIKA_FORWARD(F, f), PIKA_FORWARD(G, g)}};
+    }
+
+    template <typename Size, typename... Fs, typename G, std::size_t... Is>
+    fused_stages<Size, Fs..., std::decay_t<G>> append_stage(
+        fused_stages<Size, Fs...>&& f, Size m, G&& g,
+        pika::util::detail::index_pack<Is...>)
+    {
+        return {{{f.sizes[Is]..., m}},
+            std::tuple_cat(PIKA_MOVE(f.fs),
+                std::tuple<std::decay_t<G>>(PIKA_FORWARD(G, g)))};
+    }
+
+    template <typename Size, typename... Fs, typename G>
+    fused_stages<Size, Fs..., std::decay_t<G>> append_stage(
+        Size, fused_stages<Size, Fs...>&& f, Size m, G&& g)
+    {
+        return append_stage(PIKA_MOVE(f), m, PIKA_FORWARD(G, g),
+            pika::util::detail::make_index_pack_t<sizeof...(Fs)>{});
+    }
+
     /// This sender represents bulk work that will be performed using the
     /// thread_pool_scheduler.
     ///
@@ -200,15 +327,25 @@ namespace pika::thread_pool_bulk_detail {
                             (std::min)(static_cast<size_type>(index + 1) *
                                     task_f->chunk_size,
                                 task_f->n);
-                        auto it = pika::util::begin(op_state->shape);
-                        std::advance(it, i_begin);
-                        for (std::uint32_t i = i_begin; i < i_end; ++i)
+                        if constexpr (is_fused_stages_v<std::decay_t<F>>)
+                        {
+                            using stage_size_type =
+                                typename std::decay_t<F>::size_type;
+                            op_state->f(static_cast<stage_size_type>(i_begin),
+                                static_cast<stage_size_type>(i_end), ts);
+                        }
+                        else
                         {
-                            pika::util::detail::invoke_fused(
-                                pika::util::detail::bind_front(
-                                    op_state->f, *it),
-                                ts);
-                            ++it;
+                            auto it = pika::util::begin(op_state->shape);
+                            std::advance(it, i_begin);
+                            for (std::uint32_t i = i_begin; i < i_end; ++i)
+                            {
+                                pika::util::detail::invoke_fused(
+                                    pika::util::detail::bind_front(
+                                        op_state->f, *it),
+                                    ts);
+                                ++it;
+                            }
                         }
                     }
 
@@ -557,6 +694,23 @@ namespace pika::thread_pool_bulk_detail {
         };
 
     public:
+        // Fuse the element-wise stage g over the indices [0, m) into this
+        // bulk region. This requires the shape of this sender to be [0, n)
+        // and f to be element-wise.
+        template <typename Size, typename G>
+        auto fuse(Size m, G&& g) &&
+        {
+            static_assert(is_fusable_v<std::decay_t<F>>);
+
+            auto const n = static_cast<Size>(pika::util::size(shape));
+            auto stages = append_stage(n, PIKA_MOVE(f), m, PIKA_FORWARD(G, g));
+            return thread_pool_bulk_sender<Sender,
+                pika::util::detail::counting_shape_type<Size>,
+                decltype(stages)>{PIKA_MOVE(scheduler), PIKA_MOVE(sender),
+                pika::util::detail::make_counting_shape((std::max)(n, m)),
+                PIKA_MOVE(stages)};
+        }
+
         template <typename Receiver>
         friend auto tag_invoke(pika::execution::experimental::connect_t,
             thread_pool_bulk_sender&& s, Receiver&& receiver)
@@ -576,6 +730,38 @@ namespace pika::thread_pool_bulk_detail {
     };
 }    // namespace pika::thread_pool_bulk_detail
 
+namespace pika::detail {
+#if defined(PIKA_HAVE_THREAD_DESCRIPTION)
+    template <typename F>
+    struct get_function_annotation<
+        pika::execution::experimental::elementwise_function<F>>
+    {
+        static constexpr char const* call(
+            pika::execution::experimental::elementwise_function<F> const&
+                f) noexcept
+        {
+            return get_function_annotation<F>::call(f.f);
+        }
+    };
+
+    // Fused stages use the annotation of the first stage
+    template <typename Size, typename... Fs>
+    struct get_function_annotation<
+        pika::thread_pool_bulk_detail::fused_stages<Size, Fs...>>
+    {
+        static constexpr char const* call(
+            pika::thread_pool_bulk_detail::fused_stages<Size, Fs...> const&
+                f) noexcept
+        {
+            using first_stage_type =
+                std::tuple_element_t<0, std::tuple<Fs...>>;
+            return get_function_annotation<first_stage_type>::call(
+                std::get<0>(f.fs));
+        }
+    };
+#endif
+}    // namespace pika::detail
+
 namespace pika::execution::experimental {
     template <typename Sender, typename Shape, typename F,
         PIKA_CONCEPT_REQUIRES_(std::is_integral_v<std::decay_t<Shape>>)>
@@ -599,4 +785,19 @@ namespace pika::execution::experimental {
             PIKA_MOVE(scheduler), PIKA_FORWARD(Sender, sender),
             PIKA_FORWARD(Shape, shape), PIKA_FORWARD(F, f)};
     }
+
+    // An element-wise stage following an element-wise bulk region with the
+    // same index type is fused into that region
+    template <typename Sender, typename Size, typename F, typename Shape,
+        typename G,
+        PIKA_CONCEPT_REQUIRES_(std::is_same_v<std::decay_t<Shape>, Size> &&
+            thread_pool_bulk_detail::is_fusable_v<F>)>
+    constexpr auto tag_invoke(bulk_t, thread_pool_scheduler,
+        thread_pool_bulk_detail::thread_pool_bulk_sender<Sender,
+            pika::util::detail::counting_shape_type<Size>, F>&& sender,
+        Shape&& shape, elementwise_function<G> g)
+    {
+        return PIKA_MOVE(sender).fuse(
+            static_cast<Size>(shape), PIKA_MOVE(g));
+    }
 }    // namespace pika::execution::experimental
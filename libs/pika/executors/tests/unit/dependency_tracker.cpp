@@ -0,0 +1,217 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that dependency_tracker orders tasks by the data they
+// access, that readers of the same data run concurrently, and that exceptions
+// thrown by tasks are propagated.
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+void test_empty()
+{
+    ex::dependency_tracker tracker{ex::thread_pool_scheduler{}};
+    PIKA_TEST_EQ(tracker.num_outstanding(), std::size_t(0));
+    tt::sync_wait(tracker.when_done());
+}
+
+void test_read_write()
+{
+    ex::dependency_tracker tracker{ex::thread_pool_scheduler{}};
+    ex::data_handle<int> a(0);
+    ex::data_handle<int> b(0);
+
+    constexpr int num_iterations = 100;
+    std::atomic<int> num_reads{0};
+    for (int i = 0; i < num_iterations; ++i)
+    {
+        tracker.submit([i](int& x) { PIKA_TEST_EQ(x++, i); }, ex::inout(a));
+
+        // readers see the last write, and the next write waits for them
+        for (int j = 0; j < 3; ++j)
+        {
+            tracker.submit(
+                [&num_reads, i](int const& x) {
+                    PIKA_TEST_EQ(x, i + 1);
+                    ++num_reads;
+                },
+                ex::in(a));
+        }
+
+        tracker.submit(
+            [i](int const& x, int& y) {
+                PIKA_TEST_EQ(x, i + 1);
+                y = x;
+            },
+            ex::in(a), ex::out(b));
+    }
+
+    tt::sync_wait(tracker.when_done());
+    PIKA_TEST_EQ(tracker.num_outstanding(), std::size_t(0));
+    PIKA_TEST_EQ(num_reads.load(), 3 * num_iterations);
+    PIKA_TEST_EQ(a.get(), num_iterations);
+    PIKA_TEST_EQ(b.get(), num_iterations);
+
+    // the same data may be accessed more than once by a task
+    tracker.submit([](int const& x, int& y) { y += x; }, ex::in(a),
+        ex::inout(a));
+    tt::sync_wait(tracker.when_done());
+    PIKA_TEST_EQ(a.get(), 2 * num_iterations);
+}
+
+void test_concurrent_readers()
+{
+    std::size_t const num_threads = pika::get_num_worker_threads();
+    if (num_threads < 2)
+    {
+        return;
+    }
+
+    ex::dependency_tracker tracker{ex::thread_pool_scheduler{}};
+    ex::data_handle<int> a(42);
+
+    // all readers have to run at the same time to make progress
+    std::atomic<std::size_t> arrived{0};
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        tracker.submit(
+            [&, num_threads](int const& x) {
+                PIKA_TEST_EQ(x, 42);
+                ++arrived;
+                while (arrived.load() != num_threads)
+                {
+                    pika::this_thread::yield();
+                }
+            },
+            ex::in(a));
+    }
+    tracker.submit([](int& x) { x = 43; }, ex::out(a));
+
+    tt::sync_wait(tracker.when_done());
+    PIKA_TEST_EQ(a.get(), 43);
+}
+
+// A tiled, Cholesky-like sweep: tile (i, j) with i > j is updated from the
+// diagonal tile (j, j) and the tiles left of it
+void test_tiled()
+{
+    ex::dependency_tracker tracker{ex::thread_pool_scheduler{}};
+
+    constexpr std::size_t n = 8;
+    std::vector<ex::data_handle<std::size_t>> tiles;
+    for (std::size_t i = 0; i < n * n; ++i)
+    {
+        tiles.emplace_back(std::size_t(0));
+    }
+    auto tile = [&](std::size_t i, std::size_t j) -> auto& {
+        return tiles[i * n + j];
+    };
+
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        tracker.submit(
+            [k](std::size_t& d) {
+                PIKA_TEST_EQ(d, k);
+                ++d;
+            },
+            ex::inout(tile(k, k)));
+        for (std::size_t i = k + 1; i < n; ++i)
+        {
+            tracker.submit(
+                [k](std::size_t const& d, std::size_t& t) {
+                    PIKA_TEST_EQ(d, k + 1);
+                    PIKA_TEST_EQ(t, k);
+                    ++t;
+                },
+                ex::in(tile(k, k)), ex::inout(tile(i, k)));
+        }
+        for (std::size_t i = k + 1; i < n; ++i)
+        {
+            for (std::size_t j = k + 1; j <= i; ++j)
+            {
+                tracker.submit(
+                    [k](std::size_t const& l, std::size_t const& r,
+                        std::size_t& t) {
+                        PIKA_TEST_EQ(l, k + 1);
+                        PIKA_TEST_EQ(r, k + 1);
+                        PIKA_TEST_EQ(t, k);
+                        ++t;
+                    },
+                    ex::in(tile(i, k)), ex::in(tile(j, k)),
+                    ex::inout(tile(i, j)));
+            }
+        }
+    }
+
+    tt::sync_wait(tracker.when_done());
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j <= i; ++j)
+        {
+            PIKA_TEST_EQ(tile(i, j).get(), j + 1);
+        }
+    }
+}
+
+void test_exception()
+{
+    ex::dependency_tracker tracker{ex::thread_pool_scheduler{}};
+    ex::data_handle<int> a(0);
+
+    tracker.submit(
+        [](int&) { throw std::runtime_error("error"); }, ex::inout(a));
+    tracker.submit([](int& x) { ++x; }, ex::inout(a));
+
+    bool caught = false;
+    try
+    {
+        tt::sync_wait(tracker.when_done());
+    }
+    catch (std::runtime_error const& e)
+    {
+        PIKA_TEST_EQ(std::string(e.what()), std::string("error"));
+        caught = true;
+    }
+    PIKA_TEST(caught);
+    // the successor of the throwing task has been skipped
+    PIKA_TEST_EQ(a.get(), 0);
+
+    // tasks run again after the error has been sent
+    tracker.submit([](int& x) { ++x; }, ex::inout(a));
+    tt::sync_wait(tracker.when_done());
+    PIKA_TEST_EQ(a.get(), 1);
+}
+
+int pika_main()
+{
+    test_empty();
+    test_read_write();
+    test_concurrent_readers();
+    test_tiled();
+    test_exception();
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST_EQ_MSG(pika::init(pika_main, argc, argv), 0,
+        "pika main exited with non-zero status");
+
+    return pika::util::report_errors();
+}
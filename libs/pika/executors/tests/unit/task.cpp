@@ -0,0 +1,292 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/execution.hpp>
+#include <pika/executors/task.hpp>
+#include <pika/init.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+bool on_stackless_thread()
+{
+    return pika::threads::detail::get_thread_id_data(
+        pika::threads::detail::get_self_id())
+        ->is_stackless();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ex::task<int> answer()
+{
+    co_return 42;
+}
+
+ex::task<> nothing(bool& called)
+{
+    PIKA_TEST(on_stackless_thread());
+    called = true;
+    co_return;
+}
+
+ex::task<std::unique_ptr<int>> move_only()
+{
+    co_return std::make_unique<int>(co_await answer());
+}
+
+ex::task<std::size_t> fib(std::size_t n)
+{
+    if (n < 2)
+    {
+        co_return n;
+    }
+    co_return co_await fib(n - 1) + co_await fib(n - 2);
+}
+
+void test_values()
+{
+    PIKA_TEST_EQ(tt::sync_wait(answer()), 42);
+
+    bool called = false;
+    tt::sync_wait(nothing(called));
+    PIKA_TEST(called);
+
+    PIKA_TEST_EQ(*tt::sync_wait(move_only()), 42);
+    PIKA_TEST_EQ(tt::sync_wait(fib(15)), std::size_t(610));
+
+    // tasks are senders
+    PIKA_TEST_EQ(tt::sync_wait(answer() | ex::then([](int x) { return x + 1; })),
+        43);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ex::task<std::string> await_senders()
+{
+    ex::thread_pool_scheduler sched{};
+
+    int const x = co_await ex::just(1);
+    co_await ex::just();
+    PIKA_TEST(on_stackless_thread());
+
+    // completes asynchronously on a stackful thread, the task is resumed on a
+    // stackless thread again
+    int const y = co_await (ex::schedule(sched) | ex::then([] {
+        PIKA_TEST(!on_stackless_thread());
+        return 2;
+    }));
+    PIKA_TEST(on_stackless_thread());
+
+    // senders sending more than one value have to be adapted
+    std::string const ab = co_await (
+        ex::when_all(ex::transfer_just(sched, 3), ex::transfer_just(sched, 4)) |
+        ex::then([](int a, int b) {
+            return std::to_string(a) + std::to_string(b);
+        }));
+
+    auto s = ex::just(std::string("5"));
+    std::string const c = co_await s;
+
+    co_await sched;
+    PIKA_TEST(on_stackless_thread());
+
+    co_return std::to_string(x) + std::to_string(y) + ab + c;
+}
+
+void test_await_senders()
+{
+    PIKA_TEST_EQ(tt::sync_wait(await_senders()), std::string("12345"));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ex::task<> throws()
+{
+    throw std::runtime_error("error");
+    co_return;
+}
+
+ex::task<int> catches()
+{
+    bool caught = false;
+    try
+    {
+        co_await throws();
+    }
+    catch (std::runtime_error const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    caught = false;
+    try
+    {
+        co_await (ex::just() | ex::then([] { throw std::logic_error("error"); }));
+    }
+    catch (std::logic_error const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    co_return 1;
+}
+
+void test_exceptions()
+{
+    PIKA_TEST_EQ(tt::sync_wait(catches()), 1);
+
+    bool caught = false;
+    try
+    {
+        tt::sync_wait(throws());
+    }
+    catch (std::runtime_error const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+struct stopped_sender
+{
+    template <template <typename...> class Tuple,
+        template <typename...> class Variant>
+    using value_types = Variant<Tuple<>>;
+
+    template <template <typename...> class Variant>
+    using error_types = Variant<>;
+
+    static constexpr bool sends_done = true;
+
+    using completion_signatures =
+        ex::completion_signatures<ex::set_value_t(), ex::set_stopped_t()>;
+
+    template <typename R>
+    struct operation_state
+    {
+        R r;
+
+        friend void tag_invoke(ex::start_t, operation_state& os) noexcept
+        {
+            ex::set_stopped(std::move(os.r));
+        }
+    };
+
+    template <typename R>
+    friend operation_state<std::decay_t<R>> tag_invoke(
+        ex::connect_t, stopped_sender, R&& r)
+    {
+        return {std::forward<R>(r)};
+    }
+};
+
+struct stopped_receiver
+{
+    std::atomic<bool>& stopped;
+
+    template <typename E>
+    friend void tag_invoke(ex::set_error_t, stopped_receiver&&, E&&) noexcept
+    {
+        PIKA_TEST(false);
+    }
+
+    friend void tag_invoke(ex::set_stopped_t, stopped_receiver&& r) noexcept
+    {
+        r.stopped = true;
+    }
+
+    template <typename... Ts>
+    friend void tag_invoke(ex::set_value_t, stopped_receiver&&, Ts&&...) noexcept
+    {
+        PIKA_TEST(false);
+    }
+
+    friend constexpr ex::detail::empty_env tag_invoke(
+        ex::get_env_t, stopped_receiver const&) noexcept
+    {
+        return {};
+    }
+};
+
+ex::task<> stops(bool& reached)
+{
+    co_await stopped_sender{};
+    reached = true;
+}
+
+ex::task<int> awaits_stopped(bool& reached)
+{
+    co_await stops(reached);
+    reached = true;
+    co_return 0;
+}
+
+void test_stopped()
+{
+    bool reached = false;
+    std::atomic<bool> stopped(false);
+    {
+        auto os =
+            ex::connect(awaits_stopped(reached), stopped_receiver{stopped});
+        ex::start(os);
+        pika::util::yield_while([&] { return !stopped; });
+    }
+    PIKA_TEST(!reached);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ex::task<> count(ex::thread_pool_scheduler sched, std::atomic<std::size_t>& n)
+{
+    co_await ex::schedule(sched);
+    co_await ex::schedule(sched);
+    ++n;
+}
+
+void test_many_tasks()
+{
+    constexpr std::size_t num_tasks = 10000;
+
+    ex::thread_pool_scheduler sched{};
+    std::atomic<std::size_t> n(0);
+
+    std::vector<ex::unique_any_sender<>> senders;
+    senders.reserve(num_tasks);
+    for (std::size_t i = 0; i != num_tasks; ++i)
+    {
+        senders.emplace_back(count(sched, n) | ex::ensure_started());
+    }
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+
+    PIKA_TEST_EQ(n.load(), num_tasks);
+}
+
+int pika_main()
+{
+    test_values();
+    test_await_senders();
+    test_exceptions();
+    test_stopped();
+    test_many_tasks();
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv), 0);
+    return pika::util::report_errors();
+}
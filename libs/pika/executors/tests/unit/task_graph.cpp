@@ -0,0 +1,229 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that task_graph runs tasks after their dependencies,
+// that graphs can be run repeatedly, and that exceptions thrown by tasks are
+// propagated.
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+void test_empty()
+{
+    ex::task_graph g;
+    PIKA_TEST_EQ(g.size(), std::size_t(0));
+    tt::sync_wait(g.run());
+    tt::sync_wait(g.run());
+}
+
+void test_diamond()
+{
+    ex::thread_pool_scheduler sched{};
+    ex::task_graph g;
+
+    std::atomic<int> step{0};
+    int a = -1, b = -1, c = -1, d = -1;
+    auto const ta = g.add(sched, [&] { a = step++; });
+    auto const tb = g.add(sched, [&] { b = step++; }, {ta});
+    auto const tc = g.add(sched, [&] { c = step++; }, {ta});
+    g.add(sched, [&] { d = step++; }, {tb, tc});
+    PIKA_TEST_EQ(g.size(), std::size_t(4));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        step = 0;
+        tt::sync_wait(g.run());
+        PIKA_TEST_EQ(step.load(), 4);
+        PIKA_TEST_EQ(a, 0);
+        PIKA_TEST(b == 1 || b == 2);
+        PIKA_TEST(c == 1 || c == 2);
+        PIKA_TEST_EQ(d, 3);
+    }
+
+    // tasks can't be added once the graph has been run
+    bool caught = false;
+    try
+    {
+        g.add(sched, [] {});
+    }
+    catch (pika::exception const& e)
+    {
+        PIKA_TEST_EQ(e.get_error(), pika::error::invalid_status);
+        caught = true;
+    }
+    PIKA_TEST(caught);
+}
+
+void test_placement()
+{
+    ex::thread_pool_scheduler sched{};
+    ex::task_graph g;
+
+    std::size_t const num_threads = pika::get_num_worker_threads();
+    std::vector<ex::task_graph::node_id> roots;
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        roots.push_back(g.add(sched, [] {}));
+    }
+    auto const chained = g.add(sched, [] {}, {roots.back()});
+    auto const hinted = g.add(
+        ex::with_hint(sched, pika::execution::thread_schedule_hint(0)),
+        [] {}, roots);
+
+    tt::sync_wait(g.run());
+
+    // roots are distributed round-robin, tasks with a single dependency
+    // follow their dependency, and existing hints are kept
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        PIKA_TEST_EQ(ex::get_hint(g.get_scheduler(roots[i])).hint,
+            static_cast<std::int16_t>(i));
+    }
+    PIKA_TEST_EQ(ex::get_hint(g.get_scheduler(chained)).hint,
+        static_cast<std::int16_t>(num_threads - 1));
+    PIKA_TEST_EQ(ex::get_hint(g.get_scheduler(hinted)).hint,
+        static_cast<std::int16_t>(0));
+}
+
+void test_wide()
+{
+    ex::thread_pool_scheduler sched{};
+    ex::task_graph g;
+
+    constexpr std::size_t width = 100;
+    constexpr std::size_t depth = 10;
+
+    std::vector<std::atomic<std::size_t>> counts(width * depth);
+    std::vector<ex::task_graph::node_id> previous;
+    for (std::size_t i = 0; i < depth; ++i)
+    {
+        std::vector<ex::task_graph::node_id> current;
+        for (std::size_t j = 0; j < width; ++j)
+        {
+            std::size_t const k = i * width + j;
+            std::vector<ex::task_graph::node_id> deps;
+            if (i != 0)
+            {
+                // depend on the task above and the neighbours of it
+                for (std::size_t l = (j == 0 ? 0 : j - 1);
+                     l < (std::min)(j + 2, width); ++l)
+                {
+                    deps.push_back(previous[l]);
+                }
+            }
+            current.push_back(g.add(
+                sched,
+                [&counts, k, i, j] {
+                    if (i != 0)
+                    {
+                        // the task above has run as often as this one is
+                        // about to
+                        PIKA_TEST_EQ(counts[k - width].load(),
+                            counts[k].load() + 1);
+                    }
+                    ++counts[k];
+                },
+                deps));
+        }
+        previous = std::move(current);
+    }
+
+    for (std::size_t n = 1; n <= 5; ++n)
+    {
+        tt::sync_wait(g.run());
+        for (auto const& count : counts)
+        {
+            PIKA_TEST_EQ(count.load(), n);
+        }
+    }
+}
+
+void test_exception()
+{
+    ex::thread_pool_scheduler sched{};
+    ex::task_graph g;
+
+    bool should_throw = true;
+    std::atomic<int> count{0};
+    auto const t = g.add(sched, [&] {
+        ++count;
+        if (should_throw)
+        {
+            throw std::runtime_error("error");
+        }
+    });
+    g.add(sched, [&] { ++count; }, {t});
+    g.add(sched, [&] { ++count; });
+
+    bool caught = false;
+    try
+    {
+        tt::sync_wait(g.run());
+    }
+    catch (std::runtime_error const& e)
+    {
+        PIKA_TEST_EQ(std::string(e.what()), std::string("error"));
+        caught = true;
+    }
+    PIKA_TEST(caught);
+    // the successor of the throwing task has been skipped
+    PIKA_TEST_LT(count.load(), 3);
+
+    // the graph can be run again after an error
+    should_throw = false;
+    count = 0;
+    tt::sync_wait(g.run());
+    PIKA_TEST_EQ(count.load(), 3);
+
+    // dependencies have to be added before the tasks depending on them
+    caught = false;
+    ex::task_graph g2;
+    try
+    {
+        g2.add(sched, [] {}, {0});
+    }
+    catch (pika::exception const& e)
+    {
+        PIKA_TEST_EQ(e.get_error(), pika::error::bad_parameter);
+        caught = true;
+    }
+    PIKA_TEST(caught);
+    PIKA_TEST_EQ(g2.size(), std::size_t(0));
+}
+
+int pika_main()
+{
+    test_empty();
+    test_diamond();
+    test_placement();
+    test_wide();
+    test_exception();
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST_EQ_MSG(pika::init(pika_main, argc, argv), 0,
+        "pika main exited with non-zero status");
+
+    return pika::util::report_errors();
+}
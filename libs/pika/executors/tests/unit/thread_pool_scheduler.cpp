@@ -8,15 +8,22 @@
 #include <pika/execution.hpp>
 #include <pika/functional.hpp>
 #include <pika/init.hpp>
+#include <pika/latch.hpp>
 #include <pika/mutex.hpp>
+#include <pika/stop_token.hpp>
 #include <pika/testing.hpp>
 #include <pika/thread.hpp>
+#include <pika/topology/numa_allocator.hpp>
+#include <pika/topology/topology.hpp>
 
 #include <array>
 #include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <memory>
+#include <numeric>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -1863,6 +1870,105 @@ void test_bulk()
     }
 }
 
+template <typename Sender>
+inline constexpr bool is_fused_v = false;
+
+template <typename Sender, typename Shape, typename Size, typename... Fs>
+inline constexpr bool is_fused_v<pika::thread_pool_bulk_detail::
+        thread_pool_bulk_sender<Sender, Shape,
+            pika::thread_pool_bulk_detail::fused_stages<Size, Fs...>>> = true;
+
+void test_bulk_fusion()
+{
+    ex::thread_pool_scheduler sched{};
+
+    // Consecutive element-wise stages are fused into one bulk region
+    for (int n : {0, 1, 10, 43})
+    {
+        std::vector<int> v(n, -1);
+        auto s = ex::schedule(sched) |
+            ex::bulk(n, ex::elementwise([&v](int i) { v[i] = i; })) |
+            ex::bulk(n, ex::elementwise([&v](int i) { v[i] *= 2; })) |
+            ex::bulk(n, ex::elementwise([&v](int i) { v[i] += 1; }));
+        static_assert(is_fused_v<decltype(s)>);
+        tt::sync_wait(std::move(s));
+
+        for (int i = 0; i < n; ++i)
+        {
+            PIKA_TEST_EQ(v[i], 2 * i + 1);
+        }
+    }
+
+    // Fused stages may have different sizes
+    {
+        int const n = 17;
+        int const m = 29;
+        std::vector<int> v(m, 0);
+        tt::sync_wait(ex::schedule(sched) |
+            ex::bulk(n, ex::elementwise([&v](int i) { v[i] += 1; })) |
+            ex::bulk(m, ex::elementwise([&v](int i) { v[i] += 2; })) |
+            ex::bulk(n / 2, ex::elementwise([&v](int i) { v[i] += 4; })));
+
+        for (int i = 0; i < m; ++i)
+        {
+            PIKA_TEST_EQ(v[i], (i < n ? 1 : 0) + 2 + (i < n / 2 ? 4 : 0));
+        }
+    }
+
+    // Stages which are not element-wise see all indices of the previous stage
+    {
+        int const n = 43;
+        std::vector<int> v(n, 0);
+        std::atomic<int> sum{0};
+        auto s = ex::schedule(sched) |
+            ex::bulk(n, ex::elementwise([&v](int i) { v[i] = i; })) |
+            ex::bulk(n, [&](int i) { sum += v[n - 1 - i]; });
+        static_assert(!is_fused_v<decltype(s)>);
+        tt::sync_wait(std::move(s));
+        PIKA_TEST_EQ(sum.load(), n * (n - 1) / 2);
+    }
+
+    // Values sent by the predecessor are passed to all stages
+    {
+        int const n = 10;
+        auto set = [](int i, std::vector<int>& v) { v[i] = i; };
+        auto scale = [](int i, std::vector<int>& v) { v[i] *= 3; };
+        auto v = tt::sync_wait(
+            ex::transfer_just(sched, std::vector<int>(n, 0)) |
+            ex::bulk(n, ex::elementwise(set)) |
+            ex::bulk(n, ex::elementwise(scale)));
+
+        for (int i = 0; i < n; ++i)
+        {
+            PIKA_TEST_EQ(v[i], 3 * i);
+        }
+    }
+
+    // Exceptions thrown by fused stages are propagated
+    {
+        int const n = 43;
+        std::vector<int> v(n, -1);
+        bool caught = false;
+        try
+        {
+            tt::sync_wait(ex::schedule(sched) |
+                ex::bulk(n, ex::elementwise([&v](int i) { v[i] = i; })) |
+                ex::bulk(n, ex::elementwise([](int i) {
+                    if (i == 7)
+                    {
+                        throw std::runtime_error("error");
+                    }
+                })));
+        }
+        catch (std::runtime_error const& e)
+        {
+            PIKA_TEST_EQ(std::string(e.what()), std::string("error"));
+            caught = true;
+        }
+        PIKA_TEST(caught);
+    }
+}
+
 void test_completion_scheduler()
 {
     {
@@ -2050,6 +2156,324 @@ void test_scheduler_queries()
         ex::forward_progress_guarantee::weakly_parallel);
 }
 
+void test_inline_if_same_pool()
+{
+    using pika::threads::detail::get_self_id;
+    using pika::threads::detail::get_thread_id_data;
+
+    ex::thread_pool_scheduler sched{};
+    PIKA_TEST(!ex::get_inline_if_same_pool(sched));
+    auto inline_sched = ex::with_inline_if_same_pool(sched, true);
+    PIKA_TEST(ex::get_inline_if_same_pool(inline_sched));
+    PIKA_TEST(sched != inline_sched);
+
+    auto* pool = sched.get_thread_pool();
+    auto const inline_executions = [pool]() {
+        return pool->get_inline_execution_count(std::size_t(-1), false);
+    };
+
+    // without the property all stages run on new threads
+    {
+        auto const count = inline_executions();
+        auto const inline_depth = [] {
+            return get_thread_id_data(get_self_id())->get_inline_depth();
+        };
+        std::size_t depth0 = std::size_t(-1);
+        std::size_t depth1 = std::size_t(-1);
+        tt::sync_wait(ex::schedule(sched) |
+            ex::then([&] { depth0 = inline_depth(); }) | ex::transfer(sched) |
+            ex::then([&] { depth1 = inline_depth(); }));
+        PIKA_TEST_EQ(depth0, std::size_t(0));
+        PIKA_TEST_EQ(depth1, std::size_t(0));
+        PIKA_TEST_EQ(inline_executions(), count);
+    }
+
+    // with the property the stages run inline on the first thread, up to
+    // the maximum inline depth
+    {
+        constexpr std::size_t num_transfers = 40;
+        auto const count = inline_executions();
+
+        // Thread ids may be reused by new threads, so work running on a new
+        // thread is recognized by its inline depth being zero
+        std::vector<std::size_t> depths;
+        auto record_id = [&] {
+            auto* self = get_thread_id_data(get_self_id());
+            PIKA_TEST_LTE(self->get_inline_depth(),
+                ex::thread_pool_scheduler::max_inline_depth);
+            depths.push_back(self->get_inline_depth());
+        };
+
+        ex::unique_any_sender<> s = ex::schedule(sched) | ex::then(record_id);
+        for (std::size_t i = 0; i != num_transfers; ++i)
+        {
+            s = std::move(s) | ex::transfer(inline_sched) |
+                ex::then(record_id);
+        }
+        tt::sync_wait(std::move(s));
+
+        PIKA_TEST_EQ(depths.size(), num_transfers + 1);
+        std::size_t num_threads = 0;
+        for (std::size_t depth : depths)
+        {
+            if (depth == 0)
+            {
+                ++num_threads;
+            }
+        }
+        PIKA_TEST_LT(std::size_t(1), num_threads);
+        PIKA_TEST_EQ(inline_executions() - count,
+            std::int64_t(num_transfers + 1 - num_threads));
+        PIKA_TEST_LTE(
+            std::int64_t(num_transfers / 2), inline_executions() - count);
+    }
+
+    // the annotation of the scheduler is used for inline work
+#if defined(PIKA_HAVE_THREAD_DESCRIPTION)
+    {
+        std::string annotation;
+        tt::sync_wait(ex::schedule(sched) |
+            ex::transfer(ex::with_annotation(inline_sched, "inline")) |
+            ex::then([&] {
+                annotation =
+                    pika::threads::detail::get_thread_description(get_self_id())
+                        .get_description();
+            }));
+        PIKA_TEST_EQ(annotation, std::string("inline"));
+    }
+#endif
+
+    // work needing a stack is not run inline on stackless threads
+    {
+        auto const count = inline_executions();
+        bool stackless = true;
+        tt::sync_wait(ex::schedule(ex::with_stacksize(
+                          sched, pika::execution::thread_stacksize::nostack)) |
+            ex::transfer(inline_sched) | ex::then([&] {
+                stackless = get_thread_id_data(get_self_id())->is_stackless();
+            }));
+        PIKA_TEST(!stackless);
+        PIKA_TEST_EQ(inline_executions(), count);
+    }
+
+    // work needing a larger stack than the calling thread is not run inline
+    {
+        using pika::execution::thread_stacksize;
+
+        auto const count = inline_executions();
+        std::ptrdiff_t stacksize = 0;
+        tt::sync_wait(ex::schedule(sched) |
+            ex::transfer(
+                ex::with_stacksize(inline_sched, thread_stacksize::large)) |
+            ex::then([&] {
+                stacksize = get_thread_id_data(get_self_id())->get_stack_size();
+            }));
+        PIKA_TEST_EQ(stacksize,
+            pool->get_scheduler()->get_stack_size(thread_stacksize::large));
+        PIKA_TEST_EQ(inline_executions(), count);
+
+        // work needing a smaller stack is run inline
+        tt::sync_wait(
+            ex::schedule(ex::with_stacksize(sched, thread_stacksize::large)) |
+            ex::transfer(
+                ex::with_stacksize(inline_sched, thread_stacksize::small_)));
+        PIKA_TEST_EQ(inline_executions(), count + 1);
+    }
+
+    // work with a different priority is not run inline
+    {
+        auto const count = inline_executions();
+        tt::sync_wait(ex::schedule(sched) |
+            ex::transfer(ex::with_priority(
+                inline_sched, pika::execution::thread_priority::high)));
+        PIKA_TEST_EQ(inline_executions(), count);
+    }
+
+    // work with a scheduling hint is not run inline
+    {
+        auto const count = inline_executions();
+        tt::sync_wait(ex::schedule(sched) |
+            ex::transfer(ex::with_hint(
+                inline_sched, pika::execution::thread_schedule_hint(0))));
+        PIKA_TEST_EQ(inline_executions(), count);
+    }
+}
+
+struct stop_counting_receiver
+{
+    std::atomic<std::size_t>& num_run;
+    std::atomic<std::size_t>& num_stopped;
+    pika::latch& done;
+
+    template <typename E>
+    friend void
+    tag_invoke(ex::set_error_t, stop_counting_receiver&& r, E&&) noexcept
+    {
+        PIKA_TEST(false);
+        r.done.count_down(1);
+    }
+
+    friend void tag_invoke(
+        ex::set_stopped_t, stop_counting_receiver&& r) noexcept
+    {
+        ++r.num_stopped;
+        r.done.count_down(1);
+    }
+
+    friend void tag_invoke(
+        ex::set_value_t, stop_counting_receiver&& r) noexcept
+    {
+        ++r.num_run;
+        r.done.count_down(1);
+    }
+
+    friend constexpr pika::execution::experimental::detail::empty_env
+    tag_invoke(pika::execution::experimental::get_env_t,
+        stop_counting_receiver const&) noexcept
+    {
+        return {};
+    }
+};
+
+// Starts num_tasks operations on sched, optionally requesting stop on ss
+// after starting them, and returns the number of operations which ran and
+// which were stopped.
+std::pair<std::size_t, std::size_t> start_stoppable(
+    ex::basic_thread_pool_scheduler<true> const& sched, std::size_t num_tasks,
+    pika::stop_source* ss = nullptr)
+{
+    std::atomic<std::size_t> num_run{0};
+    std::atomic<std::size_t> num_stopped{0};
+    pika::latch done(static_cast<std::ptrdiff_t>(num_tasks));
+
+    using operation_state_type = decltype(ex::connect(
+        ex::schedule(sched), std::declval<stop_counting_receiver>()));
+    std::vector<std::unique_ptr<operation_state_type>> ops;
+    for (std::size_t i = 0; i != num_tasks; ++i)
+    {
+        ops.emplace_back(new operation_state_type(ex::connect(
+            ex::schedule(sched),
+            stop_counting_receiver{num_run, num_stopped, done})));
+        ex::start(*ops.back());
+    }
+    if (ss != nullptr)
+    {
+        ss->request_stop();
+    }
+    done.wait();
+
+    return {num_run.load(), num_stopped.load()};
+}
+
+void test_stop_token()
+{
+    ex::thread_pool_scheduler sched{};
+    auto* pool = sched.get_thread_pool();
+    auto const elided_work = [pool]() {
+        return pool->get_elided_work_count(std::size_t(-1), false);
+    };
+
+    constexpr std::size_t num_tasks = 100;
+
+    pika::stop_source ss;
+    auto stop_sched = ex::with_stop_token(sched, ss.get_token());
+    PIKA_TEST(stop_sched == ex::with_stop_token(sched, ss.get_token()));
+    static_assert(!decltype(ex::schedule(sched))::sends_done);
+    static_assert(decltype(ex::schedule(stop_sched))::sends_done);
+
+    // work runs normally as long as stop hasn't been requested
+    {
+        auto const count = elided_work();
+        auto [num_run, num_stopped] = start_stoppable(stop_sched, num_tasks);
+        PIKA_TEST_EQ(num_run, num_tasks);
+        PIKA_TEST_EQ(num_stopped, std::size_t(0));
+        PIKA_TEST_EQ(elided_work(), count);
+    }
+
+    // work which has started running when stop is requested is unaffected,
+    // the rest is stopped
+    {
+        pika::stop_source ss_concurrent;
+        auto const count = elided_work();
+        auto [num_run, num_stopped] = start_stoppable(
+            ex::with_stop_token(sched, ss_concurrent.get_token()), num_tasks,
+            &ss_concurrent);
+        PIKA_TEST_EQ(num_run + num_stopped, num_tasks);
+        PIKA_TEST_LTE(elided_work() - count, std::int64_t(num_stopped));
+    }
+
+    ss.request_stop();
+
+    // work started after stop has been requested is completed with
+    // set_stopped, without creating a thread
+    {
+        auto const count = elided_work();
+        auto [num_run, num_stopped] = start_stoppable(stop_sched, num_tasks);
+        PIKA_TEST_EQ(num_run, std::size_t(0));
+        PIKA_TEST_EQ(num_stopped, num_tasks);
+        PIKA_TEST_EQ(elided_work() - count, std::int64_t(num_tasks));
+    }
+
+    // work spawned with execute is dropped
+    {
+        std::atomic<bool> run{false};
+        auto const count = elided_work();
+
+        ex::execute(stop_sched, [&] { run = true; });
+        while (elided_work() == count)
+        {
+            pika::this_thread::yield();
+        }
+
+        PIKA_TEST(!run);
+    }
+}
+
+void test_data_locality()
+{
+    using pika::threads::detail::create_topology;
+    using pika::threads::detail::numa_allocation_policy;
+    using pika::threads::detail::numa_allocator;
+
+    constexpr std::size_t n = 1 << 16;
+    constexpr std::size_t len = n * sizeof(double);
+    std::vector<double, numa_allocator<double>> v(
+        numa_allocator<double>(numa_allocation_policy::bind, 0));
+    v.reserve(n);
+
+    // the hint is only changed if the domain of the memory is known, which
+    // depends on the platform and on whether the memory has been touched
+    auto const check_hint = [&](ex::thread_pool_scheduler const& sched) {
+        auto const hint = ex::get_hint(ex::with_data_locality(
+            ex::with_hint(sched,
+                pika::execution::thread_schedule_hint(
+                    pika::execution::thread_schedule_hint_mode::none, 0)),
+            v.data(), len));
+        if (create_topology().get_numa_domain(v.data(), len) == -1)
+        {
+            PIKA_TEST(hint.mode ==
+                pika::execution::thread_schedule_hint_mode::none);
+        }
+        else if (hint.mode ==
+            pika::execution::thread_schedule_hint_mode::thread)
+        {
+            PIKA_TEST_LT(static_cast<std::size_t>(hint.hint),
+                pika::get_num_worker_threads());
+        }
+    };
+
+    ex::thread_pool_scheduler sched{};
+    check_hint(sched);
+
+    v.resize(n, 1.0);
+    check_hint(sched);
+
+    auto const locality_sched = ex::with_data_locality(sched, v.data(), len);
+    double const sum = tt::sync_wait(ex::schedule(locality_sched) |
+        ex::then([&] { return std::accumulate(v.begin(), v.end(), 0.0); }));
+    PIKA_TEST_EQ(sum, static_cast<double>(n));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 int pika_main()
 {
@@ -2080,10 +2504,14 @@ int pika_main()
     test_let_error();
     test_detach();
     test_bulk();
+    test_bulk_fusion();
     test_drop_value();
     test_split_tuple();
     test_completion_scheduler();
     test_scheduler_queries();
+    test_inline_if_same_pool();
+    test_stop_token();
+    test_data_locality();
 
     return pika::finalize();
 }
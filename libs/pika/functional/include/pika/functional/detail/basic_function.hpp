@@ -12,10 +12,12 @@
 #include <pika/config.hpp>
 #include <pika/assert.hpp>
 #include <pika/functional/detail/empty_function.hpp>
+#include <pika/functional/detail/function_storage.hpp>
 #include <pika/functional/detail/vtable/function_vtable.hpp>
 #include <pika/functional/detail/vtable/vtable.hpp>
 #include <pika/functional/traits/get_function_address.hpp>
 #include <pika/functional/traits/get_function_annotation.hpp>
+#include <pika/modules/itt_notify.hpp>
 
 #include <cstddef>
 #include <cstring>
@@ -25,14 +27,20 @@
 #include <utility>
 
 namespace pika::util::detail {
-    static const std::size_t function_storage_size = 3 * sizeof(void*);
+    // The default size of the inline storage of type-erased functions.
+    // Callables which are larger are allocated separately.
+    inline constexpr std::size_t function_storage_size =
+        PIKA_HAVE_FUNCTION_STORAGE_SIZE * sizeof(void*);
 
     ///////////////////////////////////////////////////////////////////////////
-    class PIKA_EXPORT function_base
+    template <std::size_t StorageSize>
+    class function_base
     {
         using vtable = function_base_vtable;
 
     public:
+        static constexpr std::size_t storage_size = StorageSize;
+
         constexpr explicit function_base(
             function_base_vtable const* empty_vptr) noexcept
           : vptr(empty_vptr)
@@ -41,17 +49,123 @@ namespace pika::util::detail {
         {
         }
 
-        function_base(function_base const& other, vtable const* empty_vtable);
-        function_base(function_base&& other, vtable const* empty_vptr) noexcept;
-        ~function_base();
+        function_base(
+            function_base const& other, vtable const* /* empty_vtable */)
+          : vptr(other.vptr)
+          , object(other.object)
+        {
+            if (other.object != nullptr)
+            {
+                object = vptr->copy(
+                    storage, storage_size, other.object, /*destroy*/ false);
+            }
+        }
+
+        function_base(function_base&& other, vtable const* empty_vptr) noexcept
+          : vptr(other.vptr)
+          , object(other.object)
+        {
+            if (object == &other.storage)
+            {
+                relocate(vptr, storage, other.storage);
+                object = &storage;
+            }
+            other.vptr = empty_vptr;
+            other.object = nullptr;
+        }
+
+        ~function_base()
+        {
+            destroy();
+        }
+
+        void op_assign(
+            function_base const& other, vtable const* /* empty_vtable */)
+        {
+            if (vptr == other.vptr)
+            {
+                if (this != &other && object)
+                {
+                    PIKA_ASSERT(other.object != nullptr);
+                    // reuse object storage
+                    object = vptr->copy(object, std::size_t(-1), other.object,
+                        /*destroy*/ true);
+                }
+            }
+            else
+            {
+                destroy();
+                vptr = other.vptr;
+                if (other.object != nullptr)
+                {
+                    object = vptr->copy(storage, storage_size, other.object,
+                        /*destroy*/ false);
+                }
+                else
+                {
+                    object = nullptr;
+                }
+            }
+        }
 
-        void op_assign(function_base const& other, vtable const* empty_vtable);
         void op_assign(
-            function_base&& other, vtable const* empty_vtable) noexcept;
+            function_base&& other, vtable const* empty_vtable) noexcept
+        {
+            if (this != &other)
+            {
+                swap(other);
+                other.reset(empty_vtable);
+            }
+        }
+
+        void destroy() noexcept
+        {
+            if (object != nullptr)
+            {
+                vptr->deallocate(object, storage_size, /*destroy*/ true);
+            }
+        }
+
+        void reset(vtable const* empty_vptr) noexcept
+        {
+            destroy();
+            vptr = empty_vptr;
+            object = nullptr;
+        }
+
+        void swap(function_base& f) noexcept
+        {
+            if (this == &f)
+            {
+                return;
+            }
 
-        void destroy() noexcept;
-        void reset(vtable const* empty_vptr) noexcept;
-        void swap(function_base& f) noexcept;
+            bool const is_inline = object == &storage;
+            bool const f_is_inline = f.object == &f.storage;
+            if (is_inline && f_is_inline)
+            {
+                alignas(vtable::storage_alignment) unsigned char
+                    tmp[storage_size];
+                relocate(vptr, tmp, storage);
+                relocate(f.vptr, storage, f.storage);
+                relocate(vptr, f.storage, tmp);
+            }
+            else if (is_inline)
+            {
+                relocate(vptr, f.storage, storage);
+            }
+            else if (f_is_inline)
+            {
+                relocate(f.vptr, storage, f.storage);
+            }
+
+            std::swap(vptr, f.vptr);
+            std::swap(object, f.object);
+            if (object == &f.storage)
+                object = &storage;
+            if (f.object == &storage)
+                f.object = &f.storage;
+        }
 
         bool empty() const noexcept
         {
@@ -63,17 +177,55 @@ namespace pika::util::detail {
             return !empty();
         }
 
-        std::size_t get_function_address() const;
-        char const* get_function_annotation() const;
-        util::itt::string_handle get_function_annotation_itt() const;
+        std::size_t get_function_address() const
+        {
+#if defined(PIKA_HAVE_THREAD_DESCRIPTION)
+            return vptr->get_function_address(object);
+#else
+            return 0;
+#endif
+        }
+
+        char const* get_function_annotation() const
+        {
+#if defined(PIKA_HAVE_THREAD_DESCRIPTION)
+            return vptr->get_function_annotation(object);
+#else
+            return nullptr;
+#endif
+        }
+
+        util::itt::string_handle get_function_annotation_itt() const
+        {
+#if PIKA_HAVE_ITTNOTIFY != 0 && !defined(PIKA_HAVE_APEX)
+            return vptr->get_function_annotation_itt(object);
+#else
+            return util::itt::string_handle{};
+#endif
+        }
 
     protected:
+        // Moves the callable stored inline in from to the storage to
+        static void relocate(
+            vtable const* f_vptr, void* to, void* from) noexcept
+        {
+            if (f_vptr->relocate == nullptr)
+            {
+                std::memcpy(to, from, storage_size);
+            }
+            else
+            {
+                f_vptr->relocate(to, from);
+            }
+        }
+
         vtable const* vptr;
         void* object;
         union
         {
             char storage_init;
-            mutable unsigned char storage[function_storage_size];
+            alignas(vtable::storage_alignment) mutable unsigned char
+                storage[storage_size];
         };
     };
 
@@ -90,7 +242,8 @@ namespace pika::util::detail {
         return mp == nullptr;
     }
 
-    inline bool is_empty_function_impl(function_base const* f) noexcept
+    template <std::size_t StorageSize>
+    bool is_empty_function_impl(function_base<StorageSize> const* f) noexcept
     {
         return f->empty();
     }
@@ -107,13 +260,16 @@ namespace pika::util::detail {
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    template <typename Sig, bool Copyable>
+    template <typename Sig, bool Copyable,
+        std::size_t StorageSize = function_storage_size>
     class basic_function;
 
-    template <bool Copyable, typename R, typename... Ts>
-    class basic_function<R(Ts...), Copyable> : public function_base
+    template <bool Copyable, typename R, typename... Ts,
+        std::size_t StorageSize>
+    class basic_function<R(Ts...), Copyable, StorageSize>
+      : public function_base<StorageSize>
     {
-        using base_type = function_base;
+        using base_type = function_base<StorageSize>;
         using vtable = function_vtable<R(Ts...), Copyable>;
 
     public:
@@ -169,12 +325,19 @@ namespace pika::util::detail {
                 }
                 else
                 {
-                    destroy();
+                    base_type::destroy();
                     vptr = f_vptr;
                     buffer = vtable::template allocate<T>(
-                        storage, function_storage_size);
+                        storage, StorageSize);
                 }
                 object = ::new (buffer) T(PIKA_FORWARD(F, f));
+#if defined(PIKA_HAVE_FUNCTION_STORAGE_COUNTERS)
+                if (!vtable::template fits_storage<T>(StorageSize))
+                {
+                    record_function_storage_miss(
+                        base_type::get_function_annotation(), sizeof(T));
+                }
+#endif
             }
             else
             {
@@ -0,0 +1,53 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pika::util::detail {
+    // Callables which don't fit the inline storage of a type-erased function
+    // are allocated from per-thread caches of blocks in a few size classes.
+    // Blocks may be freed on a different thread than the one they were
+    // allocated on. Larger callables are allocated with operator new. The
+    // blocks are aligned for any fundamental type.
+    PIKA_EXPORT void* allocate_function_storage(std::size_t size);
+    PIKA_EXPORT void deallocate_function_storage(
+        void* p, std::size_t size) noexcept;
+
+#if defined(PIKA_HAVE_FUNCTION_STORAGE_COUNTERS)
+    // Count a callable of the given size which didn't fit the inline storage
+    PIKA_EXPORT void record_function_storage_miss(
+        char const* annotation, std::size_t size) noexcept;
+#endif
+}    // namespace pika::util::detail
+
+namespace pika::util {
+    /// The number of type-erased functions with a given annotation whose
+    /// callable didn't fit the inline storage, and the largest such
+    /// callable. Functions without an annotation are counted as
+    /// "<unknown>".
+    struct function_storage_miss
+    {
+        std::string annotation;
+        std::uint64_t count = 0;
+        std::size_t max_size = 0;
+    };
+
+    /// Returns the counted misses, sorted by decreasing count. The result is
+    /// empty unless pika has been built with
+    /// PIKA_WITH_FUNCTION_STORAGE_COUNTERS=ON.
+    PIKA_EXPORT std::vector<function_storage_miss>
+    get_function_storage_misses();
+
+    /// Resets the counted misses
+    PIKA_EXPORT void reset_function_storage_misses();
+}    // namespace pika::util
@@ -9,15 +9,19 @@
 #include <pika/functional/function.hpp>
 #include <pika/functional/unique_function.hpp>
 
+#include <cstddef>
+
 namespace pika::util::detail {
-    template <typename Sig>
-    inline void reset_function(pika::util::detail::function<Sig>& f)
+    template <typename Sig, std::size_t StorageSize>
+    inline void reset_function(
+        pika::util::detail::function<Sig, StorageSize>& f)
     {
         f.reset();
     }
 
-    template <typename Sig>
-    inline void reset_function(pika::util::detail::unique_function<Sig>& f)
+    template <typename Sig, std::size_t StorageSize>
+    inline void reset_function(
+        pika::util::detail::unique_function<Sig, StorageSize>& f)
     {
         f.reset();
     }
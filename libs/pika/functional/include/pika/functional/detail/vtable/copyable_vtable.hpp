@@ -21,10 +21,13 @@ namespace pika::util::detail {
         static void* _copy(void* storage, std::size_t storage_size,
             void const* src, bool destroy)
         {
+            // When destroying, the storage of the destroyed object is reused
+            void* buffer = storage;
             if (destroy)
                 vtable::get<T>(storage).~T();
+            else
+                buffer = vtable::allocate<T>(storage, storage_size);
 
-            void* buffer = vtable::allocate<T>(storage, storage_size);
             return ::new (buffer) T(vtable::get<T>(src));
         }
         void* (*copy)(void*, std::size_t, void const*, bool);
@@ -9,8 +9,10 @@
 #pragma once
 
 #include <pika/config.hpp>
+#include <pika/functional/detail/function_storage.hpp>
 
 #include <cstddef>
+#include <new>
 #include <type_traits>
 
 namespace pika::util::detail {
@@ -52,14 +54,53 @@ namespace pika::util::detail {
             return *reinterpret_cast<T const*>(obj);
         }
 
+        // Trivially copyable and small callables stored inline are relocated
+        // with memcpy when a function is moved. No destructor runs when such
+        // a thread function is moved by the scheduler outside of a pika
+        // thread. Larger callables, e.g. nested functions pointing into their
+        // own storage, are move constructed into the new storage and the old
+        // one is destroyed. They are only stored inline if that can't throw.
+        static constexpr std::size_t max_relocatable_size = 3 * sizeof(void*);
+
         template <typename T>
-        static void* allocate(void* storage, std::size_t storage_size)
+        static constexpr bool is_bytewise_relocatable =
+            std::is_trivially_copyable_v<T> ||
+            sizeof(T) <= max_relocatable_size;
+
+        // The alignment of the inline storage. Over-aligned callables are
+        // never stored inline.
+        static constexpr std::size_t storage_alignment = alignof(void*);
+
+        template <typename T>
+        static constexpr bool fits_storage(std::size_t storage_size) noexcept
         {
-            using storage_t = std::aligned_storage_t<sizeof(T), alignof(T)>;
+            return sizeof(T) <= storage_size &&
+                alignof(T) <= storage_alignment &&
+                (is_bytewise_relocatable<T> ||
+                    std::is_nothrow_move_constructible_v<T>);
+        }
+
+        // Over-aligned callables which don't fit the storage are allocated
+        // with new, other callables come from the function storage caches
+        template <typename T>
+        static constexpr bool use_function_storage_cache =
+            alignof(T) <= alignof(std::max_align_t);
 
-            if (sizeof(T) > storage_size)
+        template <typename T>
+        static void* allocate(void* storage, std::size_t storage_size)
+        {
+            if (!fits_storage<T>(storage_size))
             {
-                return new storage_t;
+                if constexpr (use_function_storage_cache<T>)
+                {
+                    return allocate_function_storage(sizeof(T));
+                }
+                else
+                {
+                    using storage_t =
+                        std::aligned_storage_t<sizeof(T), alignof(T)>;
+                    return new storage_t;
+                }
             }
             return storage;
         }
@@ -68,23 +109,42 @@ namespace pika::util::detail {
         static void
         _deallocate(void* obj, std::size_t storage_size, bool destroy)
         {
-            using storage_t = std::aligned_storage_t<sizeof(T), alignof(T)>;
-
             if (destroy)
             {
                 get<T>(obj).~T();
             }
 
-            if (sizeof(T) > storage_size)
+            if (!fits_storage<T>(storage_size))
             {
-                delete static_cast<storage_t*>(obj);
+                if constexpr (use_function_storage_cache<T>)
+                {
+                    deallocate_function_storage(obj, sizeof(T));
+                }
+                else
+                {
+                    using storage_t =
+                        std::aligned_storage_t<sizeof(T), alignof(T)>;
+                    delete static_cast<storage_t*>(obj);
+                }
             }
         }
         void (*deallocate)(void*, std::size_t storage_size, bool);
 
+        template <typename T>
+        static void _relocate(void* to, void* from) noexcept
+        {
+            ::new (to) T(PIKA_MOVE(get<T>(from)));
+            get<T>(from).~T();
+        }
+        // Null for callables which are relocated with memcpy
+        void (*relocate)(void* to, void* from) noexcept;
+
         template <typename T>
         constexpr vtable(construct_vtable<T>) noexcept
           : deallocate(&vtable::template _deallocate<T>)
+          , relocate(is_bytewise_relocatable<T> ?
+                    nullptr :
+                    &vtable::template _relocate<T>)
         {
         }
     };
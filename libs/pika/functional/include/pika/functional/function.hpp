@@ -18,13 +18,14 @@
 #include <utility>
 
 namespace pika::util::detail {
-    template <typename Sig>
+    template <typename Sig, std::size_t StorageSize = function_storage_size>
     class function;
 
-    template <typename R, typename... Ts>
-    class function<R(Ts...)> : public detail::basic_function<R(Ts...), true>
+    template <typename R, typename... Ts, std::size_t StorageSize>
+    class function<R(Ts...), StorageSize>
+      : public detail::basic_function<R(Ts...), true, StorageSize>
     {
-        using base_type = detail::basic_function<R(Ts...), true>;
+        using base_type = detail::basic_function<R(Ts...), true, StorageSize>;
 
     public:
         using result_type = R;
@@ -68,32 +69,32 @@ namespace pika::util::detail {
 #if defined(PIKA_HAVE_THREAD_DESCRIPTION)
 ///////////////////////////////////////////////////////////////////////////////
 namespace pika::detail {
-    template <typename Sig>
-    struct get_function_address<util::detail::function<Sig>>
+    template <typename Sig, std::size_t StorageSize>
+    struct get_function_address<util::detail::function<Sig, StorageSize>>
     {
         static constexpr std::size_t call(
-            util::detail::function<Sig> const& f) noexcept
+            util::detail::function<Sig, StorageSize> const& f) noexcept
         {
             return f.get_function_address();
         }
     };
 
-    template <typename Sig>
-    struct get_function_annotation<util::detail::function<Sig>>
+    template <typename Sig, std::size_t StorageSize>
+    struct get_function_annotation<util::detail::function<Sig, StorageSize>>
     {
         static constexpr char const* call(
-            util::detail::function<Sig> const& f) noexcept
+            util::detail::function<Sig, StorageSize> const& f) noexcept
         {
             return f.get_function_annotation();
         }
     };
 
 #if PIKA_HAVE_ITTNOTIFY != 0 && !defined(PIKA_HAVE_APEX)
-    template <typename Sig>
-    struct get_function_annotation_itt<util::detail::function<Sig>>
+    template <typename Sig, std::size_t StorageSize>
+    struct get_function_annotation_itt<util::detail::function<Sig, StorageSize>>
     {
         static util::itt::string_handle call(
-            util::detail::function<Sig> const& f) noexcept
+            util::detail::function<Sig, StorageSize> const& f) noexcept
         {
             return f.get_function_annotation_itt();
         }
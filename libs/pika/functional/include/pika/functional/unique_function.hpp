@@ -18,14 +18,14 @@
 #include <utility>
 
 namespace pika::util::detail {
-    template <typename Sig>
+    template <typename Sig, std::size_t StorageSize = function_storage_size>
     class unique_function;
 
-    template <typename R, typename... Ts>
-    class unique_function<R(Ts...)>
-      : public detail::basic_function<R(Ts...), false>
+    template <typename R, typename... Ts, std::size_t StorageSize>
+    class unique_function<R(Ts...), StorageSize>
+      : public detail::basic_function<R(Ts...), false, StorageSize>
     {
-        using base_type = detail::basic_function<R(Ts...), false>;
+        using base_type = detail::basic_function<R(Ts...), false, StorageSize>;
 
     public:
         using result_type = R;
@@ -69,32 +69,34 @@ namespace pika::util::detail {
 #if defined(PIKA_HAVE_THREAD_DESCRIPTION)
 ///////////////////////////////////////////////////////////////////////////////
 namespace pika::detail {
-    template <typename Sig>
-    struct get_function_address<util::detail::unique_function<Sig>>
+    template <typename Sig, std::size_t StorageSize>
+    struct get_function_address<util::detail::unique_function<Sig, StorageSize>>
     {
         static constexpr std::size_t call(
-            util::detail::unique_function<Sig> const& f) noexcept
+            util::detail::unique_function<Sig, StorageSize> const& f) noexcept
         {
             return f.get_function_address();
         }
     };
 
-    template <typename Sig>
-    struct get_function_annotation<util::detail::unique_function<Sig>>
+    template <typename Sig, std::size_t StorageSize>
+    struct get_function_annotation<
+        util::detail::unique_function<Sig, StorageSize>>
     {
         static constexpr char const* call(
-            util::detail::unique_function<Sig> const& f) noexcept
+            util::detail::unique_function<Sig, StorageSize> const& f) noexcept
         {
             return f.get_function_annotation();
         }
     };
 
 #if PIKA_HAVE_ITTNOTIFY != 0 && !defined(PIKA_HAVE_APEX)
-    template <typename Sig>
-    struct get_function_annotation_itt<util::detail::unique_function<Sig>>
+    template <typename Sig, std::size_t StorageSize>
+    struct get_function_annotation_itt<
+        util::detail::unique_function<Sig, StorageSize>>
     {
         static util::itt::string_handle call(
-            util::detail::unique_function<Sig> const& f) noexcept
+            util::detail::unique_function<Sig, StorageSize> const& f) noexcept
         {
             return f.get_function_annotation_itt();
         }
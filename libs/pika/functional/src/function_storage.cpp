@@ -0,0 +1,244 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+#include <pika/functional/detail/function_storage.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pika::util::detail {
+    namespace {
+        // Blocks of 32, 64, 128, 256, and 512 bytes are cached
+        constexpr std::size_t num_size_classes = 5;
+        constexpr std::size_t min_block_size = 32;
+        constexpr std::size_t max_block_size = min_block_size
+            << (num_size_classes - 1);
+        constexpr std::size_t max_cached_blocks = 64;
+
+        struct free_block
+        {
+            free_block* next;
+        };
+
+        struct storage_cache
+        {
+            free_block* blocks[num_size_classes] = {};
+            std::size_t num_blocks[num_size_classes] = {};
+
+            ~storage_cache();
+        };
+
+        // Set once the cache of the current thread has been destroyed.
+        // Functions destroyed by thread-local or static destructors running
+        // after that bypass the cache.
+        thread_local bool cache_destroyed = false;
+
+        storage_cache::~storage_cache()
+        {
+            for (free_block* block : blocks)
+            {
+                while (block != nullptr)
+                {
+                    free_block* next = block->next;
+                    ::operator delete(block);
+                    block = next;
+                }
+            }
+            cache_destroyed = true;
+        }
+
+        storage_cache* get_storage_cache() noexcept
+        {
+            if (cache_destroyed)
+            {
+                return nullptr;
+            }
+
+            thread_local storage_cache cache;
+            return &cache;
+        }
+
+        constexpr std::size_t get_size_class(std::size_t size) noexcept
+        {
+            std::size_t size_class = 0;
+            for (std::size_t block_size = min_block_size; block_size < size;
+                 block_size <<= 1)
+            {
+                ++size_class;
+            }
+            return size_class;
+        }
+    }    // namespace
+
+    void* allocate_function_storage(std::size_t size)
+    {
+        if (size > max_block_size)
+        {
+            return ::operator new(size);
+        }
+
+        std::size_t const size_class = get_size_class(size);
+        if (storage_cache* cache = get_storage_cache();
+            cache != nullptr && cache->blocks[size_class] != nullptr)
+        {
+            free_block* block = cache->blocks[size_class];
+            cache->blocks[size_class] = block->next;
+            --cache->num_blocks[size_class];
+            return block;
+        }
+
+        return ::operator new(min_block_size << size_class);
+    }
+
+    void deallocate_function_storage(void* p, std::size_t size) noexcept
+    {
+        if (size <= max_block_size)
+        {
+            std::size_t const size_class = get_size_class(size);
+            if (storage_cache* cache = get_storage_cache(); cache != nullptr &&
+                cache->num_blocks[size_class] < max_cached_blocks)
+            {
+                cache->blocks[size_class] =
+                    ::new (p) free_block{cache->blocks[size_class]};
+                ++cache->num_blocks[size_class];
+                return;
+            }
+        }
+
+        ::operator delete(p);
+    }
+
+#if defined(PIKA_HAVE_FUNCTION_STORAGE_COUNTERS)
+    namespace {
+        struct miss_counter
+        {
+            std::string annotation;
+            std::uint64_t count = 0;
+            std::size_t max_size = 0;
+        };
+
+        // Each thread counts its misses in its own table. The counters are
+        // keyed by the address of the annotation, and the annotation is
+        // copied when it is first seen. The mutex of a table is only
+        // contended while the misses are read or reset.
+        struct miss_counters
+        {
+            std::mutex mtx;
+            std::unordered_map<char const*, miss_counter> counters;
+        };
+
+        // The tables of all threads which have counted a miss. The tables
+        // are intentionally leaked, so that the misses of threads which have
+        // exited are kept, and since functions may be created during static
+        // destruction.
+        struct miss_counters_registry
+        {
+            std::mutex mtx;
+            std::vector<miss_counters*> threads;
+        };
+
+        miss_counters_registry& get_miss_counters_registry()
+        {
+            static miss_counters_registry* registry =
+                new miss_counters_registry;
+            return *registry;
+        }
+
+        miss_counters& get_miss_counters()
+        {
+            thread_local miss_counters* counters = [] {
+                auto& registry = get_miss_counters_registry();
+                std::lock_guard<std::mutex> l(registry.mtx);
+                registry.threads.reserve(registry.threads.size() + 1);
+                return registry.threads.emplace_back(new miss_counters);
+            }();
+            return *counters;
+        }
+    }    // namespace
+
+    void record_function_storage_miss(
+        char const* annotation, std::size_t size) noexcept
+    {
+        try
+        {
+            auto& counters = get_miss_counters();
+            std::lock_guard<std::mutex> l(counters.mtx);
+            auto [it, inserted] = counters.counters.try_emplace(annotation);
+            if (inserted)
+            {
+                it->second.annotation =
+                    annotation != nullptr ? annotation : "<unknown>";
+            }
+            ++it->second.count;
+            it->second.max_size = (std::max)(it->second.max_size, size);
+        }
+        catch (...)
+        {
+            // Counting is best-effort
+        }
+    }
+#endif
+}    // namespace pika::util::detail
+
+namespace pika::util {
+    std::vector<function_storage_miss> get_function_storage_misses()
+    {
+        std::vector<function_storage_miss> misses;
+#if defined(PIKA_HAVE_FUNCTION_STORAGE_COUNTERS)
+        {
+            // Different addresses may hold the same annotation
+            std::map<std::string, function_storage_miss> merged;
+            auto& registry = detail::get_miss_counters_registry();
+            std::lock_guard<std::mutex> l(registry.mtx);
+            for (auto* counters : registry.threads)
+            {
+                std::lock_guard<std::mutex> lc(counters->mtx);
+                for (auto const& [_, counter] : counters->counters)
+                {
+                    auto& miss = merged[counter.annotation];
+                    miss.annotation = counter.annotation;
+                    miss.count += counter.count;
+                    miss.max_size = (std::max)(miss.max_size, counter.max_size);
+                }
+            }
+
+            misses.reserve(merged.size());
+            for (auto& [_, miss] : merged)
+            {
+                misses.push_back(PIKA_MOVE(miss));
+            }
+        }
+
+        std::stable_sort(misses.begin(), misses.end(),
+            [](function_storage_miss const& a, function_storage_miss const& b) {
+                return a.count > b.count;
+            });
+#endif
+        return misses;
+    }
+
+    void reset_function_storage_misses()
+    {
+#if defined(PIKA_HAVE_FUNCTION_STORAGE_COUNTERS)
+        auto& registry = detail::get_miss_counters_registry();
+        std::lock_guard<std::mutex> l(registry.mtx);
+        for (auto* counters : registry.threads)
+        {
+            std::lock_guard<std::mutex> lc(counters->mtx);
+            counters->counters.clear();
+        }
+#endif
+    }
+}    // namespace pika::util
@@ -0,0 +1,333 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that callables are stored inline when they fit the
+// storage size of a function, that inline callables are relocated correctly
+// when functions are moved, that larger callables are allocated from the
+// function storage caches, and that such allocations are counted.
+
+#include <pika/modules/functional.hpp>
+#include <pika/testing.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+using pika::util::detail::function;
+using pika::util::detail::unique_function;
+
+template <std::size_t N>
+struct sized_callable
+{
+    std::array<std::uint8_t, N> data{};
+
+    std::size_t operator()() const
+    {
+        return data.size();
+    }
+};
+
+// A callable which is not trivially copyable, larger than three pointers, and
+// which checks that it is called at the address it was constructed at
+struct self_checking_callable
+{
+    static inline std::size_t num_moved = 0;
+    static inline std::size_t num_destroyed = 0;
+
+    self_checking_callable const* self = this;
+    std::array<std::size_t, 4> data{{1, 2, 3, 4}};
+
+    self_checking_callable() = default;
+
+    self_checking_callable(self_checking_callable const& other) noexcept
+      : data(other.data)
+    {
+    }
+
+    self_checking_callable(self_checking_callable&& other) noexcept
+      : data(other.data)
+    {
+        ++num_moved;
+    }
+
+    self_checking_callable& operator=(self_checking_callable const&) = delete;
+    self_checking_callable& operator=(self_checking_callable&&) = delete;
+
+    ~self_checking_callable()
+    {
+        ++num_destroyed;
+    }
+
+    std::size_t operator()() const
+    {
+        PIKA_TEST_EQ(self, this);
+        return data[0] + data[1] + data[2] + data[3];
+    }
+};
+
+template <std::size_t Alignment>
+struct alignas(Alignment) over_aligned_callable
+{
+    std::array<std::uint8_t, Alignment> data{};
+
+    std::size_t operator()() const
+    {
+        return data.size();
+    }
+};
+
+template <typename Function, typename T>
+bool is_stored_inline(Function& f)
+{
+    auto const* p = reinterpret_cast<char const*>(f.template target<T>());
+    auto const* begin = reinterpret_cast<char const*>(&f);
+    return p >= begin && p < begin + sizeof(Function);
+}
+
+void test_storage_size()
+{
+    using pika::util::detail::function_storage_size;
+
+    {
+        using small_type = sized_callable<function_storage_size>;
+        unique_function<std::size_t()> f = small_type{};
+        PIKA_TEST((is_stored_inline<decltype(f), small_type>(f)));
+        PIKA_TEST_EQ(f(), function_storage_size);
+    }
+
+    {
+        using big_type = sized_callable<function_storage_size + 1>;
+        unique_function<std::size_t()> f = big_type{};
+        PIKA_TEST((!is_stored_inline<decltype(f), big_type>(f)));
+        PIKA_TEST_EQ(f(), function_storage_size + 1);
+
+        // the same callable fits a function with more storage
+        constexpr std::size_t storage_size = 2 * function_storage_size;
+        unique_function<std::size_t(), storage_size> g = big_type{};
+        PIKA_TEST((is_stored_inline<decltype(g), big_type>(g)));
+        PIKA_TEST_EQ(g(), function_storage_size + 1);
+        static_assert(sizeof(g) > sizeof(f));
+
+        auto h = std::move(g);
+        PIKA_TEST(g.empty());
+        PIKA_TEST((is_stored_inline<decltype(h), big_type>(h)));
+        PIKA_TEST_EQ(h(), function_storage_size + 1);
+    }
+
+    {
+        using big_type = sized_callable<100>;
+        function<std::size_t(), 128> f = big_type{};
+        function<std::size_t(), 128> g = f;
+        PIKA_TEST((is_stored_inline<decltype(g), big_type>(g)));
+        PIKA_TEST_EQ(f(), std::size_t(100));
+        PIKA_TEST_EQ(g(), std::size_t(100));
+    }
+}
+
+void test_relocation()
+{
+    // Small and trivially copyable inline callables are relocated bytewise
+    // when a function is moved. Other callables, e.g. functions which point
+    // into their own storage, are move constructed into the new storage.
+    using inner_type = unique_function<std::size_t()>;
+    using outer_type = unique_function<std::size_t(), sizeof(inner_type)>;
+
+    outer_type f = inner_type(sized_callable<8>{});
+    PIKA_TEST((is_stored_inline<outer_type, inner_type>(f)));
+
+    outer_type g = std::move(f);
+    PIKA_TEST(f.empty());
+    PIKA_TEST_EQ(g(), std::size_t(8));
+
+    outer_type h = inner_type(sized_callable<16>{});
+    g.swap(h);
+    PIKA_TEST_EQ(g(), std::size_t(16));
+    PIKA_TEST_EQ(h(), std::size_t(8));
+
+    f = sized_callable<4>{};
+    f.swap(g);
+    PIKA_TEST_EQ(f(), std::size_t(16));
+    PIKA_TEST_EQ(g(), std::size_t(4));
+
+    using trivial_type = sized_callable<sizeof(inner_type)>;
+    outer_type i = trivial_type{};
+    PIKA_TEST((is_stored_inline<outer_type, trivial_type>(i)));
+    i.swap(f);
+    PIKA_TEST_EQ(f(), sizeof(inner_type));
+    PIKA_TEST_EQ(i(), std::size_t(16));
+
+    outer_type j = [s = std::string("abc")]() { return s.size(); };
+    outer_type k = std::move(j);
+    j = std::move(k);
+    PIKA_TEST_EQ(j(), std::size_t(3));
+}
+
+void test_move_relocation()
+{
+    using callable_type = self_checking_callable;
+    static_assert(!std::is_trivially_copyable_v<callable_type>);
+    static_assert(sizeof(callable_type) > 3 * sizeof(void*));
+
+    constexpr std::size_t storage_size = 8 * sizeof(void*);
+    using function_type = function<std::size_t(), storage_size>;
+    using unique_function_type = unique_function<std::size_t(), storage_size>;
+
+    callable_type::num_moved = 0;
+    callable_type::num_destroyed = 0;
+    {
+        unique_function_type f = callable_type{};
+        PIKA_TEST((is_stored_inline<unique_function_type, callable_type>(f)));
+        PIKA_TEST_EQ(f(), std::size_t(10));
+
+        // moving relocates the callable with its move constructor, and
+        // destroys the moved-from callable
+        std::size_t const num_moved = callable_type::num_moved;
+        std::size_t const num_destroyed = callable_type::num_destroyed;
+        unique_function_type g = std::move(f);
+        PIKA_TEST(f.empty());
+        PIKA_TEST((is_stored_inline<unique_function_type, callable_type>(g)));
+        PIKA_TEST_EQ(g(), std::size_t(10));
+        PIKA_TEST_EQ(callable_type::num_moved, num_moved + 1);
+        PIKA_TEST_EQ(callable_type::num_destroyed, num_destroyed + 1);
+
+        // swapping two inline callables and an inline callable with an empty
+        // function
+        unique_function_type h = callable_type{};
+        g.swap(h);
+        PIKA_TEST_EQ(g(), std::size_t(10));
+        PIKA_TEST_EQ(h(), std::size_t(10));
+        f.swap(g);
+        PIKA_TEST(g.empty());
+        PIKA_TEST_EQ(f(), std::size_t(10));
+
+        h = std::move(f);
+        PIKA_TEST_EQ(h(), std::size_t(10));
+
+        function_type i = callable_type{};
+        function_type j = i;
+        function_type k = std::move(i);
+        PIKA_TEST((is_stored_inline<function_type, callable_type>(j)));
+        PIKA_TEST((is_stored_inline<function_type, callable_type>(k)));
+        PIKA_TEST_EQ(j(), std::size_t(10));
+        PIKA_TEST_EQ(k(), std::size_t(10));
+    }
+
+    // every callable which has been constructed has been destroyed
+    PIKA_TEST_EQ(callable_type::num_destroyed,
+        callable_type::num_moved + std::size_t(4));
+}
+
+template <std::size_t Alignment>
+void test_over_aligned()
+{
+    // Callables which are aligned more strictly than the inline storage are
+    // allocated separately, even if they would fit
+    using callable_type = over_aligned_callable<Alignment>;
+    constexpr std::size_t storage_size = 2 * sizeof(callable_type);
+
+    unique_function<std::size_t(), storage_size> f = callable_type{};
+    PIKA_TEST((!is_stored_inline<decltype(f), callable_type>(f)));
+    PIKA_TEST_EQ(
+        reinterpret_cast<std::uintptr_t>(f.template target<callable_type>()) %
+            Alignment,
+        std::uintptr_t(0));
+    PIKA_TEST_EQ(f(), Alignment);
+
+    auto g = std::move(f);
+    PIKA_TEST_EQ(g(), Alignment);
+
+    function<std::size_t(), storage_size> h = callable_type{};
+    function<std::size_t(), storage_size> i = h;
+    PIKA_TEST_EQ(
+        reinterpret_cast<std::uintptr_t>(i.template target<callable_type>()) %
+            Alignment,
+        std::uintptr_t(0));
+    PIKA_TEST_EQ(i(), Alignment);
+}
+
+void test_storage_cache()
+{
+    using pika::util::detail::allocate_function_storage;
+    using pika::util::detail::deallocate_function_storage;
+
+    // freed blocks are reused for callables of the same size class
+    void* p = allocate_function_storage(40);
+    deallocate_function_storage(p, 40);
+    void* q = allocate_function_storage(50);
+    PIKA_TEST_EQ(p, q);
+    deallocate_function_storage(q, 50);
+
+    // large callables are not cached
+    void* r = allocate_function_storage(4096);
+    PIKA_TEST_NEQ(r, nullptr);
+    deallocate_function_storage(r, 4096);
+
+    // callables in the cached size classes can be copied and destroyed in
+    // any order
+    for (int i = 0; i < 200; ++i)
+    {
+        function<std::size_t()> f = sized_callable<64>{};
+        function<std::size_t()> g = sized_callable<300>{};
+        function<std::size_t()> h = f;
+        f = g;
+        PIKA_TEST_EQ(f(), std::size_t(300));
+        PIKA_TEST_EQ(h(), std::size_t(64));
+    }
+}
+
+void test_storage_counters()
+{
+    using pika::util::detail::function_storage_size;
+    using big_type = sized_callable<function_storage_size + 8>;
+
+    pika::util::reset_function_storage_misses();
+    {
+        unique_function<std::size_t()> f1 = sized_callable<8>{};
+        unique_function<std::size_t()> f2 = big_type{};
+        unique_function<std::size_t()> f3 = big_type{};
+        unique_function<std::size_t(), 2 * function_storage_size> f4 =
+            big_type{};
+    }
+
+    // misses are counted per thread and merged when read
+    std::thread t([] {
+        for (int i = 0; i < 3; ++i)
+        {
+            unique_function<std::size_t()> f = big_type{};
+        }
+    });
+    t.join();
+
+    auto misses = pika::util::get_function_storage_misses();
+#if defined(PIKA_HAVE_FUNCTION_STORAGE_COUNTERS)
+    PIKA_TEST_EQ(misses.size(), std::size_t(1));
+    PIKA_TEST_EQ(misses[0].annotation, std::string("<unknown>"));
+    PIKA_TEST_EQ(misses[0].count, std::uint64_t(5));
+    PIKA_TEST_EQ(misses[0].max_size, sizeof(big_type));
+
+    pika::util::reset_function_storage_misses();
+    PIKA_TEST(pika::util::get_function_storage_misses().empty());
+#else
+    PIKA_TEST(misses.empty());
+#endif
+}
+
+int main()
+{
+    test_storage_size();
+    test_relocation();
+    test_move_relocation();
+    test_over_aligned<16>();
+    test_over_aligned<32>();
+    test_storage_cache();
+    test_storage_counters();
+
+    return pika::util::report_errors();
+}
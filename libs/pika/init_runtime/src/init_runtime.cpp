@@ -24,6 +24,7 @@
 #include <pika/modules/logging.hpp>
 #include <pika/modules/schedulers.hpp>
 #include <pika/modules/timing.hpp>
+#include <pika/program_options/options_description.hpp>
 #include <pika/program_options/parsers.hpp>
 #include <pika/program_options/variables_map.hpp>
 #include <pika/resource_partitioner/partitioner.hpp>
@@ -49,6 +50,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <cstdlib>
 #include <exception>
 #include <functional>
 #include <iostream>
@@ -143,6 +145,76 @@ namespace pika {
         return 0;
     }
 
+    namespace detail {
+        // The state needed to restart a runtime which has been parked by
+        // pika::stop with pika.warm_restart enabled.
+        struct parked_runtime_data
+        {
+            std::string key;
+            pika::program_options::variables_map vm;
+        };
+
+        parked_runtime_data& get_parked_runtime_data()
+        {
+            static parked_runtime_data data;
+            return data;
+        }
+
+        // A parked runtime is only reused if it would have been created with
+        // exactly the same arguments. The command line description is
+        // compared by the options it describes, not by its address. The
+        // resource partitioner callback can't be compared, a parked runtime
+        // keeps the pools created by the first callback.
+        std::string make_warm_restart_key(
+            int argc, const char* const* argv, init_params const& params)
+        {
+            std::ostringstream key;
+            for (int i = 0; i != argc; ++i)
+            {
+                key << argv[i] << '\0';
+            }
+            key << '\0';
+            for (std::string const& cfg : params.cfg)
+            {
+                key << cfg << '\0';
+            }
+            key << '\0' << params.rp_mode << '\0' << !!params.rp_callback
+                << '\0' << params.desc_cmdline.get();
+            return key.str();
+        }
+
+        bool warm_restart_enabled(pika::runtime& rt)
+        {
+            return pika::detail::get_entry_as<bool>(
+                rt.get_config(), "pika.warm_restart", false);
+        }
+
+        void stop_parked_runtime(pika::runtime* p)
+        {
+            std::unique_ptr<runtime> rt(p);    // take ownership!
+            get_parked_runtime_data() = parked_runtime_data{};
+
+            rt->unpark();
+            rt->stop();
+        }
+
+        void stop_parked_runtime_at_exit()
+        {
+            pika::runtime* rt = get_runtime_ptr();
+            if (rt != nullptr && rt->is_parked())
+            {
+                try
+                {
+                    stop_parked_runtime(rt);
+                }
+                catch (...)
+                {
+                    // nothing we can do at this point
+                }
+            }
+        }
+    }    // namespace detail
+
     int stop(error_code& ec)
     {
         if (threads::detail::get_self_ptr())
@@ -161,8 +233,26 @@ namespace pika {
             return -1;
         }
 
+        // stopping a parked runtime tears it down for good
+        if (rt->is_parked())
+        {
+            detail::stop_parked_runtime(rt.release());
+            return 0;
+        }
+
         int result = rt->wait();
 
+        if (detail::warm_restart_enabled(*rt) && rt->park())
+        {
+            // a runtime which is never started again is stopped at exit
+            static bool const registered =
+                std::atexit(&detail::stop_parked_runtime_at_exit) == 0;
+            PIKA_UNUSED(registered);
+
+            rt.release();
+            return result;
+        }
+
         rt->stop();
         rt->rethrow_exception();
 
@@ -217,8 +307,53 @@ namespace pika {
     namespace detail {
 
         ///////////////////////////////////////////////////////////////////////
+        // Disable capturing exception info for the errors listed in
+        // pika.exception_info_disabled.
+        void init_exception_info_enabled(
+            pika::util::runtime_configuration const& rtcfg)
+        {
+            for (int e = 0; e != static_cast<int>(pika::error::last_error); ++e)
+            {
+                set_exception_info_enabled(static_cast<pika::error>(e), true);
+            }
+
+            std::vector<std::string> names;
+            pika::string_util::split(names,
+                rtcfg.get_entry("pika.exception_info_disabled", ""),
+                pika::string_util::is_any_of(", "),
+                pika::string_util::token_compress_mode::on);
+
+            for (auto const& name : names)
+            {
+                if (name.empty())
+                {
+                    continue;
+                }
+
+                int e = 0;
+                while (e != static_cast<int>(pika::error::last_error) &&
+                    name != error_names[e])
+                {
+                    ++e;
+                }
+
+                if (e == static_cast<int>(pika::error::last_error))
+                {
+                    PIKA_THROW_EXCEPTION(pika::error::bad_parameter,
+                        "init_exception_info_enabled",
+                        "unknown error name in pika.exception_info_disabled: "
+                        "{}",
+                        name);
+                }
+
+                set_exception_info_enabled(static_cast<pika::error>(e), false);
+            }
+        }
+
         void activate_global_options(detail::command_line_handling& cmdline)
         {
+            init_exception_info_enabled(cmdline.rtcfg_);
+
 #if defined(__linux) || defined(linux) || defined(__linux__) ||                \
     defined(__FreeBSD__)
             threads::coroutines::detail::posix::use_guard_pages =
@@ -328,7 +463,8 @@ namespace pika {
             detail::command_line_handling& cfg, startup_function_type startup,
             shutdown_function_type shutdown)
         {
-            if (blocking)
+            bool const warm_restart = warm_restart_enabled(*rt);
+            if (blocking && !warm_restart)
             {
                 return run(*rt, cfg.pika_main_f_, cfg.vm_, PIKA_MOVE(startup),
                     PIKA_MOVE(shutdown));
@@ -342,6 +478,43 @@ namespace pika {
             pika::runtime* p = rt.release();
             (void) p;
 
+            // pika::stop parks the runtime instead of destroying it
+            if (blocking)
+            {
+                return pika::stop();
+            }
+
+            return 0;
+        }
+
+        int restart_parked_runtime(pika::runtime& rt,
+            util::detail::function<int(
+                pika::program_options::variables_map& vm)> const& f,
+            init_params const& params, bool blocking)
+        {
+            LPROGRESS_ << "restarting parked runtime";
+
+            pika::program_options::variables_map& vm =
+                get_parked_runtime_data().vm;
+
+            add_startup_functions(
+                rt, vm, PIKA_MOVE(params.startup), PIKA_MOVE(params.shutdown));
+
+            if (!f.empty())
+            {
+                rt.restart(util::detail::bind_front(f, vm));
+            }
+            else
+            {
+                rt.restart(util::detail::function<
+                    pika::runtime::pika_main_function_type>{});
+            }
+
+            if (blocking)
+            {
+                return pika::stop();
+            }
+
             return 0;
         }
 
@@ -426,6 +599,22 @@ namespace pika {
             int result = 0;
             try
             {
+                std::string warm_restart_key =
+                    make_warm_restart_key(argc, argv, params);
+
+                pika::runtime* parked = get_runtime_ptr();
+                if (parked != nullptr && parked->is_parked())
+                {
+                    if (get_parked_runtime_data().key == warm_restart_key)
+                    {
+                        return restart_parked_runtime(
+                            *parked, f, params, blocking);
+                    }
+
+                    // the configuration has changed, start from scratch
+                    stop_parked_runtime(parked);
+                }
+
                 if ((result = ensure_no_runtime_is_up()) != 0)
                 {
                     return result;
@@ -502,6 +691,12 @@ namespace pika {
                 LPROGRESS_ << "creating local runtime";
                 rt.reset(new pika::runtime(cmdline.rtcfg_, true));
 
+                if (warm_restart_enabled(*rt))
+                {
+                    get_parked_runtime_data() = parked_runtime_data{
+                        PIKA_MOVE(warm_restart_key), cmdline.vm_};
+                }
+
                 result = run_or_start(blocking, PIKA_MOVE(rt), cmdline,
                     PIKA_MOVE(params.startup), PIKA_MOVE(params.shutdown));
             }
@@ -0,0 +1,134 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that pika::stop parks the runtime when warm restarts are
+// enabled, that a following start with the same arguments reuses the parked
+// runtime, and that a start with different arguments creates a new one. A
+// runtime suspended with pika::suspend is not parked.
+
+#include <pika/execution.hpp>
+#include <pika/future.hpp>
+#include <pika/init.hpp>
+#include <pika/program_options.hpp>
+#include <pika/runtime.hpp>
+#include <pika/runtime/config_entry.hpp>
+#include <pika/testing.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+std::size_t startup_count = 0;
+std::size_t shutdown_count = 0;
+std::size_t main_count = 0;
+std::string expected_value;
+
+int pika_main()
+{
+    ++main_count;
+    PIKA_TEST_EQ(pika::get_config_entry("pika.warm_restart_test", ""),
+        expected_value);
+
+    tt::sync_wait(ex::schedule(ex::thread_pool_scheduler{}) |
+        ex::then([] { return 42; }));
+
+    return pika::finalize();
+}
+
+pika::program_options::options_description make_desc_cmdline()
+{
+    pika::program_options::options_description desc("Usage: warm_restart");
+    desc.add_options()("test-option", "an option only used by this test");
+    return desc;
+}
+
+pika::init_params make_init_params(std::string const& value,
+    pika::program_options::options_description const& desc_cmdline)
+{
+    pika::init_params init_args;
+    init_args.desc_cmdline = desc_cmdline;
+    init_args.cfg = {
+        "pika.warm_restart!=1", "pika.warm_restart_test!=" + value};
+    init_args.startup = [] { ++startup_count; };
+    init_args.shutdown = [] { ++shutdown_count; };
+    return init_args;
+}
+
+int main(int argc, char* argv[])
+{
+    expected_value = "1";
+
+    auto const desc_cmdline = make_desc_cmdline();
+    PIKA_TEST(pika::start(
+        pika_main, argc, argv, make_init_params(expected_value, desc_cmdline)));
+    pika::runtime* rt = pika::get_runtime_ptr();
+    PIKA_TEST_EQ(pika::stop(), 0);
+
+    // the runtime is parked instead of destroyed
+    PIKA_TEST_EQ(pika::get_runtime_ptr(), rt);
+    PIKA_TEST(rt->is_parked());
+    PIKA_TEST(!pika::is_running());
+
+    // a command line description with the same options reuses the parked
+    // runtime even if it is a different object
+    for (std::size_t i = 0; i != 3; ++i)
+    {
+        auto const other_desc_cmdline = make_desc_cmdline();
+        PIKA_TEST(pika::start(pika_main, argc, argv,
+            make_init_params(expected_value, other_desc_cmdline)));
+        PIKA_TEST_EQ(pika::get_runtime_ptr(), rt);
+        PIKA_TEST_EQ(pika::stop(), 0);
+        PIKA_TEST(rt->is_parked());
+    }
+
+    // a suspended runtime is not parked
+    PIKA_TEST(pika::start(nullptr, argc, argv,
+        make_init_params(expected_value, desc_cmdline)));
+    PIKA_TEST_EQ(pika::get_runtime_ptr(), rt);
+    PIKA_TEST(!rt->is_parked());
+    PIKA_TEST_EQ(pika::suspend(), 0);
+    PIKA_TEST(!rt->is_parked());
+    PIKA_TEST_EQ(pika::resume(), 0);
+    pika::apply([]() { pika::finalize(); });
+    PIKA_TEST_EQ(pika::stop(), 0);
+    PIKA_TEST(rt->is_parked());
+
+    // blocking initialization reuses the parked runtime as well
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv,
+                     make_init_params(expected_value, desc_cmdline)),
+        0);
+    PIKA_TEST_EQ(pika::get_runtime_ptr(), rt);
+    PIKA_TEST(rt->is_parked());
+
+    PIKA_TEST_EQ(main_count, std::size_t(5));
+    PIKA_TEST_EQ(startup_count, std::size_t(6));
+    PIKA_TEST_EQ(shutdown_count, std::size_t(6));
+
+    // different arguments create a new runtime
+    expected_value = "2";
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv,
+                     make_init_params(expected_value, desc_cmdline)),
+        0);
+    PIKA_TEST(pika::get_runtime_ptr()->is_parked());
+    PIKA_TEST_EQ(main_count, std::size_t(6));
+
+    // a different command line description creates a new runtime
+    pika::program_options::options_description other_desc_cmdline(
+        "Usage: warm_restart");
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv,
+                     make_init_params(expected_value, other_desc_cmdline)),
+        0);
+    PIKA_TEST(pika::get_runtime_ptr()->is_parked());
+    PIKA_TEST_EQ(main_count, std::size_t(7));
+
+    // stopping a parked runtime destroys it
+    PIKA_TEST_EQ(pika::stop(), 0);
+    PIKA_TEST(pika::get_runtime_ptr() == nullptr);
+
+    return pika::util::report_errors();
+}
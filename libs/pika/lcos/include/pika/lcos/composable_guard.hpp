@@ -129,6 +129,22 @@ namespace pika::lcos::local {
         PIKA_EXPORT void free(guard_task* task);
 
         using guard_function = util::detail::unique_function<void()>;
+
+        // A link in the list of tasks attached
+        // to a guard
+        struct guard_task : detail::debug_object
+        {
+            guard_atomic next;
+            detail::guard_function run;
+            bool const single_guard;
+
+            explicit guard_task(bool sg = true)
+              : next(nullptr)
+              , run()
+              , single_guard(sg)
+            {
+            }
+        };
     }    // namespace detail
 
     class guard : public detail::debug_object
@@ -181,6 +197,16 @@ namespace pika::lcos::local {
             guard_set& guards, detail::guard_function task);
     };
 
+    namespace detail {
+        // Enqueue a task which is owned by the caller, e.g. a task embedded
+        // in an operation state. The task must not be a single_guard task.
+        // task->run is called once the guard has been acquired. The guard
+        // has to be released with release_guard, after which the task is no
+        // longer referenced by the guard and is never deleted by it.
+        PIKA_EXPORT void acquire_guard(guard& g, guard_task* task);
+        PIKA_EXPORT void release_guard(guard& g, guard_task* task);
+    }    // namespace detail
+
     /// Conceptually, a guard acts like a mutex on an asynchronous task. The
     /// mutex is locked before the task runs, and unlocked afterwards.
     PIKA_EXPORT void run_guarded(guard& guard, detail::guard_function task);
@@ -0,0 +1,379 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/concepts/concepts.hpp>
+#include <pika/datastructures/variant.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/functional/bind_front.hpp>
+#include <pika/functional/detail/tag_fallback_invoke.hpp>
+#include <pika/functional/invoke_fused.hpp>
+#include <pika/lcos/composable_guard.hpp>
+#include <pika/type_support/pack.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pika::lcos::local {
+    namespace on_guard_detail {
+        template <typename Sender, std::size_t N>
+        struct on_guard_sender_impl
+        {
+            struct on_guard_sender_type;
+        };
+
+        template <typename Sender, std::size_t N>
+        using on_guard_sender =
+            typename on_guard_sender_impl<Sender, N>::on_guard_sender_type;
+
+        template <typename Sender, std::size_t N>
+        struct on_guard_sender_impl<Sender, N>::on_guard_sender_type
+        {
+            PIKA_NO_UNIQUE_ADDRESS std::decay_t<Sender> sender;
+
+            // The guards are always acquired in the order of their addresses
+            // to avoid deadlocks. This is the same order as used by
+            // guard_set.
+            std::array<guard*, N> guards;
+
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+            template <typename... Ts>
+            using decayed_value_signature =
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_value_t(
+                        std::decay_t<Ts>...)>;
+
+            template <typename E>
+            using decayed_error_signature =
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_error_t(
+                        std::decay_t<E>)>;
+
+            using completion_signatures =
+                pika::execution::experimental::make_completion_signatures<
+                    std::decay_t<Sender>,
+                    pika::execution::experimental::detail::empty_env,
+                    pika::execution::experimental::completion_signatures<>,
+                    decayed_value_signature, decayed_error_signature>;
+#else
+            template <typename Tuple>
+            struct decay_tuple;
+
+            template <template <typename...> class Tuple, typename... Ts>
+            struct decay_tuple<Tuple<Ts...>>
+            {
+                using type = Tuple<std::decay_t<Ts>...>;
+            };
+
+            template <template <typename...> class Tuple,
+                template <typename...> class Variant>
+            using value_types =
+                pika::util::detail::unique_t<pika::util::detail::transform_t<
+                    typename pika::execution::experimental::sender_traits<
+                        Sender>::template value_types<Tuple, Variant>,
+                    decay_tuple>>;
+
+            template <template <typename...> class Variant>
+            using error_types =
+                pika::util::detail::unique_t<pika::util::detail::transform_t<
+                    typename pika::execution::experimental::sender_traits<
+                        Sender>::template error_types<Variant>,
+                    std::decay>>;
+
+            static constexpr bool sends_done =
+                pika::execution::experimental::sender_traits<
+                    Sender>::sends_done;
+#endif
+
+            template <typename Sender_>
+            on_guard_sender_type(Sender_&& sender, std::array<guard*, N> gs)
+              : sender(PIKA_FORWARD(Sender_, sender))
+              , guards(gs)
+            {
+                std::sort(guards.begin(), guards.end(), std::less<>{});
+            }
+
+            on_guard_sender_type(on_guard_sender_type&&) = default;
+            on_guard_sender_type& operator=(on_guard_sender_type&&) = default;
+            on_guard_sender_type(on_guard_sender_type const&) = default;
+            on_guard_sender_type& operator=(
+                on_guard_sender_type const&) = default;
+
+            template <typename Receiver>
+            struct operation_state
+            {
+                struct on_guard_receiver
+                {
+                    operation_state& op_state;
+
+                    template <typename Error>
+                    friend void
+                    tag_invoke(pika::execution::experimental::set_error_t,
+                        on_guard_receiver&& r, Error&& error) noexcept
+                    {
+                        using error_type = error_result<std::decay_t<Error>>;
+                        r.op_state.result.template emplace<error_type>(
+                            error_type{PIKA_FORWARD(Error, error)});
+                        r.op_state.release();
+                    }
+
+                    friend void tag_invoke(
+                        pika::execution::experimental::set_stopped_t,
+                        on_guard_receiver&& r) noexcept
+                    {
+                        r.op_state.result.template emplace<stopped_result>();
+                        r.op_state.release();
+                    }
+
+                    template <typename... Ts>
+                    friend void
+                    tag_invoke(pika::execution::experimental::set_value_t,
+                        on_guard_receiver&& r, Ts&&... ts) noexcept
+                    {
+                        r.op_state.result.template emplace<
+                            std::tuple<std::decay_t<Ts>...>>(
+                            PIKA_FORWARD(Ts, ts)...);
+                        r.op_state.release();
+                    }
+
+                    friend constexpr pika::execution::experimental::detail::
+                        empty_env
+                        tag_invoke(pika::execution::experimental::get_env_t,
+                            on_guard_receiver const&) noexcept
+                    {
+                        return {};
+                    }
+                };
+
+                template <typename Error>
+                struct error_result
+                {
+                    Error error;
+                };
+
+                struct stopped_result
+                {
+                };
+
+#if defined(PIKA_HAVE_P2300_REFERENCE_IMPLEMENTATION)
+                template <template <typename...> class Variant>
+                using predecessor_error_types =
+                    pika::execution::experimental::error_types_of_t<Sender,
+                        pika::execution::experimental::detail::empty_env,
+                        Variant>;
+
+                template <typename... Ts>
+                using decayed_tuple = std::tuple<std::decay_t<Ts>...>;
+
+                using value_results =
+                    pika::execution::experimental::value_types_of_t<Sender,
+                        pika::execution::experimental::detail::empty_env,
+                        decayed_tuple, pika::util::detail::pack>;
+#else
+                template <template <typename...> class Variant>
+                using predecessor_error_types =
+                    typename pika::execution::experimental::sender_traits<
+                        Sender>::template error_types<Variant>;
+
+                using value_results = value_types<std::tuple,
+                    pika::util::detail::pack>;
+#endif
+
+                template <typename Error>
+                struct error_result_helper
+                {
+                    using type = error_result<std::decay_t<Error>>;
+                };
+
+                using error_results = pika::util::detail::transform_t<
+                    predecessor_error_types<pika::util::detail::pack>,
+                    error_result_helper>;
+
+                // The result of the guarded sender is stored until the
+                // guards have been released
+                using result_type = pika::util::detail::change_pack_t<
+                    pika::detail::variant,
+                    pika::util::detail::unique_concat_t<
+                        pika::util::detail::pack<pika::detail::monostate,
+                            stopped_result>,
+                        value_results, error_results>>;
+
+                PIKA_NO_UNIQUE_ADDRESS std::decay_t<Receiver> receiver;
+                std::array<guard*, N> guards;
+
+                // The queue nodes of the guards are embedded in the
+                // operation state. Each node starts acquiring the next guard
+                // when it has acquired its own.
+                std::array<detail::guard_task, N> tasks;
+                std::size_t num_acquired = 0;
+
+                result_type result;
+
+                using operation_state_type =
+                    pika::execution::experimental::connect_result_t<Sender,
+                        on_guard_receiver>;
+                operation_state_type op_state;
+
+                template <std::size_t... Is>
+                static std::array<detail::guard_task, N> make_tasks(
+                    std::index_sequence<Is...>)
+                {
+                    return {{((void) Is, detail::guard_task(false))...}};
+                }
+
+                template <typename Sender_, typename Receiver_>
+                operation_state(Sender_&& sender, Receiver_&& receiver,
+                    std::array<guard*, N> const& guards)
+                  : receiver(PIKA_FORWARD(Receiver_, receiver))
+                  , guards(guards)
+                  , tasks(make_tasks(std::make_index_sequence<N>{}))
+                  , op_state(pika::execution::experimental::connect(
+                        PIKA_FORWARD(Sender_, sender),
+                        on_guard_receiver{*this}))
+                {
+                    for (auto& task : tasks)
+                    {
+                        // this fits into the small buffer of the function
+                        task.run = [this]() { acquired(); };
+                    }
+                }
+
+                operation_state(operation_state&&) = delete;
+                operation_state& operator=(operation_state&&) = delete;
+                operation_state(operation_state const&) = delete;
+                operation_state& operator=(operation_state const&) = delete;
+
+                void acquired() noexcept
+                {
+                    if (++num_acquired == N)
+                    {
+                        pika::execution::experimental::start(op_state);
+                    }
+                    else
+                    {
+                        detail::acquire_guard(
+                            *guards[num_acquired], &tasks[num_acquired]);
+                    }
+                }
+
+                void release() noexcept
+                {
+                    for (std::size_t i = 0; i != N; ++i)
+                    {
+                        detail::release_guard(*guards[i], &tasks[i]);
+                    }
+
+                    pika::detail::visit(
+                        set_result_visitor{PIKA_MOVE(receiver)},
+                        PIKA_MOVE(result));
+                }
+
+                struct set_result_visitor
+                {
+                    PIKA_NO_UNIQUE_ADDRESS std::decay_t<Receiver> receiver;
+
+                    [[noreturn]] void operator()(pika::detail::monostate) const
+                    {
+                        PIKA_UNREACHABLE;
+                    }
+
+                    void operator()(stopped_result)
+                    {
+                        pika::execution::experimental::set_stopped(
+                            PIKA_MOVE(receiver));
+                    }
+
+                    template <typename Error>
+                    void operator()(error_result<Error>&& e)
+                    {
+                        pika::execution::experimental::set_error(
+                            PIKA_MOVE(receiver), PIKA_MOVE(e.error));
+                    }
+
+                    template <typename... Ts>
+                    void operator()(std::tuple<Ts...>&& ts)
+                    {
+                        pika::util::detail::invoke_fused(
+                            pika::util::detail::bind_front(
+                                pika::execution::experimental::set_value,
+                                PIKA_MOVE(receiver)),
+                            PIKA_MOVE(ts));
+                    }
+                };
+
+                void start() & noexcept
+                {
+                    detail::acquire_guard(*guards[0], &tasks[0]);
+                }
+
+                friend void tag_invoke(pika::execution::experimental::start_t,
+                    operation_state& os) noexcept
+                {
+                    os.start();
+                }
+            };
+
+            template <typename Receiver>
+            friend operation_state<Receiver>
+            tag_invoke(pika::execution::experimental::connect_t,
+                on_guard_sender_type&& s, Receiver&& receiver)
+            {
+                return {PIKA_MOVE(s.sender), PIKA_FORWARD(Receiver, receiver),
+                    s.guards};
+            }
+
+            template <typename Receiver>
+            friend operation_state<Receiver>
+            tag_invoke(pika::execution::experimental::connect_t,
+                on_guard_sender_type const& s, Receiver&& receiver)
+            {
+                return {
+                    s.sender, PIKA_FORWARD(Receiver, receiver), s.guards};
+            }
+        };
+    }    // namespace on_guard_detail
+
+    /// Returns a sender which starts \a sender once all the given guards have
+    /// been acquired, and releases the guards when \a sender completes. The
+    /// completion of \a sender is forwarded after the guards have been
+    /// released. Guards are acquired in a fixed order, so on_guard can be
+    /// combined with run_guarded and guard_set on the same guards.
+    ///
+    /// Unlike run_guarded, on_guard does not allocate: the queue nodes for the
+    /// guards are embedded in the operation state. The number of guards is
+    /// known at compile time. Values and errors are sent decayed.
+    inline constexpr struct on_guard_t final
+      : pika::functional::detail::tag_fallback<on_guard_t>
+    {
+    private:
+        // clang-format off
+        template <typename Sender, typename... Guards,
+            PIKA_CONCEPT_REQUIRES_(
+                pika::execution::experimental::is_sender_v<Sender> &&
+                sizeof...(Guards) != 0 &&
+                (std::is_same_v<Guards, guard> && ...)
+            )>
+        // clang-format on
+        friend constexpr PIKA_FORCEINLINE auto tag_fallback_invoke(
+            on_guard_t, Sender&& sender, Guards&... guards)
+        {
+            return on_guard_detail::on_guard_sender<Sender,
+                sizeof...(Guards)>{PIKA_FORWARD(Sender, sender),
+                std::array<guard*, sizeof...(Guards)>{{&guards...}}};
+        }
+    } on_guard{};
+}    // namespace pika::lcos::local
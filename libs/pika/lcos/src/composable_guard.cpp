@@ -6,6 +6,7 @@
 
 #include <pika/config.hpp>
 #include <pika/assert.hpp>
+#include <pika/execution_base/this_thread.hpp>
 #include <pika/functional/bind_front.hpp>
 #include <pika/functional/function.hpp>
 
@@ -20,31 +21,7 @@
 namespace pika::lcos::local {
     static void run_composable(detail::guard_task* task);
 
-    static void nothing() {}
-
     namespace detail {
-        // A link in the list of tasks attached
-        // to a guard
-        struct guard_task : detail::debug_object
-        {
-            guard_atomic next;
-            detail::guard_function run;
-            bool const single_guard;
-
-            guard_task()
-              : next(nullptr)
-              , run(nothing)
-              , single_guard(true)
-            {
-            }
-            guard_task(bool sg)
-              : next(nullptr)
-              , run(nothing)
-              , single_guard(sg)
-            {
-            }
-        };
-
         void free(guard_task* task)
         {
             if (task == nullptr)
@@ -115,6 +92,36 @@ namespace pika::lcos::local {
         }
     }
 
+    namespace detail {
+        void acquire_guard(guard& g, guard_task* task)
+        {
+            PIKA_ASSERT(!task->single_guard);
+            run_guarded(g, task);
+        }
+
+        void release_guard(guard& g, guard_task* task)
+        {
+            PIKA_ASSERT(task != nullptr);
+            task->check_();
+
+            // If the task is still the last one on the guard, the guard is
+            // free again. Otherwise the next task has been attached to the
+            // guard, but may not have been linked to this task yet.
+            guard_task* expected = task;
+            if (g.task.compare_exchange_strong(expected, nullptr))
+            {
+                return;
+            }
+
+            guard_task* next = nullptr;
+            pika::util::yield_while([&]() {
+                next = task->next.load();
+                return next == nullptr;
+            });
+            run_composable(next);
+        }
+    }    // namespace detail
+
     struct stage_task_cleanup
     {
         stage_data* sd;
@@ -0,0 +1,179 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/lcos/composable_guard.hpp>
+#include <pika/lcos/on_guard.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+using pika::lcos::local::guard;
+using pika::lcos::local::guard_set;
+using pika::lcos::local::on_guard;
+using pika::lcos::local::run_guarded;
+
+constexpr std::size_t num_tasks = 1000;
+
+// Checks that at most one task holding the guard runs at a time
+struct checked_guard
+{
+    std::shared_ptr<guard> g = std::make_shared<guard>();
+    std::atomic<bool> busy{false};
+    std::size_t count = 0;
+
+    void enter()
+    {
+        PIKA_TEST(!busy.exchange(true));
+        ++count;
+    }
+
+    void leave()
+    {
+        busy.store(false);
+    }
+};
+
+void test_values()
+{
+    guard g;
+
+    PIKA_TEST_EQ(tt::sync_wait(on_guard(ex::just(42), g)), 42);
+    PIKA_TEST_EQ(tt::sync_wait(on_guard(ex::just(std::string("42")), g)),
+        std::string("42"));
+    tt::sync_wait(on_guard(ex::just(), g));
+
+    // the guard is released after errors
+    bool caught = false;
+    try
+    {
+        tt::sync_wait(on_guard(
+            ex::just() | ex::then([] { throw std::runtime_error("error"); }),
+            g));
+    }
+    catch (std::runtime_error const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    PIKA_TEST_EQ(tt::sync_wait(on_guard(ex::just(43), g)), 43);
+}
+
+void test_single_guard()
+{
+    ex::thread_pool_scheduler sched{};
+    checked_guard cg;
+    std::atomic<std::size_t> run_guarded_done{0};
+
+    std::vector<ex::unique_any_sender<>> senders;
+    for (std::size_t i = 0; i != num_tasks; ++i)
+    {
+        auto work = ex::schedule(sched) | ex::then([&] {
+            cg.enter();
+            cg.leave();
+        });
+        senders.emplace_back(
+            on_guard(std::move(work), *cg.g) | ex::ensure_started());
+
+        // on_guard and run_guarded can be used on the same guard
+        if (i % 10 == 0)
+        {
+            run_guarded(*cg.g, [&] {
+                cg.enter();
+                cg.leave();
+                ++run_guarded_done;
+            });
+        }
+    }
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+    pika::util::yield_while(
+        [&] { return run_guarded_done != num_tasks / 10; });
+
+    PIKA_TEST_EQ(cg.count, num_tasks + num_tasks / 10);
+}
+
+void test_multiple_guards()
+{
+    ex::thread_pool_scheduler sched{};
+    checked_guard cg1;
+    checked_guard cg2;
+    checked_guard cg3;
+    std::atomic<std::size_t> run_guarded_done{0};
+
+    guard_set gs;
+    gs.add(cg1.g);
+    gs.add(cg3.g);
+
+    auto work = [&](auto&... cgs) {
+        return ex::schedule(sched) | ex::then([&] {
+            (cgs.enter(), ...);
+            (cgs.leave(), ...);
+        });
+    };
+
+    std::vector<ex::unique_any_sender<>> senders;
+    for (std::size_t i = 0; i != num_tasks; ++i)
+    {
+        senders.emplace_back(
+            on_guard(work(cg1), *cg1.g) | ex::ensure_started());
+        senders.emplace_back(
+            on_guard(work(cg1, cg2), *cg1.g, *cg2.g) | ex::ensure_started());
+        // the order of the guards does not matter
+        senders.emplace_back(
+            on_guard(work(cg2, cg3), *cg3.g, *cg2.g) | ex::ensure_started());
+        senders.emplace_back(
+            on_guard(work(cg1, cg2, cg3), *cg2.g, *cg3.g, *cg1.g) |
+            ex::ensure_started());
+
+        if (i % 10 == 0)
+        {
+            run_guarded(gs, [&] {
+                cg1.enter();
+                cg3.enter();
+                cg1.leave();
+                cg3.leave();
+                ++run_guarded_done;
+            });
+        }
+    }
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+    pika::util::yield_while(
+        [&] { return run_guarded_done != num_tasks / 10; });
+
+    PIKA_TEST_EQ(cg1.count, 3 * num_tasks + num_tasks / 10);
+    PIKA_TEST_EQ(cg2.count, 3 * num_tasks);
+    PIKA_TEST_EQ(cg3.count, 2 * num_tasks + num_tasks / 10);
+}
+
+int pika_main()
+{
+    test_values();
+    test_single_guard();
+    test_multiple_guards();
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST_EQ_MSG(pika::init(pika_main, argc, argv), 0,
+        "pika main exited with non-zero status");
+
+    return pika::util::report_errors();
+}
@@ -70,6 +70,10 @@ namespace pika::resource::detail {
         std::size_t num_threads_;
         pika::threads::scheduler_mode mode_;
         scheduler_function create_function_;
+
+        // pools idle workers of this pool may take staged work from, in
+        // order of preference
+        std::vector<std::string> overflow_pools_;
     };
 
     ///////////////////////////////////////////////////////////////////////
@@ -147,6 +151,11 @@ namespace pika::resource::detail {
         pika::threads::scheduler_mode get_scheduler_mode(
             std::size_t pool_index) const;
 
+        void set_overflow_pools(std::string const& pool_name,
+            std::vector<std::string> overflow_pools);
+        std::vector<std::string> get_overflow_pools(
+            std::size_t pool_index) const;
+
         std::string const& get_pool_name(std::size_t index) const;
         std::size_t get_pool_index(std::string const& pool_name) const;
 
@@ -158,6 +158,13 @@ namespace pika::resource {
 
         PIKA_EXPORT const std::string& get_default_pool_name() const;
 
+        // Allow idle worker threads of the pool to take work from the given
+        // pools, tried in the given order. Only work which has not started
+        // running yet and which was not given a worker thread hint is taken.
+        // The pools are isolated from each other by default.
+        PIKA_EXPORT void set_overflow_pools(std::string const& pool_name,
+            std::vector<std::string> overflow_pools);
+
         ///////////////////////////////////////////////////////////////////////
         // Functions to add processing units to thread pools via
         // the pu/core/numa_domain API
@@ -71,5 +71,6 @@ namespace pika::resource {
         abp_priority_fifo = 5,
         abp_priority_lifo = 6,
         shared_priority = 7,
+        deadline = 8,
     };
 }    // namespace pika::resource
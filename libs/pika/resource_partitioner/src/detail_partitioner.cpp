@@ -151,6 +151,9 @@ namespace pika::resource::detail {
         case resource::shared_priority:
             sched = "shared_priority";
             break;
+        case resource::deadline:
+            sched = "deadline";
+            break;
         }
 
         os << "\"" << sched << "\" is running on PUs : \n";
@@ -478,6 +481,10 @@ namespace pika::resource::detail {
         {
             default_scheduler = scheduling_policy::shared_priority;
         }
+        else if (0 == std::string("deadline").find(default_scheduler_str))
+        {
+            default_scheduler = scheduling_policy::deadline;
+        }
         else
         {
             throw pika::detail::command_line_error(
@@ -833,6 +840,20 @@ namespace pika::resource::detail {
         return get_pool_data(l, pool_index).mode_;
     }
 
+    void partitioner::set_overflow_pools(std::string const& pool_name,
+        std::vector<std::string> overflow_pools)
+    {
+        std::unique_lock<mutex_type> l(mtx_);
+        get_pool_data(l, pool_name).overflow_pools_ = PIKA_MOVE(overflow_pools);
+    }
+
+    std::vector<std::string> partitioner::get_overflow_pools(
+        std::size_t pool_index) const
+    {
+        std::unique_lock<mutex_type> l(mtx_);
+        return get_pool_data(l, pool_index).overflow_pools_;
+    }
+
     detail::init_pool_data const& partitioner::get_pool_data(
         std::unique_lock<mutex_type>& l, std::size_t pool_index) const
     {
@@ -167,6 +167,12 @@ namespace pika::resource {
         return partitioner_.get_default_pool_name();
     }
 
+    void partitioner::set_overflow_pools(std::string const& pool_name,
+        std::vector<std::string> overflow_pools)
+    {
+        partitioner_.set_overflow_pools(pool_name, PIKA_MOVE(overflow_pools));
+    }
+
     void partitioner::add_resource(pu const& p, std::string const& pool_name,
         bool exclusive, std::size_t num_threads /*= 1*/)
     {
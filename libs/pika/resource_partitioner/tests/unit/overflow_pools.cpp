@@ -0,0 +1,141 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that idle worker threads of a pool take work from its
+// overflow pools, and that work bound to a worker thread is never taken.
+
+#include <pika/assert.hpp>
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/latch.hpp>
+#include <pika/modules/resource_partitioner.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+
+std::size_t const max_threads = (std::min)(
+    std::size_t(4), std::size_t(pika::threads::detail::hardware_concurrency()));
+
+int pika_main()
+{
+    auto& default_pool = pika::resource::get_thread_pool("default");
+    auto& overflow_pool = pika::resource::get_thread_pool("overflow");
+    PIKA_TEST_EQ(default_pool.get_os_thread_count(), std::size_t(1));
+
+    ex::thread_pool_scheduler sched{&default_pool};
+
+    constexpr std::size_t num_tasks = 100;
+    constexpr std::size_t num_bound_tasks = 10;
+
+    std::atomic<std::size_t> done{0};
+    std::atomic<std::size_t> ran_on_overflow{0};
+    pika::latch bound_done(num_bound_tasks + 1);
+    std::atomic<std::size_t> bound_ran_on_default{0};
+
+    // work bound to the only worker of the default pool stays there
+    for (std::size_t i = 0; i < num_bound_tasks; ++i)
+    {
+        ex::execute(
+            ex::with_hint(sched, pika::execution::thread_schedule_hint(0)),
+            [&] {
+                if (pika::this_thread::get_pool() == &default_pool)
+                {
+                    ++bound_ran_on_default;
+                }
+                bound_done.count_down(1);
+            });
+    }
+
+    for (std::size_t i = 0; i < num_tasks; ++i)
+    {
+        ex::execute(sched, [&] {
+            if (pika::this_thread::get_pool() == &overflow_pool)
+            {
+                ++ran_on_overflow;
+            }
+            ++done;
+        });
+    }
+
+    // Block the only worker thread of the default pool without yielding.
+    // The work can only make progress on the overflow pool.
+    auto const start = std::chrono::steady_clock::now();
+    while (done != num_tasks &&
+        std::chrono::steady_clock::now() - start < std::chrono::seconds(30))
+    {
+    }
+
+    PIKA_TEST_EQ(done.load(), num_tasks);
+    PIKA_TEST_EQ(ran_on_overflow.load(), num_tasks);
+    PIKA_TEST_EQ(
+        overflow_pool.get_cross_pool_steal_count(std::size_t(-1), false),
+        std::int64_t(num_tasks));
+    PIKA_TEST_EQ(
+        default_pool.get_cross_pool_steal_count(std::size_t(-1), false),
+        std::int64_t(0));
+
+    bound_done.arrive_and_wait();
+    PIKA_TEST_EQ(bound_ran_on_default.load(), num_bound_tasks);
+    PIKA_TEST_EQ(
+        overflow_pool.get_cross_pool_steal_count(std::size_t(-1), true),
+        std::int64_t(num_tasks));
+    PIKA_TEST_EQ(
+        overflow_pool.get_cross_pool_steal_count(std::size_t(-1), false),
+        std::int64_t(0));
+
+    return pika::finalize();
+}
+
+void init_resource_partitioner_handler(pika::resource::partitioner& rp,
+    pika::program_options::variables_map const&)
+{
+    rp.create_thread_pool("default",
+        pika::resource::scheduling_policy::local_priority_fifo);
+    rp.create_thread_pool("overflow",
+        pika::resource::scheduling_policy::local_priority_fifo);
+    rp.set_overflow_pools("overflow", {"default"});
+
+    // one PU for the default pool, the rest for the overflow pool
+    std::size_t thread_count = 0;
+    for (pika::resource::numa_domain const& d : rp.numa_domains())
+    {
+        for (pika::resource::core const& c : d.cores())
+        {
+            for (pika::resource::pu const& p : c.pus())
+            {
+                if (thread_count < max_threads)
+                {
+                    rp.add_resource(
+                        p, thread_count == 0 ? "default" : "overflow");
+                    ++thread_count;
+                }
+            }
+        }
+    }
+}
+
+// this test must be run with at least 2 threads
+int main(int argc, char* argv[])
+{
+    PIKA_ASSERT(max_threads >= 2);
+
+    pika::init_params init_args;
+    init_args.cfg = {"pika.os_threads=" + std::to_string(max_threads)};
+    init_args.rp_callback = &init_resource_partitioner_handler;
+
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv, init_args), 0);
+    return pika::util::report_errors();
+}
@@ -11,7 +11,9 @@
 #include <pika/assert.hpp>
 #include <pika/functional/function.hpp>
 #include <pika/modules/errors.hpp>
+#include <pika/threading_base/thread_description.hpp>
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <exception>
@@ -80,6 +82,25 @@ namespace pika {
         // under the [auxinfo] tag.
         PIKA_DEFINE_ERROR_INFO(throw_auxinfo, std::string);
 
+        // Stores the information which is expensive to turn into strings in
+        // raw form: the return addresses of the stack backtrace and the
+        // description of the pika thread. It is captured without allocating
+        // and converted to strings only when the diagnostic information is
+        // queried. This information will show up in error messages under the
+        // [stack_trace], [hostname], [thread_description], [env], and
+        // [config] tags.
+        struct deferred_exception_info
+        {
+            static constexpr std::size_t max_frames = 128;
+
+            std::array<void*, max_frames> frames;
+            std::size_t num_frames = 0;
+            pika::detail::thread_description thread_description;
+            bool has_hostname = false;
+        };
+
+        PIKA_DEFINE_ERROR_INFO(throw_deferred_info, deferred_exception_info);
+
         // Portably extract the current execution environment
         PIKA_EXPORT std::string get_execution_environment();
 
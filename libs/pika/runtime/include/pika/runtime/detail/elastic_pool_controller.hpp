@@ -0,0 +1,116 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/thread_manager/thread_manager_fwd.hpp>
+#include <pika/threading_base/threading_base_fwd.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pika::detail {
+    struct elastic_pool_parameters
+    {
+        // time between two decisions of the controller
+        std::chrono::milliseconds interval{10};
+
+        // bounds for the number of running workers of each pool, a maximum of
+        // zero means the size of the pool
+        std::size_t min_threads = 1;
+        std::size_t max_threads = 0;
+
+        // number of consecutive intervals a worker has to be idle before it
+        // is suspended
+        std::size_t suspend_after = 50;
+
+        // a worker is resumed when the number of queued tasks per running
+        // worker exceeds this value
+        std::size_t resume_queue_length = 2;
+
+        // a worker is resumed when the average time tasks wait in the queues
+        // exceeds this value, zero disables the check (only available with
+        // PIKA_WITH_THREAD_QUEUE_WAITTIME)
+        std::chrono::nanoseconds resume_wait_time{0};
+
+        // names of the pools to manage, all pools if empty
+        std::vector<std::string> pools;
+
+        // names of the pools on which elasticity is disabled, these are not
+        // managed even if they are listed in pools
+        std::vector<std::string> exclude_pools;
+    };
+
+    /// Suspends workers of thread pools that have been idle for a while and
+    /// resumes them again when tasks start to queue up. The decisions are
+    /// taken on a separate OS thread which is not registered with the
+    /// runtime. A worker that is asked to suspend drains its queues first,
+    /// new work is redirected to the running workers of the pool. Pools on
+    /// which scheduler_mode::enable_elasticity is removed while the
+    /// controller runs are left alone from then on.
+    class PIKA_EXPORT elastic_pool_controller
+    {
+    public:
+        elastic_pool_controller(threads::detail::thread_manager& tm,
+            elastic_pool_parameters params);
+        ~elastic_pool_controller();
+
+        elastic_pool_controller(elastic_pool_controller const&) = delete;
+        elastic_pool_controller(elastic_pool_controller&&) = delete;
+        elastic_pool_controller& operator=(
+            elastic_pool_controller const&) = delete;
+        elastic_pool_controller& operator=(elastic_pool_controller&&) = delete;
+
+        /// Enable elasticity on the managed pools and start the controller
+        /// thread. Throws if one of the configured pools does not exist.
+        void start();
+
+        /// Stop the controller thread. Workers which are suspended at this
+        /// point stay suspended until the pool is stopped or they are
+        /// resumed explicitly. Must be called before the thread pools are
+        /// stopped.
+        void stop();
+
+        elastic_pool_parameters const& get_parameters() const
+        {
+            return params_;
+        }
+
+        // Take a single decision for every managed pool.
+        void update();
+
+    private:
+        struct pool_data
+        {
+            threads::detail::thread_pool_base* pool;
+            std::vector<std::int64_t> busy_loop_counts;
+            std::vector<std::size_t> idle_intervals;
+        };
+
+        void run();
+        void update(pool_data& data);
+        void suspend(
+            threads::detail::thread_pool_base& pool, std::size_t virt_core);
+        void resume(
+            threads::detail::thread_pool_base& pool, std::size_t virt_core);
+
+        threads::detail::thread_manager& tm_;
+        elastic_pool_parameters params_;
+        std::vector<pool_data> pools_;
+
+        std::mutex mtx_;
+        std::condition_variable cond_;
+        bool stop_requested_ = false;
+        std::thread thread_;
+    };
+}    // namespace pika::detail
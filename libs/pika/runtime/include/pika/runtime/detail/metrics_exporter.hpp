@@ -0,0 +1,71 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/thread_manager/thread_manager_fwd.hpp>
+#include <pika/threading_base/threading_base_fwd.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pika::detail {
+    /// Periodically publishes the statistics of all thread pools into a
+    /// POSIX shared memory segment. The layout of the segment is described
+    /// in pika/runtime/metrics_snapshot.hpp. The exporter runs on its own OS
+    /// thread which is not registered with the runtime.
+    class PIKA_EXPORT metrics_exporter
+    {
+    public:
+        metrics_exporter(threads::detail::thread_manager& tm,
+            std::string shm_name, std::chrono::milliseconds interval);
+        ~metrics_exporter();
+
+        metrics_exporter(metrics_exporter const&) = delete;
+        metrics_exporter(metrics_exporter&&) = delete;
+        metrics_exporter& operator=(metrics_exporter const&) = delete;
+        metrics_exporter& operator=(metrics_exporter&&) = delete;
+
+        /// Start the exporter thread. Throws if the shared memory segment
+        /// can't be created.
+        void start();
+
+        /// Write a final snapshot, stop the exporter thread, and remove the
+        /// shared memory segment. Must be called before the thread pools are
+        /// destroyed.
+        void stop();
+
+        std::string const& get_shm_name() const
+        {
+            return shm_name_;
+        }
+
+        // Write a single snapshot into the segment.
+        void update();
+
+    private:
+        void run();
+
+        threads::detail::thread_manager& tm_;
+        std::vector<threads::detail::thread_pool_base*> pools_;
+        std::string shm_name_;
+        std::chrono::milliseconds interval_;
+
+        void* segment_ = nullptr;
+        std::size_t segment_size_ = 0;
+
+        std::mutex mtx_;
+        std::condition_variable cond_;
+        bool stop_requested_ = false;
+        std::thread thread_;
+    };
+}    // namespace pika::detail
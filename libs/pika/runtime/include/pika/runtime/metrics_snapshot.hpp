@@ -0,0 +1,181 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+/// \file pika/runtime/metrics_snapshot.hpp
+///
+/// Layout of the shared memory segment written by the metrics exporter
+/// (--pika:metrics-export). This header is intentionally self-contained so
+/// that external readers can consume the segment without linking to pika.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace pika::metrics {
+    /// Magic number identifying a pika metrics segment ("PIKAMTRX").
+    inline constexpr std::uint64_t snapshot_magic = 0x5852544d'414b4950ull;
+
+    /// Version of the segment layout. Incremented whenever the layout of
+    /// any of the structures below changes.
+    inline constexpr std::uint32_t snapshot_version = 1;
+
+    inline constexpr std::size_t max_pool_name_length = 64;
+
+    /// Bits in snapshot_header::available_ describing which of the optional
+    /// counters have been compiled into pika. Optional counters which are not
+    /// available are always written as zero.
+    enum snapshot_counters : std::uint32_t
+    {
+        counters_none = 0x00,
+        counters_cumulative = 0x01,     // PIKA_HAVE_THREAD_CUMULATIVE_COUNTS
+        counters_idle_rates = 0x02,     // PIKA_HAVE_THREAD_IDLE_RATES
+        counters_stealing = 0x04,       // PIKA_HAVE_THREAD_STEALING_COUNTS
+        counters_queue_waittime = 0x08  // PIKA_HAVE_THREAD_QUEUE_WAITTIME
+    };
+
+    struct snapshot_header
+    {
+        std::uint64_t magic_;
+        std::uint32_t version_;
+        std::uint32_t available_;
+
+        // Sequence number used as a seqlock: odd while the writer is
+        // updating the segment, even otherwise. Incremented by two for each
+        // published snapshot.
+        std::atomic<std::uint64_t> sequence_;
+
+        std::uint64_t pid_;
+        std::uint64_t interval_ms_;
+        std::uint64_t timestamp_ns_;    // steady clock, time of last update
+        std::uint64_t total_size_;      // size of the whole segment in bytes
+
+        std::uint32_t num_pools_;
+        std::uint32_t num_workers_;
+        std::uint32_t pools_offset_;      // offset of first snapshot_pool
+        std::uint32_t workers_offset_;    // offset of first snapshot_worker
+    };
+
+    struct snapshot_pool
+    {
+        char name_[max_pool_name_length];
+        std::uint32_t index_;
+        std::uint32_t num_threads_;
+        std::uint32_t first_worker_;    // index into the worker array
+        std::uint32_t num_active_threads_;
+
+        std::int64_t queue_length_;
+        std::int64_t thread_count_active_;
+        std::int64_t thread_count_pending_;
+        std::int64_t thread_count_suspended_;
+        std::int64_t thread_count_staged_;
+        std::int64_t thread_count_terminated_;
+        std::int64_t idle_core_count_;
+        std::int64_t background_thread_count_;
+        std::int64_t scheduler_utilization_;    // percent
+    };
+
+    struct snapshot_worker
+    {
+        std::uint32_t pool_index_;
+        std::uint32_t local_thread_num_;
+        std::uint32_t global_thread_num_;
+        std::uint32_t state_;    // pika::runtime_state
+
+        std::int64_t queue_length_;
+        std::int64_t thread_count_active_;
+        std::int64_t thread_count_pending_;
+        std::int64_t thread_count_suspended_;
+        std::int64_t thread_count_staged_;
+        std::int64_t idle_loop_count_;
+        std::int64_t busy_loop_count_;
+        std::int64_t cumulative_duration_;
+
+        // counters_cumulative
+        std::int64_t executed_threads_;
+        std::int64_t executed_thread_phases_;
+
+        // counters_idle_rates
+        std::int64_t idle_rate_;    // 0.01 percent
+
+        // counters_stealing
+        std::int64_t pending_misses_;
+        std::int64_t pending_accesses_;
+        std::int64_t stolen_from_pending_;
+        std::int64_t stolen_to_pending_;
+        std::int64_t stolen_from_staged_;
+        std::int64_t stolen_to_staged_;
+
+        // counters_queue_waittime
+        std::int64_t average_thread_wait_time_;
+        std::int64_t average_task_wait_time_;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+        "the metrics snapshot requires lock-free 64-bit atomics");
+
+    constexpr std::size_t snapshot_size(
+        std::size_t num_pools, std::size_t num_workers) noexcept
+    {
+        return sizeof(snapshot_header) + num_pools * sizeof(snapshot_pool) +
+            num_workers * sizeof(snapshot_worker);
+    }
+
+    /// Copy a consistent snapshot of the segment starting at \a segment into
+    /// \a buffer. \a buffer must be at least header.total_size_ bytes large.
+    /// Returns false if the segment is not a compatible pika metrics segment
+    /// or if no consistent copy could be taken within \a max_retries
+    /// attempts.
+    inline bool read_snapshot(void const* segment, std::size_t segment_size,
+        void* buffer, std::size_t max_retries = 1000) noexcept
+    {
+        if (segment_size < sizeof(snapshot_header))
+            return false;
+
+        auto const* header = static_cast<snapshot_header const*>(segment);
+        if (header->magic_ != snapshot_magic ||
+            header->version_ != snapshot_version ||
+            header->total_size_ > segment_size)
+        {
+            return false;
+        }
+
+        for (std::size_t i = 0; i != max_retries; ++i)
+        {
+            std::uint64_t const before =
+                header->sequence_.load(std::memory_order_acquire);
+            if (before % 2 != 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::memcpy(buffer, segment, header->total_size_);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (header->sequence_.load(std::memory_order_relaxed) == before)
+                return true;
+        }
+        return false;
+    }
+
+    inline snapshot_pool const* get_pools(
+        snapshot_header const& header) noexcept
+    {
+        return reinterpret_cast<snapshot_pool const*>(
+            reinterpret_cast<char const*>(&header) + header.pools_offset_);
+    }
+
+    inline snapshot_worker const* get_workers(
+        snapshot_header const& header) noexcept
+    {
+        return reinterpret_cast<snapshot_worker const*>(
+            reinterpret_cast<char const*>(&header) + header.workers_offset_);
+    }
+}    // namespace pika::metrics
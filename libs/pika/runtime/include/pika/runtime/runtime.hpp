@@ -13,6 +13,8 @@
 #include <pika/modules/program_options.hpp>
 #include <pika/modules/thread_manager.hpp>
 #include <pika/modules/topology.hpp>
+#include <pika/runtime/detail/elastic_pool_controller.hpp>
+#include <pika/runtime/detail/metrics_exporter.hpp>
 #include <pika/runtime/os_thread_type.hpp>
 #include <pika/runtime/runtime_fwd.hpp>
 #include <pika/runtime/shutdown_function.hpp>
@@ -23,6 +25,7 @@
 #include <pika/runtime_configuration/runtime_configuration.hpp>
 #include <pika/runtime_configuration/runtime_mode.hpp>
 #include <pika/threading_base/callback_notifier.hpp>
+#include <pika/threading_base/detail/task_timeline.hpp>
 
 #include <atomic>
 #include <condition_variable>
@@ -212,6 +215,38 @@ namespace pika {
         ///    \brief Resume the runtime system
         virtual int resume();
 
+        /// \brief Park the runtime system after pika_main has finished
+        ///
+        /// Calls the shutdown functions and suspends all thread pools, but
+        /// keeps the worker threads, schedulers, and thread stacks alive so
+        /// that the runtime can be started again quickly with \a restart.
+        /// Must be called after \a wait.
+        ///
+        /// \returns          false without parking the runtime if pika_main
+        ///                   terminated with an exception, true otherwise.
+        bool park();
+
+        /// \brief Run a new pika_main on a parked runtime system
+        ///
+        /// The startup functions registered since the runtime was parked
+        /// are called before \p func. The return value and \p blocking
+        /// behave as for \a start.
+        int restart(util::detail::function<pika_main_function_type> const& func,
+            bool blocking = false);
+
+        /// \brief Resume the thread pools of a parked runtime system without
+        ///        running a new pika_main, e.g. to stop it
+        void unpark();
+
+        /// \brief Return true if the runtime system has been parked by \a park
+        ///        and not been restarted or unparked since
+        ///
+        /// A runtime suspended with \a suspend is not parked.
+        bool is_parked() const
+        {
+            return parked_.load();
+        }
+
         virtual int finalize(double /*shutdown_timeout*/);
 
         ///  \brief Return true if networking is enabled.
@@ -409,6 +444,9 @@ namespace pika {
 
         std::atomic<runtime_state> state_;
 
+        // set only by park, a suspended runtime is not necessarily parked
+        std::atomic<bool> parked_;
+
         // support tying in external functions to be called for thread events
         notification_policy_type::on_startstop_type on_start_func_;
         notification_policy_type::on_startstop_type on_stop_func_;
@@ -421,6 +459,13 @@ namespace pika {
         notification_policy_type notifier_;
         std::unique_ptr<pika::threads::detail::thread_manager> thread_manager_;
 
+        // publishes pool statistics if enabled with --pika:metrics-export
+        std::unique_ptr<detail::metrics_exporter> metrics_exporter_;
+
+        // suspends and resumes workers if enabled with --pika:elasticity
+        std::unique_ptr<detail::elastic_pool_controller>
+            elastic_pool_controller_;
+
     private:
         /// \brief Helper function to stop the runtime.
         ///
@@ -448,6 +493,24 @@ namespace pika {
         void notify_finalize();
         void wait_finalize();
 
+        int launch_main(
+            util::detail::function<pika_main_function_type> const& func,
+            bool blocking);
+
+        void add_global_startup_shutdown_functions();
+
+        void start_metrics_exporter();
+        void stop_metrics_exporter();
+
+        void start_elastic_pool_controller();
+        void stop_elastic_pool_controller();
+
+        void start_task_timeline();
+        void stop_task_timeline();
+
+        void start_task_latencies();
+        void stop_task_latencies();
+
         void call_startup_functions(bool pre_startup);
         void call_shutdown_functions(bool pre_shutdown);
 
@@ -459,6 +522,19 @@ namespace pika {
         bool stop_called_;
         bool stop_done_;
         std::condition_variable wait_condition_;
+
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+        // the file the task timeline is written to, empty if not recording
+        std::string task_timeline_file_;
+        threads::detail::task_timeline_format task_timeline_format_ =
+            threads::detail::task_timeline_format::chrome;
+#endif
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        // the file the task latencies are written to, standard output if
+        // empty
+        std::string task_latency_file_;
+        bool task_latency_recording_ = false;
+#endif
     };
 
     PIKA_EXPORT void set_signal_handlers();
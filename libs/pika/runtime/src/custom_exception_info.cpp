@@ -75,19 +75,18 @@ namespace pika {
         {
             strm << pika::detail::get_full_build_string();
 
-            std::string const* env = xi.get<pika::detail::throw_env>();
-            if (env && !env->empty())
-                strm << "{env}: " << *env;
+            std::string const env = get_error_env(xi);
+            if (env != "<unknown>")
+                strm << "{env}: " << env;
         }
 
         if (verbosity >= 1)
         {
-            std::string const* back_trace =
-                xi.get<pika::detail::throw_stacktrace>();
-            if (back_trace && !back_trace->empty())
+            std::string const back_trace = get_error_backtrace(xi);
+            if (!back_trace.empty())
             {
                 // FIXME: add indentation to stack frame information
-                strm << "{stack-trace}: " << *back_trace << "\n";
+                strm << "{stack-trace}: " << back_trace << "\n";
             }
 
             std::uint32_t const* locality =
@@ -95,10 +94,9 @@ namespace pika {
             if (locality)
                 strm << "{locality-id}: " << *locality << "\n";
 
-            std::string const* hostname_ =
-                xi.get<pika::detail::throw_hostname>();
-            if (hostname_ && !hostname_->empty())
-                strm << "{hostname}: " << *hostname_ << "\n";
+            std::string const hostname_ = get_error_host_name(xi);
+            if (!hostname_.empty())
+                strm << "{hostname}: " << hostname_ << "\n";
 
             std::int64_t const* pid_ = xi.get<pika::detail::throw_pid>();
             if (pid_ && -1 != *pid_)
@@ -129,10 +127,10 @@ namespace pika {
                 fmt::print(strm, "{:016x}\n", *thread_id);
             }
 
-            std::string const* thread_description =
-                xi.get<pika::detail::throw_thread_name>();
-            if (thread_description && !thread_description->empty())
-                strm << "{thread-description}: " << *thread_description << "\n";
+            std::string const thread_description =
+                get_error_thread_description(xi);
+            if (!thread_description.empty())
+                strm << "{thread-description}: " << thread_description << "\n";
 
             std::string const* state = xi.get<pika::detail::throw_state>();
             if (state)
@@ -380,11 +378,18 @@ namespace pika {
                 util::from_string<std::size_t>(get_config_entry(
                     "pika.trace_depth", PIKA_HAVE_THREAD_BACKTRACE_DEPTH));
 
-            pika::debug::detail::backtrace bt(trace_depth);
-            std::string back_trace = bt.trace();
+            // Only the raw return addresses are captured here, symbolizing
+            // them is deferred until the backtrace is requested.
+            pika::detail::deferred_exception_info deferred;
+            if (trace_depth != 0)
+            {
+                // we omit two frames from printing
+                deferred.num_frames = pika::debug::detail::stack_trace::trace(
+                    deferred.frames.data(),
+                    (std::min)(trace_depth + 2, deferred.frames.size()));
+            }
 
             std::string state_name("not running");
-            std::string hostname;
             pika::runtime* rt = get_runtime_ptr();
             if (rt)
             {
@@ -394,7 +399,7 @@ namespace pika {
                 if (rts_state >= runtime_state::initialized &&
                     rts_state < runtime_state::stopped)
                 {
-                    hostname = get_runtime().here();
+                    deferred.has_hostname = true;
                 }
             }
 
@@ -405,7 +410,6 @@ namespace pika {
 
             std::size_t shepherd = std::size_t(-1);
             threads::detail::thread_id_type thread_id;
-            detail::thread_description thread_name;
 
             threads::detail::thread_self* self =
                 threads::detail::get_self_ptr();
@@ -415,26 +419,19 @@ namespace pika {
                     shepherd = pika::get_worker_thread_num();
 
                 thread_id = threads::detail::get_self_id();
-                thread_name =
+                deferred.thread_description =
                     threads::detail::get_thread_description(thread_id);
             }
 
-            std::string env(pika::detail::get_execution_environment());
-            std::string config(pika::configuration_string());
-
             return pika::exception_info().set(
-                pika::detail::throw_stacktrace(back_trace),
+                pika::detail::throw_deferred_info(deferred),
                 pika::detail::throw_locality(node),
-                pika::detail::throw_hostname(hostname),
                 pika::detail::throw_pid(pid),
                 pika::detail::throw_shepherd(shepherd),
                 pika::detail::throw_thread_id(
                     reinterpret_cast<std::size_t>(thread_id.get())),
-                pika::detail::throw_thread_name(detail::as_string(thread_name)),
                 pika::detail::throw_function(func),
                 pika::detail::throw_file(file), pika::detail::throw_line(line),
-                pika::detail::throw_env(env),
-                pika::detail::throw_config(config),
                 pika::detail::throw_state(state_name),
                 pika::detail::throw_auxinfo(auxinfo));
         }
@@ -449,6 +446,11 @@ namespace pika {
         std::string const* hostname_ = xi.get<pika::detail::throw_hostname>();
         if (hostname_ && !hostname_->empty())
             return *hostname_;
+
+        auto const* deferred = xi.get<pika::detail::throw_deferred_info>();
+        pika::runtime* rt = get_runtime_ptr();
+        if (deferred && deferred->has_hostname && rt)
+            return rt->here();
         return std::string();
     }
 
@@ -481,6 +483,11 @@ namespace pika {
         if (env && !env->empty())
             return *env;
 
+        // the environment is not captured when throwing, it is read when
+        // the diagnostic information is queried
+        if (xi.get<pika::detail::throw_deferred_info>())
+            return pika::detail::get_execution_environment();
+
         return "<unknown>";
     }
 
@@ -492,6 +499,13 @@ namespace pika {
         if (back_trace && !back_trace->empty())
             return *back_trace;
 
+        auto const* deferred = xi.get<pika::detail::throw_deferred_info>();
+        if (deferred && deferred->num_frames != 0)
+        {
+            return pika::debug::detail::stack_trace::get_symbols(
+                deferred->frames.data(), deferred->num_frames);
+        }
+
         return std::string();
     }
 
@@ -523,6 +537,10 @@ namespace pika {
             xi.get<pika::detail::throw_thread_name>();
         if (thread_description && !thread_description->empty())
             return *thread_description;
+
+        auto const* deferred = xi.get<pika::detail::throw_deferred_info>();
+        if (deferred && deferred->thread_description)
+            return pika::detail::as_string(deferred->thread_description);
         return std::string();
     }
 
@@ -533,6 +551,9 @@ namespace pika {
         std::string const* config_info = xi.get<pika::detail::throw_config>();
         if (config_info && !config_info->empty())
             return *config_info;
+
+        if (xi.get<pika::detail::throw_deferred_info>())
+            return pika::configuration_string();
         return std::string();
     }
 
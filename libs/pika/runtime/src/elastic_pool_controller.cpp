@@ -0,0 +1,309 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+#include <pika/execution_base/this_thread.hpp>
+#include <pika/modules/errors.hpp>
+#include <pika/modules/logging.hpp>
+#include <pika/modules/thread_manager.hpp>
+#include <pika/runtime/detail/elastic_pool_controller.hpp>
+#include <pika/runtime/state.hpp>
+#include <pika/threading_base/scheduler_base.hpp>
+#include <pika/threading_base/scheduler_mode.hpp>
+#include <pika/threading_base/thread_pool_base.hpp>
+#include <pika/topology/cpu_mask.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pika::detail {
+    elastic_pool_controller::elastic_pool_controller(
+        threads::detail::thread_manager& tm, elastic_pool_parameters params)
+      : tm_(tm)
+      , params_(PIKA_MOVE(params))
+    {
+        if (params_.interval.count() <= 0)
+        {
+            params_.interval = std::chrono::milliseconds(1);
+        }
+
+        if (params_.min_threads == 0)
+        {
+            params_.min_threads = 1;
+        }
+
+        if (params_.suspend_after == 0)
+        {
+            params_.suspend_after = 1;
+        }
+    }
+
+    elastic_pool_controller::~elastic_pool_controller()
+    {
+        stop();
+    }
+
+    void elastic_pool_controller::start()
+    {
+        std::vector<threads::detail::thread_pool_base*> pools;
+        if (params_.pools.empty())
+        {
+            std::size_t const num_threads = tm_.get_os_thread_count();
+            for (std::size_t i = 0; i != num_threads; ++i)
+            {
+                auto* pool = &tm_.get_pool(i);
+                if (std::find(pools.begin(), pools.end(), pool) == pools.end())
+                {
+                    pools.push_back(pool);
+                }
+            }
+        }
+        else
+        {
+            for (auto const& name : params_.pools)
+            {
+                if (!tm_.pool_exists(name))
+                {
+                    PIKA_THROW_EXCEPTION(pika::error::bad_parameter,
+                        "elastic_pool_controller::start",
+                        "the thread pool \"{}\" does not exist", name);
+                }
+                pools.push_back(&tm_.get_pool(name));
+            }
+        }
+
+        for (auto* pool : pools)
+        {
+            // Pools which have elasticity disabled explicitly are left alone
+            std::size_t const num_threads = pool->get_os_thread_count();
+            if (num_threads <= params_.min_threads ||
+                std::find(params_.exclude_pools.begin(),
+                    params_.exclude_pools.end(),
+                    pool->get_pool_name()) != params_.exclude_pools.end())
+            {
+                continue;
+            }
+
+            // Redirect new work away from suspended workers
+            pool->get_scheduler()->add_scheduler_mode(
+                threads::scheduler_mode::enable_elasticity);
+
+            pool_data data{pool, {}, {}};
+            data.busy_loop_counts.resize(num_threads);
+            data.idle_intervals.resize(num_threads, 0);
+            for (std::size_t i = 0; i != num_threads; ++i)
+            {
+                data.busy_loop_counts[i] = pool->get_busy_loop_count(i, false);
+            }
+            pools_.push_back(PIKA_MOVE(data));
+
+            LRT_(info).format("elastic_pool_controller: managing pool {} "
+                              "({} threads)",
+                pool->get_pool_name(), num_threads);
+        }
+
+        if (pools_.empty())
+        {
+            return;
+        }
+
+        thread_ = std::thread(&elastic_pool_controller::run, this);
+    }
+
+    void elastic_pool_controller::stop()
+    {
+        if (thread_.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> l(mtx_);
+                stop_requested_ = true;
+            }
+            cond_.notify_all();
+            thread_.join();
+        }
+
+        // cancel pending suspensions, sleeping workers are woken up when the
+        // pool stops
+        for (auto& data : pools_)
+        {
+            for (std::size_t i = 0; i != data.idle_intervals.size(); ++i)
+            {
+                runtime_state expected = runtime_state::pre_sleep;
+                auto& state = data.pool->get_scheduler()->get_state(i);
+                state.compare_exchange_strong(expected, runtime_state::running);
+            }
+        }
+        pools_.clear();
+    }
+
+    void elastic_pool_controller::update()
+    {
+        for (auto& data : pools_)
+        {
+            update(data);
+        }
+    }
+
+    void elastic_pool_controller::update(pool_data& data)
+    {
+        auto& pool = *data.pool;
+
+        // the pool may be starting, suspended, or shutting down, in which
+        // case the state of the workers is controlled by someone else, and
+        // elasticity may have been disabled on the pool since it was started
+        auto* sched = pool.get_scheduler();
+        auto const states = sched->get_minmax_state();
+        if (states.first != runtime_state::running ||
+            states.second > runtime_state::sleeping ||
+            !sched->has_scheduler_mode(
+                threads::scheduler_mode::enable_elasticity))
+        {
+            return;
+        }
+
+        std::size_t const num_threads = data.idle_intervals.size();
+
+        // workers which are neither running a task nor have queued work
+        threads::detail::mask_type idle_mask = threads::detail::mask_type();
+        threads::detail::resize(idle_mask, num_threads);
+        pool.get_idle_core_mask(idle_mask);
+
+        std::size_t const max_threads = params_.max_threads == 0 ?
+            num_threads :
+            (std::min)(params_.max_threads, num_threads);
+        std::size_t const min_threads =
+            (std::min)(params_.min_threads, max_threads);
+
+        std::size_t running = 0;
+        std::size_t resume_candidate = num_threads;
+        std::size_t suspend_candidate = num_threads;
+        for (std::size_t i = 0; i != num_threads; ++i)
+        {
+            runtime_state const state = pool.get_state(i);
+
+            // a worker is idle for an interval if it hasn't started any task
+            // during the interval and isn't running one now, a worker
+            // running a single long task is thus never suspended
+            std::int64_t const busy = pool.get_busy_loop_count(i, false);
+            bool const idle = busy == data.busy_loop_counts[i] &&
+                threads::detail::test(idle_mask, i);
+            data.busy_loop_counts[i] = busy;
+
+            if (state == runtime_state::running)
+            {
+                ++running;
+                data.idle_intervals[i] = idle ? data.idle_intervals[i] + 1 : 0;
+                if (data.idle_intervals[i] >= params_.suspend_after ||
+                    running > max_threads)
+                {
+                    suspend_candidate = i;
+                }
+            }
+            else if ((state == runtime_state::pre_sleep ||
+                         state == runtime_state::sleeping) &&
+                resume_candidate == num_threads)
+            {
+                data.idle_intervals[i] = 0;
+                resume_candidate = i;
+            }
+        }
+
+        std::int64_t const queued =
+            pool.get_queue_length(std::size_t(-1), false);
+        bool overloaded = queued >
+            static_cast<std::int64_t>(params_.resume_queue_length *
+                (std::max)(running, std::size_t(1)));
+
+#if defined(PIKA_HAVE_THREAD_QUEUE_WAITTIME)
+        if (params_.resume_wait_time.count() != 0)
+        {
+            overloaded = overloaded ||
+                pool.get_average_thread_wait_time(std::size_t(-1), false) >
+                    params_.resume_wait_time.count();
+        }
+#endif
+
+        // Resume one worker per interval while tasks are queueing up, and
+        // suspend one worker per interval that has been idle for long enough.
+        // Suspending only after a number of idle intervals avoids oscillating
+        // between the two.
+        if ((overloaded || running < min_threads) && running < max_threads &&
+            resume_candidate != num_threads)
+        {
+            LRT_(debug).format("elastic_pool_controller: resuming worker {} "
+                               "of pool {} ({} tasks queued)",
+                resume_candidate, pool.get_pool_name(), queued);
+
+            resume(pool, resume_candidate);
+            std::fill(data.idle_intervals.begin(), data.idle_intervals.end(),
+                std::size_t(0));
+        }
+        else if ((running > max_threads ||
+                     (!overloaded && running > min_threads)) &&
+            suspend_candidate != num_threads)
+        {
+            LRT_(debug).format("elastic_pool_controller: suspending worker {} "
+                               "of pool {}",
+                suspend_candidate, pool.get_pool_name());
+
+            data.idle_intervals[suspend_candidate] = 0;
+            suspend(pool, suspend_candidate);
+        }
+    }
+
+    // The worker suspends itself once it has finished its current task and
+    // its queues are empty. Unlike suspend_processing_unit_direct this does
+    // not wait for that to happen as the worker may be blocked in a long
+    // running task.
+    void elastic_pool_controller::suspend(
+        threads::detail::thread_pool_base& pool, std::size_t virt_core)
+    {
+        auto* sched = pool.get_scheduler();
+        std::unique_lock<threads::detail::scheduler_base::pu_mutex_type> l(
+            sched->get_pu_mutex(virt_core), std::defer_lock);
+
+        // The mutex is also taken by threads scheduling work on this worker,
+        // wait for it instead of silently dropping the decision
+        util::yield_while([&l]() { return !l.try_lock(); },
+            "elastic_pool_controller::suspend");
+
+        runtime_state expected = runtime_state::running;
+        sched->get_state(virt_core).compare_exchange_strong(
+            expected, runtime_state::pre_sleep);
+    }
+
+    void elastic_pool_controller::resume(
+        threads::detail::thread_pool_base& pool, std::size_t virt_core)
+    {
+        // a worker that hasn't suspended itself yet keeps running, if it
+        // went to sleep in the meantime it is woken up below
+        runtime_state expected = runtime_state::pre_sleep;
+        if (!pool.get_scheduler()->get_state(virt_core).compare_exchange_strong(
+                expected, runtime_state::running))
+        {
+            error_code ec(throwmode::lightweight);
+            pool.resume_processing_unit_direct(virt_core, ec);
+        }
+    }
+
+    void elastic_pool_controller::run()
+    {
+        std::unique_lock<std::mutex> l(mtx_);
+        while (!cond_.wait_for(
+            l, params_.interval, [this] { return stop_requested_; }))
+        {
+            l.unlock();
+            update();
+            l.lock();
+        }
+    }
+}    // namespace pika::detail
@@ -0,0 +1,339 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/modules/errors.hpp>
+#include <pika/modules/logging.hpp>
+#include <pika/modules/thread_manager.hpp>
+#include <pika/runtime/detail/metrics_exporter.hpp>
+#include <pika/runtime/metrics_snapshot.hpp>
+#include <pika/threading_base/thread_pool_base.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(PIKA_HAVE_UNISTD_H)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pika::detail {
+    namespace {
+        std::vector<threads::detail::thread_pool_base*> collect_pools(
+            threads::detail::thread_manager& tm)
+        {
+            std::vector<threads::detail::thread_pool_base*> pools;
+            std::size_t const num_threads = tm.get_os_thread_count();
+            for (std::size_t i = 0; i != num_threads; ++i)
+            {
+                auto* pool = &tm.get_pool(i);
+                if (std::find(pools.begin(), pools.end(), pool) == pools.end())
+                {
+                    pools.push_back(pool);
+                }
+            }
+
+            std::sort(pools.begin(), pools.end(), [](auto* lhs, auto* rhs) {
+                return lhs->get_pool_index() < rhs->get_pool_index();
+            });
+            return pools;
+        }
+
+        constexpr std::uint32_t available_counters() noexcept
+        {
+            std::uint32_t available = metrics::counters_none;
+#if defined(PIKA_HAVE_THREAD_CUMULATIVE_COUNTS)
+            available |= metrics::counters_cumulative;
+#endif
+#if defined(PIKA_HAVE_THREAD_IDLE_RATES)
+            available |= metrics::counters_idle_rates;
+#endif
+#if defined(PIKA_HAVE_THREAD_STEALING_COUNTS)
+            available |= metrics::counters_stealing;
+#endif
+#if defined(PIKA_HAVE_THREAD_QUEUE_WAITTIME)
+            available |= metrics::counters_queue_waittime;
+#endif
+            return available;
+        }
+
+        void fill_worker(threads::detail::thread_pool_base& pool,
+            std::size_t local_thread_num, metrics::snapshot_worker& w)
+        {
+            constexpr bool reset = false;
+            std::size_t const n = local_thread_num;
+
+            w.state_ = static_cast<std::uint32_t>(pool.get_state(n));
+            w.queue_length_ = pool.get_queue_length(n, reset);
+            w.thread_count_active_ = pool.get_thread_count_active(n, reset);
+            w.thread_count_pending_ = pool.get_thread_count_pending(n, reset);
+            w.thread_count_suspended_ =
+                pool.get_thread_count_suspended(n, reset);
+            w.thread_count_staged_ = pool.get_thread_count_staged(n, reset);
+            w.idle_loop_count_ = pool.get_idle_loop_count(n, reset);
+            w.busy_loop_count_ = pool.get_busy_loop_count(n, reset);
+            w.cumulative_duration_ = pool.get_cumulative_duration(n, reset);
+
+#if defined(PIKA_HAVE_THREAD_CUMULATIVE_COUNTS)
+            w.executed_threads_ = pool.get_executed_threads(n, reset);
+            w.executed_thread_phases_ =
+                pool.get_executed_thread_phases(n, reset);
+#endif
+#if defined(PIKA_HAVE_THREAD_IDLE_RATES)
+            w.idle_rate_ = pool.avg_idle_rate(n, reset);
+#endif
+#if defined(PIKA_HAVE_THREAD_STEALING_COUNTS)
+            w.pending_misses_ = pool.get_num_pending_misses(n, reset);
+            w.pending_accesses_ = pool.get_num_pending_accesses(n, reset);
+            w.stolen_from_pending_ = pool.get_num_stolen_from_pending(n, reset);
+            w.stolen_to_pending_ = pool.get_num_stolen_to_pending(n, reset);
+            w.stolen_from_staged_ = pool.get_num_stolen_from_staged(n, reset);
+            w.stolen_to_staged_ = pool.get_num_stolen_to_staged(n, reset);
+#endif
+#if defined(PIKA_HAVE_THREAD_QUEUE_WAITTIME)
+            w.average_thread_wait_time_ =
+                pool.get_average_thread_wait_time(n, reset);
+            w.average_task_wait_time_ =
+                pool.get_average_task_wait_time(n, reset);
+#endif
+        }
+
+        void fill_pool(threads::detail::thread_pool_base& pool,
+            std::size_t first_worker, metrics::snapshot_pool& p)
+        {
+            constexpr bool reset = false;
+            constexpr std::size_t all = std::size_t(-1);
+
+            std::string const& name = pool.get_pool_name();
+            std::size_t const len =
+                (std::min)(name.size(), metrics::max_pool_name_length - 1);
+            std::memcpy(p.name_, name.data(), len);
+            p.name_[len] = '\0';
+
+            std::size_t const active = pool.get_active_os_thread_count();
+
+            p.index_ = static_cast<std::uint32_t>(pool.get_pool_index());
+            p.num_threads_ =
+                static_cast<std::uint32_t>(pool.get_os_thread_count());
+            p.first_worker_ = static_cast<std::uint32_t>(first_worker);
+            p.num_active_threads_ = static_cast<std::uint32_t>(active);
+
+            p.queue_length_ = pool.get_queue_length(all, reset);
+            p.thread_count_active_ = pool.get_thread_count_active(all, reset);
+            p.thread_count_pending_ = pool.get_thread_count_pending(all, reset);
+            p.thread_count_suspended_ =
+                pool.get_thread_count_suspended(all, reset);
+            p.thread_count_staged_ = pool.get_thread_count_staged(all, reset);
+            p.thread_count_terminated_ =
+                pool.get_thread_count_terminated(all, reset);
+            p.idle_core_count_ = pool.get_idle_core_count();
+            p.background_thread_count_ = pool.get_background_thread_count();
+
+            // the utilization is normalized by the number of active threads
+            // which is zero while the whole pool is suspended
+            p.scheduler_utilization_ =
+                active != 0 ? pool.get_scheduler_utilization() : 0;
+        }
+    }    // namespace
+
+    metrics_exporter::metrics_exporter(threads::detail::thread_manager& tm,
+        std::string shm_name, std::chrono::milliseconds interval)
+      : tm_(tm)
+      , shm_name_(PIKA_MOVE(shm_name))
+      , interval_(interval)
+    {
+        // POSIX requires portable shared memory object names to start with
+        // a slash
+        if (shm_name_.empty() || shm_name_[0] != '/')
+        {
+            shm_name_.insert(0, 1, '/');
+        }
+
+        if (interval_.count() <= 0)
+        {
+            interval_ = std::chrono::milliseconds(1);
+        }
+    }
+
+    metrics_exporter::~metrics_exporter()
+    {
+        stop();
+    }
+
+#if defined(PIKA_HAVE_UNISTD_H)
+    void metrics_exporter::start()
+    {
+        pools_ = collect_pools(tm_);
+        std::size_t const num_workers = tm_.get_os_thread_count();
+
+        segment_size_ = metrics::snapshot_size(pools_.size(), num_workers);
+
+        int fd = ::shm_open(shm_name_.c_str(), O_CREAT | O_RDWR | O_TRUNC,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd == -1)
+        {
+            PIKA_THROW_EXCEPTION(pika::error::kernel_error,
+                "metrics_exporter::start",
+                "could not create shared memory segment {}: {}", shm_name_,
+                std::strerror(errno));
+        }
+
+        if (::ftruncate(fd, static_cast<off_t>(segment_size_)) == -1)
+        {
+            int const err = errno;
+            ::close(fd);
+            ::shm_unlink(shm_name_.c_str());
+            PIKA_THROW_EXCEPTION(pika::error::kernel_error,
+                "metrics_exporter::start",
+                "could not resize shared memory segment {}: {}", shm_name_,
+                std::strerror(err));
+        }
+
+        void* segment = ::mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (segment == MAP_FAILED)
+        {
+            ::shm_unlink(shm_name_.c_str());
+            PIKA_THROW_EXCEPTION(pika::error::kernel_error,
+                "metrics_exporter::start",
+                "could not map shared memory segment {}: {}", shm_name_,
+                std::strerror(errno));
+        }
+        segment_ = segment;
+
+        // The static parts of the segment are written once. The magic number
+        // is written last so that readers never see a partially initialized
+        // header.
+        auto* header = new (segment_) metrics::snapshot_header{};
+        header->version_ = metrics::snapshot_version;
+        header->available_ = available_counters();
+        header->pid_ = static_cast<std::uint64_t>(::getpid());
+        header->interval_ms_ = static_cast<std::uint64_t>(interval_.count());
+        header->total_size_ = segment_size_;
+        header->num_pools_ = static_cast<std::uint32_t>(pools_.size());
+        header->num_workers_ = static_cast<std::uint32_t>(num_workers);
+        header->pools_offset_ = sizeof(metrics::snapshot_header);
+        header->workers_offset_ = static_cast<std::uint32_t>(
+            sizeof(metrics::snapshot_header) +
+            pools_.size() * sizeof(metrics::snapshot_pool));
+
+        update();
+
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic_ = metrics::snapshot_magic;
+
+        LRT_(info).format("metrics_exporter: publishing pool statistics to "
+                          "{} every {}ms",
+            shm_name_, interval_.count());
+
+        thread_ = std::thread(&metrics_exporter::run, this);
+    }
+
+    void metrics_exporter::stop()
+    {
+        if (thread_.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> l(mtx_);
+                stop_requested_ = true;
+            }
+            cond_.notify_all();
+            thread_.join();
+
+            // publish the final state of the pools before they go away
+            update();
+        }
+
+        if (segment_ != nullptr)
+        {
+            ::munmap(segment_, segment_size_);
+            ::shm_unlink(shm_name_.c_str());
+            segment_ = nullptr;
+        }
+    }
+
+    void metrics_exporter::update()
+    {
+        PIKA_ASSERT(segment_ != nullptr);
+
+        auto* header = static_cast<metrics::snapshot_header*>(segment_);
+        auto* pools = reinterpret_cast<metrics::snapshot_pool*>(
+            static_cast<char*>(segment_) + header->pools_offset_);
+        auto* workers = reinterpret_cast<metrics::snapshot_worker*>(
+            static_cast<char*>(segment_) + header->workers_offset_);
+
+        // Seqlock write: readers retry while the sequence number is odd or
+        // has changed during their copy.
+        std::uint64_t const seq =
+            header->sequence_.load(std::memory_order_relaxed);
+        header->sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::size_t worker = 0;
+        std::size_t pool_num = 0;
+        for (auto* pool : pools_)
+        {
+            metrics::snapshot_pool& p = pools[pool_num++];
+            fill_pool(*pool, worker, p);
+
+            for (std::size_t i = 0; i != p.num_threads_; ++i)
+            {
+                PIKA_ASSERT(worker < header->num_workers_);
+                metrics::snapshot_worker& w = workers[worker];
+                w.pool_index_ = p.index_;
+                w.local_thread_num_ = static_cast<std::uint32_t>(i);
+                w.global_thread_num_ = static_cast<std::uint32_t>(
+                    pool->get_thread_offset() + i);
+                fill_worker(*pool, i, w);
+                ++worker;
+            }
+        }
+
+        header->timestamp_ns_ = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+
+        header->sequence_.store(seq + 2, std::memory_order_release);
+    }
+#else
+    void metrics_exporter::start()
+    {
+        PIKA_THROW_EXCEPTION(pika::error::not_implemented,
+            "metrics_exporter::start",
+            "the metrics exporter requires POSIX shared memory support");
+    }
+
+    void metrics_exporter::stop() {}
+
+    void metrics_exporter::update() {}
+#endif
+
+    void metrics_exporter::run()
+    {
+        std::unique_lock<std::mutex> l(mtx_);
+        while (!cond_.wait_for(l, interval_, [this] { return stop_requested_; }))
+        {
+            l.unlock();
+            update();
+            l.lock();
+        }
+    }
+}    // namespace pika::detail
@@ -29,11 +29,15 @@
 #include <pika/runtime/state.hpp>
 #include <pika/runtime/thread_hooks.hpp>
 #include <pika/runtime/thread_mapper.hpp>
+#include <pika/string_util/classification.hpp>
 #include <pika/string_util/from_string.hpp>
+#include <pika/string_util/split.hpp>
 #include <pika/thread_support/set_thread_name.hpp>
 #include <pika/threading_base/external_timer.hpp>
 #include <pika/threading_base/scheduler_mode.hpp>
+#include <pika/threading_base/task_latency.hpp>
 #include <pika/topology/topology.hpp>
+#include <pika/util/get_entry_as.hpp>
 #include <pika/version.hpp>
 
 #if defined(PIKA_HAVE_TRACY)
@@ -42,6 +46,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -49,6 +54,7 @@
 #include <cstdint>
 #include <cstring>
 #include <exception>
+#include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
@@ -275,6 +281,7 @@ namespace pika {
       , thread_support_(new util::thread_mapper)
       , topology_(resource::get_partitioner().get_topology())
       , state_(runtime_state::invalid)
+      , parked_(false)
       , on_start_func_(global_on_start_func)
       , on_stop_func_(global_on_stop_func)
       , on_error_func_(global_on_error_func)
@@ -308,6 +315,7 @@ namespace pika {
       , thread_support_(new util::thread_mapper)
       , topology_(resource::get_partitioner().get_topology())
       , state_(runtime_state::invalid)
+      , parked_(false)
       , on_start_func_(global_on_start_func)
       , on_stop_func_(global_on_stop_func)
       , on_error_func_(global_on_error_func)
@@ -345,27 +353,7 @@ namespace pika {
             thread_manager_->init();
 
             // copy over all startup functions registered so far
-            for (startup_function_type& f :
-                detail::global_pre_startup_functions)
-            {
-                add_pre_startup_function(f);
-            }
-
-            for (startup_function_type& f : detail::global_startup_functions)
-            {
-                add_startup_function(f);
-            }
-
-            for (shutdown_function_type& f :
-                detail::global_pre_shutdown_functions)
-            {
-                add_pre_shutdown_function(f);
-            }
-
-            for (shutdown_function_type& f : detail::global_shutdown_functions)
-            {
-                add_shutdown_function(f);
-            }
+            add_global_startup_shutdown_functions();
         }
         catch (std::exception const& e)
         {
@@ -387,7 +375,11 @@ namespace pika {
         LRT_(debug).format("~runtime(entering)");
 
         // stop all services
+        stop_elastic_pool_controller();
+        stop_metrics_exporter();
         thread_manager_->stop();
+        stop_task_timeline();
+        stop_task_latencies();
         LRT_(debug).format("~runtime(finished)");
 
         LPROGRESS_;
@@ -399,6 +391,29 @@ namespace pika {
         resource::detail::delete_partitioner();
     }
 
+    void runtime::add_global_startup_shutdown_functions()
+    {
+        for (startup_function_type& f : detail::global_pre_startup_functions)
+        {
+            add_pre_startup_function(f);
+        }
+
+        for (startup_function_type& f : detail::global_startup_functions)
+        {
+            add_startup_function(f);
+        }
+
+        for (shutdown_function_type& f : detail::global_pre_shutdown_functions)
+        {
+            add_pre_shutdown_function(f);
+        }
+
+        for (shutdown_function_type& f : detail::global_shutdown_functions)
+        {
+            add_shutdown_function(f);
+        }
+    }
+
     void runtime::on_exit(util::detail::function<void()> const& f)
     {
         std::lock_guard<std::mutex> l(mtx_);
@@ -1036,7 +1051,8 @@ namespace pika {
         runtime* rt = get_runtime_ptr();
         if (nullptr != rt)
         {
-            if (rt->get_state() > runtime_state::pre_startup)
+            if (rt->get_state() > runtime_state::pre_startup &&
+                !rt->is_parked())
             {
                 PIKA_THROW_EXCEPTION(pika::error::invalid_status,
                     "register_pre_startup_function",
@@ -1056,7 +1072,8 @@ namespace pika {
         runtime* rt = get_runtime_ptr();
         if (nullptr != rt)
         {
-            if (rt->get_state() > runtime_state::startup)
+            if (rt->get_state() > runtime_state::startup &&
+                !rt->is_parked())
             {
                 PIKA_THROW_EXCEPTION(pika::error::invalid_status,
                     "register_startup_function",
@@ -1311,11 +1328,26 @@ namespace pika {
         init_tss_helper(
             "main-thread", os_thread_type::main_thread, 0, 0, "", "", false);
 
+        // the timeline buffers and latency histograms have to exist before
+        // the workers start
+        start_task_timeline();
+        start_task_latencies();
+
         // start the thread manager
         thread_manager_->run();
         lbt_ << "(1st stage) runtime::start: started thread_manager";
+
+        start_metrics_exporter();
+        start_elastic_pool_controller();
         // }}}
 
+        return launch_main(func, blocking);
+    }
+
+    int runtime::launch_main(
+        util::detail::function<pika_main_function_type> const& func,
+        bool blocking)
+    {
         // {{{ launch main
         // register the given main function with the thread manager
         lbt_ << "(1st stage) runtime::start: launching run_helper "
@@ -1445,6 +1477,11 @@ namespace pika {
         // execute all on_exit functions whenever the first thread calls this
         this->runtime::stopping();
 
+        // the exporter and the elasticity controller access the thread pools
+        // and have to be stopped before them
+        stop_elastic_pool_controller();
+        stop_metrics_exporter();
+
         // stop runtime services (threads)
         thread_manager_->stop(false);    // just initiate shutdown
 
@@ -1480,6 +1517,10 @@ namespace pika {
             LRT_(info).format("runtime: stopped all services");
         }
 
+        // all worker threads have exited, the timeline is complete
+        stop_task_timeline();
+        stop_task_latencies();
+
         call_shutdown_functions(false);
     }
 
@@ -1501,6 +1542,227 @@ namespace pika {
         cond.notify_all();    // we're done now
     }
 
+    void runtime::start_metrics_exporter()
+    {
+        util::section const* sec = get_config().get_section("pika.metrics");
+        if (sec == nullptr ||
+            pika::detail::get_entry_as<int>(*sec, "export", 0) == 0)
+        {
+            return;
+        }
+
+        std::string shm_name = sec->get_entry("shm_name", "");
+        if (shm_name.empty())
+        {
+            shm_name = "/pika-metrics." +
+                get_config().get_entry("system.pid", "0");
+        }
+
+        auto interval = std::chrono::milliseconds(
+            pika::detail::get_entry_as<std::size_t>(*sec, "interval", 100));
+
+        metrics_exporter_ = std::make_unique<detail::metrics_exporter>(
+            *thread_manager_, PIKA_MOVE(shm_name), interval);
+        metrics_exporter_->start();
+    }
+
+    void runtime::stop_metrics_exporter()
+    {
+        if (metrics_exporter_)
+        {
+            metrics_exporter_->stop();
+            metrics_exporter_.reset();
+        }
+    }
+
+    void runtime::start_elastic_pool_controller()
+    {
+        util::section const* sec =
+            get_config().get_section("pika.elasticity");
+        if (sec == nullptr ||
+            pika::detail::get_entry_as<int>(*sec, "enabled", 0) == 0)
+        {
+            return;
+        }
+
+        detail::elastic_pool_parameters params;
+        params.interval = std::chrono::milliseconds(
+            pika::detail::get_entry_as<std::size_t>(*sec, "interval", 10));
+        params.min_threads =
+            pika::detail::get_entry_as<std::size_t>(*sec, "min_threads", 1);
+        params.max_threads =
+            pika::detail::get_entry_as<std::size_t>(*sec, "max_threads", 0);
+        params.suspend_after =
+            pika::detail::get_entry_as<std::size_t>(*sec, "suspend_after", 50);
+        params.resume_queue_length = pika::detail::get_entry_as<std::size_t>(
+            *sec, "resume_queue_length", 2);
+        params.resume_wait_time = std::chrono::nanoseconds(
+            pika::detail::get_entry_as<std::int64_t>(
+                *sec, "resume_wait_time", 0));
+
+        std::string const pools = sec->get_entry("pools", "");
+        pika::string_util::split(params.pools, pools,
+            pika::string_util::is_any_of(", "),
+            pika::string_util::token_compress_mode::on);
+        params.pools.erase(
+            std::remove(params.pools.begin(), params.pools.end(), ""),
+            params.pools.end());
+
+        std::string const exclude_pools = sec->get_entry("exclude_pools", "");
+        pika::string_util::split(params.exclude_pools, exclude_pools,
+            pika::string_util::is_any_of(", "),
+            pika::string_util::token_compress_mode::on);
+        params.exclude_pools.erase(std::remove(params.exclude_pools.begin(),
+                                       params.exclude_pools.end(), ""),
+            params.exclude_pools.end());
+
+        elastic_pool_controller_ =
+            std::make_unique<detail::elastic_pool_controller>(
+                *thread_manager_, PIKA_MOVE(params));
+        elastic_pool_controller_->start();
+    }
+
+    void runtime::stop_elastic_pool_controller()
+    {
+        if (elastic_pool_controller_)
+        {
+            elastic_pool_controller_->stop();
+            elastic_pool_controller_.reset();
+        }
+    }
+
+    void runtime::start_task_timeline()
+    {
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+        util::section const* sec = get_config().get_section("pika.timeline");
+        if (sec == nullptr ||
+            pika::detail::get_entry_as<int>(*sec, "enabled", 0) == 0)
+        {
+            return;
+        }
+
+        task_timeline_format_ = threads::detail::parse_task_timeline_format(
+            sec->get_entry("format", "chrome"));
+
+        task_timeline_file_ = sec->get_entry("file", "");
+        if (task_timeline_file_.empty())
+        {
+            task_timeline_file_ = fmt::format("pika-timeline.{}.{}",
+                get_config().get_entry("system.pid", "0"),
+                task_timeline_format_ ==
+                        threads::detail::task_timeline_format::chrome ?
+                    "json" :
+                    "perfetto-trace");
+        }
+
+        threads::detail::start_task_timeline(
+            get_config().get_os_thread_count(),
+            pika::detail::get_entry_as<std::size_t>(
+                *sec, "buffer_size", 65536));
+
+        int const signum = pika::detail::get_entry_as<int>(*sec, "signal", 0);
+        if (signum != 0)
+        {
+            threads::detail::start_task_timeline_signal_handler(
+                signum, task_timeline_file_, task_timeline_format_);
+        }
+
+        LRT_(info).format("runtime: recording task timeline into {}",
+            task_timeline_file_);
+#endif
+    }
+
+    void runtime::stop_task_timeline()
+    {
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+        if (task_timeline_file_.empty())
+        {
+            return;
+        }
+
+        threads::detail::stop_task_timeline_signal_handler();
+        threads::detail::stop_task_timeline();
+
+        // this is also called from the destructor, don't let exceptions
+        // escape
+        try
+        {
+            threads::detail::dump_task_timeline(
+                task_timeline_file_, task_timeline_format_);
+        }
+        catch (std::exception const& e)
+        {
+            LRT_(error).format(
+                "runtime: could not write task timeline: {}", e.what());
+            std::cerr << "could not write task timeline: " << e.what()
+                      << "\n";
+        }
+        task_timeline_file_.clear();
+#endif
+    }
+
+    void runtime::start_task_latencies()
+    {
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        util::section const* sec =
+            get_config().get_section("pika.latency_histograms");
+        if (sec == nullptr ||
+            pika::detail::get_entry_as<int>(*sec, "enabled", 0) == 0)
+        {
+            return;
+        }
+
+        task_latency_file_ = sec->get_entry("file", "");
+        threads::detail::start_task_latencies(
+            get_config().get_os_thread_count());
+        task_latency_recording_ = true;
+
+        LRT_(info).format("runtime: recording task latency histograms");
+#endif
+    }
+
+    void runtime::stop_task_latencies()
+    {
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        if (!task_latency_recording_)
+        {
+            return;
+        }
+
+        threads::detail::stop_task_latencies();
+        task_latency_recording_ = false;
+
+        // this is also called from the destructor, don't let exceptions
+        // escape
+        try
+        {
+            auto const latencies = threads::get_task_latencies();
+            if (task_latency_file_.empty())
+            {
+                threads::print_task_latencies(std::cout, latencies);
+            }
+            else
+            {
+                std::ofstream os(task_latency_file_);
+                if (!os)
+                {
+                    PIKA_THROW_EXCEPTION(pika::error::kernel_error,
+                        "runtime::stop_task_latencies",
+                        "could not open {} for writing", task_latency_file_);
+                }
+                threads::print_task_latencies(os, latencies);
+            }
+        }
+        catch (std::exception const& e)
+        {
+            LRT_(error).format(
+                "runtime: could not write task latencies: {}", e.what());
+            std::cerr << "could not write task latencies: " << e.what()
+                      << "\n";
+        }
+#endif
+    }
+
     int runtime::suspend()
     {
         LRT_(info).format("runtime: about to suspend runtime");
@@ -1548,6 +1810,82 @@ namespace pika {
         return 0;
     }
 
+    bool runtime::park()
+    {
+        LRT_(info).format("runtime: about to park runtime");
+
+        {
+            std::lock_guard<std::mutex> l(mtx_);
+            if (exception_)
+            {
+                return false;
+            }
+        }
+
+        call_shutdown_functions(true);
+        call_shutdown_functions(false);
+
+        // the functions registered for this run have been called, the next
+        // run starts again with the globally registered ones
+        pre_startup_functions_.clear();
+        startup_functions_.clear();
+        pre_shutdown_functions_.clear();
+        shutdown_functions_.clear();
+        add_global_startup_shutdown_functions();
+
+        // all work has finished in wait(), this only puts the workers to
+        // sleep
+        thread_manager_->suspend();
+
+        set_state(runtime_state::suspended);
+        parked_ = true;
+
+        LRT_(info).format("runtime: parked runtime");
+        return true;
+    }
+
+    int runtime::restart(
+        util::detail::function<pika_main_function_type> const& func,
+        bool blocking)
+    {
+        LRT_(info).format("runtime: about to restart parked runtime");
+
+        if (!is_parked())
+        {
+            PIKA_THROW_EXCEPTION(pika::error::invalid_status,
+                "runtime::restart",
+                "Can only restart runtime from parked state");
+            return -1;
+        }
+
+        {
+            std::lock_guard<std::mutex> l(mtx_);
+            stop_called_ = false;
+            stop_done_ = false;
+            result_ = 0;
+        }
+
+        parked_ = false;
+        set_state(runtime_state::initialized);
+        thread_manager_->resume();
+
+        return launch_main(func, blocking);
+    }
+
+    void runtime::unpark()
+    {
+        if (!is_parked())
+        {
+            PIKA_THROW_EXCEPTION(pika::error::invalid_status, "runtime::unpark",
+                "Can only unpark runtime from parked state");
+            return;
+        }
+
+        parked_ = false;
+        thread_manager_->resume();
+        set_state(runtime_state::running);
+    }
+
     int runtime::finalize(double /*shutdown_timeout*/)
     {
         notify_finalize();
@@ -0,0 +1,152 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that idle workers are suspended down to the configured
+// minimum when elasticity is enabled, that workers running a long task are not
+// suspended, and that suspended workers are resumed again when tasks queue
+// up. The decisions of the controller are triggered explicitly by the test.
+
+#include <pika/execution.hpp>
+#include <pika/execution_base/this_thread.hpp>
+#include <pika/init.hpp>
+#include <pika/runtime.hpp>
+#include <pika/runtime/detail/elastic_pool_controller.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ex = pika::execution::experimental;
+
+pika::detail::elastic_pool_parameters make_parameters()
+{
+    // The controller thread never takes a decision on its own
+    pika::detail::elastic_pool_parameters params;
+    params.interval = std::chrono::hours(1);
+    params.min_threads = 1;
+    params.suspend_after = 1;
+    return params;
+}
+
+void test_excluded_pool(pika::threads::detail::thread_pool_base& pool)
+{
+    auto params = make_parameters();
+    params.exclude_pools = {"default"};
+    pika::detail::elastic_pool_controller controller(
+        pika::threads::get_thread_manager(), params);
+    controller.start();
+
+    for (std::size_t i = 0; i != 2 * pool.get_os_thread_count(); ++i)
+    {
+        controller.update();
+    }
+    PIKA_TEST_EQ(pool.get_active_os_thread_count(), pool.get_os_thread_count());
+
+    controller.stop();
+}
+
+void test_suspend_resume(pika::threads::detail::thread_pool_base& pool)
+{
+    std::size_t const num_threads = pool.get_os_thread_count();
+    std::int16_t const hint =
+        static_cast<std::int16_t>((pika::get_worker_thread_num() + 1) %
+            num_threads);
+
+    // keep one worker busy with a task that never yields
+    std::atomic<std::size_t> long_worker{num_threads};
+    std::atomic<bool> long_task_done{false};
+    auto sched = ex::with_hint(ex::thread_pool_scheduler{},
+        pika::execution::thread_schedule_hint(hint));
+    ex::start_detached(ex::schedule(sched) | ex::then([&] {
+        long_worker = pika::get_worker_thread_num();
+        while (!long_task_done)
+        {
+        }
+    }));
+    pika::util::yield_while([&] { return long_worker == num_threads; });
+
+    pika::detail::elastic_pool_controller controller(
+        pika::threads::get_thread_manager(), make_parameters());
+    controller.start();
+
+    // idle workers are suspended one at a time until only the worker running
+    // this task and the worker running the long task are left
+    std::size_t const expected_threads =
+        (std::min)(num_threads, std::size_t(2));
+    for (std::size_t i = 0; i != 2 * num_threads; ++i)
+    {
+        controller.update();
+        PIKA_TEST(
+            pool.get_state(long_worker) == pika::runtime_state::running);
+    }
+    PIKA_TEST_EQ(pool.get_active_os_thread_count(), expected_threads);
+
+    // wait for the worker of the long task to become idle, only the worker
+    // running this task is busy after that
+    long_task_done = true;
+    pika::util::yield_while([&] {
+        return pool.get_idle_core_count() <
+            static_cast<std::int64_t>(num_threads - 1);
+    });
+
+    // the number of running workers never drops below the minimum
+    for (std::size_t i = 0; i != 2 * num_threads; ++i)
+    {
+        controller.update();
+    }
+    PIKA_TEST_EQ(pool.get_active_os_thread_count(), std::size_t(1));
+
+    // queued tasks resume the suspended workers
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> running_tasks{0};
+    for (std::size_t i = 0; i != 16 * num_threads; ++i)
+    {
+        ++running_tasks;
+        ex::start_detached(
+            ex::schedule(ex::thread_pool_scheduler{}) | ex::then([&] {
+                while (!done)
+                {
+                    pika::this_thread::yield();
+                }
+                --running_tasks;
+            }));
+    }
+
+    for (std::size_t i = 0; i != num_threads; ++i)
+    {
+        controller.update();
+    }
+    pika::util::yield_while(
+        [&] { return pool.get_active_os_thread_count() < num_threads; });
+    PIKA_TEST_EQ(pool.get_active_os_thread_count(), num_threads);
+
+    done = true;
+    pika::util::yield_while([&] { return running_tasks != 0; });
+
+    controller.stop();
+}
+
+int pika_main()
+{
+    auto& pool = pika::resource::get_thread_pool("default");
+
+    test_excluded_pool(pool);
+    test_suspend_resume(pool);
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv), 0);
+
+    return pika::util::report_errors();
+}
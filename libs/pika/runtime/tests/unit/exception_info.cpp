@@ -0,0 +1,99 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that the diagnostic information captured when throwing
+// exceptions is available after the fact, and that capturing it can be
+// disabled for individual errors.
+
+#include <pika/init.hpp>
+#include <pika/runtime.hpp>
+#include <pika/runtime/custom_exception_info.hpp>
+#include <pika/version.hpp>
+#include <pika/testing.hpp>
+
+#include <exception>
+#include <string>
+
+std::exception_ptr throw_error(pika::error e)
+{
+    try
+    {
+        PIKA_THROW_EXCEPTION(e, "throw_error", "simulated error");
+    }
+    catch (...)
+    {
+        return std::current_exception();
+    }
+    return {};
+}
+
+void test_enabled()
+{
+    PIKA_TEST(
+        pika::detail::get_exception_info_enabled(pika::error::no_success));
+
+    std::exception_ptr p = throw_error(pika::error::no_success);
+    PIKA_TEST(p);
+    PIKA_TEST_EQ(pika::get_error_function_name(p), std::string("throw_error"));
+    PIKA_TEST_NEQ(pika::get_error_process_id(p), -1);
+    PIKA_TEST_EQ(pika::get_error_host_name(p), pika::get_runtime().here());
+    PIKA_TEST_EQ(pika::get_error_config(p), pika::configuration_string());
+
+#if defined(PIKA_HAVE_STACKTRACES)
+    // symbols are resolved when the backtrace is requested
+    std::string const backtrace = pika::get_error_backtrace(p);
+    PIKA_TEST(!backtrace.empty());
+    PIKA_TEST_EQ(pika::get_error_backtrace(p), backtrace);
+#endif
+#if defined(PIKA_HAVE_THREAD_DESCRIPTION)
+    PIKA_TEST(!pika::get_error_thread_description(p).empty());
+#endif
+
+    std::string const info = pika::diagnostic_information(p);
+    PIKA_TEST_NEQ(info.find("{function}: throw_error"), std::string::npos);
+    PIKA_TEST_NEQ(info.find("{hostname}: "), std::string::npos);
+#if defined(PIKA_HAVE_STACKTRACES)
+    PIKA_TEST_NEQ(info.find("{stack-trace}: "), std::string::npos);
+#endif
+}
+
+void test_disabled()
+{
+    PIKA_TEST(
+        !pika::detail::get_exception_info_enabled(pika::error::bad_parameter));
+
+    std::exception_ptr p = throw_error(pika::error::bad_parameter);
+    PIKA_TEST(p);
+    PIKA_TEST_EQ(pika::get_error(p), pika::error::bad_parameter);
+    PIKA_TEST_EQ(pika::get_error_function_name(p), std::string("throw_error"));
+    PIKA_TEST_EQ(pika::get_error_process_id(p), -1);
+    PIKA_TEST(pika::get_error_host_name(p).empty());
+    PIKA_TEST(pika::get_error_backtrace(p).empty());
+    PIKA_TEST(pika::get_error_thread_description(p).empty());
+    PIKA_TEST(pika::get_error_config(p).empty());
+
+    std::string const info = pika::diagnostic_information(p);
+    PIKA_TEST_NEQ(info.find("{function}: throw_error"), std::string::npos);
+    PIKA_TEST_EQ(info.find("{stack-trace}: "), std::string::npos);
+}
+
+int pika_main()
+{
+    test_enabled();
+    test_disabled();
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    pika::init_params init_args;
+    init_args.cfg = {"pika.exception_info_disabled!=bad_parameter"};
+
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv, init_args), 0);
+
+    return pika::util::report_errors();
+}
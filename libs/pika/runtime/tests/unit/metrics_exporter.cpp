@@ -0,0 +1,111 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/execution_base/this_thread.hpp>
+#include <pika/init.hpp>
+#include <pika/runtime.hpp>
+#include <pika/runtime/metrics_snapshot.hpp>
+#include <pika/testing.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::string const shm_name =
+    "/pika-metrics-exporter-test." + std::to_string(getpid());
+
+void check_snapshot()
+{
+    int fd = ::shm_open(shm_name.c_str(), O_RDONLY, 0);
+    PIKA_TEST_NEQ(fd, -1);
+
+    struct stat st;
+    PIKA_TEST_NEQ(::fstat(fd, &st), -1);
+    std::size_t const size = static_cast<std::size_t>(st.st_size);
+
+    void* segment = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    PIKA_TEST(segment != MAP_FAILED);
+
+    std::vector<std::uint64_t> buffer(size / sizeof(std::uint64_t) + 1);
+    PIKA_TEST(pika::metrics::read_snapshot(segment, size, buffer.data()));
+
+    auto const& header =
+        *reinterpret_cast<pika::metrics::snapshot_header const*>(
+            buffer.data());
+    PIKA_TEST_EQ(header.magic_, pika::metrics::snapshot_magic);
+    PIKA_TEST_EQ(header.version_, pika::metrics::snapshot_version);
+    PIKA_TEST_EQ(header.pid_, static_cast<std::uint64_t>(getpid()));
+    PIKA_TEST_EQ(header.interval_ms_, std::uint64_t(10));
+    PIKA_TEST_EQ(header.sequence_.load() % 2, std::uint64_t(0));
+    PIKA_TEST_EQ(header.num_pools_, std::uint32_t(1));
+    PIKA_TEST_EQ(std::size_t(header.num_workers_),
+        pika::get_num_worker_threads());
+    PIKA_TEST_EQ(std::size_t(header.total_size_),
+        pika::metrics::snapshot_size(
+            header.num_pools_, header.num_workers_));
+
+    auto const* pools = pika::metrics::get_pools(header);
+    PIKA_TEST_EQ(std::string(pools[0].name_), std::string("default"));
+    PIKA_TEST_EQ(pools[0].first_worker_, std::uint32_t(0));
+    PIKA_TEST_EQ(pools[0].num_threads_, header.num_workers_);
+
+    auto const* workers = pika::metrics::get_workers(header);
+    for (std::uint32_t i = 0; i != header.num_workers_; ++i)
+    {
+        PIKA_TEST_EQ(workers[i].pool_index_, std::uint32_t(0));
+        PIKA_TEST_EQ(workers[i].local_thread_num_, i);
+        PIKA_TEST_EQ(workers[i].global_thread_num_, i);
+    }
+
+    ::munmap(segment, size);
+}
+
+int pika_main()
+{
+    check_snapshot();
+
+    // the segment is updated periodically
+    std::uint64_t first_sequence = 0;
+    {
+        int fd = ::shm_open(shm_name.c_str(), O_RDONLY, 0);
+        PIKA_TEST_NEQ(fd, -1);
+        void* segment = ::mmap(nullptr, sizeof(pika::metrics::snapshot_header),
+            PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        auto const* header =
+            static_cast<pika::metrics::snapshot_header const*>(segment);
+        first_sequence = header->sequence_.load();
+        pika::util::yield_while(
+            [&] { return header->sequence_.load() < first_sequence + 4; });
+
+        ::munmap(segment, sizeof(pika::metrics::snapshot_header));
+    }
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    pika::init_params init_args;
+    init_args.cfg = {"pika.metrics.export!=1",
+        "pika.metrics.shm_name!=" + shm_name, "pika.metrics.interval!=10"};
+
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv, init_args), 0);
+
+    // the segment is removed when the runtime stops
+    PIKA_TEST_EQ(::shm_open(shm_name.c_str(), O_RDONLY, 0), -1);
+
+    return 0;
+}
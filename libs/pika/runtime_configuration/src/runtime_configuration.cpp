@@ -91,6 +91,7 @@ namespace pika::util {
             "finalize_wait_time = ${PIKA_FINALIZE_WAIT_TIME:-1.0}",
             "shutdown_timeout = ${PIKA_SHUTDOWN_TIMEOUT:-1.0}",
             "shutdown_check_count = ${PIKA_SHUTDOWN_CHECK_COUNT:10}",
+            "warm_restart = ${PIKA_WARM_RESTART:0}",
 #ifdef PIKA_HAVE_VERIFY_LOCKS
 #if defined(PIKA_DEBUG)
             "lock_detection = ${PIKA_LOCK_DETECTION:1}",
@@ -155,6 +156,7 @@ namespace pika::util {
             "exception_verbosity = ${PIKA_EXCEPTION_VERBOSITY:1}",
             "trace_depth = ${PIKA_TRACE_DEPTH:" PIKA_PP_STRINGIZE(
                 PIKA_PP_EXPAND(PIKA_HAVE_THREAD_BACKTRACE_DEPTH)) "}",
+            "exception_info_disabled = ${PIKA_EXCEPTION_INFO_DISABLED:}",
 
             "[pika.stacks]",
             "small_size = ${PIKA_SMALL_STACK_SIZE:" PIKA_PP_STRINGIZE(
@@ -170,6 +172,33 @@ namespace pika::util {
             "use_guard_pages = ${PIKA_USE_GUARD_PAGES:1}",
 #endif
 
+            "[pika.metrics]",
+            "export = ${PIKA_METRICS_EXPORT:0}",
+            "shm_name = ${PIKA_METRICS_SHM_NAME:/pika-metrics.$[system.pid]}",
+            "interval = ${PIKA_METRICS_INTERVAL:100}",
+
+            "[pika.elasticity]",
+            "enabled = ${PIKA_ELASTICITY:0}",
+            "interval = ${PIKA_ELASTICITY_INTERVAL:10}",
+            "min_threads = ${PIKA_ELASTICITY_MIN_THREADS:1}",
+            "max_threads = ${PIKA_ELASTICITY_MAX_THREADS:0}",
+            "suspend_after = ${PIKA_ELASTICITY_SUSPEND_AFTER:50}",
+            "resume_queue_length = ${PIKA_ELASTICITY_RESUME_QUEUE_LENGTH:2}",
+            "resume_wait_time = ${PIKA_ELASTICITY_RESUME_WAIT_TIME:0}",
+            "pools = ${PIKA_ELASTICITY_POOLS:}",
+            "exclude_pools = ${PIKA_ELASTICITY_EXCLUDE_POOLS:}",
+
+            "[pika.timeline]",
+            "enabled = ${PIKA_TIMELINE:0}",
+            "file = ${PIKA_TIMELINE_FILE:}",
+            "format = ${PIKA_TIMELINE_FORMAT:chrome}",
+            "buffer_size = ${PIKA_TIMELINE_BUFFER_SIZE:65536}",
+            "signal = ${PIKA_TIMELINE_SIGNAL:0}",
+
+            "[pika.latency_histograms]",
+            "enabled = ${PIKA_LATENCY_HISTOGRAMS:0}",
+            "file = ${PIKA_LATENCY_HISTOGRAMS_FILE:}",
+
             "[pika.thread_queue]",
             "max_thread_count = ${PIKA_THREAD_QUEUE_MAX_THREAD_COUNT:" PIKA_PP_STRINGIZE(
                 PIKA_PP_EXPAND(PIKA_THREAD_QUEUE_MAX_THREAD_COUNT)) "}",
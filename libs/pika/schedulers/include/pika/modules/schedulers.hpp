@@ -8,6 +8,7 @@
 
 #include <pika/config.hpp>
 
+#include <pika/schedulers/deadline_queue_scheduler.hpp>
 #include <pika/schedulers/local_priority_queue_scheduler.hpp>
 #include <pika/schedulers/local_queue_scheduler.hpp>
 #include <pika/schedulers/shared_priority_queue_scheduler.hpp>
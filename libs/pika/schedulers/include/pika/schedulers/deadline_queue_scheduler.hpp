@@ -0,0 +1,387 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/modules/logging.hpp>
+#include <pika/schedulers/deadlock_detection.hpp>
+#include <pika/schedulers/local_queue_scheduler.hpp>
+#include <pika/schedulers/lockfree_queue_backends.hpp>
+#include <pika/schedulers/thread_queue.hpp>
+#include <pika/thread_support/spinlock.hpp>
+#include <pika/threading_base/thread_data.hpp>
+#include <pika/threading_base/thread_init_data.hpp>
+#include <pika/topology/topology.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pika/config/warnings_prefix.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace pika::threads {
+    namespace detail {
+        // The deadline of the entries stored in the queues of a thread_queue:
+        // threads, threads with wait time information, and task descriptions.
+        inline std::chrono::steady_clock::time_point queue_entry_deadline(
+            threads::detail::thread_init_data const& data) noexcept
+        {
+            return data.deadline;
+        }
+
+        inline std::chrono::steady_clock::time_point queue_entry_deadline(
+            threads::detail::thread_id_ref_type const& thrd) noexcept
+        {
+            return get_thread_id_data(thrd)->get_deadline();
+        }
+
+        inline std::chrono::steady_clock::time_point queue_entry_deadline(
+            threads::detail::thread_data_reference_counting const*
+                thrd) noexcept
+        {
+            return static_cast<threads::detail::thread_data const*>(thrd)
+                ->get_deadline();
+        }
+
+        template <typename T>
+        std::chrono::steady_clock::time_point queue_entry_deadline(
+            T const* entry) noexcept
+        {
+            return queue_entry_deadline(entry->data);
+        }
+    }    // namespace detail
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Earliest deadline first. Entries with the same deadline, including
+    // entries without a deadline, are popped in FIFO order.
+    template <typename T>
+    struct deadline_queue_backend
+    {
+        using value_type = T;
+        using reference = T&;
+        using const_reference = T const&;
+        using rvalue_reference = T&&;
+        using size_type = std::uint64_t;
+        using time_point = std::chrono::steady_clock::time_point;
+
+        deadline_queue_backend(size_type initial_size = 0,
+            size_type /* num_thread */ = size_type(-1))
+        {
+            heap_.reserve(std::size_t(initial_size));
+        }
+
+        bool push(const_reference val, bool /*other_end*/ = false)
+        {
+            entry e{detail::queue_entry_deadline(val), 0, val};
+
+            std::lock_guard<mutex_type> l(mtx_);
+            e.sequence = sequence_++;
+            heap_.push_back(PIKA_MOVE(e));
+            std::push_heap(heap_.begin(), heap_.end(), later{});
+            update_earliest_deadline();
+            return true;
+        }
+
+        bool push(rvalue_reference val, bool other_end = false)
+        {
+            return push(const_reference(val), other_end);
+        }
+
+        bool pop(reference val, bool /* steal */ = true)
+        {
+            std::lock_guard<mutex_type> l(mtx_);
+            if (heap_.empty())
+            {
+                return false;
+            }
+
+            std::pop_heap(heap_.begin(), heap_.end(), later{});
+            val = PIKA_MOVE(heap_.back().value);
+            heap_.pop_back();
+            update_earliest_deadline();
+            return true;
+        }
+
+        bool empty()
+        {
+            std::lock_guard<mutex_type> l(mtx_);
+            return heap_.empty();
+        }
+
+        // The deadline of the next entry to be popped. This is read without
+        // taking the lock and may be outdated by the time it is used.
+        time_point earliest_deadline() const noexcept
+        {
+            return time_point(time_point::duration(
+                earliest_deadline_.load(std::memory_order_relaxed)));
+        }
+
+    private:
+        struct entry
+        {
+            time_point deadline;
+            std::uint64_t sequence;
+            T value;
+        };
+
+        // std::push_heap and std::pop_heap maintain a max-heap
+        struct later
+        {
+            bool operator()(entry const& lhs, entry const& rhs) const noexcept
+            {
+                return lhs.deadline > rhs.deadline ||
+                    (lhs.deadline == rhs.deadline &&
+                        lhs.sequence > rhs.sequence);
+            }
+        };
+
+        void update_earliest_deadline() noexcept
+        {
+            time_point const earliest =
+                heap_.empty() ? (time_point::max)() : heap_.front().deadline;
+            earliest_deadline_.store(
+                earliest.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        using mutex_type = pika::detail::spinlock;
+
+        mutex_type mtx_;
+        std::vector<entry> heap_;
+        std::uint64_t sequence_ = 0;
+        std::atomic<time_point::rep> earliest_deadline_{
+            (time_point::max)().time_since_epoch().count()};
+    };
+
+    struct deadline_queue
+    {
+        template <typename T>
+        struct apply
+        {
+            using type = deadline_queue_backend<T>;
+        };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// The deadline_queue_scheduler maintains one queue per OS thread which is
+    /// ordered by the deadlines of the threads (see
+    /// pika::execution::experimental::with_deadline). Each OS thread runs the
+    /// work with the earliest deadline from its own queue first. When its
+    /// queue is empty it steals from the queue which holds the most urgent
+    /// work. Threads without a deadline run after all threads with a
+    /// deadline. Thread priorities are ignored.
+    template <typename Mutex = std::mutex,
+        typename TerminatedQueuing =
+            default_local_queue_scheduler_terminated_queue>
+    class deadline_queue_scheduler
+      : public local_queue_scheduler<Mutex, deadline_queue, deadline_queue,
+            TerminatedQueuing>
+    {
+    public:
+        using base_type = local_queue_scheduler<Mutex, deadline_queue,
+            deadline_queue, TerminatedQueuing>;
+        using thread_queue_type = typename base_type::thread_queue_type;
+
+        deadline_queue_scheduler(
+            typename base_type::init_parameter_type const& init,
+            bool deferred_initialization = true)
+          : base_type(init, deferred_initialization)
+        {
+        }
+
+        static std::string get_scheduler_name()
+        {
+            return "deadline_queue_scheduler";
+        }
+
+        /// Return the next thread to be executed, return false if none is
+        /// available
+        bool get_next_thread(std::size_t num_thread, bool running,
+            threads::detail::thread_id_ref_type& thrd,
+            bool /*enable_stealing*/) override
+        {
+            PIKA_ASSERT(num_thread < this->queues_.size());
+
+            thread_queue_type* q = this->queues_[num_thread];
+            bool result = q->get_next_thread(thrd);
+
+            q->increment_num_pending_accesses();
+            if (result)
+                return true;
+            q->increment_num_pending_misses();
+
+            // Give up, we should have work to convert.
+            if (q->get_staged_queue_length(std::memory_order_relaxed) != 0 ||
+                !running)
+            {
+                return false;
+            }
+
+            std::size_t const victim =
+                find_most_urgent_queue(num_thread, [](thread_queue_type* q) {
+                    return q->get_pending_queue_length(
+                               std::memory_order_relaxed) != 0;
+                },
+                    [](thread_queue_type* q) {
+                        return q->get_work_items().earliest_deadline();
+                    });
+            if (victim != std::size_t(-1))
+            {
+                thread_queue_type* vq = this->queues_[victim];
+                if (vq->get_next_thread(thrd, running))
+                {
+                    vq->increment_num_stolen_from_pending();
+                    q->increment_num_stolen_to_pending();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /// This is a function which gets called periodically by the thread
+        /// manager to allow for maintenance tasks to be executed in the
+        /// scheduler. Returns true if the OS thread calling this function
+        /// has to be terminated (i.e. no more work has to be done).
+        bool wait_or_add_new(std::size_t num_thread, bool running,
+            std::int64_t& idle_loop_count, bool /*enable_stealing*/,
+            std::size_t& added) override
+        {
+            PIKA_ASSERT(num_thread < this->queues_.size());
+
+            added = 0;
+
+            thread_queue_type* q = this->queues_[num_thread];
+            bool result = q->wait_or_add_new(running, added);
+            if (0 != added)
+                return result;
+
+            // Check if we have been disabled
+            if (!running)
+            {
+                return true;
+            }
+
+            std::size_t const victim =
+                find_most_urgent_queue(num_thread, [](thread_queue_type* q) {
+                    return q->get_staged_queue_length(
+                               std::memory_order_relaxed) != 0;
+                },
+                    [](thread_queue_type* q) {
+                        return (std::min)(
+                            q->get_new_tasks().earliest_deadline(),
+                            q->get_new_bound_tasks().earliest_deadline());
+                    });
+            if (victim != std::size_t(-1))
+            {
+                thread_queue_type* vq = this->queues_[victim];
+                result = q->wait_or_add_new(running, added, vq) && result;
+                if (0 != added)
+                {
+                    vq->increment_num_stolen_from_staged(added);
+                    q->increment_num_stolen_to_staged(added);
+                    return result;
+                }
+            }
+
+#ifdef PIKA_HAVE_THREAD_MINIMAL_DEADLOCK_DETECTION
+            // no new work is available, are we deadlocked?
+            if (PIKA_UNLIKELY(get_minimal_deadlock_detection_enabled() &&
+                    LPIKA_ENABLED(error)))
+            {
+                bool suspended_only = true;
+
+                for (std::size_t i = 0;
+                     suspended_only && i != this->queues_.size(); ++i)
+                {
+                    suspended_only = this->queues_[i]->dump_suspended_threads(
+                        i, idle_loop_count, running);
+                }
+
+                if (PIKA_UNLIKELY(suspended_only))
+                {
+                    LTM_(warning).format(
+                        "queue({}): no new work available, are we deadlocked?",
+                        num_thread);
+                }
+            }
+#else
+            PIKA_UNUSED(idle_loop_count);
+#endif
+
+            return result;
+        }
+
+    private:
+        // Returns the index of the queue other than the queue of num_thread
+        // which has work and the earliest deadline, or std::size_t(-1) if no
+        // other queue has work. Queues in other NUMA domains are only
+        // considered if NUMA stealing is enabled.
+        template <typename HasWork, typename GetDeadline>
+        std::size_t find_most_urgent_queue(std::size_t num_thread,
+            HasWork&& has_work, GetDeadline&& get_deadline) const
+        {
+            bool const numa_stealing =
+                this->has_scheduler_mode(scheduler_mode::enable_stealing_numa);
+
+            std::size_t const queues_size = this->queues_.size();
+            std::size_t victim = std::size_t(-1);
+            auto earliest = (std::chrono::steady_clock::time_point::max)();
+            for (std::size_t i = 1; i != queues_size; ++i)
+            {
+                std::size_t const idx = (i + num_thread) % queues_size;
+
+                if (!numa_stealing &&
+                    !::pika::threads::detail::test(
+                        this->numa_domain_masks_[num_thread],
+                        this->affinity_data_.get_pu_num(idx)))    //-V600
+                {
+                    continue;
+                }
+
+                thread_queue_type* q = this->queues_[idx];
+                if (!has_work(q))
+                {
+                    continue;
+                }
+
+                auto const deadline = get_deadline(q);
+                if (victim == std::size_t(-1) || deadline < earliest)
+                {
+                    earliest = deadline;
+                    victim = idx;
+                }
+            }
+            return victim;
+        }
+    };
+}    // namespace pika::threads
+
+template <typename Mutex, typename TerminatedQueuing>
+struct fmt::formatter<
+    pika::threads::deadline_queue_scheduler<Mutex, TerminatedQueuing>>
+  : fmt::formatter<pika::threads::detail::scheduler_base>
+{
+    template <typename FormatContext>
+    auto format(pika::threads::detail::scheduler_base const& scheduler,
+        FormatContext& ctx)
+    {
+        return fmt::formatter<pika::threads::detail::scheduler_base>::format(
+            scheduler, ctx);
+    }
+};
+
+#include <pika/config/warnings_suffix.hpp>
@@ -529,8 +529,8 @@ namespace pika::threads {
             std::unique_lock<pu_mutex_type> l;
             num_thread = select_active_pu(l, num_thread);
 
-            data.schedulehint.mode =
-                execution::thread_schedule_hint_mode::thread;
+            // The mode is left as is so that staged work which was not bound
+            // to a worker thread can be given to other pools.
             data.schedulehint.hint = static_cast<std::int16_t>(num_thread);
 
             // now create the thread
@@ -1110,6 +1110,24 @@ namespace pika::threads {
         }
 #endif
 
+        /// Give a staged task without worker thread hint to another pool.
+        /// High priority work is never given away.
+        bool steal_staged_task(
+            threads::detail::thread_init_data& data) override
+        {
+            std::size_t const first =
+                curr_queue_.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i != num_queues_; ++i)
+            {
+                if (queues_[(first + i) % num_queues_].data_->steal_staged_task(
+                        data))
+                {
+                    return true;
+                }
+            }
+            return low_priority_queue_.steal_staged_task(data);
+        }
+
         /// This is a function which gets called periodically by the thread
         /// manager to allow for maintenance tasks to be executed in the
         /// scheduler. Returns true if the OS thread calling this function
@@ -701,6 +701,23 @@ namespace pika::threads {
         }
 #endif
 
+        /// Give a staged task without worker thread hint to another pool.
+        bool steal_staged_task(
+            threads::detail::thread_init_data& data) override
+        {
+            std::size_t const queues_size = queues_.size();
+            std::size_t const first =
+                curr_queue_.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i != queues_size; ++i)
+            {
+                if (queues_[(first + i) % queues_size]->steal_staged_task(data))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
         /// This is a function which gets called periodically by the thread
         /// manager to allow for maintenance tasks to be executed in the
         /// scheduler. Returns true if the OS thread calling this function
@@ -22,6 +22,7 @@
 #include <pika/threading_base/thread_data.hpp>
 #include <pika/threading_base/thread_data_stackful.hpp>
 #include <pika/threading_base/thread_data_stackless.hpp>
+#include <pika/threading_base/thread_num_tss.hpp>
 #include <pika/threading_base/thread_queue_init_parameters.hpp>
 #include <pika/util/get_and_reset_value.hpp>
 
@@ -31,6 +32,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstddef>
@@ -46,6 +48,107 @@
 #include <vector>
 
 ///////////////////////////////////////////////////////////////////////////////
+namespace pika::threads::detail {
+#if defined(PIKA_HAVE_SHARDED_THREAD_COUNTS)
+    // The counters of a thread_queue are split into a shard updated by the
+    // worker thread owning the queue and a shard updated by all other threads,
+    // e.g. when stealing work or when scheduling threads on another worker.
+    // The owner updates its counters without sharing the cache line with
+    // other workers. Reading a counter sums both shards.
+    class thread_queue_counter
+    {
+    public:
+        explicit thread_queue_counter(std::size_t owner = std::size_t(-1))
+          : owner_(owner)
+        {
+        }
+
+        void set_owner(std::size_t owner) noexcept
+        {
+            owner_ = owner;
+        }
+
+        void operator++() noexcept
+        {
+            get_shard().fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void operator--() noexcept
+        {
+            get_shard().fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        std::int64_t load(
+            std::memory_order order = std::memory_order_seq_cst) const noexcept
+        {
+            return owner_count_.data_.load(order) +
+                remote_count_.data_.load(order);
+        }
+
+        operator std::int64_t() const noexcept
+        {
+            return load();
+        }
+
+        void reset() noexcept
+        {
+            owner_count_.data_.store(0, std::memory_order_relaxed);
+            remote_count_.data_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::int64_t>& get_shard() noexcept
+        {
+            return get_local_thread_num_tss() == owner_ ? owner_count_.data_ :
+                                                          remote_count_.data_;
+        }
+
+        std::size_t owner_;
+        pika::concurrency::detail::cache_line_data<std::atomic<std::int64_t>>
+            owner_count_;
+        pika::concurrency::detail::cache_line_data<std::atomic<std::int64_t>>
+            remote_count_;
+    };
+#else
+    class thread_queue_counter
+    {
+    public:
+        explicit thread_queue_counter(std::size_t = std::size_t(-1)) {}
+
+        void set_owner(std::size_t) noexcept {}
+
+        void operator++() noexcept
+        {
+            ++count_;
+        }
+
+        void operator--() noexcept
+        {
+            --count_;
+        }
+
+        std::int64_t load(
+            std::memory_order order = std::memory_order_seq_cst) const noexcept
+        {
+            return count_.load(order);
+        }
+
+        operator std::int64_t() const noexcept
+        {
+            return load();
+        }
+
+        void reset() noexcept
+        {
+            count_ = 0;
+        }
+
+    private:
+        std::atomic<std::int64_t> count_{0};
+    };
+#endif
+}    // namespace pika::threads::detail
+
 namespace pika::threads {
     ///////////////////////////////////////////////////////////////////////////
     // // Queue back-end interface:
@@ -207,6 +310,35 @@ namespace pika::threads {
         static pika::detail::internal_allocator<task_description>
             task_description_alloc_;
 
+        // Staged tasks with a worker thread hint are bound to this pool. They
+        // are kept apart from the other staged tasks, which other pools may
+        // steal.
+        static bool is_bound_task(task_description const* task) noexcept
+        {
+            return task->data.schedulehint.mode ==
+                execution::thread_schedule_hint_mode::thread;
+        }
+
+        bool push_new_task(task_description* task)
+        {
+            return is_bound_task(task) ? new_bound_tasks_.push(task) :
+                                         new_tasks_.push(task);
+        }
+
+        // Pops a staged task, alternating between the bound and the other
+        // staged tasks on each call with the same bound flag
+        bool pop_new_task(task_description*& task, bool steal, bool& bound)
+        {
+            bound = !bound;
+            if (bound)
+            {
+                return new_bound_tasks_.pop(task, steal) ||
+                    new_tasks_.pop(task, steal);
+            }
+            return new_tasks_.pop(task, steal) ||
+                new_bound_tasks_.pop(task, steal);
+        }
+
         ///////////////////////////////////////////////////////////////////////
         // add new threads if there is some amount of work available
         std::size_t add_new(std::int64_t add_count, thread_queue* addfrom,
@@ -218,8 +350,10 @@ namespace pika::threads {
                 return 0;
 
             std::size_t added = 0;
+            std::vector<threads::detail::thread_function_type> aborted;
             task_description* task = nullptr;
-            while (add_count-- && addfrom->new_tasks_.pop(task, steal))
+            bool bound = false;
+            while (add_count-- && addfrom->pop_new_task(task, steal, bound))
             {
 #ifdef PIKA_HAVE_THREAD_QUEUE_WAITTIME
                 if (get_maintain_queue_wait_times_enabled())
@@ -236,6 +370,19 @@ namespace pika::threads {
                 // create the new thread
                 threads::detail::thread_init_data& data = task->data;
 
+                // cancelled work is completed without creating a thread, but
+                // only once the queues have been updated
+                if (PIKA_UNLIKELY(data.stop_requested != nullptr &&
+                        data.stop_requested(data.func)))
+                {
+                    aborted.push_back(PIKA_MOVE(data.func));
+
+                    task->~task_description();
+                    task_description_alloc_.deallocate(task, 1);
+                    --addfrom->new_tasks_count_.data_;
+                    continue;
+                }
+
                 bool schedule_now = data.initial_state ==
                     threads::detail::thread_schedule_state::pending;
                 (void) schedule_now;
@@ -275,6 +422,16 @@ namespace pika::threads {
                 schedule_thread(PIKA_MOVE(thrd));
             }
 
+            if (PIKA_UNLIKELY(!aborted.empty()))
+            {
+                pika::detail::unlock_guard<std::unique_lock<mutex_type>> ull(
+                    lk);
+                for (auto& func : aborted)
+                {
+                    func(threads::detail::thread_restart_state::abort);
+                }
+            }
+
             if (added)
             {
                 LTM_(debug).format("add_new: added {} tasks to queues", added);
@@ -460,15 +617,16 @@ namespace pika::threads {
         thread_queue(std::size_t queue_num = std::size_t(-1),
             detail::thread_queue_init_parameters parameters = {})
           : parameters_(parameters)
-          , thread_map_count_(0)
+          , thread_map_count_(queue_num)
           , work_items_(128, queue_num)
 #ifdef PIKA_HAVE_THREAD_QUEUE_WAITTIME
           , work_items_wait_(0)
           , work_items_wait_count_(0)
 #endif
           , terminated_items_(128)
-          , terminated_items_count_(0)
+          , terminated_items_count_(queue_num)
           , new_tasks_(128)
+          , new_bound_tasks_(128)
 #ifdef PIKA_HAVE_THREAD_QUEUE_WAITTIME
           , new_tasks_wait_(0)
           , new_tasks_wait_count_(0)
@@ -491,8 +649,8 @@ namespace pika::threads {
           , stolen_to_staged_(0)
 #endif
         {
-            new_tasks_count_.data_ = 0;
-            work_items_count_.data_ = 0;
+            new_tasks_count_.data_.set_owner(queue_num);
+            work_items_count_.data_.set_owner(queue_num);
         }
 
         static void deallocate(threads::detail::thread_data* p)
@@ -554,6 +712,23 @@ namespace pika::threads {
             return new_tasks_count_.data_.load(order);
         }
 
+        // Access to the queue backends for schedulers which inspect them,
+        // e.g. to decide which queue to steal from
+        work_items_type const& get_work_items() const noexcept
+        {
+            return work_items_;
+        }
+
+        task_items_type const& get_new_tasks() const noexcept
+        {
+            return new_tasks_;
+        }
+
+        task_items_type const& get_new_bound_tasks() const noexcept
+        {
+            return new_bound_tasks_;
+        }
+
 #ifdef PIKA_HAVE_THREAD_QUEUE_WAITTIME
         std::uint64_t get_average_task_wait_time() const
         {
@@ -763,7 +938,7 @@ namespace pika::threads {
 #else
             new (td) task_description{PIKA_MOVE(data)};    //-V106
 #endif
-            new_tasks_.push(td);
+            push_new_task(td);
             if (&ec != &throws)
                 ec = make_success_code();
         }
@@ -788,7 +963,8 @@ namespace pika::threads {
                 }
 #endif
 
-                bool finished = count == ++work_items_count_.data_;
+                ++work_items_count_.data_;
+                bool finished = count == work_items_count_.data_.load();
                 work_items_.push(trd);
                 if (finished)
                     break;
@@ -798,7 +974,8 @@ namespace pika::threads {
         void move_task_items_from(thread_queue* src, std::int64_t count)
         {
             task_description* task = nullptr;
-            while (src->new_tasks_.pop(task))
+            bool bound = false;
+            while (src->pop_new_task(task, true, bound))
             {
 #ifdef PIKA_HAVE_THREAD_QUEUE_WAITTIME
                 if (get_maintain_queue_wait_times_enabled())
@@ -812,13 +989,14 @@ namespace pika::threads {
                 }
 #endif
 
-                bool finish = count == ++new_tasks_count_.data_;
+                ++new_tasks_count_.data_;
+                bool finish = count == new_tasks_count_.data_.load();
 
                 // Decrement only after the local new_tasks_count_ has
                 // been incremented
                 --src->new_tasks_count_.data_;
 
-                if (new_tasks_.push(task))
+                if (push_new_task(task))
                 {
                     if (finish)
                         break;
@@ -830,6 +1008,44 @@ namespace pika::threads {
             }
         }
 
+        /// Remove a staged task which was not given a worker thread hint, so
+        /// that it can be created by another pool. Returns false if this
+        /// queue has too few staged tasks for stealing.
+        bool steal_staged_task(threads::detail::thread_init_data& data)
+        {
+            if (new_tasks_count_.data_.load(std::memory_order_relaxed) <
+                std::max(parameters_.min_tasks_to_steal_staged_,
+                    std::int64_t(1)))
+            {
+                return false;
+            }
+
+            // tasks bound to a worker thread of this pool are staged in
+            // new_bound_tasks_ and are never stolen
+            task_description* task = nullptr;
+            if (!new_tasks_.pop(task, true))
+            {
+                return false;
+            }
+
+#ifdef PIKA_HAVE_THREAD_QUEUE_WAITTIME
+            if (get_maintain_queue_wait_times_enabled())
+            {
+                std::int64_t now = std::chrono::high_resolution_clock::now()
+                                       .time_since_epoch()
+                                       .count();
+                new_tasks_wait_ += now - task->waittime;
+                ++new_tasks_wait_count_;
+            }
+#endif
+
+            data = PIKA_MOVE(task->data);
+            task->~task_description();
+            task_description_alloc_.deallocate(task, 1);
+            --new_tasks_count_.data_;
+            return true;
+        }
+
         /// Return the next thread to be executed, return false if none is
         /// available
         bool get_next_thread(threads::detail::thread_id_ref_type& thrd,
@@ -904,8 +1120,8 @@ namespace pika::threads {
 
             terminated_items_.push(thrd);
 
-            std::int64_t count = ++terminated_items_count_;
-            if (count > parameters_.max_terminated_threads_)
+            ++terminated_items_count_;
+            if (terminated_items_count_ > parameters_.max_terminated_threads_)
             {
                 cleanup_terminated(true);    // clean up all terminated threads
             }
@@ -1205,7 +1421,7 @@ namespace pika::threads {
             thread_map_;    // mapping of thread id's to pika-threads
 
         // overall count of work items
-        std::atomic<std::int64_t> thread_map_count_;
+        detail::thread_queue_counter thread_map_count_;
 
         work_items_type work_items_;    // list of active work items
 
@@ -1218,9 +1434,10 @@ namespace pika::threads {
         // list of terminated threads
         terminated_items_type terminated_items_;
         // count of terminated items
-        std::atomic<std::int64_t> terminated_items_count_;
+        detail::thread_queue_counter terminated_items_count_;
 
-        task_items_type new_tasks_;    // list of new tasks to run
+        task_items_type new_tasks_;          // list of new tasks to run
+        task_items_type new_bound_tasks_;    // new tasks with a thread hint
 
 #ifdef PIKA_HAVE_THREAD_QUEUE_WAITTIME
         // overall wait time of new tasks
@@ -1258,11 +1475,11 @@ namespace pika::threads {
 #endif
         // count of new tasks to run, separate to new cache line to avoid false
         // sharing
-        pika::concurrency::detail::cache_line_data<std::atomic<std::int64_t>>
+        pika::concurrency::detail::cache_line_data<detail::thread_queue_counter>
             new_tasks_count_;
 
         // count of active work items
-        pika::concurrency::detail::cache_line_data<std::atomic<std::int64_t>>
+        pika::concurrency::detail::cache_line_data<detail::thread_queue_counter>
             work_items_count_;
     };
 
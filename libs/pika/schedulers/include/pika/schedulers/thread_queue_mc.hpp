@@ -92,11 +92,23 @@ namespace pika::threads {
             }
 
             std::size_t added = 0;
+            std::vector<threads::detail::thread_function_type> aborted;
             task_description task;
             while (add_count-- && addfrom->new_task_items_.pop(task, stealing))
             {
                 // create the new thread
                 threads::detail::thread_init_data& data = task;
+
+                // cancelled work is completed without creating a thread, but
+                // only once the queues have been updated
+                if (PIKA_UNLIKELY(data.stop_requested != nullptr &&
+                        data.stop_requested(data.func)))
+                {
+                    aborted.push_back(PIKA_MOVE(data.func));
+                    --addfrom->new_tasks_count_.data_;
+                    continue;
+                }
+
                 threads::detail::thread_id_ref_type tid;
 
                 holder_->create_thread_object(tid, data);
@@ -121,6 +133,11 @@ namespace pika::threads {
                 schedule_work(PIKA_MOVE(tid), stealing);
             }
 
+            for (auto& func : aborted)
+            {
+                func(threads::detail::thread_restart_state::abort);
+            }
+
             return added;
         }
 
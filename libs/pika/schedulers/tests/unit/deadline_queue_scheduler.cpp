@@ -0,0 +1,187 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/modules/schedulers.hpp>
+#include <pika/runtime.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+using time_point = std::chrono::steady_clock::time_point;
+
+struct task
+{
+    pika::threads::detail::thread_init_data data;
+    int id;
+};
+
+void test_backend()
+{
+    pika::threads::deadline_queue_backend<task*> queue;
+    PIKA_TEST(queue.empty());
+    PIKA_TEST(queue.earliest_deadline() == (time_point::max)());
+
+    time_point const now = std::chrono::steady_clock::now();
+    std::vector<task> tasks(6);
+    int const offsets[] = {3, -1, 1, 2, -1, 1};
+    for (int i = 0; i != 6; ++i)
+    {
+        tasks[i].id = i;
+        if (offsets[i] >= 0)
+        {
+            tasks[i].data.deadline = now + std::chrono::seconds(offsets[i]);
+        }
+        queue.push(&tasks[i]);
+    }
+    PIKA_TEST(!queue.empty());
+    PIKA_TEST(queue.earliest_deadline() == now + std::chrono::seconds(1));
+
+    // earliest deadline first, FIFO for equal deadlines, no deadline last
+    int const expected[] = {2, 5, 3, 0, 1, 4};
+    for (int id : expected)
+    {
+        task* t = nullptr;
+        PIKA_TEST(queue.pop(t));
+        PIKA_TEST_EQ(t->id, id);
+    }
+
+    task* t = nullptr;
+    PIKA_TEST(!queue.pop(t));
+    PIKA_TEST(queue.empty());
+    PIKA_TEST(queue.earliest_deadline() == (time_point::max)());
+}
+
+void test_properties()
+{
+    ex::thread_pool_scheduler sched{};
+    PIKA_TEST(ex::get_deadline(sched) == (time_point::max)());
+
+    time_point const deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    auto sched_with_deadline = ex::with_deadline(sched, deadline);
+    PIKA_TEST(ex::get_deadline(sched_with_deadline) == deadline);
+    PIKA_TEST(sched != sched_with_deadline);
+
+    // the deadline is kept by the thread, also after suspension
+    tt::sync_wait(ex::schedule(sched_with_deadline) | ex::then([&] {
+        auto get_thread_deadline = [] {
+            return pika::threads::detail::get_thread_id_data(
+                pika::threads::detail::get_self_id())
+                ->get_deadline();
+        };
+        PIKA_TEST(get_thread_deadline() == deadline);
+        pika::this_thread::yield();
+        PIKA_TEST(get_thread_deadline() == deadline);
+    }));
+}
+
+// With a single worker thread all tasks are queued before any of them runs,
+// so they have to run in the order of their deadlines.
+int pika_main_ordered()
+{
+    test_properties();
+
+    ex::thread_pool_scheduler sched{};
+    time_point const now = std::chrono::steady_clock::now();
+
+    std::mutex mtx;
+    std::vector<int> order;
+    std::vector<ex::unique_any_sender<>> senders;
+    auto record = [&](int id) {
+        return [&, id] {
+            std::lock_guard<std::mutex> l(mtx);
+            order.push_back(id);
+        };
+    };
+
+    // background work without deadlines is spawned first
+    for (int i = 0; i != 10; ++i)
+    {
+        senders.emplace_back(
+            ex::schedule(sched) | ex::then(record(100 + i)) |
+            ex::ensure_started());
+    }
+
+    for (int i : {4, 1, 3, 0, 2})
+    {
+        senders.emplace_back(
+            ex::schedule(ex::with_deadline(
+                sched, now + std::chrono::milliseconds(10 * i))) |
+            ex::then(record(i)) | ex::ensure_started());
+    }
+
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+
+    std::vector<int> expected = {0, 1, 2, 3, 4};
+    for (int i = 0; i != 10; ++i)
+    {
+        expected.push_back(100 + i);
+    }
+    PIKA_TEST(order == expected);
+
+    return pika::finalize();
+}
+
+int pika_main_concurrent()
+{
+    test_properties();
+
+    constexpr std::size_t num_tasks = 1000;
+
+    ex::thread_pool_scheduler sched{};
+    time_point const now = std::chrono::steady_clock::now();
+
+    std::atomic<std::size_t> count(0);
+    std::vector<ex::unique_any_sender<>> senders;
+    for (std::size_t i = 0; i != num_tasks; ++i)
+    {
+        auto s = i % 3 == 0 ?
+            sched :
+            ex::with_deadline(sched, now + std::chrono::microseconds(i % 17));
+        senders.emplace_back(ex::schedule(s) | ex::then([&] {
+            pika::this_thread::yield();
+            ++count;
+        }) | ex::ensure_started());
+    }
+
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+    PIKA_TEST_EQ(count.load(), num_tasks);
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    test_backend();
+
+    {
+        // the command line is ignored to make sure only one worker thread is
+        // used
+        pika::init_params init_args;
+        init_args.cfg = {"pika.os_threads=1", "pika.scheduler=deadline"};
+        PIKA_TEST_EQ(pika::init(pika_main_ordered, 1, argv, init_args), 0);
+    }
+
+    {
+        pika::init_params init_args;
+        init_args.cfg = {"pika.scheduler=deadline"};
+        PIKA_TEST_EQ(
+            pika::init(pika_main_concurrent, argc, argv, init_args), 0);
+    }
+
+    return pika::util::report_errors();
+}
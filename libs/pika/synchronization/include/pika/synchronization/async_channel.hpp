@@ -0,0 +1,498 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/modules/errors.hpp>
+#include <pika/synchronization/spinlock.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pika::execution::experimental {
+    namespace detail {
+        // Base class of operation states waiting on an async_channel or
+        // async_receive_buffer. Waiting operation states are kept in an
+        // intrusive list so that waiting does not allocate.
+        struct async_channel_waiter
+        {
+            async_channel_waiter* next = nullptr;
+            std::exception_ptr error;
+            void (*complete)(async_channel_waiter&) noexcept = nullptr;
+        };
+
+        // the value received by a getter or the value to be stored by a
+        // setter
+        template <typename T>
+        struct async_channel_value_waiter : async_channel_waiter
+        {
+            std::optional<T> value;
+        };
+
+        class async_channel_waiter_queue
+        {
+        public:
+            bool empty() const noexcept
+            {
+                return head == nullptr;
+            }
+
+            void push(async_channel_waiter& w) noexcept
+            {
+                w.next = nullptr;
+                if (tail == nullptr)
+                {
+                    head = &w;
+                }
+                else
+                {
+                    tail->next = &w;
+                }
+                tail = &w;
+            }
+
+            async_channel_waiter& pop() noexcept
+            {
+                PIKA_ASSERT(head != nullptr);
+                async_channel_waiter& w = *head;
+                head = w.next;
+                if (head == nullptr)
+                {
+                    tail = nullptr;
+                }
+                w.next = nullptr;
+                return w;
+            }
+
+            async_channel_waiter_queue take() noexcept
+            {
+                async_channel_waiter_queue q;
+                std::swap(q.head, head);
+                std::swap(q.tail, tail);
+                return q;
+            }
+
+        private:
+            async_channel_waiter* head = nullptr;
+            async_channel_waiter* tail = nullptr;
+        };
+
+        // Completes a waiter at the end of the scope, i.e. after the lock of
+        // the channel has been released.
+        struct complete_waiter_on_exit
+        {
+            async_channel_waiter* w = nullptr;
+
+            ~complete_waiter_on_exit()
+            {
+                if (w != nullptr)
+                {
+                    w->complete(*w);
+                }
+            }
+        };
+    }    // namespace detail
+
+    /// A bounded multi-producer multi-consumer channel where values are sent
+    /// and received through senders.
+    ///
+    /// async_set returns a sender which completes once the value has been
+    /// stored in the channel or handed to a receiver waiting in async_get.
+    /// async_get returns a sender which sends the oldest value of the
+    /// channel. Values are stored in a ring buffer which is allocated when
+    /// the channel is constructed. Operations which can't complete
+    /// immediately are queued in an intrusive list of operation states. The
+    /// channel never allocates after construction. A channel with a capacity
+    /// of zero hands values directly from async_set to async_get.
+    ///
+    /// Once the channel is closed the senders of async_set and of async_get
+    /// on an empty channel complete with an error. The channel must outlive
+    /// all operation states connected to its senders.
+    template <typename T, typename Mutex = pika::spinlock>
+    class async_channel
+    {
+    private:
+        using mutex_type = Mutex;
+        using waiter_type = detail::async_channel_waiter;
+        using value_waiter = detail::async_channel_value_waiter<T>;
+
+    public:
+        explicit async_channel(std::size_t capacity)
+          : buffer_(capacity)
+        {
+        }
+
+        async_channel(async_channel&&) = delete;
+        async_channel& operator=(async_channel&&) = delete;
+        async_channel(async_channel const&) = delete;
+        async_channel& operator=(async_channel const&) = delete;
+
+        ~async_channel()
+        {
+            PIKA_ASSERT(get_waiters_.empty());
+            PIKA_ASSERT(set_waiters_.empty());
+        }
+
+        std::size_t capacity() const noexcept
+        {
+            return buffer_.size();
+        }
+
+        std::size_t size() const
+        {
+            std::lock_guard<mutex_type> l(mtx_);
+            return size_;
+        }
+
+        bool is_closed() const
+        {
+            std::lock_guard<mutex_type> l(mtx_);
+            return closed_;
+        }
+
+        /// Close the channel. Waiting operations complete with an error.
+        /// Values that are already in the channel can still be received.
+        /// Returns the number of waiting operations that were cancelled.
+        std::size_t close()
+        {
+            detail::async_channel_waiter_queue get_waiters;
+            detail::async_channel_waiter_queue set_waiters;
+            {
+                std::lock_guard<mutex_type> l(mtx_);
+                closed_ = true;
+                get_waiters = get_waiters_.take();
+                set_waiters = set_waiters_.take();
+            }
+
+            std::size_t count = 0;
+            for (auto* q : {&get_waiters, &set_waiters})
+            {
+                while (!q->empty())
+                {
+                    waiter_type& w = q->pop();
+                    w.error = closed_error();
+                    w.complete(w);
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        /// Try to receive a value without waiting.
+        std::optional<T> try_get()
+        {
+            detail::complete_waiter_on_exit on_exit;
+            std::lock_guard<mutex_type> l(mtx_);
+            return take_value(on_exit);
+        }
+
+        /// Try to store a value without waiting. Returns false if the
+        /// channel is full or closed.
+        template <typename U>
+        bool try_set(U&& u)
+        {
+            detail::complete_waiter_on_exit on_exit;
+            std::lock_guard<mutex_type> l(mtx_);
+            if (closed_)
+            {
+                return false;
+            }
+            return put_value(PIKA_FORWARD(U, u), on_exit);
+        }
+
+    private:
+        static std::exception_ptr closed_error()
+        {
+            return PIKA_GET_EXCEPTION(pika::error::invalid_status,
+                "pika::execution::experimental::async_channel",
+                "the channel was closed");
+        }
+
+        void push_buffer(T&& t)
+        {
+            PIKA_ASSERT(size_ < buffer_.size());
+            std::size_t pos = head_ + size_;
+            if (pos >= buffer_.size())
+            {
+                pos -= buffer_.size();
+            }
+            buffer_[pos].emplace(PIKA_MOVE(t));
+            ++size_;
+        }
+
+        T pop_buffer()
+        {
+            PIKA_ASSERT(size_ != 0);
+            T t = PIKA_MOVE(*buffer_[head_]);
+            buffer_[head_].reset();
+            if (++head_ == buffer_.size())
+            {
+                head_ = 0;
+            }
+            --size_;
+            return t;
+        }
+
+        // Called with the lock held. A waiting setter whose value has been
+        // moved into the channel is completed after the lock is released.
+        std::optional<T> take_value(detail::complete_waiter_on_exit& on_exit)
+        {
+            std::optional<T> value;
+            if (size_ != 0)
+            {
+                value.emplace(pop_buffer());
+                if (!set_waiters_.empty())
+                {
+                    auto& w = static_cast<value_waiter&>(set_waiters_.pop());
+                    push_buffer(PIKA_MOVE(*w.value));
+                    on_exit.w = &w;
+                }
+            }
+            else if (!set_waiters_.empty())
+            {
+                auto& w = static_cast<value_waiter&>(set_waiters_.pop());
+                value.emplace(PIKA_MOVE(*w.value));
+                on_exit.w = &w;
+            }
+            return value;
+        }
+
+        // Called with the lock held. A waiting getter which receives the
+        // value is completed after the lock is released.
+        template <typename U>
+        bool put_value(U&& u, detail::complete_waiter_on_exit& on_exit)
+        {
+            if (!get_waiters_.empty())
+            {
+                auto& w = static_cast<value_waiter&>(get_waiters_.pop());
+                w.value.emplace(PIKA_FORWARD(U, u));
+                on_exit.w = &w;
+                return true;
+            }
+
+            if (size_ < buffer_.size())
+            {
+                push_buffer(T(PIKA_FORWARD(U, u)));
+                return true;
+            }
+
+            return false;
+        }
+
+        struct get_sender
+        {
+            async_channel* channel;
+
+            template <template <typename...> class Tuple,
+                template <typename...> class Variant>
+            using value_types = Variant<Tuple<T>>;
+
+            template <template <typename...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+
+            static constexpr bool sends_done = false;
+
+            using completion_signatures =
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_value_t(T),
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr)>;
+
+            template <typename R>
+            struct operation_state : value_waiter
+            {
+                PIKA_NO_UNIQUE_ADDRESS std::decay_t<R> r;
+                async_channel* channel;
+
+                template <typename R_>
+                operation_state(R_&& r, async_channel* channel)
+                  : r(PIKA_FORWARD(R_, r))
+                  , channel(channel)
+                {
+                    this->complete = &complete_impl;
+                }
+
+                operation_state(operation_state&&) = delete;
+                operation_state& operator=(operation_state&&) = delete;
+                operation_state(operation_state const&) = delete;
+                operation_state& operator=(operation_state const&) = delete;
+
+                static void complete_impl(waiter_type& w) noexcept
+                {
+                    auto& os = static_cast<operation_state&>(w);
+                    if (os.error)
+                    {
+                        pika::execution::experimental::set_error(
+                            PIKA_MOVE(os.r), PIKA_MOVE(os.error));
+                        return;
+                    }
+
+                    PIKA_ASSERT(os.value);
+                    pika::execution::experimental::set_value(
+                        PIKA_MOVE(os.r), PIKA_MOVE(*os.value));
+                }
+
+                void start() noexcept
+                {
+                    auto& ch = *channel;
+                    {
+                        detail::complete_waiter_on_exit on_exit;
+                        std::unique_lock<mutex_type> l(ch.mtx_);
+                        this->value = ch.take_value(on_exit);
+                        if (!this->value)
+                        {
+                            if (!ch.closed_)
+                            {
+                                ch.get_waiters_.push(*this);
+                                return;
+                            }
+                            this->error = closed_error();
+                        }
+                    }
+                    complete_impl(*this);
+                }
+
+                friend void tag_invoke(pika::execution::experimental::start_t,
+                    operation_state& os) noexcept
+                {
+                    os.start();
+                }
+            };
+
+            template <typename R>
+            friend operation_state<R> tag_invoke(
+                pika::execution::experimental::connect_t, get_sender&& s,
+                R&& r)
+            {
+                return {PIKA_FORWARD(R, r), s.channel};
+            }
+        };
+
+        struct set_sender
+        {
+            async_channel* channel;
+            T value;
+
+            template <template <typename...> class Tuple,
+                template <typename...> class Variant>
+            using value_types = Variant<Tuple<>>;
+
+            template <template <typename...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+
+            static constexpr bool sends_done = false;
+
+            using completion_signatures =
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_value_t(),
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr)>;
+
+            template <typename R>
+            struct operation_state : value_waiter
+            {
+                PIKA_NO_UNIQUE_ADDRESS std::decay_t<R> r;
+                async_channel* channel;
+
+                template <typename R_>
+                operation_state(R_&& r, async_channel* channel, T&& value)
+                  : r(PIKA_FORWARD(R_, r))
+                  , channel(channel)
+                {
+                    this->value.emplace(PIKA_MOVE(value));
+                    this->complete = &complete_impl;
+                }
+
+                operation_state(operation_state&&) = delete;
+                operation_state& operator=(operation_state&&) = delete;
+                operation_state(operation_state const&) = delete;
+                operation_state& operator=(operation_state const&) = delete;
+
+                static void complete_impl(waiter_type& w) noexcept
+                {
+                    auto& os = static_cast<operation_state&>(w);
+                    if (os.error)
+                    {
+                        pika::execution::experimental::set_error(
+                            PIKA_MOVE(os.r), PIKA_MOVE(os.error));
+                        return;
+                    }
+
+                    pika::execution::experimental::set_value(PIKA_MOVE(os.r));
+                }
+
+                void start() noexcept
+                {
+                    auto& ch = *channel;
+                    {
+                        detail::complete_waiter_on_exit on_exit;
+                        std::unique_lock<mutex_type> l(ch.mtx_);
+                        if (ch.closed_)
+                        {
+                            this->error = closed_error();
+                        }
+                        else if (!ch.put_value(
+                                     PIKA_MOVE(*this->value), on_exit))
+                        {
+                            ch.set_waiters_.push(*this);
+                            return;
+                        }
+                    }
+                    complete_impl(*this);
+                }
+
+                friend void tag_invoke(pika::execution::experimental::start_t,
+                    operation_state& os) noexcept
+                {
+                    os.start();
+                }
+            };
+
+            template <typename R>
+            friend operation_state<R> tag_invoke(
+                pika::execution::experimental::connect_t, set_sender&& s,
+                R&& r)
+            {
+                return {PIKA_FORWARD(R, r), s.channel, PIKA_MOVE(s.value)};
+            }
+        };
+
+    public:
+        /// Returns a sender which sends the oldest value of the channel once
+        /// one is available.
+        get_sender async_get()
+        {
+            return {this};
+        }
+
+        /// Returns a sender which completes once \a u has been stored in the
+        /// channel.
+        template <typename U>
+        set_sender async_set(U&& u)
+        {
+            return {this, T(PIKA_FORWARD(U, u))};
+        }
+
+    private:
+        mutable mutex_type mtx_;
+        std::vector<std::optional<T>> buffer_;
+        std::size_t head_ = 0;
+        std::size_t size_ = 0;
+        bool closed_ = false;
+        detail::async_channel_waiter_queue get_waiters_;
+        detail::async_channel_waiter_queue set_waiters_;
+    };
+}    // namespace pika::execution::experimental
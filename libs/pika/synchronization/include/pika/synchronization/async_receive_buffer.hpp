@@ -0,0 +1,330 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/execution_base/operation_state.hpp>
+#include <pika/execution_base/receiver.hpp>
+#include <pika/execution_base/sender.hpp>
+#include <pika/modules/errors.hpp>
+#include <pika/synchronization/async_channel.hpp>
+#include <pika/synchronization/spinlock.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pika::execution::experimental {
+    /// A buffer of values indexed by a step number where values are received
+    /// through senders, e.g. for receiving the values of neighbors in an
+    /// iterative computation.
+    ///
+    /// receive(step) returns a sender which sends the value of the given step
+    /// once it has been stored with store_received. Each step can be stored
+    /// and received once, the entry of the step is released once both have
+    /// happened. The entries are stored in a ring of \a window entries which
+    /// is allocated when the buffer is constructed, i.e. steps which are in
+    /// use at the same time must be within \a window of each other. The
+    /// buffer never allocates after construction.
+    ///
+    /// The buffer must outlive all operation states connected to its
+    /// senders.
+    template <typename T, typename Mutex = pika::spinlock>
+    class async_receive_buffer
+    {
+    private:
+        using mutex_type = Mutex;
+        using waiter_type = detail::async_channel_waiter;
+        using value_waiter = detail::async_channel_value_waiter<T>;
+
+        struct entry
+        {
+            std::size_t step = 0;
+            bool used = false;
+            std::optional<T> value;
+            value_waiter* waiter = nullptr;
+        };
+
+    public:
+        explicit async_receive_buffer(std::size_t window)
+          : entries_(window)
+        {
+            if (window == 0)
+            {
+                PIKA_THROW_EXCEPTION(pika::error::bad_parameter,
+                    "async_receive_buffer::async_receive_buffer",
+                    "the window of the receive buffer must not be zero");
+            }
+        }
+
+        async_receive_buffer(async_receive_buffer&&) = delete;
+        async_receive_buffer& operator=(async_receive_buffer&&) = delete;
+        async_receive_buffer(async_receive_buffer const&) = delete;
+        async_receive_buffer& operator=(async_receive_buffer const&) = delete;
+
+        ~async_receive_buffer()
+        {
+            PIKA_ASSERT(empty());
+        }
+
+        std::size_t window() const noexcept
+        {
+            return entries_.size();
+        }
+
+        bool empty() const
+        {
+            std::lock_guard<mutex_type> l(mtx_);
+            return num_used_ == 0;
+        }
+
+        /// Store the value of the given step. Completes an operation waiting
+        /// for the step. Throws if the entry for the step is in use by a
+        /// different step, or if the value of the step was stored already.
+        template <typename U>
+        void store_received(std::size_t step, U&& u)
+        {
+            value_waiter* w = nullptr;
+            {
+                std::lock_guard<mutex_type> l(mtx_);
+                entry& e =
+                    get_entry(step, "async_receive_buffer::store_received");
+                if (e.value)
+                {
+                    PIKA_THROW_EXCEPTION(pika::error::invalid_status,
+                        "async_receive_buffer::store_received",
+                        "the value of step {} was stored already", step);
+                }
+
+                if (e.waiter != nullptr)
+                {
+                    w = std::exchange(e.waiter, nullptr);
+                    w->value.emplace(PIKA_FORWARD(U, u));
+                    release_entry(e);
+                }
+                else
+                {
+                    e.value.emplace(PIKA_FORWARD(U, u));
+                }
+            }
+
+            if (w != nullptr)
+            {
+                w->complete(*w);
+            }
+        }
+
+        /// Try to receive the value of the given step without waiting.
+        std::optional<T> try_receive(std::size_t step)
+        {
+            std::lock_guard<mutex_type> l(mtx_);
+            entry& e = entries_[step % entries_.size()];
+            if (!e.used || e.step != step || !e.value)
+            {
+                return std::nullopt;
+            }
+
+            std::optional<T> value = PIKA_MOVE(e.value);
+            release_entry(e);
+            return value;
+        }
+
+        /// Complete all waiting operations with the given error. Stored
+        /// values which have not been received are released if \a
+        /// force_delete_entries is true. Returns the number of released
+        /// entries.
+        std::size_t cancel_waiting(
+            std::exception_ptr const& e, bool force_delete_entries = false)
+        {
+            detail::async_channel_waiter_queue waiters;
+            std::size_t count = 0;
+            {
+                std::lock_guard<mutex_type> l(mtx_);
+                for (entry& en : entries_)
+                {
+                    if (!en.used)
+                    {
+                        continue;
+                    }
+
+                    if (en.waiter != nullptr)
+                    {
+                        waiters.push(*std::exchange(en.waiter, nullptr));
+                    }
+                    else if (!force_delete_entries)
+                    {
+                        continue;
+                    }
+
+                    release_entry(en);
+                    ++count;
+                }
+            }
+
+            while (!waiters.empty())
+            {
+                waiter_type& w = waiters.pop();
+                w.error = e;
+                w.complete(w);
+            }
+            return count;
+        }
+
+    private:
+        // Called with the lock held.
+        entry& get_entry(std::size_t step, char const* function_name)
+        {
+            entry& e = entries_[step % entries_.size()];
+            if (!e.used)
+            {
+                e.used = true;
+                e.step = step;
+                ++num_used_;
+            }
+            else if (e.step != step)
+            {
+                PIKA_THROW_EXCEPTION(pika::error::bad_parameter,
+                    function_name,
+                    "step {} is outside of the window of the receive buffer, "
+                    "step {} is still in use (window: {})",
+                    step, e.step, entries_.size());
+            }
+            return e;
+        }
+
+        void release_entry(entry& e) noexcept
+        {
+            PIKA_ASSERT(e.used);
+            e.used = false;
+            e.value.reset();
+            e.waiter = nullptr;
+            --num_used_;
+        }
+
+        struct receive_sender
+        {
+            async_receive_buffer* buffer;
+            std::size_t step;
+
+            template <template <typename...> class Tuple,
+                template <typename...> class Variant>
+            using value_types = Variant<Tuple<T>>;
+
+            template <template <typename...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+
+            static constexpr bool sends_done = false;
+
+            using completion_signatures =
+                pika::execution::experimental::completion_signatures<
+                    pika::execution::experimental::set_value_t(T),
+                    pika::execution::experimental::set_error_t(
+                        std::exception_ptr)>;
+
+            template <typename R>
+            struct operation_state : value_waiter
+            {
+                PIKA_NO_UNIQUE_ADDRESS std::decay_t<R> r;
+                async_receive_buffer* buffer;
+                std::size_t step;
+
+                template <typename R_>
+                operation_state(
+                    R_&& r, async_receive_buffer* buffer, std::size_t step)
+                  : r(PIKA_FORWARD(R_, r))
+                  , buffer(buffer)
+                  , step(step)
+                {
+                    this->complete = &complete_impl;
+                }
+
+                operation_state(operation_state&&) = delete;
+                operation_state& operator=(operation_state&&) = delete;
+                operation_state(operation_state const&) = delete;
+                operation_state& operator=(operation_state const&) = delete;
+
+                static void complete_impl(waiter_type& w) noexcept
+                {
+                    auto& os = static_cast<operation_state&>(w);
+                    if (os.error)
+                    {
+                        pika::execution::experimental::set_error(
+                            PIKA_MOVE(os.r), PIKA_MOVE(os.error));
+                        return;
+                    }
+
+                    PIKA_ASSERT(os.value);
+                    pika::execution::experimental::set_value(
+                        PIKA_MOVE(os.r), PIKA_MOVE(*os.value));
+                }
+
+                void start() noexcept
+                {
+                    auto& buf = *buffer;
+                    try
+                    {
+                        std::lock_guard<mutex_type> l(buf.mtx_);
+                        entry& e = buf.get_entry(
+                            step, "async_receive_buffer::receive");
+                        if (e.waiter != nullptr)
+                        {
+                            PIKA_THROW_EXCEPTION(pika::error::invalid_status,
+                                "async_receive_buffer::receive",
+                                "step {} is being received already", step);
+                        }
+
+                        if (!e.value)
+                        {
+                            e.waiter = this;
+                            return;
+                        }
+
+                        this->value = PIKA_MOVE(e.value);
+                        buf.release_entry(e);
+                    }
+                    catch (...)
+                    {
+                        this->error = std::current_exception();
+                    }
+                    complete_impl(*this);
+                }
+
+                friend void tag_invoke(pika::execution::experimental::start_t,
+                    operation_state& os) noexcept
+                {
+                    os.start();
+                }
+            };
+
+            template <typename R>
+            friend operation_state<R> tag_invoke(
+                pika::execution::experimental::connect_t, receive_sender&& s,
+                R&& r)
+            {
+                return {PIKA_FORWARD(R, r), s.buffer, s.step};
+            }
+        };
+
+    public:
+        /// Returns a sender which sends the value of the given step once it
+        /// has been stored.
+        receive_sender receive(std::size_t step)
+        {
+            return {this, step};
+        }
+
+    private:
+        mutable mutex_type mtx_;
+        std::vector<entry> entries_;
+        std::size_t num_used_ = 0;
+    };
+}    // namespace pika::execution::experimental
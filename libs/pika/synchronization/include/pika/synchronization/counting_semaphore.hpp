@@ -90,8 +90,12 @@ namespace pika {
         //                  types ([thread.mutex.requirements.mutex]).
         void release(std::ptrdiff_t update = 1)
         {
-            std::unique_lock<mutex_type> l(mtx_);
-            sem_.signal(PIKA_MOVE(l), update);
+            // the lock is only needed if threads have to be woken up
+            if (!sem_.release_fast(update))
+            {
+                std::unique_lock<mutex_type> l(mtx_);
+                sem_.notify(PIKA_MOVE(l), update);
+            }
         }
 
         // Effects:         Attempts to atomically decrement counter if it is
@@ -108,8 +112,7 @@ namespace pika {
         // Returns:         true if counter was decremented, otherwise false.
         bool try_acquire() noexcept
         {
-            std::unique_lock<mutex_type> l(mtx_);
-            return sem_.try_acquire(l);
+            return sem_.try_acquire_fast(1);
         }
 
         // Effects:         Repeatedly performs the following steps, in order:
@@ -123,6 +126,11 @@ namespace pika {
         //                  types ([thread.mutex.requirements.mutex]).
         void acquire()
         {
+            if (sem_.try_acquire_fast(1))
+            {
+                return;
+            }
+
             std::unique_lock<mutex_type> l(mtx_);
             sem_.wait(l, 1);
         }
@@ -145,6 +153,11 @@ namespace pika {
         //                  ([thread.mutex.requirements.mutex]).
         bool try_acquire_until(pika::chrono::steady_time_point const& abs_time)
         {
+            if (sem_.try_acquire_fast(1))
+            {
+                return true;
+            }
+
             std::unique_lock<mutex_type> l(mtx_);
             return sem_.wait_until(l, abs_time, 1);
         }
@@ -11,6 +11,7 @@
 #include <pika/synchronization/detail/condition_variable.hpp>
 #include <pika/synchronization/spinlock.hpp>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
@@ -23,6 +24,9 @@
 ////////////////////////////////////////////////////////////////////////////////
 namespace pika::detail {
 
+    // The count is kept in an atomic so that acquiring and releasing the
+    // semaphore does not need to take the lock as long as no thread has to
+    // wait. The lock is only needed for suspending and notifying threads.
     class counting_semaphore
     {
     private:
@@ -32,6 +36,32 @@ namespace pika::detail {
         PIKA_EXPORT counting_semaphore(std::ptrdiff_t value = 0);
         PIKA_EXPORT ~counting_semaphore();
 
+        // Decrement the count by the given amount if that leaves it
+        // non-negative, without taking the lock.
+        bool try_acquire_fast(std::ptrdiff_t count = 1) noexcept
+        {
+            // sequentially consistent to pair with the check for waiting
+            // threads in release_fast
+            std::ptrdiff_t value = value_.load(std::memory_order_seq_cst);
+            while (value >= count)
+            {
+                if (value_.compare_exchange_weak(value, value - count,
+                        std::memory_order_seq_cst))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Increment the count without taking the lock. Returns false if
+        // threads may be waiting, in which case notify has to be called.
+        bool release_fast(std::ptrdiff_t count) noexcept
+        {
+            value_.fetch_add(count, std::memory_order_seq_cst);
+            return num_waiting_.load(std::memory_order_seq_cst) == 0;
+        }
+
         PIKA_EXPORT void wait(
             std::unique_lock<mutex_type>& l, std::ptrdiff_t count);
 
@@ -47,10 +77,16 @@ namespace pika::detail {
         PIKA_EXPORT void signal(
             std::unique_lock<mutex_type> l, std::ptrdiff_t count);
 
+        // Wake up to count waiting threads after the count has been
+        // incremented with release_fast.
+        PIKA_EXPORT void notify(
+            std::unique_lock<mutex_type> l, std::ptrdiff_t count);
+
         PIKA_EXPORT std::ptrdiff_t signal_all(std::unique_lock<mutex_type> l);
 
     private:
-        std::ptrdiff_t value_;
+        std::atomic<std::ptrdiff_t> value_;
+        std::atomic<std::size_t> num_waiting_;
         pika::detail::condition_variable cond_;
     };
 }    // namespace pika::detail
@@ -10,6 +10,8 @@
 #include <pika/synchronization/detail/condition_variable.hpp>
 #include <pika/synchronization/spinlock.hpp>
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <utility>
@@ -22,6 +24,9 @@
 ////////////////////////////////////////////////////////////////////////////////
 namespace pika::detail {
 
+    // The limits are kept in atomics so that waiting and signaling do not
+    // need to take the lock as long as no thread has to wait. The lock is
+    // only needed for suspending and notifying threads.
     class sliding_semaphore
     {
     private:
@@ -35,6 +40,31 @@ namespace pika::detail {
         PIKA_EXPORT void set_max_difference(std::unique_lock<mutex_type>& l,
             std::int64_t max_difference, std::int64_t lower_limit);
 
+        // Returns true if a thread waiting for the given upper limit would
+        // not have to suspend, without taking the lock.
+        bool try_wait_fast(std::int64_t upper_limit) const noexcept
+        {
+            // sequentially consistent to pair with the check for waiting
+            // threads in signal_fast
+            return upper_limit -
+                max_difference_.load(std::memory_order_seq_cst) <=
+                lower_limit_.load(std::memory_order_seq_cst);
+        }
+
+        // Update the lower limit without taking the lock. Returns false if
+        // threads may be waiting, in which case notify has to be called.
+        bool signal_fast(std::int64_t lower_limit) noexcept
+        {
+            std::int64_t current =
+                lower_limit_.load(std::memory_order_relaxed);
+            while (current < lower_limit &&
+                !lower_limit_.compare_exchange_weak(
+                    current, lower_limit, std::memory_order_seq_cst))
+            {
+            }
+            return num_waiting_.load(std::memory_order_seq_cst) == 0;
+        }
+
         PIKA_EXPORT void wait(
             std::unique_lock<mutex_type>& l, std::int64_t upper_limit);
 
@@ -44,11 +74,16 @@ namespace pika::detail {
         PIKA_EXPORT void signal(
             std::unique_lock<mutex_type> l, std::int64_t lower_limit);
 
+        // Wake up all waiting threads after the lower limit has been updated
+        // with signal_fast.
+        PIKA_EXPORT void notify(std::unique_lock<mutex_type> l);
+
         PIKA_EXPORT std::int64_t signal_all(std::unique_lock<mutex_type> l);
 
     private:
-        std::int64_t max_difference_;
-        std::int64_t lower_limit_;
+        std::atomic<std::int64_t> max_difference_;
+        std::atomic<std::int64_t> lower_limit_;
+        std::atomic<std::size_t> num_waiting_;
         pika::detail::condition_variable cond_;
     };
 }    // namespace pika::detail
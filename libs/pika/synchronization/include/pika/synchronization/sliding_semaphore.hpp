@@ -85,6 +85,11 @@ namespace pika {
         ///           set by signal() is larger than the max_difference.
         void wait(std::int64_t upper_limit)
         {
+            if (sem_.try_wait_fast(upper_limit))
+            {
+                return;
+            }
+
             std::unique_lock<mutex_type> l(mtx_);
             sem_.wait(l, upper_limit);
         }
@@ -100,8 +105,7 @@ namespace pika {
         ///           would not block if it was calling wait().
         bool try_wait(std::int64_t upper_limit = 1)
         {
-            std::unique_lock<mutex_type> l(mtx_);
-            return sem_.try_wait(l, upper_limit);
+            return sem_.try_wait_fast(upper_limit);
         }
 
         /// \brief Signal the semaphore
@@ -113,8 +117,12 @@ namespace pika {
         ///             limit plus the max_difference.
         void signal(std::int64_t lower_limit)
         {
-            std::unique_lock<mutex_type> l(mtx_);
-            sem_.signal(PIKA_MOVE(l), lower_limit);
+            // the lock is only needed if threads have to be woken up
+            if (!sem_.signal_fast(lower_limit))
+            {
+                std::unique_lock<mutex_type> l(mtx_);
+                sem_.notify(PIKA_MOVE(l));
+            }
         }
 
         std::int64_t signal_all()
@@ -0,0 +1,225 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/assert.hpp>
+#include <pika/concurrency/cache_line_data.hpp>
+#include <pika/execution_base/this_thread.hpp>
+#include <pika/modules/errors.hpp>
+#include <pika/synchronization/barrier.hpp>
+#include <pika/synchronization/detail/condition_variable.hpp>
+#include <pika/synchronization/spinlock.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <pika/config/warnings_prefix.hpp>
+
+namespace pika {
+    /// A barrier for a fixed number of participants which arrive at the
+    /// leaves of a combining tree instead of at a single counter.
+    ///
+    /// Each participant identifies itself with an index in [0,
+    /// num_participants) when arriving. Participants with the same leaf
+    /// decrement the counter of that leaf, the last one of them carries the
+    /// arrival to the parent node, and the last arrival at the root runs the
+    /// completion function and starts the next phase. Each node of the tree
+    /// is on its own cache line so that at most \a fan_in participants
+    /// contend on one counter.
+    ///
+    /// Waiting participants first spin (yielding pika threads) for up to
+    /// \a spin_count iterations and then suspend until the phase is
+    /// completed. Waiting works for both pika threads and OS threads. The
+    /// completion function is only called by the participant completing a
+    /// phase, waking up suspended participants takes a lock only if a
+    /// participant is actually suspended.
+    template <typename OnCompletion = detail::empty_oncompletion>
+    class tree_barrier
+    {
+    public:
+        PIKA_NON_COPYABLE(tree_barrier);
+
+    private:
+        using mutex_type = pika::spinlock;
+
+        static constexpr std::size_t no_parent = std::size_t(-1);
+
+        struct node
+        {
+            std::atomic<std::size_t> count{0};
+            std::size_t expected = 0;
+            std::size_t parent = no_parent;
+        };
+
+    public:
+        using arrival_token = std::size_t;
+
+        static constexpr std::size_t default_fan_in = 4;
+        static constexpr std::size_t default_spin_count = 128;
+
+        explicit tree_barrier(std::size_t num_participants,
+            OnCompletion completion = OnCompletion(),
+            std::size_t fan_in = default_fan_in,
+            std::size_t spin_count = default_spin_count)
+          : num_participants_(num_participants)
+          , fan_in_(fan_in)
+          , spin_count_(spin_count)
+          , completion_(PIKA_MOVE(completion))
+        {
+            if (num_participants == 0 || fan_in < 2)
+            {
+                PIKA_THROW_EXCEPTION(pika::error::bad_parameter,
+                    "tree_barrier::tree_barrier",
+                    "the number of participants must be positive and the "
+                    "fan-in must be at least two (num_participants: {}, "
+                    "fan_in: {})",
+                    num_participants, fan_in);
+            }
+
+            // count the nodes of all levels, the leaves come first
+            std::size_t num_nodes = 0;
+            for (std::size_t n = num_participants;;)
+            {
+                n = (n + fan_in - 1) / fan_in;
+                num_nodes += n;
+                if (n == 1)
+                {
+                    break;
+                }
+            }
+            nodes_ = std::vector<node_type>(num_nodes);
+
+            std::size_t level_begin = 0;
+            std::size_t num_children = num_participants;
+            for (;;)
+            {
+                std::size_t const level_size =
+                    (num_children + fan_in - 1) / fan_in;
+                std::size_t const next_level_begin = level_begin + level_size;
+                for (std::size_t i = 0; i != level_size; ++i)
+                {
+                    node& n = nodes_[level_begin + i].data_;
+                    n.expected =
+                        (std::min)(fan_in, num_children - i * fan_in);
+                    n.count.store(n.expected, std::memory_order_relaxed);
+                    if (level_size != 1)
+                    {
+                        n.parent = next_level_begin + i / fan_in;
+                    }
+                }
+
+                if (level_size == 1)
+                {
+                    break;
+                }
+                level_begin = next_level_begin;
+                num_children = level_size;
+            }
+        }
+
+        std::size_t num_participants() const noexcept
+        {
+            return num_participants_;
+        }
+
+        /// Arrive at the barrier without waiting. The returned token can be
+        /// passed to wait.
+        [[nodiscard]] arrival_token arrive(std::size_t participant)
+        {
+            PIKA_ASSERT(participant < num_participants_);
+
+            std::size_t const phase =
+                phase_.data_.load(std::memory_order_relaxed);
+            std::size_t i = participant / fan_in_;
+            for (;;)
+            {
+                node& n = nodes_[i].data_;
+                if (n.count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                {
+                    return phase;
+                }
+
+                // This is the last arrival at this node. The counter can be
+                // reset before the phase is completed since no participant
+                // can arrive at this node again before that.
+                n.count.store(n.expected, std::memory_order_relaxed);
+                if (n.parent == no_parent)
+                {
+                    break;
+                }
+                i = n.parent;
+            }
+
+            completion_();
+            phase_.data_.store(phase + 1, std::memory_order_seq_cst);
+
+            if (num_sleepers_.data_.load(std::memory_order_seq_cst) != 0)
+            {
+                std::unique_lock<mutex_type> l(mtx_);
+                cond_.notify_all(PIKA_MOVE(l));
+            }
+
+            return phase;
+        }
+
+        /// Wait until the phase of \a token has been completed.
+        void wait(arrival_token&& token) const
+        {
+            // sequentially consistent to pair with the check for sleepers in
+            // arrive
+            auto completed = [&] {
+                return phase_.data_.load(std::memory_order_seq_cst) != token;
+            };
+
+            for (std::size_t k = 0; k != spin_count_; ++k)
+            {
+                if (completed())
+                {
+                    return;
+                }
+                pika::execution::this_thread::detail::yield_k(
+                    k, "tree_barrier::wait");
+            }
+
+            std::unique_lock<mutex_type> l(mtx_);
+            num_sleepers_.data_.fetch_add(1, std::memory_order_seq_cst);
+            while (!completed())
+            {
+                cond_.wait(l, "tree_barrier::wait");
+            }
+            num_sleepers_.data_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void arrive_and_wait(std::size_t participant)
+        {
+            wait(arrive(participant));
+        }
+
+    private:
+        using node_type = concurrency::detail::cache_line_data<node>;
+
+        std::size_t const num_participants_;
+        std::size_t const fan_in_;
+        std::size_t const spin_count_;
+        OnCompletion completion_;
+        std::vector<node_type> nodes_;
+
+        concurrency::detail::cache_line_data<std::atomic<std::size_t>> phase_;
+        mutable concurrency::detail::cache_line_data<std::atomic<std::size_t>>
+            num_sleepers_;
+
+        mutable mutex_type mtx_;
+        mutable pika::detail::condition_variable cond_;
+    };
+}    // namespace pika
+
+#include <pika/config/warnings_suffix.hpp>
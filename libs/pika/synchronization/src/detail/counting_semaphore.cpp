@@ -22,6 +22,7 @@ namespace pika::detail {
 
     counting_semaphore::counting_semaphore(std::ptrdiff_t value)
       : value_(value)
+      , num_waiting_(0)
     {
     }
 
@@ -32,11 +33,20 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        while (value_ < count)
+        if (try_acquire_fast(count))
+        {
+            return;
+        }
+
+        // Announce the waiting thread before checking the count again. A
+        // concurrent release_fast either sees the waiting thread and
+        // notifies it under the lock, or its increment is seen here.
+        num_waiting_.fetch_add(1, std::memory_order_seq_cst);
+        while (!try_acquire_fast(count))
         {
             cond_.wait(l, "counting_semaphore::wait");
         }
-        value_ -= count;
+        num_waiting_.fetch_sub(1, std::memory_order_relaxed);
     }
 
     bool counting_semaphore::wait_until(std::unique_lock<mutex_type>& l,
@@ -44,17 +54,24 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        while (value_ < count)
+        if (try_acquire_fast(count))
+        {
+            return true;
+        }
+
+        num_waiting_.fetch_add(1, std::memory_order_seq_cst);
+        while (!try_acquire_fast(count))
         {
             // return false if unblocked by timeout expiring
             if (cond_.wait_until(
                     l, abs_time, "counting_semaphore::wait_until") !=
                 threads::detail::thread_restart_state::unknown)
             {
+                num_waiting_.fetch_sub(1, std::memory_order_relaxed);
                 return false;
             }
         }
-        value_ -= count;
+        num_waiting_.fetch_sub(1, std::memory_order_relaxed);
         return true;
     }
 
@@ -63,7 +80,7 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        if (!(value_ < count))
+        if (!(value_.load(std::memory_order_relaxed) < count))
         {
             // enter wait_locked only if there are sufficient credits
             // available
@@ -77,12 +94,7 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        if (value_ >= 1)
-        {
-            --value_;
-            return true;
-        }
-        return false;
+        return try_acquire_fast(1);
     }
 
     void counting_semaphore::signal(
@@ -90,11 +102,20 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
+        value_.fetch_add(count, std::memory_order_seq_cst);
+        notify(PIKA_MOVE(l), count);
+    }
+
+    void counting_semaphore::notify(
+        std::unique_lock<mutex_type> l, std::ptrdiff_t count)
+    {
+        PIKA_ASSERT_OWNS_LOCK(l);
+
         mutex_type* mtx = l.mutex();
 
         // release no more threads than we get resources
-        value_ += count;
-        for (std::int64_t i = 0; value_ >= 0 && i < count; ++i)
+        for (std::int64_t i = 0;
+             value_.load(std::memory_order_relaxed) >= 0 && i < count; ++i)
         {
             // notify_one() returns false if no more threads are
             // waiting
@@ -10,7 +10,7 @@
 #include <pika/synchronization/spinlock.hpp>
 #include <pika/thread_support/assert_owns_lock.hpp>
 
-#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <utility>
@@ -24,6 +24,7 @@ namespace pika::detail {
       // NOLINTEND(bugprone-easily-swappable-parameters)
       : max_difference_(max_difference)
       , lower_limit_(lower_limit)
+      , num_waiting_(0)
       , cond_()
     {
     }
@@ -37,8 +38,8 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        max_difference_ = max_difference;
-        lower_limit_ = lower_limit;
+        max_difference_.store(max_difference, std::memory_order_seq_cst);
+        lower_limit_.store(lower_limit, std::memory_order_seq_cst);
     }
 
     void sliding_semaphore::wait(
@@ -46,10 +47,20 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        while (upper_limit - max_difference_ > lower_limit_)
+        if (try_wait_fast(upper_limit))
+        {
+            return;
+        }
+
+        // Announce the waiting thread before checking the limits again. A
+        // concurrent signal_fast either sees the waiting thread and notifies
+        // it under the lock, or its update is seen here.
+        num_waiting_.fetch_add(1, std::memory_order_seq_cst);
+        while (!try_wait_fast(upper_limit))
         {
             cond_.wait(l, "sliding_semaphore::wait");
         }
+        num_waiting_.fetch_sub(1, std::memory_order_relaxed);
     }
 
     bool sliding_semaphore::try_wait(
@@ -57,7 +68,7 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        if (!(upper_limit - max_difference_ > lower_limit_))
+        if (try_wait_fast(upper_limit))
         {
             // enter wait_locked only if necessary
             wait(l, upper_limit);
@@ -71,9 +82,15 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        mutex_type* mtx = l.mutex();
+        signal_fast(lower_limit);
+        notify(PIKA_MOVE(l));
+    }
 
-        lower_limit_ = (std::max)(lower_limit, lower_limit_);
+    void sliding_semaphore::notify(std::unique_lock<mutex_type> l)
+    {
+        PIKA_ASSERT_OWNS_LOCK(l);
+
+        mutex_type* mtx = l.mutex();
 
         // touch upon all threads
         std::int64_t count = static_cast<std::int64_t>(cond_.size(l));
@@ -91,7 +108,9 @@ namespace pika::detail {
     {
         PIKA_ASSERT_OWNS_LOCK(l);
 
-        signal(PIKA_MOVE(l), lower_limit_);
-        return lower_limit_;
+        std::int64_t const lower_limit =
+            lower_limit_.load(std::memory_order_relaxed);
+        signal(PIKA_MOVE(l), lower_limit);
+        return lower_limit;
     }
 }    // namespace pika::detail
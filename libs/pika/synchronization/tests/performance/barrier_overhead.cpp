@@ -0,0 +1,108 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+//  Measures the time per phase of pika::barrier and pika::tree_barrier when
+//  all participants repeatedly arrive and wait at the barrier.
+
+#include <pika/future.hpp>
+#include <pika/init.hpp>
+#include <pika/synchronization/barrier.hpp>
+#include <pika/synchronization/tree_barrier.hpp>
+#include <pika/thread.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename F>
+double run_participants(std::size_t num_participants, F&& f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<pika::future<void>> participants;
+    participants.reserve(num_participants);
+    for (std::size_t i = 0; i != num_participants; ++i)
+    {
+        participants.push_back(pika::async(f, i));
+    }
+    pika::wait_all(participants);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void print_result(std::string const& name, double time, std::size_t num_phases)
+{
+    std::cout << name << ": " << (time / num_phases) << " [s/phase] ("
+              << (num_phases / time) << " [phase/s])\n";
+}
+
+int pika_main(pika::program_options::variables_map& vm)
+{
+    auto const num_participants = vm["participants"].as<std::size_t>();
+    auto const num_phases = vm["phases"].as<std::size_t>();
+    auto const fan_in = vm["fan-in"].as<std::size_t>();
+
+    if (num_participants == 0)
+    {
+        std::cout << "the number of participants must be positive\n";
+        return pika::finalize();
+    }
+
+    {
+        pika::barrier<> b(static_cast<std::ptrdiff_t>(num_participants));
+        double const t = run_participants(num_participants, [&](std::size_t) {
+            for (std::size_t phase = 0; phase != num_phases; ++phase)
+            {
+                b.arrive_and_wait();
+            }
+        });
+        print_result("barrier", t, num_phases);
+    }
+
+    {
+        pika::tree_barrier<> b(num_participants, {}, fan_in);
+        double const t = run_participants(num_participants, [&](std::size_t i) {
+            for (std::size_t phase = 0; phase != num_phases; ++phase)
+            {
+                b.arrive_and_wait(i);
+            }
+        });
+        print_result("tree_barrier", t, num_phases);
+    }
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    pika::program_options::options_description cmdline(
+        "usage: " PIKA_APPLICATION_STRING " [options]");
+
+    // clang-format off
+    cmdline.add_options()
+        ("participants",
+            pika::program_options::value<std::size_t>()->default_value(4),
+            "number of participants (default: 4)")
+        ("phases",
+            pika::program_options::value<std::size_t>()->default_value(10000),
+            "number of barrier phases (default: 10000)")
+        ("fan-in",
+            pika::program_options::value<std::size_t>()->default_value(4),
+            "fan-in of the tree barrier (default: 4)")
+        ;
+    // clang-format on
+
+    pika::init_params init_args;
+    init_args.desc_cmdline = cmdline;
+
+    return pika::init(pika_main, argc, argv, init_args);
+}
@@ -0,0 +1,143 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+//  Measures the throughput of acquiring and releasing counting and sliding
+//  semaphores, both uncontended and when used to throttle concurrent work.
+
+#include <pika/future.hpp>
+#include <pika/init.hpp>
+#include <pika/semaphore.hpp>
+#include <pika/synchronization/sliding_semaphore.hpp>
+#include <pika/thread.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename F>
+double run_concurrently(std::size_t num_tasks, F&& f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<pika::future<void>> tasks;
+    tasks.reserve(num_tasks);
+    for (std::size_t i = 0; i != num_tasks; ++i)
+    {
+        tasks.push_back(pika::async(f, i));
+    }
+    pika::wait_all(tasks);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void print_result(std::string const& name, double time, std::size_t num_ops)
+{
+    std::cout << name << ": " << (num_ops / time) << " [op/s] ("
+              << (time / num_ops) << " [s/op])\n";
+}
+
+int pika_main(pika::program_options::variables_map& vm)
+{
+    auto const num_ops = vm["operations"].as<std::size_t>();
+    auto const num_tasks = vm["tasks"].as<std::size_t>();
+    auto const max_in_flight = vm["in-flight"].as<std::size_t>();
+
+    {
+        pika::counting_semaphore<> sem(1);
+        double const t = run_concurrently(1, [&](std::size_t) {
+            for (std::size_t i = 0; i != num_ops; ++i)
+            {
+                sem.acquire();
+                sem.release();
+            }
+        });
+        print_result("counting_semaphore, uncontended", t, num_ops);
+    }
+
+    {
+        pika::counting_semaphore<> sem(
+            static_cast<std::ptrdiff_t>(max_in_flight));
+        double const t = run_concurrently(num_tasks, [&](std::size_t) {
+            for (std::size_t i = 0; i != num_ops; ++i)
+            {
+                sem.acquire();
+                sem.release();
+            }
+        });
+        print_result("counting_semaphore, contended", t, num_ops * num_tasks);
+    }
+
+    {
+        pika::sliding_semaphore sem(
+            static_cast<std::int64_t>(max_in_flight), 0);
+        double const t = run_concurrently(1, [&](std::size_t) {
+            for (std::size_t i = 0; i != num_ops; ++i)
+            {
+                sem.wait(static_cast<std::int64_t>(i));
+                sem.signal(static_cast<std::int64_t>(i));
+            }
+        });
+        print_result("sliding_semaphore, uncontended", t, num_ops);
+    }
+
+    {
+        // one task limits the steps the other tasks can be ahead of it
+        pika::sliding_semaphore sem(
+            static_cast<std::int64_t>(max_in_flight), 0);
+        double const t = run_concurrently(num_tasks, [&](std::size_t task) {
+            for (std::size_t i = 0; i != num_ops; ++i)
+            {
+                if (task == 0)
+                {
+                    sem.signal(static_cast<std::int64_t>(i));
+                }
+                else
+                {
+                    sem.wait(static_cast<std::int64_t>(i));
+                }
+            }
+            if (task == 0)
+            {
+                sem.signal(static_cast<std::int64_t>(num_ops));
+            }
+        });
+        print_result("sliding_semaphore, contended", t, num_ops * num_tasks);
+    }
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    pika::program_options::options_description cmdline(
+        "usage: " PIKA_APPLICATION_STRING " [options]");
+
+    // clang-format off
+    cmdline.add_options()
+        ("operations",
+            pika::program_options::value<std::size_t>()->default_value(
+                1000000),
+            "number of operations per task (default: 1000000)")
+        ("tasks",
+            pika::program_options::value<std::size_t>()->default_value(4),
+            "number of concurrent tasks (default: 4)")
+        ("in-flight",
+            pika::program_options::value<std::size_t>()->default_value(2),
+            "maximum number of operations in flight (default: 2)")
+        ;
+    // clang-format on
+
+    pika::init_params init_args;
+    init_args.desc_cmdline = cmdline;
+
+    return pika::init(pika_main, argc, argv, init_args);
+}
@@ -0,0 +1,155 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/synchronization/async_channel.hpp>
+#include <pika/testing.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+void test_try_get_set()
+{
+    ex::async_channel<int> ch(2);
+    PIKA_TEST_EQ(ch.capacity(), std::size_t(2));
+    PIKA_TEST(!ch.try_get());
+
+    PIKA_TEST(ch.try_set(1));
+    PIKA_TEST(ch.try_set(2));
+    PIKA_TEST(!ch.try_set(3));
+    PIKA_TEST_EQ(ch.size(), std::size_t(2));
+
+    PIKA_TEST_EQ(*ch.try_get(), 1);
+    PIKA_TEST(ch.try_set(3));
+    PIKA_TEST_EQ(*ch.try_get(), 2);
+    PIKA_TEST_EQ(*ch.try_get(), 3);
+    PIKA_TEST(!ch.try_get());
+}
+
+void test_waiting_get()
+{
+    ex::async_channel<std::unique_ptr<int>> ch(1);
+
+    // the getter waits until a value is set
+    std::atomic<bool> received{false};
+    ex::start_detached(
+        ch.async_get() | ex::then([&](std::unique_ptr<int> p) {
+            PIKA_TEST_EQ(*p, 42);
+            received = true;
+        }));
+    PIKA_TEST(!received);
+
+    tt::sync_wait(ch.async_set(std::make_unique<int>(42)));
+    PIKA_TEST(received);
+    PIKA_TEST_EQ(ch.size(), std::size_t(0));
+}
+
+void test_waiting_set()
+{
+    ex::async_channel<int> ch(1);
+    tt::sync_wait(ch.async_set(1));
+
+    // the setter waits until there is space in the channel
+    std::atomic<bool> stored{false};
+    ex::start_detached(ch.async_set(2) | ex::then([&] { stored = true; }));
+    PIKA_TEST(!stored);
+
+    PIKA_TEST_EQ(tt::sync_wait(ch.async_get()), 1);
+    PIKA_TEST(stored);
+    PIKA_TEST_EQ(tt::sync_wait(ch.async_get()), 2);
+}
+
+void test_close()
+{
+    ex::async_channel<int> ch(1);
+
+    std::atomic<bool> failed{false};
+    ex::start_detached(ch.async_get() |
+        ex::then([](int) { PIKA_TEST(false); }) |
+        ex::let_error([&](std::exception_ptr) {
+            failed = true;
+            return ex::just();
+        }));
+
+    PIKA_TEST_EQ(ch.close(), std::size_t(1));
+    PIKA_TEST(failed);
+    PIKA_TEST(ch.is_closed());
+    PIKA_TEST(!ch.try_set(1));
+
+    bool caught = false;
+    try
+    {
+        tt::sync_wait(ch.async_set(1));
+    }
+    catch (pika::exception const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+}
+
+void test_producer_consumer(std::size_t capacity)
+{
+    constexpr std::size_t num_producers = 4;
+    constexpr std::size_t num_values = 1000;
+
+    ex::async_channel<std::size_t> ch(capacity);
+    ex::thread_pool_scheduler sched{};
+
+    std::vector<ex::unique_any_sender<>> producers;
+    for (std::size_t p = 0; p != num_producers; ++p)
+    {
+        producers.emplace_back(
+            ex::schedule(sched) | ex::then([&ch, p] {
+                for (std::size_t i = 0; i != num_values; ++i)
+                {
+                    tt::sync_wait(ch.async_set(p * num_values + i));
+                }
+            }) |
+            ex::ensure_started());
+    }
+
+    std::vector<bool> seen(num_producers * num_values, false);
+    for (std::size_t i = 0; i != num_producers * num_values; ++i)
+    {
+        std::size_t const v = tt::sync_wait(ch.async_get());
+        PIKA_TEST(!seen[v]);
+        seen[v] = true;
+    }
+
+    for (auto& p : producers)
+    {
+        tt::sync_wait(std::move(p));
+    }
+    PIKA_TEST(!ch.try_get());
+}
+
+int pika_main()
+{
+    test_try_get_set();
+    test_waiting_get();
+    test_waiting_set();
+    test_close();
+    test_producer_consumer(0);
+    test_producer_consumer(1);
+    test_producer_consumer(16);
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv), 0);
+    return pika::util::report_errors();
+}
@@ -0,0 +1,152 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/synchronization/async_receive_buffer.hpp>
+#include <pika/testing.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+void test_store_then_receive()
+{
+    ex::async_receive_buffer<int> buf(4);
+    PIKA_TEST(buf.empty());
+
+    buf.store_received(1, 1);
+    buf.store_received(0, 0);
+    PIKA_TEST(!buf.empty());
+    PIKA_TEST(!buf.try_receive(2));
+
+    PIKA_TEST_EQ(tt::sync_wait(buf.receive(0)), 0);
+    PIKA_TEST_EQ(*buf.try_receive(1), 1);
+    PIKA_TEST(buf.empty());
+}
+
+void test_receive_then_store()
+{
+    ex::async_receive_buffer<int> buf(2);
+
+    std::atomic<int> received{-1};
+    ex::start_detached(
+        buf.receive(5) | ex::then([&](int v) { received = v; }));
+    PIKA_TEST_EQ(received.load(), -1);
+    PIKA_TEST(!buf.empty());
+
+    buf.store_received(5, 5);
+    PIKA_TEST_EQ(received.load(), 5);
+    PIKA_TEST(buf.empty());
+}
+
+void test_window()
+{
+    ex::async_receive_buffer<int> buf(2);
+    buf.store_received(0, 0);
+
+    // step 2 uses the same entry as step 0
+    bool caught = false;
+    try
+    {
+        buf.store_received(2, 2);
+    }
+    catch (pika::exception const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    caught = false;
+    try
+    {
+        tt::sync_wait(buf.receive(2));
+    }
+    catch (pika::exception const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    // once step 0 has been received step 2 can be used
+    PIKA_TEST_EQ(tt::sync_wait(buf.receive(0)), 0);
+    buf.store_received(2, 2);
+    PIKA_TEST_EQ(tt::sync_wait(buf.receive(2)), 2);
+}
+
+void test_cancel_waiting()
+{
+    ex::async_receive_buffer<int> buf(4);
+    buf.store_received(1, 1);
+
+    std::atomic<bool> failed{false};
+    ex::start_detached(buf.receive(0) |
+        ex::then([](int) { PIKA_TEST(false); }) |
+        ex::let_error([&](std::exception_ptr) {
+            failed = true;
+            return ex::just();
+        }));
+
+    auto e = std::make_exception_ptr(std::runtime_error("cancelled"));
+    PIKA_TEST_EQ(buf.cancel_waiting(e), std::size_t(1));
+    PIKA_TEST(failed);
+    PIKA_TEST(!buf.empty());
+
+    PIKA_TEST_EQ(buf.cancel_waiting(e, true), std::size_t(1));
+    PIKA_TEST(buf.empty());
+}
+
+// Two neighbors exchange values in each iteration, like in a halo exchange.
+void test_exchange()
+{
+    constexpr std::size_t num_steps = 1000;
+
+    ex::async_receive_buffer<std::size_t> left(2);
+    ex::async_receive_buffer<std::size_t> right(2);
+    ex::thread_pool_scheduler sched{};
+
+    auto neighbor = [&](ex::async_receive_buffer<std::size_t>& in,
+                        ex::async_receive_buffer<std::size_t>& out,
+                        std::size_t offset) {
+        for (std::size_t step = 0; step != num_steps; ++step)
+        {
+            out.store_received(step, step + offset);
+            std::size_t const v = tt::sync_wait(in.receive(step));
+            PIKA_TEST_EQ(v, step + (offset == 0 ? 1 : 0));
+        }
+    };
+
+    auto s = ex::schedule(sched) | ex::then([&] { neighbor(left, right, 0); }) |
+        ex::ensure_started();
+    neighbor(right, left, 1);
+    tt::sync_wait(std::move(s));
+
+    PIKA_TEST(left.empty());
+    PIKA_TEST(right.empty());
+}
+
+int pika_main()
+{
+    test_store_then_receive();
+    test_receive_then_store();
+    test_window();
+    test_cancel_waiting();
+    test_exchange();
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv), 0);
+    return pika::util::report_errors();
+}
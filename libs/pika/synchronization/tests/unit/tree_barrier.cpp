@@ -0,0 +1,157 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/synchronization/tree_barrier.hpp>
+#include <pika/testing.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+std::atomic<std::size_t> arrived(0);
+std::atomic<std::size_t> completed(0);
+
+struct oncomplete
+{
+    void operator()() const
+    {
+        ++completed;
+    }
+};
+
+// Each participant checks that all participants have arrived in each phase
+// before any of them leaves the barrier.
+template <typename Barrier>
+void participate(Barrier& b, std::size_t participant, std::size_t num_phases)
+{
+    std::size_t const n = b.num_participants();
+    for (std::size_t phase = 0; phase != num_phases; ++phase)
+    {
+        ++arrived;
+        b.arrive_and_wait(participant);
+        PIKA_TEST_LTE((phase + 1) * n, arrived.load());
+        PIKA_TEST_EQ(completed.load(), phase + 1);
+
+        // the second barrier makes sure no participant arrives for the next
+        // phase before all have checked the counters
+        b.arrive_and_wait(participant);
+        PIKA_TEST_EQ(completed.load(), phase + 1);
+    }
+}
+
+void test_pika_threads(std::size_t num_participants, std::size_t fan_in)
+{
+    constexpr std::size_t num_phases = 20;
+
+    arrived = 0;
+    completed = 0;
+
+    // every second phase is only used to separate the phases
+    struct count_every_second
+    {
+        std::size_t* phase;
+        void operator()() const
+        {
+            if ((*phase)++ % 2 == 0)
+            {
+                ++completed;
+            }
+        }
+    };
+    std::size_t phase = 0;
+    pika::tree_barrier<count_every_second> b(
+        num_participants, count_every_second{&phase}, fan_in);
+
+    std::vector<ex::unique_any_sender<>> senders;
+    for (std::size_t i = 1; i != num_participants; ++i)
+    {
+        senders.emplace_back(ex::schedule(ex::thread_pool_scheduler{}) |
+            ex::then([&b, i] { participate(b, i, num_phases); }) |
+            ex::ensure_started());
+    }
+    participate(b, 0, num_phases);
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+
+    PIKA_TEST_EQ(completed.load(), num_phases);
+    PIKA_TEST_EQ(phase, 2 * num_phases);
+}
+
+void test_os_threads(std::size_t num_participants)
+{
+    pika::tree_barrier<oncomplete> b(num_participants);
+    completed = 0;
+
+    std::atomic<std::size_t> count(0);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i != num_participants; ++i)
+    {
+        threads.emplace_back([&b, &count, i, num_participants] {
+            for (std::size_t phase = 0; phase != 10; ++phase)
+            {
+                ++count;
+                b.arrive_and_wait(i);
+                PIKA_TEST_LTE((phase + 1) * num_participants, count.load());
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    PIKA_TEST_EQ(completed.load(), std::size_t(10));
+}
+
+void test_split_phase()
+{
+    pika::tree_barrier<oncomplete> b(2);
+    completed = 0;
+
+    auto token = b.arrive(0);
+    PIKA_TEST_EQ(completed.load(), std::size_t(0));
+    b.arrive_and_wait(1);
+    PIKA_TEST_EQ(completed.load(), std::size_t(1));
+    b.wait(std::move(token));
+}
+
+int pika_main()
+{
+    test_split_phase();
+
+    for (std::size_t fan_in : {2, 4, 7})
+    {
+        test_pika_threads(1, fan_in);
+        test_pika_threads(5, fan_in);
+        test_pika_threads(17, fan_in);
+        test_pika_threads(64, fan_in);
+    }
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    test_os_threads(3);
+
+    bool caught = false;
+    try
+    {
+        pika::tree_barrier<> b(4, {}, 1);
+    }
+    catch (pika::exception const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv), 0);
+    return pika::util::report_errors();
+}
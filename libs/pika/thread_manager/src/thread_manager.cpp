@@ -493,12 +493,59 @@ namespace pika::threads::detail {
                 pools_.push_back(PIKA_MOVE(pool));
                 break;
             }
+
+            case resource::deadline:
+            {
+                // instantiate the scheduler
+                using local_sched_type =
+                    pika::threads::deadline_queue_scheduler<>;
+
+                local_sched_type::init_parameter_type init(
+                    thread_pool_init.num_threads_,
+                    thread_pool_init.affinity_data_, thread_queue_init,
+                    "core-deadline_queue_scheduler");
+
+                std::unique_ptr<local_sched_type> sched(
+                    new local_sched_type(init));
+
+                // set the default scheduler flags
+                sched->set_scheduler_mode(thread_pool_init.mode_);
+                // conditionally set/unset this flag
+                sched->update_scheduler_mode(
+                    scheduler_mode::enable_stealing_numa, !numa_sensitive);
+
+                // instantiate the pool
+                std::unique_ptr<thread_pool_base> pool(
+                    new pika::threads::detail::scheduled_thread_pool<
+                        local_sched_type>(PIKA_MOVE(sched), thread_pool_init));
+                pools_.push_back(PIKA_MOVE(pool));
+                break;
+            }
             }
 
             // update the thread_offset for the next pool
             thread_offset += num_threads_in_pool;
         }
 
+        // let idle worker threads take staged work from other pools
+        for (std::size_t i = 0; i != num_pools; ++i)
+        {
+            std::vector<scheduler_base*> overflow_schedulers;
+            for (std::string const& name : rp.get_overflow_pools(i))
+            {
+                std::size_t const index = rp.get_pool_index(name);
+                if (index == i)
+                {
+                    throw std::invalid_argument("Thread pool " +
+                        rp.get_pool_name(i) +
+                        " can't be an overflow pool of itself");
+                }
+                overflow_schedulers.push_back(pools_[index]->get_scheduler());
+            }
+            pools_[i]->get_scheduler()->set_overflow_schedulers(
+                PIKA_MOVE(overflow_schedulers));
+        }
+
         // fill the thread-lookup table
         for (auto& pool_iter : pools_)
         {
@@ -11,6 +11,7 @@
 #include <pika/affinity/affinity_data.hpp>
 #include <pika/assert.hpp>
 #include <pika/concurrency/barrier.hpp>
+#include <pika/concurrency/detail/sharded_counter.hpp>
 #include <pika/functional/function.hpp>
 #include <pika/modules/errors.hpp>
 #include <pika/thread_pools/scheduling_loop.hpp>
@@ -278,6 +279,15 @@ namespace pika::threads::detail {
 
         std::int64_t get_idle_loop_count(std::size_t num, bool reset) override;
         std::int64_t get_busy_loop_count(std::size_t num, bool reset) override;
+        void increment_inline_execution_count(std::size_t num) override;
+        std::int64_t get_inline_execution_count(
+            std::size_t num, bool reset) override;
+        void increment_elided_work_count(std::size_t num) override;
+        std::int64_t get_elided_work_count(
+            std::size_t num, bool reset) override;
+        void increment_cross_pool_steal_count(std::size_t num) override;
+        std::int64_t get_cross_pool_steal_count(
+            std::size_t num, bool reset) override;
         std::int64_t get_scheduler_utilization() const override;
 
     protected:
@@ -380,6 +390,18 @@ namespace pika::threads::detail {
             std::int64_t idle_loop_counts_;
             std::int64_t busy_loop_counts_;
 
+            // work items run inline instead of being spawned
+            std::int64_t inline_executions_;
+            std::int64_t reset_inline_executions_;
+
+            // cancelled work items for which no thread was created
+            std::int64_t elided_work_;
+            std::int64_t reset_elided_work_;
+
+            // staged work items taken from other pools
+            std::int64_t cross_pool_steals_;
+            std::int64_t reset_cross_pool_steals_;
+
             // scheduler utilization data
             bool tasks_active_;
         };
@@ -388,7 +410,12 @@ namespace pika::threads::detail {
 
         // support detail::manage_executor interface
         std::atomic<long> thread_count_;
+#if defined(PIKA_HAVE_SHARDED_THREAD_COUNTS)
+        // one shard per worker thread and one for all other threads
+        pika::concurrency::detail::sharded_counter tasks_scheduled_;
+#else
         std::atomic<std::int64_t> tasks_scheduled_;
+#endif
         network_background_callback_type network_background_callback_;
 
         std::size_t max_background_threads_;
@@ -101,7 +101,11 @@ namespace pika::threads::detail {
       : thread_pool_base(init)
       , sched_(PIKA_MOVE(sched))
       , thread_count_(0)
+#if defined(PIKA_HAVE_SHARDED_THREAD_COUNTS)
+      , tasks_scheduled_(init.num_threads_ + 1)
+#else
       , tasks_scheduled_(0)
+#endif
       , network_background_callback_(init.network_background_callback_)
       , max_background_threads_(init.max_background_threads_)
       , max_idle_loop_count_(init.max_idle_loop_count_)
@@ -296,6 +300,7 @@ namespace pika::threads::detail {
 
         init_perf_counter_data(pool_threads);
         this->init_pool_time_scale();
+        this->init_numa_domain_threads(pool_threads);
 
         LTM_(info).format(
             "run: {} timestamp_scale: {}", id_.name(), timestamp_scale_);
@@ -622,7 +627,11 @@ namespace pika::threads::detail {
         threads::detail::create_thread(sched_.get(), data, id, ec);    //-V601
 
         // update statistics
+#if defined(PIKA_HAVE_SHARDED_THREAD_COUNTS)
+        tasks_scheduled_.increment(get_local_thread_num_tss());
+#else
         ++tasks_scheduled_;
+#endif
     }
 
     template <typename Scheduler>
@@ -644,7 +653,11 @@ namespace pika::threads::detail {
             threads::detail::create_work(sched_.get(), data, ec);    //-V601
 
         // update statistics
+#if defined(PIKA_HAVE_SHARDED_THREAD_COUNTS)
+        tasks_scheduled_.increment(get_local_thread_num_tss());
+#else
         ++tasks_scheduled_;
+#endif
 
         return id;
     }
@@ -1793,6 +1806,146 @@ namespace pika::threads::detail {
         return counter_data_[num].busy_loop_counts_;
     }
 
+    template <typename Scheduler>
+    void scheduled_thread_pool<Scheduler>::increment_inline_execution_count(
+        std::size_t num)
+    {
+        PIKA_ASSERT(num < counter_data_.size());
+        ++counter_data_[num].inline_executions_;
+    }
+
+    template <typename Scheduler>
+    std::int64_t scheduled_thread_pool<Scheduler>::get_inline_execution_count(
+        std::size_t num, bool reset)
+    {
+        std::int64_t inline_executions = 0;
+        std::int64_t reset_inline_executions = 0;
+
+        if (num != std::size_t(-1))
+        {
+            inline_executions = counter_data_[num].inline_executions_;
+            reset_inline_executions =
+                counter_data_[num].reset_inline_executions_;
+
+            if (reset)
+            {
+                counter_data_[num].reset_inline_executions_ =
+                    inline_executions;
+            }
+        }
+        else
+        {
+            inline_executions = accumulate_projected(counter_data_.begin(),
+                counter_data_.end(), std::int64_t(0),
+                &scheduling_counter_data::inline_executions_);
+            reset_inline_executions = accumulate_projected(
+                counter_data_.begin(), counter_data_.end(), std::int64_t(0),
+                &scheduling_counter_data::reset_inline_executions_);
+
+            if (reset)
+            {
+                copy_projected(counter_data_.begin(), counter_data_.end(),
+                    counter_data_.begin(),
+                    &scheduling_counter_data::inline_executions_,
+                    &scheduling_counter_data::reset_inline_executions_);
+            }
+        }
+
+        return inline_executions - reset_inline_executions;
+    }
+
+    template <typename Scheduler>
+    void scheduled_thread_pool<Scheduler>::increment_elided_work_count(
+        std::size_t num)
+    {
+        PIKA_ASSERT(num < counter_data_.size());
+        ++counter_data_[num].elided_work_;
+    }
+
+    template <typename Scheduler>
+    std::int64_t scheduled_thread_pool<Scheduler>::get_elided_work_count(
+        std::size_t num, bool reset)
+    {
+        std::int64_t elided_work = 0;
+        std::int64_t reset_elided_work = 0;
+
+        if (num != std::size_t(-1))
+        {
+            elided_work = counter_data_[num].elided_work_;
+            reset_elided_work = counter_data_[num].reset_elided_work_;
+
+            if (reset)
+            {
+                counter_data_[num].reset_elided_work_ = elided_work;
+            }
+        }
+        else
+        {
+            elided_work = accumulate_projected(counter_data_.begin(),
+                counter_data_.end(), std::int64_t(0),
+                &scheduling_counter_data::elided_work_);
+            reset_elided_work = accumulate_projected(counter_data_.begin(),
+                counter_data_.end(), std::int64_t(0),
+                &scheduling_counter_data::reset_elided_work_);
+
+            if (reset)
+            {
+                copy_projected(counter_data_.begin(), counter_data_.end(),
+                    counter_data_.begin(),
+                    &scheduling_counter_data::elided_work_,
+                    &scheduling_counter_data::reset_elided_work_);
+            }
+        }
+
+        return elided_work - reset_elided_work;
+    }
+
+    template <typename Scheduler>
+    void scheduled_thread_pool<Scheduler>::increment_cross_pool_steal_count(
+        std::size_t num)
+    {
+        PIKA_ASSERT(num < counter_data_.size());
+        ++counter_data_[num].cross_pool_steals_;
+    }
+
+    template <typename Scheduler>
+    std::int64_t scheduled_thread_pool<Scheduler>::get_cross_pool_steal_count(
+        std::size_t num, bool reset)
+    {
+        std::int64_t steals = 0;
+        std::int64_t reset_steals = 0;
+
+        if (num != std::size_t(-1))
+        {
+            steals = counter_data_[num].cross_pool_steals_;
+            reset_steals = counter_data_[num].reset_cross_pool_steals_;
+
+            if (reset)
+            {
+                counter_data_[num].reset_cross_pool_steals_ = steals;
+            }
+        }
+        else
+        {
+            steals = accumulate_projected(counter_data_.begin(),
+                counter_data_.end(), std::int64_t(0),
+                &scheduling_counter_data::cross_pool_steals_);
+            reset_steals = accumulate_projected(counter_data_.begin(),
+                counter_data_.end(), std::int64_t(0),
+                &scheduling_counter_data::reset_cross_pool_steals_);
+
+            if (reset)
+            {
+                copy_projected(counter_data_.begin(), counter_data_.end(),
+                    counter_data_.begin(),
+                    &scheduling_counter_data::cross_pool_steals_,
+                    &scheduling_counter_data::reset_cross_pool_steals_);
+            }
+        }
+
+        return steals - reset_steals;
+    }
+
     template <typename Scheduler>
     std::int64_t
     scheduled_thread_pool<Scheduler>::get_scheduler_utilization() const
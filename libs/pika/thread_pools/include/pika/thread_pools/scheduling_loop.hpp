@@ -24,6 +24,14 @@
 #include <pika/thread_pools/detail/scoped_background_timer.hpp>
 #endif
 
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+#include <pika/threading_base/task_latency.hpp>
+#endif
+
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+#include <pika/threading_base/detail/task_timeline.hpp>
+#endif
+
 #if defined(PIKA_HAVE_TRACY)
 #include <pika/threading_base/detail/tracy.hpp>
 #include <common/TracyColor.hpp>
@@ -716,6 +724,13 @@ namespace pika::threads::detail {
                                 exec_time_wrapper exec_time_collector(
                                     idle_rate);
 
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+                                task_timeline_scope timeline(thrdptr);
+#endif
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+                                task_latency_scope latency(thrdptr);
+#endif
+
 #if defined(PIKA_HAVE_APEX)
                                 // get the APEX data pointer, in case we are resuming the
                                 // thread and have to restore any leaf timers from
@@ -761,6 +776,12 @@ namespace pika::threads::detail {
 #endif
 
                                 thrd_stat = (*thrdptr)(context_storage);
+#endif
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+                                timeline.finish(thrd_stat.get_previous());
+#endif
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+                                latency.finish(thrd_stat.get_previous());
 #endif
                             }
 
@@ -918,6 +939,15 @@ namespace pika::threads::detail {
                         running, idle_loop_count, enable_stealing_staged,
                         added))
                 {
+                    // There is no work in this pool, take work from the
+                    // overflow pools of this pool, if any
+                    if (running &&
+                        scheduler.SchedulingPolicy::
+                            steal_from_overflow_schedulers(num_thread))
+                    {
+                        continue;
+                    }
+
                     // Clean up terminated threads before trying to exit
                     bool can_exit = !running &&
                         scheduler.SchedulingPolicy::cleanup_terminated(
@@ -5,6 +5,7 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include <pika/config.hpp>
+#include <pika/schedulers/deadline_queue_scheduler.hpp>
 #include <pika/schedulers/local_priority_queue_scheduler.hpp>
 #include <pika/schedulers/local_queue_scheduler.hpp>
 #include <pika/schedulers/shared_priority_queue_scheduler.hpp>
@@ -55,3 +56,7 @@ template class PIKA_EXPORT pika::threads::detail::scheduled_thread_pool<
 template class PIKA_EXPORT pika::threads::shared_priority_queue_scheduler<>;
 template class PIKA_EXPORT pika::threads::detail::scheduled_thread_pool<
     pika::threads::shared_priority_queue_scheduler<>>;
+
+template class PIKA_EXPORT pika::threads::deadline_queue_scheduler<>;
+template class PIKA_EXPORT pika::threads::detail::scheduled_thread_pool<
+    pika::threads::deadline_queue_scheduler<>>;
@@ -0,0 +1,117 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+#include <pika/threading_base/thread_data.hpp>
+#include <pika/timing/steady_clock.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace pika::threads::detail {
+    enum class task_timeline_format
+    {
+        chrome,      // Chrome trace event JSON, also readable by Perfetto
+        perfetto,    // Perfetto protobuf trace
+    };
+
+    /// Parse the format name used in the configuration ("chrome" or
+    /// "perfetto"). Throws pika::error::bad_parameter for unknown names.
+    PIKA_EXPORT task_timeline_format parse_task_timeline_format(
+        std::string const& format);
+
+    /// One execution of a task on a worker thread, i.e. the time between the
+    /// scheduler switching to the task and the task yielding, suspending, or
+    /// terminating.
+    struct task_timeline_event
+    {
+        char const* annotation;    // owned by the timeline
+        std::uint64_t thread_id;
+        std::uint64_t begin_ns;
+        std::uint64_t end_ns;
+        std::uint32_t phase;
+        bool resumed;      // false if this is the first run of the task
+        bool suspended;    // false if the task terminated
+    };
+
+    PIKA_EXPORT extern std::atomic<bool> task_timeline_enabled;
+
+    /// Allocate per-worker ring buffers of \a buffer_size events each and
+    /// start recording. Must be called before the worker threads start
+    /// running tasks. When a buffer is full the oldest events are
+    /// overwritten.
+    PIKA_EXPORT void start_task_timeline(
+        std::size_t num_workers, std::size_t buffer_size);
+
+    /// Stop recording. The recorded events are kept until the next call to
+    /// start_task_timeline.
+    PIKA_EXPORT void stop_task_timeline();
+
+    /// Write all recorded events in the given format. Dumping while workers
+    /// are still recording is allowed, but the oldest events of a full
+    /// buffer may be inconsistent in that case.
+    PIKA_EXPORT void dump_task_timeline(
+        std::ostream& os, task_timeline_format format);
+    PIKA_EXPORT void dump_task_timeline(
+        std::string const& filename, task_timeline_format format);
+
+    /// Install a handler for \a signum which dumps the timeline to
+    /// \a filename. The dump itself is done on a separate OS thread.
+    PIKA_EXPORT void start_task_timeline_signal_handler(
+        int signum, std::string filename, task_timeline_format format);
+    PIKA_EXPORT void stop_task_timeline_signal_handler();
+
+    PIKA_EXPORT void record_task_timeline_event(thread_data* thrd,
+        std::uint64_t begin_ns, std::size_t phase,
+        thread_schedule_state state) noexcept;
+
+    /// Used by the scheduling loop around the execution of a task. Does
+    /// nothing except for checking a flag when recording is disabled.
+    class task_timeline_scope
+    {
+    public:
+        explicit task_timeline_scope(thread_data* thrd) noexcept
+          : thrd_(task_timeline_enabled.load(std::memory_order_relaxed) ?
+                    thrd :
+                    nullptr)
+        {
+            if (thrd_ != nullptr)
+            {
+                phase_ = thrd_->get_thread_phase();
+                begin_ns_ = now();
+            }
+        }
+
+        void finish(thread_schedule_state state) noexcept
+        {
+            if (thrd_ != nullptr)
+            {
+                record_task_timeline_event(thrd_, begin_ns_, phase_, state);
+            }
+        }
+
+        static std::uint64_t now() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                pika::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+    private:
+        thread_data* thrd_;
+        std::uint64_t begin_ns_ = 0;
+        std::size_t phase_ = 0;
+    };
+}    // namespace pika::threads::detail
+#endif
@@ -0,0 +1,117 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/coroutines/detail/coroutine_self.hpp>
+#include <pika/coroutines/detail/fiber_local_storage.hpp>
+#include <pika/modules/errors.hpp>
+
+#include <cstddef>
+#include <memory>
+
+namespace pika::threads::detail {
+    /// A pointer which has a separate value for each pika thread, similar to
+    /// thread_specific_ptr. Each instance is assigned a dense index on
+    /// construction which is used to access a slot in the storage of the
+    /// current pika thread, accessing the value is constant time and does not
+    /// allocate. The value of a pika thread is cleaned up with \a Deleter when
+    /// the thread finishes. Instances are meant to be long-lived (e.g. static
+    /// variables) since indices are not reused.
+    template <typename T, typename Deleter = std::default_delete<T>>
+    class fiber_specific_ptr
+    {
+    private:
+        using coroutine_self = coroutines::detail::coroutine_self;
+
+        static void cleanup(void* data)
+        {
+            Deleter{}(static_cast<T*>(data));
+        }
+
+        static coroutines::detail::fiber_local_storage& get_storage(
+            char const* function_name)
+        {
+            coroutine_self* self = coroutine_self::get_self();
+            if (self == nullptr)
+            {
+                PIKA_THROW_EXCEPTION(pika::error::null_thread_id,
+                    function_name, "null thread id encountered");
+            }
+            return self->get_fiber_local_storage();
+        }
+
+    public:
+        using element_type = T;
+
+        fiber_specific_ptr()
+          : key_(coroutines::detail::allocate_fiber_local_key())
+        {
+        }
+
+        fiber_specific_ptr(fiber_specific_ptr const&) = delete;
+        fiber_specific_ptr(fiber_specific_ptr&&) = delete;
+        fiber_specific_ptr& operator=(fiber_specific_ptr const&) = delete;
+        fiber_specific_ptr& operator=(fiber_specific_ptr&&) = delete;
+
+        ~fiber_specific_ptr()
+        {
+            // clean up data if this type is used locally for one thread
+            if (coroutine_self::get_self() != nullptr)
+            {
+                reset();
+            }
+        }
+
+        /// Returns the value of the current pika thread, or nullptr if
+        /// called outside of a pika thread.
+        T* get() const noexcept
+        {
+            coroutine_self* self = coroutine_self::get_self();
+            if (self == nullptr)
+            {
+                return nullptr;
+            }
+            return static_cast<T*>(self->get_fiber_local_storage().get(key_));
+        }
+
+        T* operator->() const noexcept
+        {
+            return get();
+        }
+
+        T& operator*() const noexcept
+        {
+            return *get();
+        }
+
+        T* release()
+        {
+            return static_cast<T*>(
+                get_storage("fiber_specific_ptr::release").set(key_, nullptr));
+        }
+
+        void reset(T* new_value = nullptr)
+        {
+            auto& storage = get_storage("fiber_specific_ptr::reset");
+            T* const old_value = static_cast<T*>(storage.set(
+                key_, new_value, new_value != nullptr ? &cleanup : nullptr));
+            if (old_value != nullptr && old_value != new_value)
+            {
+                Deleter{}(old_value);
+            }
+        }
+
+        std::size_t key() const noexcept
+        {
+            return key_;
+        }
+
+    private:
+        std::size_t key_;
+    };
+}    // namespace pika::threads::detail
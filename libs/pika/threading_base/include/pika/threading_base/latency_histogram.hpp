@@ -0,0 +1,216 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pika::threads {
+    /// A histogram of non-negative integer values, typically latencies in
+    /// nanoseconds, with logarithmically sized buckets in the style of HDR
+    /// histograms. Values below 2^sub_bucket_bits are counted exactly. Larger
+    /// values are counted in buckets whose width is at most 1/2^sub_bucket_bits
+    /// of the values they contain, i.e. every power of two range is split
+    /// into 2^sub_bucket_bits buckets. Percentiles are thus reported with a
+    /// relative error of at most 1/2^sub_bucket_bits (6.25%).
+    ///
+    /// Recording a value is a constant time operation. The buckets are
+    /// allocated on demand up to the largest recorded value, an empty
+    /// histogram does not allocate. Histograms can be merged, e.g. to combine
+    /// the histograms collected by different worker threads.
+    class latency_histogram
+    {
+    public:
+        static constexpr unsigned sub_bucket_bits = 4;
+        static constexpr std::uint64_t sub_bucket_count = std::uint64_t(1)
+            << sub_bucket_bits;
+
+        latency_histogram() = default;
+
+        /// Count \a value \a n times.
+        void record(std::uint64_t value, std::uint64_t n = 1)
+        {
+            std::size_t const idx = bucket_index(value);
+            if (idx >= buckets_.size())
+            {
+                buckets_.resize(idx + 1, 0);
+            }
+            buckets_[idx] += n;
+
+            if (count_ == 0)
+            {
+                min_ = value;
+                max_ = value;
+            }
+            else
+            {
+                min_ = (std::min)(min_, value);
+                max_ = (std::max)(max_, value);
+            }
+            count_ += n;
+            sum_ += value * n;
+        }
+
+        /// Add all values counted by \a other to this histogram.
+        void merge(latency_histogram const& other)
+        {
+            if (other.count_ == 0)
+            {
+                return;
+            }
+
+            if (other.buckets_.size() > buckets_.size())
+            {
+                buckets_.resize(other.buckets_.size(), 0);
+            }
+            for (std::size_t i = 0; i != other.buckets_.size(); ++i)
+            {
+                buckets_[i] += other.buckets_[i];
+            }
+
+            min_ = count_ == 0 ? other.min_ : (std::min)(min_, other.min_);
+            max_ = count_ == 0 ? other.max_ : (std::max)(max_, other.max_);
+            count_ += other.count_;
+            sum_ += other.sum_;
+        }
+
+        void reset() noexcept
+        {
+            buckets_.clear();
+            count_ = 0;
+            sum_ = 0;
+            min_ = 0;
+            max_ = 0;
+        }
+
+        std::uint64_t count() const noexcept
+        {
+            return count_;
+        }
+
+        bool empty() const noexcept
+        {
+            return count_ == 0;
+        }
+
+        /// The smallest and largest recorded values, exact. Zero if the
+        /// histogram is empty.
+        std::uint64_t min() const noexcept
+        {
+            return min_;
+        }
+
+        std::uint64_t max() const noexcept
+        {
+            return max_;
+        }
+
+        /// The mean of the recorded values, exact. Zero if the histogram is
+        /// empty.
+        double mean() const noexcept
+        {
+            return count_ == 0 ? 0.0 : double(sum_) / double(count_);
+        }
+
+        /// The smallest value such that at least \a percentile percent of
+        /// the recorded values are smaller or equal to it, rounded up to the
+        /// upper bound of its bucket. For example, percentile(99.9) returns
+        /// the p999 latency. Zero if the histogram is empty.
+        std::uint64_t percentile(double percentile) const noexcept
+        {
+            if (count_ == 0)
+            {
+                return 0;
+            }
+
+            percentile = (std::min)((std::max)(percentile, 0.0), 100.0);
+            auto const rank = (std::max)(std::uint64_t(1),
+                static_cast<std::uint64_t>(
+                    std::ceil(percentile / 100.0 * double(count_))));
+
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i != buckets_.size(); ++i)
+            {
+                seen += buckets_[i];
+                if (seen >= rank)
+                {
+                    return (std::max)(
+                        (std::min)(bucket_upper_bound(i), max_), min_);
+                }
+            }
+            return max_;
+        }
+
+        /// The index of the bucket counting \a value.
+        static constexpr std::size_t bucket_index(std::uint64_t value) noexcept
+        {
+            if (value < sub_bucket_count)
+            {
+                return std::size_t(value);
+            }
+
+            // the position of the most significant bit, at least
+            // sub_bucket_bits
+            unsigned const msb = most_significant_bit(value);
+            unsigned const shift = msb - sub_bucket_bits;
+            return std::size_t((shift + 1) * sub_bucket_count +
+                ((value >> shift) - sub_bucket_count));
+        }
+
+        /// The smallest and largest value counted by the bucket \a idx.
+        static constexpr std::uint64_t bucket_lower_bound(
+            std::size_t idx) noexcept
+        {
+            if (idx < sub_bucket_count)
+            {
+                return std::uint64_t(idx);
+            }
+
+            auto const shift = unsigned(idx / sub_bucket_count - 1);
+            return (sub_bucket_count + idx % sub_bucket_count) << shift;
+        }
+
+        static constexpr std::uint64_t bucket_upper_bound(
+            std::size_t idx) noexcept
+        {
+            if (idx < sub_bucket_count)
+            {
+                return std::uint64_t(idx);
+            }
+
+            auto const shift = unsigned(idx / sub_bucket_count - 1);
+            return bucket_lower_bound(idx) + ((std::uint64_t(1) << shift) - 1);
+        }
+
+    private:
+        static constexpr unsigned most_significant_bit(
+            std::uint64_t value) noexcept
+        {
+            unsigned msb = 0;
+            for (unsigned bits = 32; bits != 0; bits /= 2)
+            {
+                if (value >> bits != 0)
+                {
+                    value >>= bits;
+                    msb += bits;
+                }
+            }
+            return msb;
+        }
+
+        std::vector<std::uint64_t> buckets_;
+        std::uint64_t count_ = 0;
+        std::uint64_t sum_ = 0;
+        std::uint64_t min_ = 0;
+        std::uint64_t max_ = 0;
+    };
+}    // namespace pika::threads
@@ -261,6 +261,23 @@ namespace pika::threads::detail {
 
         virtual void reset_thread_distribution() {}
 
+        // Schedulers of other pools, tried in the given order, from which
+        // idle worker threads of this scheduler take staged work
+        void set_overflow_schedulers(std::vector<scheduler_base*> schedulers);
+
+        // Take one staged task from the overflow schedulers and create it on
+        // the given worker thread. Returns false if no task was found.
+        bool steal_from_overflow_schedulers(std::size_t num_thread);
+
+        // Remove one staged task which was not given a worker thread hint, so
+        // that it can be created by the scheduler of another pool. Schedulers
+        // which don't support this never give away work.
+        virtual bool steal_staged_task(
+            threads::detail::thread_init_data& /*data*/)
+        {
+            return false;
+        }
+
         std::ptrdiff_t get_stack_size(
             execution::thread_stacksize stacksize) const
         {
@@ -411,6 +428,8 @@ namespace pika::threads::detail {
 
         std::atomic<std::int64_t> background_thread_count_;
 
+        std::vector<scheduler_base*> overflow_schedulers_;
+
         std::atomic<polling_function_ptr> polling_function_mpi_;
         std::atomic<polling_function_ptr> polling_function_cuda_;
         std::atomic<polling_work_count_function_ptr>
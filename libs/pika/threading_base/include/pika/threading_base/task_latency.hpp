@@ -0,0 +1,126 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+#include <pika/threading_base/latency_histogram.hpp>
+#include <pika/threading_base/thread_data.hpp>
+#include <pika/timing/steady_clock.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+
+namespace pika::threads {
+    /// The latencies of all executions of tasks with the same annotation, in
+    /// nanoseconds. The queue wait time of a task is the time between the
+    /// task becoming ready, i.e. being created, resumed, or yielding, and a
+    /// worker thread starting to run it. The execution time is the time
+    /// between a worker thread switching to the task and the task yielding,
+    /// suspending, or terminating.
+    struct task_latency
+    {
+        latency_histogram queue_wait;
+        latency_histogram execution;
+
+        void merge(task_latency const& other)
+        {
+            queue_wait.merge(other.queue_wait);
+            execution.merge(other.execution);
+        }
+    };
+
+    /// The task latencies recorded so far by all worker threads, keyed by
+    /// task annotation. Tasks without annotation are reported as
+    /// "<unknown>". Each worker thread records at most 256 annotations
+    /// separately, the tasks of further annotations are reported as
+    /// "<other>". The histograms of the worker threads are merged, the
+    /// recording continues while they are copied.
+    PIKA_EXPORT std::map<std::string, task_latency> get_task_latencies();
+
+    /// The task latencies recorded so far by the worker thread with the
+    /// given global thread number.
+    PIKA_EXPORT std::map<std::string, task_latency> get_task_latencies(
+        std::size_t global_thread_num);
+
+    /// Discard the task latencies recorded so far.
+    PIKA_EXPORT void reset_task_latencies();
+
+    /// Write the number of executions and the p50, p99, and p999 queue wait
+    /// and execution times of each annotation as a table.
+    PIKA_EXPORT void print_task_latencies(std::ostream& os,
+        std::map<std::string, task_latency> const& latencies);
+}    // namespace pika::threads
+
+namespace pika::threads::detail {
+    PIKA_EXPORT extern std::atomic<bool> task_latency_enabled;
+
+    /// Allocate the histograms for \a num_workers worker threads and start
+    /// recording. Must be called before the worker threads start running
+    /// tasks.
+    PIKA_EXPORT void start_task_latencies(std::size_t num_workers);
+
+    /// Stop recording. The recorded latencies are kept until the next call
+    /// to start_task_latencies.
+    PIKA_EXPORT void stop_task_latencies();
+
+    PIKA_EXPORT void record_task_latency(thread_data* thrd,
+        std::uint64_t begin_ns, thread_schedule_state state) noexcept;
+
+    inline std::uint64_t task_latency_now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            pika::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /// Called whenever a task becomes ready to run. Does nothing except for
+    /// checking a flag when recording is disabled.
+    inline void mark_task_ready(thread_data* thrd) noexcept
+    {
+        thrd->set_ready_time(
+            task_latency_enabled.load(std::memory_order_relaxed) ?
+                task_latency_now() :
+                0);
+    }
+
+    /// Used by the scheduling loop around the execution of a task. Does
+    /// nothing except for checking a flag when recording is disabled.
+    class task_latency_scope
+    {
+    public:
+        explicit task_latency_scope(thread_data* thrd) noexcept
+          : thrd_(task_latency_enabled.load(std::memory_order_relaxed) ?
+                    thrd :
+                    nullptr)
+        {
+            if (thrd_ != nullptr)
+            {
+                begin_ns_ = task_latency_now();
+            }
+        }
+
+        void finish(thread_schedule_state state) noexcept
+        {
+            if (thrd_ != nullptr)
+            {
+                record_task_latency(thrd_, begin_ns_, state);
+            }
+        }
+
+    private:
+        thread_data* thrd_;
+        std::uint64_t begin_ns_ = 0;
+    };
+}    // namespace pika::threads::detail
+#endif
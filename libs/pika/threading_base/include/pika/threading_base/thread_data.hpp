@@ -28,6 +28,7 @@
 #endif
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <forward_list>
@@ -442,6 +443,41 @@ namespace pika::threads::detail {
             priority_ = priority;
         }
 
+        constexpr std::chrono::steady_clock::time_point
+        get_deadline() const noexcept
+        {
+            return deadline_;
+        }
+        void set_deadline(
+            std::chrono::steady_clock::time_point deadline) noexcept
+        {
+            deadline_ = deadline;
+        }
+
+        // the number of work items currently running inline on the stack of
+        // this thread, see thread_pool_scheduler
+        constexpr std::size_t get_inline_depth() const noexcept
+        {
+            return inline_depth_;
+        }
+        void set_inline_depth(std::size_t depth) noexcept
+        {
+            inline_depth_ = depth;
+        }
+
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        // the time in nanoseconds at which the thread last became ready to
+        // run, zero if unknown
+        std::uint64_t get_ready_time() const noexcept
+        {
+            return ready_time_;
+        }
+        void set_ready_time(std::uint64_t ready_time) noexcept
+        {
+            ready_time_ = ready_time;
+        }
+#endif
+
         // handle thread interruption
         bool interruption_requested() const noexcept
         {
@@ -607,6 +643,11 @@ namespace pika::threads::detail {
 #endif
         ///////////////////////////////////////////////////////////////////////
         execution::thread_priority priority_;
+        std::chrono::steady_clock::time_point deadline_;
+        std::size_t inline_depth_;
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        std::uint64_t ready_time_ = 0;
+#endif
 
         bool requested_interrupt_;
         bool enabled_interrupt_;
@@ -16,6 +16,7 @@
 #endif
 #include <pika/type_support/unused.hpp>
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -40,6 +41,8 @@ namespace pika::threads::detail {
           , timer_data(nullptr)
 #endif
           , priority(execution::thread_priority::normal)
+          , deadline((std::chrono::steady_clock::time_point::max)())
+          , stop_requested(nullptr)
           , schedulehint()
           , stacksize(execution::thread_stacksize::default_)
           , initial_state(thread_schedule_state::pending)
@@ -58,6 +61,8 @@ namespace pika::threads::detail {
         {
             func = PIKA_MOVE(rhs.func);
             priority = rhs.priority;
+            deadline = rhs.deadline;
+            stop_requested = rhs.stop_requested;
             schedulehint = rhs.schedulehint;
             stacksize = rhs.stacksize;
             initial_state = rhs.initial_state;
@@ -96,6 +101,8 @@ namespace pika::threads::detail {
                 description, parent_locality_id, parent_id))
 #endif
           , priority(rhs.priority)
+          , deadline(rhs.deadline)
+          , stop_requested(rhs.stop_requested)
           , schedulehint(rhs.schedulehint)
           , stacksize(rhs.stacksize)
           , initial_state(rhs.initial_state)
@@ -132,6 +139,8 @@ namespace pika::threads::detail {
                 description, parent_locality_id, parent_id))
 #endif
           , priority(priority_)
+          , deadline((std::chrono::steady_clock::time_point::max)())
+          , stop_requested(nullptr)
           , schedulehint(os_thread)
           , stacksize(stacksize_)
           , initial_state(initial_state_)
@@ -165,6 +174,16 @@ namespace pika::threads::detail {
 #endif
 
         execution::thread_priority priority;
+        // The time by which the thread should run, used by deadline aware
+        // schedulers. The maximum time point means no deadline.
+        std::chrono::steady_clock::time_point deadline;
+        // Returns true if func has been cancelled, null if func can't be
+        // cancelled. The stop state is kept by func itself. Schedulers check
+        // it before creating a thread for staged work. Instead of creating a
+        // thread for cancelled work they call func with
+        // thread_restart_state::abort once the queue operation has finished,
+        // which lets func complete without running.
+        bool (*stop_requested)(thread_function_type const& func);
         execution::thread_schedule_hint schedulehint;
         execution::thread_stacksize stacksize;
         thread_schedule_state initial_state;
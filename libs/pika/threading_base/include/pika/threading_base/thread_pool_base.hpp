@@ -23,6 +23,7 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <exception>
@@ -268,6 +269,13 @@ namespace pika::threads::detail {
         mask_type get_used_processing_units() const;
         hwloc_bitmap_ptr get_numa_domain_bitmap() const;
 
+        /// Return the local index of a worker thread of this pool running on
+        /// the given NUMA domain, or std::size_t(-1) if no active worker
+        /// thread runs on the domain. Successive calls cycle through the
+        /// worker threads of the domain, which are looked up when the pool
+        /// starts running.
+        std::size_t get_numa_domain_thread(std::size_t domain);
+
         // performance counters
 #if defined(PIKA_HAVE_THREAD_CUMULATIVE_COUNTS)
         virtual std::int64_t get_executed_threads(
@@ -493,6 +501,33 @@ namespace pika::threads::detail {
         virtual std::int64_t get_busy_loop_count(
             std::size_t num, bool reset) = 0;
 
+        // count work items which were run inline on a worker thread of this
+        // pool instead of being spawned as new pika threads
+        virtual void increment_inline_execution_count(std::size_t /*num*/) {}
+        virtual std::int64_t get_inline_execution_count(
+            std::size_t /*num*/, bool /*reset*/)
+        {
+            return 0;
+        }
+
+        // count work items which were cancelled before a pika thread was
+        // created for them
+        virtual void increment_elided_work_count(std::size_t /*num*/) {}
+        virtual std::int64_t get_elided_work_count(
+            std::size_t /*num*/, bool /*reset*/)
+        {
+            return 0;
+        }
+
+        // count staged work items which idle worker threads of this pool took
+        // from other pools
+        virtual void increment_cross_pool_steal_count(std::size_t /*num*/) {}
+        virtual std::int64_t get_cross_pool_steal_count(
+            std::size_t /*num*/, bool /*reset*/)
+        {
+            return 0;
+        }
+
         ///////////////////////////////////////////////////////////////////////
         virtual bool enumerate_threads(
             util::detail::function<bool(thread_id_type)> const& /*f*/,
@@ -532,6 +567,7 @@ namespace pika::threads::detail {
     protected:
         /// \cond NOINTERNAL
         void init_pool_time_scale();
+        void init_numa_domain_threads(std::size_t pool_threads);
         /// \endcond
 
     protected:
@@ -547,6 +583,12 @@ namespace pika::threads::detail {
 
         pika::detail::affinity_data const& affinity_data_;
 
+        // the local indices of the worker threads on each NUMA domain, and
+        // the counter used by get_numa_domain_thread to distribute work over
+        // them
+        std::vector<std::vector<std::size_t>> numa_domain_threads_;
+        std::atomic<std::size_t> numa_domain_thread_counter_;
+
         // scale timestamps to nanoseconds
         double timestamp_scale_;
 
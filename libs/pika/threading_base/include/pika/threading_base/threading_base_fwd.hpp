@@ -59,7 +59,8 @@ namespace pika::threads::detail {
 
     using thread_function_sig = thread_result_type(thread_arg_type);
     using thread_function_type =
-        util::detail::unique_function<thread_function_sig>;
+        util::detail::unique_function<thread_function_sig,
+            coroutines::detail::thread_function_storage_size>;
 
     using thread_self = coroutines::detail::coroutine_self;
     using thread_self_impl_type = coroutines::detail::coroutine_impl;
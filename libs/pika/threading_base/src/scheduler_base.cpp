@@ -364,6 +364,42 @@ namespace pika::threads::detail {
         --background_thread_count_;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void scheduler_base::set_overflow_schedulers(
+        std::vector<scheduler_base*> schedulers)
+    {
+        overflow_schedulers_ = PIKA_MOVE(schedulers);
+    }
+
+    bool scheduler_base::steal_from_overflow_schedulers(std::size_t num_thread)
+    {
+        if (overflow_schedulers_.empty())
+        {
+            return false;
+        }
+
+        threads::detail::thread_init_data data;
+        for (scheduler_base* scheduler : overflow_schedulers_)
+        {
+            if (!scheduler->steal_staged_task(data))
+            {
+                continue;
+            }
+
+            // the task becomes a thread of this pool, running on the worker
+            // thread which took it
+            data.scheduler_base = this;
+            data.schedulehint = execution::thread_schedule_hint(
+                static_cast<std::int16_t>(num_thread));
+            data.run_now = true;
+            create_thread(data, nullptr, pika::throws);
+
+            parent_pool_->increment_cross_pool_steal_count(num_thread);
+            return true;
+        }
+        return false;
+    }
+
 #if defined(PIKA_HAVE_SCHEDULER_LOCAL_STORAGE)
     coroutines::detail::tss_data_node* scheduler_base::find_tss_data(
         void const* key)
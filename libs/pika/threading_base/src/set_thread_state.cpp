@@ -13,6 +13,7 @@
 #include <pika/threading_base/create_work.hpp>
 #include <pika/threading_base/register_thread.hpp>
 #include <pika/threading_base/set_thread_state.hpp>
+#include <pika/threading_base/task_latency.hpp>
 #include <pika/threading_base/thread_data.hpp>
 #include <pika/threading_base/threading_base_fwd.hpp>
 
@@ -266,6 +267,9 @@ namespace pika::threads::detail {
             // round robin queuing.
 
             auto* thrd_data = get_thread_id_data(thrd);
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+            mark_task_ready(thrd_data);
+#endif
             auto* scheduler = thrd_data->get_scheduler_base();
             scheduler->schedule_thread(
                 thrd, schedulehint, false, thrd_data->get_priority());
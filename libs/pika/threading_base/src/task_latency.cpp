@@ -0,0 +1,221 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+#include <pika/assert.hpp>
+#include <pika/thread_support/spinlock.hpp>
+#include <pika/threading_base/task_latency.hpp>
+#include <pika/threading_base/thread_data.hpp>
+#include <pika/threading_base/thread_description.hpp>
+#include <pika/threading_base/thread_num_tss.hpp>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pika::threads::detail {
+    std::atomic<bool> task_latency_enabled{false};
+
+    namespace {
+        using task_latency_map = std::map<std::string, task_latency>;
+
+        // Each worker thread records only into its own buffer. The lock is
+        // only contended while the histograms are copied or reset. The
+        // annotations are copied into the keys of the map since the
+        // annotation strings of pika threads may be thread local to the
+        // thread which created the task. A small direct-mapped cache keyed by
+        // annotation pointer avoids comparing strings for every task. At most
+        // max_annotations annotations are recorded separately, the tasks of
+        // any further annotations are recorded as overflow_annotation.
+        struct alignas(64) task_latency_buffer
+        {
+            static constexpr std::size_t max_annotations = 256;
+            static constexpr std::size_t annotation_cache_size = 64;
+            static constexpr char const* overflow_annotation = "<other>";
+
+            task_latency& get(char const* annotation)
+            {
+                auto& cached = cache[std::hash<char const*>{}(annotation) %
+                    annotation_cache_size];
+                // Annotations recorded as overflow_annotation don't compare
+                // equal to their entry, they are recognized by the pointer
+                if (cached.key == annotation &&
+                    (cached.entry->first == overflow_annotation ||
+                        cached.entry->first == annotation))
+                {
+                    return cached.entry->second;
+                }
+
+                auto it = latencies.find(annotation);
+                if (it == latencies.end())
+                {
+                    char const* key = latencies.size() < max_annotations ?
+                        annotation :
+                        overflow_annotation;
+                    it = latencies.try_emplace(key).first;
+                }
+
+                cached.key = annotation;
+                cached.entry = &*it;
+                return it->second;
+            }
+
+            void clear()
+            {
+                cache.fill(cache_entry{});
+                latencies.clear();
+            }
+
+            struct cache_entry
+            {
+                char const* key = nullptr;
+                task_latency_map::value_type* entry = nullptr;
+            };
+
+            pika::detail::spinlock mtx;
+            task_latency_map latencies;
+            std::array<cache_entry, annotation_cache_size> cache{};
+        };
+
+        std::vector<std::unique_ptr<task_latency_buffer>> latency_buffers;
+    }    // namespace
+
+    void start_task_latencies(std::size_t num_workers)
+    {
+        PIKA_ASSERT(!task_latency_enabled.load());
+
+        latency_buffers.clear();
+        latency_buffers.reserve(num_workers);
+        for (std::size_t i = 0; i != num_workers; ++i)
+        {
+            latency_buffers.push_back(std::make_unique<task_latency_buffer>());
+        }
+
+        task_latency_enabled.store(true, std::memory_order_release);
+    }
+
+    void stop_task_latencies()
+    {
+        task_latency_enabled.store(false, std::memory_order_release);
+    }
+
+    void record_task_latency(thread_data* thrd, std::uint64_t begin_ns,
+        thread_schedule_state state) noexcept
+    {
+        std::uint64_t const end_ns = task_latency_now();
+        std::uint64_t const ready_ns = thrd->get_ready_time();
+
+        // A task which yielded is ready again right away. Suspended tasks
+        // are marked as ready when they are resumed.
+        thrd->set_ready_time(state == thread_schedule_state::pending ||
+                    state == thread_schedule_state::pending_boost ?
+                end_ns :
+                0);
+
+        std::size_t const worker = get_global_thread_num_tss();
+        if (worker >= latency_buffers.size())
+        {
+            return;
+        }
+        task_latency_buffer& buffer = *latency_buffers[worker];
+
+        char const* annotation = "<unknown>";
+        auto const desc = thrd->get_description();
+        if (desc.kind() ==
+            pika::detail::thread_description::data_type::data_type_description)
+        {
+            annotation = desc.get_description();
+        }
+
+        std::lock_guard<pika::detail::spinlock> l(buffer.mtx);
+        try
+        {
+            task_latency& latency = buffer.get(annotation);
+            if (ready_ns != 0 && ready_ns <= begin_ns)
+            {
+                latency.queue_wait.record(begin_ns - ready_ns);
+            }
+            latency.execution.record(end_ns - begin_ns);
+        }
+        catch (...)
+        {
+            // out of memory, drop the sample
+        }
+    }
+}    // namespace pika::threads::detail
+
+namespace pika::threads {
+    std::map<std::string, task_latency> get_task_latencies()
+    {
+        std::map<std::string, task_latency> result;
+        for (auto& buffer : detail::latency_buffers)
+        {
+            std::lock_guard<pika::detail::spinlock> l(buffer->mtx);
+            for (auto const& [annotation, latency] : buffer->latencies)
+            {
+                result[annotation].merge(latency);
+            }
+        }
+        return result;
+    }
+
+    std::map<std::string, task_latency> get_task_latencies(
+        std::size_t global_thread_num)
+    {
+        if (global_thread_num >= detail::latency_buffers.size())
+        {
+            return {};
+        }
+
+        auto& buffer = *detail::latency_buffers[global_thread_num];
+        std::lock_guard<pika::detail::spinlock> l(buffer.mtx);
+        return buffer.latencies;
+    }
+
+    void reset_task_latencies()
+    {
+        for (auto& buffer : detail::latency_buffers)
+        {
+            std::lock_guard<pika::detail::spinlock> l(buffer->mtx);
+            buffer->clear();
+        }
+    }
+
+    void print_task_latencies(std::ostream& os,
+        std::map<std::string, task_latency> const& latencies)
+    {
+        os << fmt::format("{:<40} {:>10} {:>12} {:>12} {:>12} {:>12} {:>12} "
+                          "{:>12}\n",
+            "annotation", "count", "queue p50", "queue p99", "queue p999",
+            "exec p50", "exec p99", "exec p999");
+
+        for (auto const& [annotation, latency] : latencies)
+        {
+            auto const& q = latency.queue_wait;
+            auto const& e = latency.execution;
+            os << fmt::format("{:<40} {:>10} {:>12} {:>12} {:>12} {:>12} "
+                              "{:>12} {:>12}\n",
+                annotation, e.count(), q.percentile(50), q.percentile(99),
+                q.percentile(99.9), e.percentile(50), e.percentile(99),
+                e.percentile(99.9));
+        }
+        os << "(all times in nanoseconds)\n";
+    }
+}    // namespace pika::threads
+#endif
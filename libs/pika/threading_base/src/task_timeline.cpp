@@ -0,0 +1,629 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/config.hpp>
+
+#if defined(PIKA_HAVE_TASK_TIMELINE)
+#include <pika/assert.hpp>
+#include <pika/errors/throw_exception.hpp>
+#include <pika/threading_base/detail/task_timeline.hpp>
+#include <pika/threading_base/thread_data.hpp>
+#include <pika/threading_base/thread_description.hpp>
+#include <pika/threading_base/thread_num_tss.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(PIKA_HAVE_UNISTD_H)
+#include <csignal>
+#include <unistd.h>
+#endif
+
+namespace pika::threads::detail {
+    std::atomic<bool> task_timeline_enabled{false};
+
+    namespace {
+        // The annotations are copied into a fixed number of slots per buffer
+        // since the annotation strings of pika threads may be thread local to
+        // the thread which created the task. Recording thus never allocates
+        // and the memory used by dynamic annotations is bounded. Annotations
+        // are truncated to max_annotation_length characters, and are recorded
+        // as overflow_annotation once all slots are in use.
+        constexpr std::size_t max_annotations = 256;
+        constexpr std::size_t max_annotation_length = 63;
+        constexpr std::size_t annotation_table_size = 2 * max_annotations;
+        constexpr char const* overflow_annotation = "<other>";
+
+        // Each worker thread writes only to its own buffer
+        struct alignas(64) task_timeline_buffer
+        {
+            explicit task_timeline_buffer(std::size_t capacity)
+              : events(new task_timeline_event[capacity])
+              , capacity(capacity)
+              , annotations(new annotation_entry[annotation_table_size]())
+              , strings(new annotation_string[max_annotations]())
+            {
+            }
+
+            char const* intern(char const* annotation) noexcept
+            {
+                // Every annotation seen is counted against max_annotations,
+                // the table is thus never more than half full.
+                std::size_t i = std::hash<char const*>{}(annotation) %
+                    annotation_table_size;
+                while (annotations[i].key != nullptr &&
+                    annotations[i].key != annotation)
+                {
+                    i = (i + 1) % annotation_table_size;
+                }
+
+                annotation_entry& entry = annotations[i];
+                if (entry.key == annotation &&
+                    std::strncmp(entry.interned, annotation,
+                        max_annotation_length) == 0)
+                {
+                    return entry.interned;
+                }
+
+                if (num_strings == max_annotations)
+                {
+                    return overflow_annotation;
+                }
+
+                // The slots are never reused, the interned strings can thus
+                // be read concurrently by a dump
+                char* interned = strings[num_strings++].data();
+                std::strncpy(interned, annotation, max_annotation_length);
+                entry.key = annotation;
+                entry.interned = interned;
+                return interned;
+            }
+
+            struct annotation_entry
+            {
+                char const* key;
+                char const* interned;
+            };
+            using annotation_string =
+                std::array<char, max_annotation_length + 1>;
+
+            std::unique_ptr<task_timeline_event[]> events;
+            std::size_t capacity;
+            std::atomic<std::uint64_t> count{0};
+
+            std::unique_ptr<annotation_entry[]> annotations;
+            std::unique_ptr<annotation_string[]> strings;
+            std::size_t num_strings = 0;
+        };
+
+        std::vector<std::unique_ptr<task_timeline_buffer>> buffers;
+
+        std::uint64_t get_pid()
+        {
+#if defined(PIKA_HAVE_UNISTD_H)
+            return static_cast<std::uint64_t>(::getpid());
+#else
+            return 0;
+#endif
+        }
+
+        template <typename F>
+        void for_each_event(F&& f)
+        {
+            for (std::size_t worker = 0; worker != buffers.size(); ++worker)
+            {
+                task_timeline_buffer const& buffer = *buffers[worker];
+                std::uint64_t const count =
+                    buffer.count.load(std::memory_order_acquire);
+
+                // When the buffer has wrapped around the oldest event may be
+                // overwritten by a concurrent write, skip it.
+                std::uint64_t const first = count > buffer.capacity ?
+                    count - buffer.capacity + 1 :
+                    0;
+                for (std::uint64_t i = first; i != count; ++i)
+                {
+                    f(worker, buffer.events[i % buffer.capacity]);
+                }
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        void write_json_string(std::ostream& os, char const* s)
+        {
+            os << '"';
+            for (; *s != '\0'; ++s)
+            {
+                char const c = *s;
+                if (c == '"' || c == '\\')
+                {
+                    os << '\\' << c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    os << fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+                }
+                else
+                {
+                    os << c;
+                }
+            }
+            os << '"';
+        }
+
+        void dump_chrome(std::ostream& os)
+        {
+            std::uint64_t const pid = get_pid();
+
+            os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+            bool first = true;
+            for (std::size_t worker = 0; worker != buffers.size(); ++worker)
+            {
+                os << (first ? "\n" : ",\n");
+                first = false;
+                os << fmt::format("{{\"ph\":\"M\",\"name\":\"thread_name\","
+                                  "\"pid\":{},\"tid\":{},\"args\":{{\"name\":"
+                                  "\"pika/worker:{}\"}}}}",
+                    pid, worker, worker);
+            }
+
+            for_each_event(
+                [&](std::size_t worker, task_timeline_event const& e) {
+                    os << ",\n{\"ph\":\"X\",\"cat\":\"task\",\"name\":";
+                    write_json_string(os, e.annotation);
+                    os << fmt::format(
+                        ",\"pid\":{},\"tid\":{},\"ts\":{}.{:03},\"dur\":{}.{:03},"
+                        "\"args\":{{\"thread\":\"0x{:x}\",\"phase\":{},"
+                        "\"begin\":\"{}\",\"end\":\"{}\"}}}}",
+                        pid, worker, e.begin_ns / 1000, e.begin_ns % 1000,
+                        (e.end_ns - e.begin_ns) / 1000,
+                        (e.end_ns - e.begin_ns) % 1000, e.thread_id, e.phase,
+                        e.resumed ? "resume" : "begin",
+                        e.suspended ? "suspend" : "end");
+                });
+
+            os << "\n]}\n";
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // Minimal protobuf writer for the subset of the Perfetto trace format
+        // (protos/perfetto/trace/trace.proto) used below.
+        class protobuf_writer
+        {
+        public:
+            void varint(std::uint32_t field, std::uint64_t value)
+            {
+                tag(field, 0);
+                raw_varint(value);
+            }
+
+            void string(std::uint32_t field, char const* s)
+            {
+                bytes(field, s, std::strlen(s));
+            }
+
+            void string(std::uint32_t field, std::string const& s)
+            {
+                bytes(field, s.data(), s.size());
+            }
+
+            void message(std::uint32_t field, protobuf_writer const& m)
+            {
+                bytes(field, m.data_.data(), m.data_.size());
+            }
+
+            std::string const& data() const noexcept
+            {
+                return data_;
+            }
+
+            void clear() noexcept
+            {
+                data_.clear();
+            }
+
+        private:
+            void tag(std::uint32_t field, std::uint32_t wire_type)
+            {
+                raw_varint((std::uint64_t(field) << 3) | wire_type);
+            }
+
+            void bytes(std::uint32_t field, char const* s, std::size_t size)
+            {
+                tag(field, 2);
+                raw_varint(size);
+                data_.append(s, size);
+            }
+
+            void raw_varint(std::uint64_t value)
+            {
+                while (value >= 0x80)
+                {
+                    data_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                    value >>= 7;
+                }
+                data_.push_back(static_cast<char>(value));
+            }
+
+            std::string data_;
+        };
+
+        namespace perfetto {
+            // Trace
+            constexpr std::uint32_t trace_packet = 1;
+
+            // TracePacket
+            constexpr std::uint32_t packet_timestamp = 8;
+            constexpr std::uint32_t packet_sequence_id = 10;
+            constexpr std::uint32_t packet_track_event = 11;
+            constexpr std::uint32_t packet_sequence_flags = 13;
+            constexpr std::uint32_t packet_timestamp_clock_id = 58;
+            constexpr std::uint32_t packet_track_descriptor = 60;
+
+            constexpr std::uint64_t clock_monotonic = 3;
+            constexpr std::uint64_t seq_incremental_state_cleared = 1;
+
+            // TrackDescriptor
+            constexpr std::uint32_t track_uuid = 1;
+            constexpr std::uint32_t track_process = 3;
+            constexpr std::uint32_t track_thread = 4;
+
+            // ProcessDescriptor and ThreadDescriptor
+            constexpr std::uint32_t descriptor_pid = 1;
+            constexpr std::uint32_t descriptor_tid = 2;
+            constexpr std::uint32_t process_name = 6;
+            constexpr std::uint32_t thread_name = 5;
+
+            // TrackEvent
+            constexpr std::uint32_t event_debug_annotations = 4;
+            constexpr std::uint32_t event_type = 9;
+            constexpr std::uint32_t event_track_uuid = 11;
+            constexpr std::uint32_t event_name = 23;
+
+            constexpr std::uint64_t type_slice_begin = 1;
+            constexpr std::uint64_t type_slice_end = 2;
+
+            // DebugAnnotation
+            constexpr std::uint32_t annotation_uint_value = 3;
+            constexpr std::uint32_t annotation_string_value = 6;
+            constexpr std::uint32_t annotation_name = 10;
+
+            constexpr std::uint64_t sequence_id = 1;
+            constexpr std::uint64_t process_uuid = 1;
+
+            std::uint64_t worker_uuid(std::size_t worker)
+            {
+                return process_uuid + 1 + worker;
+            }
+        }    // namespace perfetto
+
+        void write_packet(std::ostream& os, protobuf_writer& trace,
+            protobuf_writer const& packet)
+        {
+            trace.clear();
+            trace.message(perfetto::trace_packet, packet);
+            os.write(trace.data().data(),
+                static_cast<std::streamsize>(trace.data().size()));
+        }
+
+        void dump_perfetto(std::ostream& os)
+        {
+            std::uint64_t const pid = get_pid();
+            protobuf_writer trace, packet, track, descriptor, event, annotation;
+
+            // process track
+            descriptor.varint(perfetto::descriptor_pid, pid);
+            descriptor.string(perfetto::process_name, "pika");
+            track.varint(perfetto::track_uuid, perfetto::process_uuid);
+            track.message(perfetto::track_process, descriptor);
+            packet.varint(
+                perfetto::packet_sequence_id, perfetto::sequence_id);
+            packet.varint(perfetto::packet_sequence_flags,
+                perfetto::seq_incremental_state_cleared);
+            packet.message(perfetto::packet_track_descriptor, track);
+            write_packet(os, trace, packet);
+
+            // one track per worker thread
+            for (std::size_t worker = 0; worker != buffers.size(); ++worker)
+            {
+                descriptor.clear();
+                descriptor.varint(perfetto::descriptor_pid, pid);
+                descriptor.varint(perfetto::descriptor_tid, worker + 1);
+                descriptor.string(perfetto::thread_name,
+                    fmt::format("pika/worker:{}", worker));
+                track.clear();
+                track.varint(
+                    perfetto::track_uuid, perfetto::worker_uuid(worker));
+                track.message(perfetto::track_thread, descriptor);
+                packet.clear();
+                packet.varint(
+                    perfetto::packet_sequence_id, perfetto::sequence_id);
+                packet.message(perfetto::packet_track_descriptor, track);
+                write_packet(os, trace, packet);
+            }
+
+            auto add_annotation = [&](char const* name, auto const& value) {
+                annotation.clear();
+                annotation.string(perfetto::annotation_name, name);
+                if constexpr (std::is_integral_v<
+                                  std::decay_t<decltype(value)>>)
+                {
+                    annotation.varint(perfetto::annotation_uint_value, value);
+                }
+                else
+                {
+                    annotation.string(
+                        perfetto::annotation_string_value, value);
+                }
+                event.message(perfetto::event_debug_annotations, annotation);
+            };
+
+            for_each_event(
+                [&](std::size_t worker, task_timeline_event const& e) {
+                    event.clear();
+                    event.varint(perfetto::event_type,
+                        perfetto::type_slice_begin);
+                    event.varint(perfetto::event_track_uuid,
+                        perfetto::worker_uuid(worker));
+                    event.string(perfetto::event_name, e.annotation);
+                    add_annotation("thread", e.thread_id);
+                    add_annotation("phase", std::uint64_t(e.phase));
+                    add_annotation("begin", e.resumed ? "resume" : "begin");
+                    add_annotation("end", e.suspended ? "suspend" : "end");
+
+                    packet.clear();
+                    packet.varint(perfetto::packet_timestamp, e.begin_ns);
+                    packet.varint(perfetto::packet_timestamp_clock_id,
+                        perfetto::clock_monotonic);
+                    packet.varint(
+                        perfetto::packet_sequence_id, perfetto::sequence_id);
+                    packet.message(perfetto::packet_track_event, event);
+                    write_packet(os, trace, packet);
+
+                    event.clear();
+                    event.varint(
+                        perfetto::event_type, perfetto::type_slice_end);
+                    event.varint(perfetto::event_track_uuid,
+                        perfetto::worker_uuid(worker));
+
+                    packet.clear();
+                    packet.varint(perfetto::packet_timestamp, e.end_ns);
+                    packet.varint(perfetto::packet_timestamp_clock_id,
+                        perfetto::clock_monotonic);
+                    packet.varint(
+                        perfetto::packet_sequence_id, perfetto::sequence_id);
+                    packet.message(perfetto::packet_track_event, event);
+                    write_packet(os, trace, packet);
+                });
+        }
+    }    // namespace
+
+    ///////////////////////////////////////////////////////////////////////////
+    task_timeline_format parse_task_timeline_format(std::string const& format)
+    {
+        if (format == "chrome" || format == "json")
+        {
+            return task_timeline_format::chrome;
+        }
+        if (format == "perfetto" || format == "protobuf")
+        {
+            return task_timeline_format::perfetto;
+        }
+
+        PIKA_THROW_EXCEPTION(pika::error::bad_parameter,
+            "parse_task_timeline_format",
+            "unknown task timeline format \"{}\" (expected \"chrome\" or "
+            "\"perfetto\")",
+            format);
+    }
+
+    void start_task_timeline(std::size_t num_workers, std::size_t buffer_size)
+    {
+        PIKA_ASSERT(!task_timeline_enabled.load());
+
+        buffers.clear();
+        buffers.reserve(num_workers);
+        for (std::size_t i = 0; i != num_workers; ++i)
+        {
+            buffers.push_back(std::make_unique<task_timeline_buffer>(
+                (std::max)(buffer_size, std::size_t(2))));
+        }
+
+        task_timeline_enabled.store(true, std::memory_order_release);
+    }
+
+    void stop_task_timeline()
+    {
+        task_timeline_enabled.store(false, std::memory_order_release);
+    }
+
+    void dump_task_timeline(std::ostream& os, task_timeline_format format)
+    {
+        switch (format)
+        {
+        case task_timeline_format::chrome:
+            dump_chrome(os);
+            break;
+        case task_timeline_format::perfetto:
+            dump_perfetto(os);
+            break;
+        }
+    }
+
+    void dump_task_timeline(
+        std::string const& filename, task_timeline_format format)
+    {
+        std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+        if (!os)
+        {
+            PIKA_THROW_EXCEPTION(pika::error::kernel_error,
+                "dump_task_timeline", "could not open {} for writing",
+                filename);
+        }
+        dump_task_timeline(os, format);
+    }
+
+    void record_task_timeline_event(thread_data* thrd, std::uint64_t begin_ns,
+        std::size_t phase, thread_schedule_state state) noexcept
+    {
+        std::uint64_t const end_ns = task_timeline_scope::now();
+
+        std::size_t const worker = get_global_thread_num_tss();
+        if (worker >= buffers.size())
+        {
+            return;
+        }
+        task_timeline_buffer& buffer = *buffers[worker];
+
+        char const* annotation = "<unknown>";
+        auto const desc = thrd->get_description();
+        if (desc.kind() ==
+            pika::detail::thread_description::data_type::data_type_description)
+        {
+            annotation = buffer.intern(desc.get_description());
+        }
+
+        std::uint64_t const count =
+            buffer.count.load(std::memory_order_relaxed);
+        buffer.events[count % buffer.capacity] = task_timeline_event{
+            annotation, reinterpret_cast<std::uint64_t>(thrd), begin_ns,
+            end_ns, static_cast<std::uint32_t>(phase), phase != 0,
+            state != thread_schedule_state::terminated};
+        buffer.count.store(count + 1, std::memory_order_release);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+#if defined(PIKA_HAVE_UNISTD_H)
+    namespace {
+        // The signal handler only writes to a pipe, the timeline is dumped
+        // by a separate OS thread reading from the pipe.
+        struct task_timeline_signal_state
+        {
+            int signum = 0;
+            int pipe_fds[2] = {-1, -1};
+            struct sigaction previous_action;
+            std::thread dumper;
+        };
+
+        task_timeline_signal_state signal_state;
+
+        extern "C" void task_timeline_signal_handler(int)
+        {
+            int const saved_errno = errno;
+            char const c = 'd';
+            [[maybe_unused]] auto r = ::write(signal_state.pipe_fds[1], &c, 1);
+            errno = saved_errno;
+        }
+
+        void task_timeline_dumper(
+            int fd, std::string filename, task_timeline_format format)
+        {
+            char c = 0;
+            while (true)
+            {
+                auto const r = ::read(fd, &c, 1);
+                if (r == -1 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (r != 1 || c != 'd')
+                {
+                    break;
+                }
+
+                try
+                {
+                    dump_task_timeline(filename, format);
+                }
+                catch (...)
+                {
+                    // there is no one to report the error to
+                }
+            }
+        }
+    }    // namespace
+
+    void start_task_timeline_signal_handler(
+        int signum, std::string filename, task_timeline_format format)
+    {
+        PIKA_ASSERT(signal_state.signum == 0);
+
+        if (::pipe(signal_state.pipe_fds) == -1)
+        {
+            PIKA_THROW_EXCEPTION(pika::error::kernel_error,
+                "start_task_timeline_signal_handler",
+                "could not create pipe: {}", std::strerror(errno));
+        }
+
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = &task_timeline_signal_handler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        if (::sigaction(signum, &action, &signal_state.previous_action) == -1)
+        {
+            int const error = errno;
+            ::close(signal_state.pipe_fds[0]);
+            ::close(signal_state.pipe_fds[1]);
+            PIKA_THROW_EXCEPTION(pika::error::kernel_error,
+                "start_task_timeline_signal_handler",
+                "could not install handler for signal {}: {}", signum,
+                std::strerror(error));
+        }
+
+        signal_state.signum = signum;
+        signal_state.dumper = std::thread(&task_timeline_dumper,
+            signal_state.pipe_fds[0], PIKA_MOVE(filename), format);
+    }
+
+    void stop_task_timeline_signal_handler()
+    {
+        if (signal_state.signum == 0)
+        {
+            return;
+        }
+
+        ::sigaction(signal_state.signum, &signal_state.previous_action,
+            nullptr);
+
+        char const c = 'q';
+        [[maybe_unused]] auto r = ::write(signal_state.pipe_fds[1], &c, 1);
+        signal_state.dumper.join();
+
+        ::close(signal_state.pipe_fds[0]);
+        ::close(signal_state.pipe_fds[1]);
+        signal_state.signum = 0;
+    }
+#else
+    void start_task_timeline_signal_handler(int, std::string, task_timeline_format)
+    {
+        PIKA_THROW_EXCEPTION(pika::error::not_implemented,
+            "start_task_timeline_signal_handler",
+            "dumping the task timeline on a signal is not supported on this "
+            "platform");
+    }
+
+    void stop_task_timeline_signal_handler() {}
+#endif
+}    // namespace pika::threads::detail
+#endif
@@ -18,6 +18,9 @@
 #if defined(PIKA_HAVE_APEX)
 #include <pika/threading_base/external_timer.hpp>
 #endif
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+#include <pika/threading_base/task_latency.hpp>
+#endif
 
 #include <fmt/format.h>
 
@@ -66,6 +69,8 @@ namespace pika::threads::detail {
       , backtrace_(nullptr)
 #endif
       , priority_(init_data.priority)
+      , deadline_(init_data.deadline)
+      , inline_depth_(0)
       , requested_interrupt_(false)
       , enabled_interrupt_(true)
       , ran_exit_funcs_(false)
@@ -98,6 +103,9 @@ namespace pika::threads::detail {
 #endif
 #if defined(PIKA_HAVE_APEX)
         set_timer_data(init_data.timer_data);
+#endif
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        mark_task_ready(this);
 #endif
     }
 
@@ -216,6 +224,8 @@ namespace pika::threads::detail {
         backtrace_ = nullptr;
 #endif
         priority_ = init_data.priority;
+        deadline_ = init_data.deadline;
+        inline_depth_ = 0;
         requested_interrupt_ = false;
         enabled_interrupt_ = true;
         ran_exit_funcs_ = false;
@@ -252,6 +262,9 @@ namespace pika::threads::detail {
 #endif
 #if defined(PIKA_HAVE_APEX)
         set_timer_data(init_data.timer_data);
+#endif
+#if defined(PIKA_HAVE_TASK_LATENCY_HISTOGRAMS)
+        mark_task_ready(this);
 #endif
     }
 
@@ -15,6 +15,7 @@
 #include <pika/threading_base/thread_pool_base.hpp>
 #include <pika/topology/topology.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
@@ -23,6 +24,7 @@
 #include <ostream>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace pika::threads::detail {
     ///////////////////////////////////////////////////////////////////////////
@@ -30,6 +32,7 @@ namespace pika::threads::detail {
       : id_(init.index_, init.name_)
       , thread_offset_(init.thread_offset_)
       , affinity_data_(init.affinity_data_)
+      , numa_domain_thread_counter_(0)
       , timestamp_scale_(1.0)
       , notifier_(init.notifier_)
     {
@@ -64,6 +67,58 @@ namespace pika::threads::detail {
         return topo.cpuset_to_nodeset(used_processing_units);
     }
 
+    void thread_pool_base::init_numa_domain_threads(std::size_t pool_threads)
+    {
+        auto const& topo = create_topology();
+
+        numa_domain_threads_.clear();
+        for (std::size_t thread_num = 0; thread_num != pool_threads;
+             ++thread_num)
+        {
+            std::size_t const domain = topo.get_numa_node_number(
+                affinity_data_.get_pu_num(thread_num + get_thread_offset()));
+            if (domain == std::size_t(-1))
+            {
+                continue;
+            }
+
+            if (domain >= numa_domain_threads_.size())
+            {
+                numa_domain_threads_.resize(domain + 1);
+            }
+            numa_domain_threads_[domain].push_back(thread_num);
+        }
+    }
+
+    std::size_t thread_pool_base::get_numa_domain_thread(std::size_t domain)
+    {
+        if (domain >= numa_domain_threads_.size() ||
+            numa_domain_threads_[domain].empty())
+        {
+            return std::size_t(-1);
+        }
+
+        // Threads which have been stopped since the pool started running are
+        // skipped
+        auto const& domain_threads = numa_domain_threads_[domain];
+        auto const sched = get_scheduler();
+        std::size_t const num_domain_threads = domain_threads.size();
+        std::size_t const first =
+            numa_domain_thread_counter_.fetch_add(1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i != num_domain_threads; ++i)
+        {
+            std::size_t const thread_num =
+                domain_threads[(first + i) % num_domain_threads];
+            if (sched->get_state(thread_num).load(std::memory_order_relaxed) <=
+                runtime_state::suspended)
+            {
+                return thread_num;
+            }
+        }
+
+        return std::size_t(-1);
+    }
+
     std::size_t thread_pool_base::get_active_os_thread_count() const
     {
         std::size_t active_os_thread_count = 0;
@@ -66,7 +66,7 @@ int main(int argc, char** argv)
 {
     std::vector<std::string> schedulers = {"local", "local-priority-fifo",
         "local-priority-lifo", "static", "static-priority", "abp-priority-fifo",
-        "abp-priority-lifo", "shared-priority"};
+        "abp-priority-lifo", "shared-priority", "deadline"};
     for (auto const& scheduler : schedulers)
     {
         pika::init_params iparams;
@@ -0,0 +1,150 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that values of fiber_specific_ptr are separate for each
+// pika thread, survive suspension, and are cleaned up when the thread
+// finishes, including values stored in overflow slots and values set by
+// cleanup functions.
+
+#include <pika/coroutines/detail/fiber_local_storage.hpp>
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+#include <pika/threading_base/fiber_specific_ptr.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+using pika::threads::coroutines::detail::fiber_local_storage;
+using pika::threads::detail::fiber_specific_ptr;
+
+std::atomic<std::size_t> num_cleanups(0);
+
+struct data
+{
+    std::size_t value;
+
+    ~data()
+    {
+        ++num_cleanups;
+    }
+};
+
+// more pointers than inline slots to exercise the overflow slots
+constexpr std::size_t num_ptrs = fiber_local_storage::num_inline_slots + 4;
+fiber_specific_ptr<data> ptrs[num_ptrs];
+
+// the cleanup of this pointer sets a value of another pointer
+fiber_specific_ptr<data> nested_ptr;
+struct set_nested
+{
+    void operator()(data* p) const
+    {
+        nested_ptr.reset(new data{p->value});
+        delete p;
+    }
+};
+fiber_specific_ptr<data, set_nested> outer_ptr;
+
+void set_and_check(std::size_t value)
+{
+    for (auto& p : ptrs)
+    {
+        PIKA_TEST(p.get() == nullptr);
+        p.reset(new data{value});
+    }
+    outer_ptr.reset(new data{value});
+
+    pika::this_thread::yield();
+
+    for (auto& p : ptrs)
+    {
+        PIKA_TEST(p.get() != nullptr);
+        PIKA_TEST_EQ(p->value, value);
+    }
+}
+
+int pika_main()
+{
+    constexpr std::size_t num_tasks = 10;
+
+    // stackful threads
+    {
+        num_cleanups = 0;
+        std::vector<pika::thread> threads;
+        for (std::size_t i = 0; i != num_tasks; ++i)
+        {
+            threads.emplace_back(&set_and_check, i);
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        PIKA_TEST_EQ(num_cleanups.load(), num_tasks * (num_ptrs + 2));
+    }
+
+    // stackless threads can't yield, values are set and cleaned up only
+    {
+        num_cleanups = 0;
+        auto sched = ex::with_stacksize(ex::thread_pool_scheduler{},
+            pika::execution::thread_stacksize::nostack);
+        tt::sync_wait(ex::schedule(sched) | ex::then([] {
+            for (auto& p : ptrs)
+            {
+                p.reset(new data{42});
+                PIKA_TEST_EQ(p->value, std::size_t(42));
+            }
+        }));
+        PIKA_TEST_EQ(num_cleanups.load(), num_ptrs);
+    }
+
+    // reset cleans up the previous value, release does not
+    {
+        num_cleanups = 0;
+        ptrs[0].reset(new data{1});
+        ptrs[0].reset(new data{2});
+        PIKA_TEST_EQ(num_cleanups.load(), std::size_t(1));
+
+        data* p = ptrs[0].release();
+        PIKA_TEST(ptrs[0].get() == nullptr);
+        PIKA_TEST_EQ(p->value, std::size_t(2));
+        delete p;
+        PIKA_TEST_EQ(num_cleanups.load(), std::size_t(2));
+    }
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    // outside of pika threads there is no value
+    PIKA_TEST(ptrs[0].get() == nullptr);
+    bool caught = false;
+    try
+    {
+        ptrs[0].reset();
+    }
+    catch (pika::exception const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    // keys are dense indices
+    for (std::size_t i = 1; i != num_ptrs; ++i)
+    {
+        PIKA_TEST_EQ(ptrs[i].key(), ptrs[i - 1].key() + 1);
+    }
+
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv), 0);
+    return pika::util::report_errors();
+}
@@ -0,0 +1,121 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <pika/testing.hpp>
+#include <pika/threading_base/latency_histogram.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+using pika::threads::latency_histogram;
+
+void test_buckets()
+{
+    // small values are counted exactly
+    for (std::uint64_t v = 0; v != latency_histogram::sub_bucket_count; ++v)
+    {
+        PIKA_TEST_EQ(latency_histogram::bucket_index(v), std::size_t(v));
+    }
+
+    // the buckets are contiguous and each bucket contains its bounds
+    std::uint64_t expected_lower = 0;
+    for (std::size_t idx = 0; idx != 40 * latency_histogram::sub_bucket_count;
+         ++idx)
+    {
+        std::uint64_t const lower = latency_histogram::bucket_lower_bound(idx);
+        std::uint64_t const upper = latency_histogram::bucket_upper_bound(idx);
+        PIKA_TEST_EQ(lower, expected_lower);
+        PIKA_TEST_LTE(lower, upper);
+        PIKA_TEST_EQ(latency_histogram::bucket_index(lower), idx);
+        PIKA_TEST_EQ(latency_histogram::bucket_index(upper), idx);
+
+        // the relative error is bounded
+        PIKA_TEST_LTE((upper - lower) * latency_histogram::sub_bucket_count,
+            (std::max)(lower, std::uint64_t(1)));
+        expected_lower = upper + 1;
+    }
+
+    // the largest values have a bucket too
+    std::uint64_t const max = std::uint64_t(-1);
+    PIKA_TEST_EQ(latency_histogram::bucket_upper_bound(
+                     latency_histogram::bucket_index(max)),
+        max);
+}
+
+void test_percentiles()
+{
+    latency_histogram h;
+    PIKA_TEST(h.empty());
+    PIKA_TEST_EQ(h.percentile(50), std::uint64_t(0));
+
+    // 1..1000
+    for (std::uint64_t v = 1; v <= 1000; ++v)
+    {
+        h.record(v);
+    }
+    PIKA_TEST_EQ(h.count(), std::uint64_t(1000));
+    PIKA_TEST_EQ(h.min(), std::uint64_t(1));
+    PIKA_TEST_EQ(h.max(), std::uint64_t(1000));
+    PIKA_TEST_EQ(h.mean(), 500.5);
+
+    auto within = [](std::uint64_t actual, std::uint64_t exact) {
+        return actual >= exact &&
+            actual - exact <= exact / latency_histogram::sub_bucket_count;
+    };
+    PIKA_TEST(within(h.percentile(50), 500));
+    PIKA_TEST(within(h.percentile(99), 990));
+    PIKA_TEST(within(h.percentile(99.9), 999));
+    PIKA_TEST_EQ(h.percentile(100), std::uint64_t(1000));
+    PIKA_TEST_EQ(h.percentile(0), std::uint64_t(1));
+
+    // a single outlier shows up in the tail only
+    latency_histogram tail;
+    tail.record(10, 998);
+    tail.record(1000000, 2);
+    PIKA_TEST_EQ(tail.percentile(50), std::uint64_t(10));
+    PIKA_TEST_EQ(tail.percentile(99), std::uint64_t(10));
+    PIKA_TEST(within(tail.percentile(99.9), 1000000));
+
+    tail.reset();
+    PIKA_TEST(tail.empty());
+    PIKA_TEST_EQ(tail.max(), std::uint64_t(0));
+}
+
+void test_merge()
+{
+    latency_histogram a;
+    latency_histogram b;
+    latency_histogram all;
+    for (std::uint64_t v = 0; v < 10000; v += 7)
+    {
+        (v % 2 == 0 ? a : b).record(v);
+        all.record(v);
+    }
+
+    latency_histogram merged;
+    merged.merge(a);
+    merged.merge(latency_histogram{});
+    merged.merge(b);
+
+    PIKA_TEST_EQ(merged.count(), all.count());
+    PIKA_TEST_EQ(merged.min(), all.min());
+    PIKA_TEST_EQ(merged.max(), all.max());
+    PIKA_TEST_EQ(merged.mean(), all.mean());
+    for (double p : {0.0, 10.0, 50.0, 90.0, 99.0, 99.9, 100.0})
+    {
+        PIKA_TEST_EQ(merged.percentile(p), all.percentile(p));
+    }
+}
+
+int main()
+{
+    test_buckets();
+    test_percentiles();
+    test_merge();
+
+    return pika::util::report_errors();
+}
@@ -0,0 +1,148 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that the queue wait and execution times of annotated
+// tasks are recorded per annotation, also across suspension.
+
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/runtime.hpp>
+#include <pika/semaphore.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+#include <pika/threading_base/task_latency.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+int pika_main()
+{
+    constexpr std::size_t num_tasks = 100;
+    constexpr std::size_t num_yields = 3;
+
+    pika::threads::reset_task_latencies();
+
+    auto short_sched =
+        ex::with_annotation(ex::thread_pool_scheduler{}, "latency-short");
+    auto long_sched =
+        ex::with_annotation(ex::thread_pool_scheduler{}, "latency-long");
+
+    // the long task is suspended until the short tasks have finished
+    pika::binary_semaphore<> sem(0);
+
+    auto long_task = ex::schedule(long_sched) | ex::then([&] {
+        sem.acquire();
+
+        auto const start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start <
+            std::chrono::milliseconds(5))
+        {
+        }
+    }) | ex::ensure_started();
+
+    std::vector<ex::unique_any_sender<>> senders;
+    for (std::size_t i = 0; i != num_tasks; ++i)
+    {
+        senders.emplace_back(ex::schedule(short_sched) | ex::then([] {
+            for (std::size_t j = 0; j != num_yields; ++j)
+            {
+                pika::this_thread::yield();
+            }
+        }) | ex::ensure_started());
+    }
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+    sem.release();
+    tt::sync_wait(std::move(long_task));
+
+    auto latencies = pika::threads::get_task_latencies();
+
+    // each yield ends one execution of the task
+    auto const& short_latency = latencies["latency-short"];
+    PIKA_TEST_EQ(
+        short_latency.execution.count(), num_tasks * (num_yields + 1));
+    PIKA_TEST_EQ(
+        short_latency.queue_wait.count(), num_tasks * (num_yields + 1));
+
+    auto const& long_latency = latencies["latency-long"];
+    PIKA_TEST_LTE(std::uint64_t(1), long_latency.execution.count());
+    PIKA_TEST_EQ(
+        long_latency.queue_wait.count(), long_latency.execution.count());
+    PIKA_TEST_LTE(std::uint64_t(5000000), long_latency.execution.max());
+    PIKA_TEST_LTE(
+        std::uint64_t(5000000), long_latency.execution.percentile(99.9));
+
+    // the histograms of the worker threads add up to the merged ones
+    std::uint64_t count = 0;
+    for (std::size_t i = 0; i != pika::get_num_worker_threads(); ++i)
+    {
+        auto worker_latencies = pika::threads::get_task_latencies(i);
+        count += worker_latencies["latency-short"].execution.count();
+    }
+    PIKA_TEST_EQ(count, short_latency.execution.count());
+
+    std::ostringstream os;
+    pika::threads::print_task_latencies(os, latencies);
+    PIKA_TEST_NEQ(os.str().find("latency-short"), std::string::npos);
+    PIKA_TEST_NEQ(os.str().find("latency-long"), std::string::npos);
+
+    pika::threads::reset_task_latencies();
+    PIKA_TEST_EQ(pika::threads::get_task_latencies().count("latency-short"),
+        std::size_t(0));
+
+    // the number of annotations recorded separately is bounded, the tasks of
+    // further annotations are recorded together
+    constexpr std::size_t num_annotations = 2000;
+    std::vector<std::string> annotations;
+    annotations.reserve(num_annotations);
+    std::vector<ex::unique_any_sender<>> dynamic_senders;
+    for (std::size_t i = 0; i != num_annotations; ++i)
+    {
+        annotations.push_back("latency-dynamic-" + std::to_string(i));
+        dynamic_senders.emplace_back(
+            ex::schedule(ex::with_annotation(
+                ex::thread_pool_scheduler{}, annotations.back().c_str())) |
+            ex::ensure_started());
+    }
+    tt::sync_wait(ex::when_all_vector(std::move(dynamic_senders)));
+
+    std::uint64_t dynamic_count = 0;
+    for (std::size_t i = 0; i != pika::get_num_worker_threads(); ++i)
+    {
+        auto worker_latencies = pika::threads::get_task_latencies(i);
+        PIKA_TEST_LTE(worker_latencies.size(), std::size_t(257));
+        for (auto const& [annotation, latency] : worker_latencies)
+        {
+            if (annotation.find("latency-dynamic-") == 0 ||
+                annotation == "<other>")
+            {
+                dynamic_count += latency.execution.count();
+            }
+        }
+    }
+    PIKA_TEST_EQ(dynamic_count, std::uint64_t(num_annotations));
+    PIKA_TEST_EQ(
+        pika::threads::get_task_latencies().count("<other>"), std::size_t(1));
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    pika::init_params init_args;
+    init_args.cfg = {"pika.latency_histograms.enabled=1",
+        "pika.latency_histograms.file=task_latency_test.txt"};
+
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv, init_args), 0);
+    return pika::util::report_errors();
+}
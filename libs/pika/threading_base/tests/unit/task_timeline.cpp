@@ -0,0 +1,128 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that the task timeline records begin, suspend, resume,
+// and end of annotated tasks and writes them in both supported formats.
+
+#include <pika/execution.hpp>
+#include <pika/execution_base/this_thread.hpp>
+#include <pika/init.hpp>
+#include <pika/testing.hpp>
+#include <pika/thread.hpp>
+#include <pika/threading_base/detail/task_timeline.hpp>
+
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+namespace timeline = pika::threads::detail;
+
+std::string const timeline_file = "task_timeline_test.json";
+
+int pika_main()
+{
+    auto sched = ex::with_annotation(
+        ex::thread_pool_scheduler{}, "timeline-test-task");
+    tt::sync_wait(ex::schedule(sched) | ex::then([] {
+        // each yield ends one execution of the task
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            pika::this_thread::yield();
+        }
+    }));
+
+    // dynamic annotations use a bounded number of slots, the remaining ones
+    // are recorded as "<other>"
+    std::vector<std::string> annotations;
+    for (std::size_t i = 0; i < 2000; ++i)
+    {
+        annotations.push_back("timeline-dynamic-" + std::to_string(i));
+    }
+    std::vector<ex::unique_any_sender<>> senders;
+    for (auto const& annotation : annotations)
+    {
+        auto dynamic_sched = ex::with_annotation(
+            ex::thread_pool_scheduler{}, annotation.c_str());
+        senders.emplace_back(ex::schedule(dynamic_sched) | ex::then([] {}));
+    }
+    tt::sync_wait(ex::when_all_vector(std::move(senders)));
+
+    std::ostringstream perfetto;
+    timeline::dump_task_timeline(
+        perfetto, timeline::task_timeline_format::perfetto);
+    std::string const data = perfetto.str();
+
+    // the trace consists of length delimited TracePackets (field 1)
+    PIKA_TEST(!data.empty());
+    PIKA_TEST_EQ(data[0], '\x0a');
+    PIKA_TEST_NEQ(data.find("timeline-test-task"), std::string::npos);
+    PIKA_TEST_NEQ(data.find("pika/worker:0"), std::string::npos);
+    PIKA_TEST_NEQ(data.find("timeline-dynamic-0"), std::string::npos);
+    PIKA_TEST_NEQ(data.find("<other>"), std::string::npos);
+
+    // the signal handler writes the timeline recorded so far
+    std::remove(timeline_file.c_str());
+    std::raise(SIGUSR2);
+    pika::util::yield_while([] { return !std::ifstream(timeline_file); });
+
+    return pika::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    PIKA_TEST(timeline::parse_task_timeline_format("chrome") ==
+        timeline::task_timeline_format::chrome);
+    PIKA_TEST(timeline::parse_task_timeline_format("perfetto") ==
+        timeline::task_timeline_format::perfetto);
+
+    bool caught = false;
+    try
+    {
+        timeline::parse_task_timeline_format("unknown");
+    }
+    catch (pika::exception const&)
+    {
+        caught = true;
+    }
+    PIKA_TEST(caught);
+
+    pika::init_params init_args;
+    init_args.cfg = {"pika.timeline.enabled!=1",
+        "pika.timeline.file!=" + timeline_file,
+        "pika.timeline.format!=chrome",
+        "pika.timeline.signal!=" + std::to_string(SIGUSR2)};
+
+    PIKA_TEST_EQ(pika::init(pika_main, argc, argv, init_args), 0);
+
+    // the timeline is written when the runtime stops
+    std::ifstream is(timeline_file);
+    PIKA_TEST(is.good());
+    std::string const json{
+        std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+    is.close();
+    std::remove(timeline_file.c_str());
+
+    PIKA_TEST_EQ(json.rfind("{\"displayTimeUnit\"", 0), std::size_t(0));
+    PIKA_TEST_NEQ(json.find("\"name\":\"timeline-test-task\""),
+        std::string::npos);
+    PIKA_TEST_NEQ(json.find("\"begin\":\"begin\",\"end\":\"suspend\""),
+        std::string::npos);
+    PIKA_TEST_NEQ(json.find("\"begin\":\"resume\",\"end\":\"suspend\""),
+        std::string::npos);
+    PIKA_TEST_NEQ(
+        json.find("\"begin\":\"resume\",\"end\":\"end\""), std::string::npos);
+    PIKA_TEST_NEQ(json.find("\"thread_name\""), std::string::npos);
+
+    return 0;
+}
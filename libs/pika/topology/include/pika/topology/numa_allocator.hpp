@@ -0,0 +1,151 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <pika/config.hpp>
+#include <pika/topology/topology.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace pika::threads::detail {
+    enum class numa_allocation_policy
+    {
+        // pages are placed on the domain of the thread first touching them
+        first_touch,
+        // pages are placed on a given domain
+        bind,
+        // pages are distributed round-robin over all domains
+        interleave,
+    };
+
+    /// \brief An allocator placing the allocated pages on NUMA domains.
+    ///
+    /// With numa_allocation_policy::first_touch memory should be initialized
+    /// by the tasks which will later work on it, so that the pages end up on
+    /// the domains of the worker threads running those tasks. The placement
+    /// is best effort: if the operating system does not support binding
+    /// memory, the memory is allocated without binding.
+    ///
+    /// Memory is allocated in whole pages directly from the operating system.
+    /// The allocator is meant for large, long-lived buffers.
+    template <typename T>
+    class numa_allocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = numa_allocator<U>;
+        };
+
+        /// The domain is only used by numa_allocation_policy::bind.
+        explicit numa_allocator(
+            numa_allocation_policy policy = numa_allocation_policy::first_touch,
+            std::size_t domain = 0) noexcept
+          : policy_(policy)
+          , domain_(domain)
+        {
+        }
+
+        template <typename U>
+        numa_allocator(numa_allocator<U> const& other) noexcept
+          : policy_(other.policy())
+          , domain_(other.domain())
+        {
+        }
+
+        numa_allocation_policy policy() const noexcept
+        {
+            return policy_;
+        }
+
+        std::size_t domain() const noexcept
+        {
+            return domain_;
+        }
+
+        T* allocate(std::size_t n)
+        {
+            if (n == 0)
+            {
+                return nullptr;
+            }
+            if (n > (std::numeric_limits<std::size_t>::max)() / sizeof(T))
+            {
+                throw std::bad_array_new_length();
+            }
+
+            topology const& topo = create_topology();
+            std::size_t const len = n * sizeof(T);
+
+            hwloc_bitmap_ptr nodeset = topo.cpuset_to_nodeset(
+                policy_ == numa_allocation_policy::bind ?
+                    topo.init_numa_node_affinity_mask_from_numa_node(domain_) :
+                    topo.get_machine_affinity_mask());
+
+            void* p =
+                topo.allocate_membind(len, nodeset, get_membind_policy(), 0);
+            if (p == nullptr)
+            {
+                p = topo.allocate(len);
+                if (p == nullptr)
+                {
+                    throw std::bad_alloc();
+                }
+            }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            if (p != nullptr)
+            {
+                create_topology().deallocate(p, n * sizeof(T));
+            }
+        }
+
+        template <typename U>
+        friend bool operator==(
+            numa_allocator const& lhs, numa_allocator<U> const& rhs) noexcept
+        {
+            return lhs.policy_ == rhs.policy() && lhs.domain_ == rhs.domain();
+        }
+
+        template <typename U>
+        friend bool operator!=(
+            numa_allocator const& lhs, numa_allocator<U> const& rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        pika_hwloc_membind_policy get_membind_policy() const noexcept
+        {
+            switch (policy_)
+            {
+            case numa_allocation_policy::bind:
+                return membind_bind;
+            case numa_allocation_policy::interleave:
+                return membind_interleave;
+            case numa_allocation_policy::first_touch:
+            default:
+                return membind_firsttouch;
+            }
+        }
+
+        numa_allocation_policy policy_;
+        std::size_t domain_;
+    };
+}    // namespace pika::threads::detail
@@ -287,6 +287,12 @@ namespace pika::threads::detail {
 
         int get_numa_domain(const void* addr) const;
 
+        /// Return the NUMA domain on which most of the pages of the given
+        /// range are located, or -1 if it can't be determined, e.g. when none
+        /// of the pages have been touched yet. Only a few pages of large
+        /// ranges are inspected. This does not throw.
+        int get_numa_domain(const void* addr, std::size_t len) const;
+
         /// Free memory that was previously allocated by allocate
         void deallocate(void* addr, std::size_t len) const;
 
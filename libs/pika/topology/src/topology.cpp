@@ -17,7 +17,15 @@
 #include <pika/type_support/unused.hpp>
 #include <pika/util/ios_flags_saver.hpp>
 
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -199,40 +207,195 @@ namespace pika::threads::detail {
     mask_type topology::empty_mask = mask_type();
 #endif
 
-    topology::topology()
-      : topo(nullptr)
-      , use_pus_as_cores_(false)
-      , machine_affinity_mask_(0)
-    {    // {{{
-        int err = hwloc_topology_init(&topo);
-        if (err != 0)
-        {
-            PIKA_THROW_EXCEPTION(pika::error::no_success, "topology::topology",
-                "Failed to init hwloc topology");
-        }
+    namespace {
+        // Create an empty topology with the type filters used by pika. pika
+        // never looks at I/O objects or instruction caches, discovering them
+        // is expensive on machines with many PCI devices.
+        hwloc_topology_t init_hwloc_topology()
+        {
+            hwloc_topology_t topo = nullptr;
+            int err = hwloc_topology_init(&topo);
+            if (err != 0)
+            {
+                PIKA_THROW_EXCEPTION(pika::error::no_success,
+                    "topology::topology", "Failed to init hwloc topology");
+            }
 
 #if HWLOC_API_VERSION >= 0x00020000
+            hwloc_topology_set_io_types_filter(
+                topo, HWLOC_TYPE_FILTER_KEEP_NONE);
+            hwloc_topology_set_icache_types_filter(
+                topo, HWLOC_TYPE_FILTER_KEEP_NONE);
+
 #if defined(PIKA_HAVE_ADDITIONAL_HWLOC_TESTING)
-        // Enable HWLOC filtering that makes it report no cores. This is purely
-        // an option allowing to test whether things work properly on systems
-        // that may not report cores in the topology at all (e.g. FreeBSD).
-        err = hwloc_topology_set_type_filter(
-            topo, HWLOC_OBJ_CORE, HWLOC_TYPE_FILTER_KEEP_NONE);
-        if (err != 0)
+            // Enable HWLOC filtering that makes it report no cores. This is
+            // purely an option allowing to test whether things work properly
+            // on systems that may not report cores in the topology at all
+            // (e.g. FreeBSD).
+            err = hwloc_topology_set_type_filter(
+                topo, HWLOC_OBJ_CORE, HWLOC_TYPE_FILTER_KEEP_NONE);
+            if (err != 0)
+            {
+                hwloc_topology_destroy(topo);
+                PIKA_THROW_EXCEPTION(pika::error::no_success,
+                    "topology::topology",
+                    "Failed to set core filter for hwloc topology");
+            }
+#endif
+#endif
+
+            return topo;
+        }
+
+#if HWLOC_API_VERSION >= 0x00020100
+        // The name of the info attribute of the root object identifying the
+        // machine a cached topology was generated on.
+        constexpr char const* topology_cache_key_name = "PikaTopologyCacheKey";
+
+        // The cache is invalidated by a reboot (hardware changes require
+        // one), by a different set of online processing units, and by a
+        // different version of hwloc.
+        std::string get_topology_cache_key()
+        {
+            std::string key = fmt::format("hwloc:{:x};pus:{}",
+                HWLOC_API_VERSION, std::thread::hardware_concurrency());
+
+#if defined(PIKA_HAVE_UNISTD_H)
+            char hostname[256] = {};
+            if (gethostname(hostname, sizeof(hostname) - 1) == 0)
+            {
+                key += fmt::format(";host:{}", hostname);
+            }
+#endif
+#if defined(__linux__)
+            std::ifstream boot_id_file("/proc/sys/kernel/random/boot_id");
+            std::string boot_id;
+            if (std::getline(boot_id_file, boot_id))
+            {
+                key += fmt::format(";boot:{}", boot_id);
+            }
+#endif
+            return key;
+        }
+
+        // Load the topology from the cache file. The set of allowed
+        // processing units and NUMA nodes is always taken from the current
+        // process, not from the cache. Returns nullptr if the file does not
+        // exist, can't be parsed, or was generated on a different machine.
+        hwloc_topology_t load_cached_hwloc_topology(
+            char const* filename, std::string const& key)
         {
-            PIKA_THROW_EXCEPTION(pika::error::no_success, "topology::topology",
-                "Failed to set core filter for hwloc topology");
+            if (!std::ifstream(filename))
+            {
+                return nullptr;
+            }
+
+            hwloc_topology_t topo = init_hwloc_topology();
+            if (hwloc_topology_set_xml(topo, filename) != 0 ||
+                hwloc_topology_set_flags(topo,
+                    HWLOC_TOPOLOGY_FLAG_IS_THISSYSTEM |
+                        HWLOC_TOPOLOGY_FLAG_THISSYSTEM_ALLOWED_RESOURCES) !=
+                    0 ||
+                hwloc_topology_load(topo) != 0)
+            {
+                hwloc_topology_destroy(topo);
+                return nullptr;
+            }
+
+            char const* cached_key = hwloc_obj_get_info_by_name(
+                hwloc_get_root_obj(topo), topology_cache_key_name);
+            if (cached_key == nullptr || key != cached_key)
+            {
+                hwloc_topology_destroy(topo);
+                return nullptr;
+            }
+
+            return topo;
         }
+
+        // Discover the full topology of the machine, including resources not
+        // available to this process, and write it to the cache file. The
+        // file is replaced atomically so that concurrently starting
+        // processes never see a partially written cache. Errors are ignored,
+        // the cache is only an optimization.
+        void write_cached_hwloc_topology(
+            char const* filename, std::string const& key)
+        {
+            hwloc_topology_t topo = init_hwloc_topology();
+            if (hwloc_topology_set_flags(
+                    topo, HWLOC_TOPOLOGY_FLAG_INCLUDE_DISALLOWED) != 0 ||
+                hwloc_topology_load(topo) != 0)
+            {
+                hwloc_topology_destroy(topo);
+                return;
+            }
+
+            hwloc_obj_add_info(
+                hwloc_get_root_obj(topo), topology_cache_key_name, key.c_str());
+
+            std::string tmp_filename = fmt::format("{}.{}.tmp", filename,
+#if defined(PIKA_HAVE_UNISTD_H)
+                getpid());
+#else
+                std::hash<std::thread::id>()(std::this_thread::get_id()));
 #endif
+            if (hwloc_topology_export_xml(topo, tmp_filename.c_str(), 0) == 0)
+            {
+                if (std::rename(tmp_filename.c_str(), filename) != 0)
+                {
+                    std::remove(tmp_filename.c_str());
+                }
+            }
+
+            hwloc_topology_destroy(topo);
+        }
 #endif
 
-        err = hwloc_topology_load(topo);
-        if (err != 0)
+        hwloc_topology_t load_hwloc_topology()
         {
-            PIKA_THROW_EXCEPTION(pika::error::no_success, "topology::topology",
-                "Failed to load hwloc topology");
+#if HWLOC_API_VERSION >= 0x00020100
+            // PIKA_TOPOLOGY_CACHE names an XML file caching the topology of
+            // the machine. This is read from the environment as the topology
+            // is created before the runtime configuration is available.
+            char const* cache_filename = std::getenv("PIKA_TOPOLOGY_CACHE");
+            if (cache_filename != nullptr && *cache_filename != '\0')
+            {
+                std::string const key = get_topology_cache_key();
+                if (hwloc_topology_t topo =
+                        load_cached_hwloc_topology(cache_filename, key))
+                {
+                    return topo;
+                }
+
+                // Regenerate the cache and load the topology from it, this
+                // makes sure that the topology is the same no matter if it
+                // was loaded from the cache or not.
+                write_cached_hwloc_topology(cache_filename, key);
+                if (hwloc_topology_t topo =
+                        load_cached_hwloc_topology(cache_filename, key))
+                {
+                    return topo;
+                }
+            }
+#endif
+
+            hwloc_topology_t topo = init_hwloc_topology();
+            int err = hwloc_topology_load(topo);
+            if (err != 0)
+            {
+                hwloc_topology_destroy(topo);
+                PIKA_THROW_EXCEPTION(pika::error::no_success,
+                    "topology::topology", "Failed to load hwloc topology");
+            }
+            return topo;
         }
+    }    // namespace
 
+    topology::topology()
+      : topo(load_hwloc_topology())
+      , use_pus_as_cores_(false)
+      , machine_affinity_mask_(0)
+    {    // {{{
         init_num_of_pus();
 
         socket_numbers_.reserve(num_of_pus_);
@@ -1458,6 +1621,81 @@ namespace pika::threads::detail {
 #endif
     }
 
+    int topology::get_numa_domain(const void* addr, std::size_t len) const
+    {
+#if HWLOC_API_VERSION >= 0x00010b06
+        pika_hwloc_bitmap_wrapper& nodeset = bitmap_storage();
+        if (!nodeset)
+        {
+            nodeset.reset(hwloc_bitmap_alloc());
+        }
+
+        hwloc_nodeset_t ns =
+            reinterpret_cast<hwloc_nodeset_t>(nodeset.get_bmp());
+
+        // Sample pages spread evenly over the range and return the domain
+        // holding most of the sampled pages. Pages which have not been touched
+        // yet are not located on any domain and are ignored.
+        constexpr std::size_t max_samples = 8;
+        std::size_t const num_pages =
+            (std::max)(len / memory_page_size_, std::size_t(1));
+        std::size_t const num_samples = (std::min)(num_pages, max_samples);
+
+        std::array<std::size_t, max_samples> domains;
+        std::array<std::size_t, max_samples> counts;
+        std::size_t num_domains = 0;
+
+        for (std::size_t i = 0; i != num_samples; ++i)
+        {
+            char const* sample = static_cast<char const*>(addr) +
+                (i * num_pages / num_samples) * memory_page_size_;
+            if (hwloc_get_area_memlocation(
+                    topo, sample, 1, ns, HWLOC_MEMBIND_BYNODESET) < 0)
+            {
+                return -1;
+            }
+
+            std::size_t const domain = threads::detail::find_first(
+                bitmap_to_mask(ns, HWLOC_OBJ_NUMANODE));
+            if (domain == ~std::size_t(0))
+            {
+                continue;
+            }
+
+            std::size_t j = 0;
+            while (j != num_domains && domains[j] != domain)
+            {
+                ++j;
+            }
+            if (j == num_domains)
+            {
+                domains[num_domains] = domain;
+                counts[num_domains++] = 0;
+            }
+            ++counts[j];
+        }
+
+        if (num_domains == 0)
+        {
+            return -1;
+        }
+
+        std::size_t most = 0;
+        for (std::size_t j = 1; j != num_domains; ++j)
+        {
+            if (counts[j] > counts[most])
+            {
+                most = j;
+            }
+        }
+        return static_cast<int>(domains[most]);
+#else
+        PIKA_UNUSED(addr);
+        PIKA_UNUSED(len);
+        return -1;
+#endif
+    }
+
     /// Free memory that was previously allocated by allocate
     void topology::deallocate(void* addr, std::size_t len) const
     {
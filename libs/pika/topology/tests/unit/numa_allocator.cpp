@@ -0,0 +1,92 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that memory allocated with numa_allocator is usable with
+// all placement policies, and that the NUMA domain of touched memory can be
+// looked up.
+
+#include <pika/testing.hpp>
+#include <pika/topology/numa_allocator.hpp>
+#include <pika/topology/topology.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using pika::threads::detail::create_topology;
+using pika::threads::detail::numa_allocation_policy;
+using pika::threads::detail::numa_allocator;
+
+void test_policy(numa_allocation_policy policy, std::size_t domain = 0)
+{
+    constexpr std::size_t n = 1 << 20;
+
+    numa_allocator<double> alloc(policy, domain);
+    PIKA_TEST(alloc.policy() == policy);
+
+    std::vector<double, numa_allocator<double>> v(n, 1.0, alloc);
+    PIKA_TEST(v.get_allocator() == alloc);
+
+    // memory is page aligned
+    auto const page_size = pika::threads::detail::get_memory_page_size();
+    PIKA_TEST_EQ(reinterpret_cast<std::uintptr_t>(v.data()) % page_size,
+        std::uintptr_t(0));
+
+    double sum = 0;
+    for (double x : v)
+    {
+        sum += x;
+    }
+    PIKA_TEST_EQ(sum, static_cast<double>(n));
+
+    // the pages have been touched, so they are located on some domain if the
+    // platform supports querying the location of memory
+    int const found_domain =
+        create_topology().get_numa_domain(v.data(), n * sizeof(double));
+    PIKA_TEST_LT(found_domain,
+        static_cast<int>(create_topology().get_number_of_numa_nodes()));
+    if (policy == numa_allocation_policy::bind && found_domain != -1)
+    {
+        PIKA_TEST_EQ(found_domain, static_cast<int>(domain));
+    }
+}
+
+void test_allocator()
+{
+    numa_allocator<int> alloc;
+    PIKA_TEST(alloc.policy() == numa_allocation_policy::first_touch);
+    PIKA_TEST(alloc.allocate(0) == nullptr);
+    alloc.deallocate(nullptr, 0);
+
+    // rebinding keeps the policy
+    numa_allocator<double> rebound(
+        numa_allocator<int>(numa_allocation_policy::bind, 0));
+    PIKA_TEST(rebound.policy() == numa_allocation_policy::bind);
+    PIKA_TEST_EQ(rebound.domain(), std::size_t(0));
+    PIKA_TEST(rebound != alloc);
+    PIKA_TEST(numa_allocator<double>(alloc) == alloc);
+
+    int* p = alloc.allocate(3);
+    p[0] = 1;
+    p[2] = 3;
+    PIKA_TEST_EQ(p[0] + p[2], 4);
+    alloc.deallocate(p, 3);
+}
+
+int main()
+{
+    test_allocator();
+
+    test_policy(numa_allocation_policy::first_touch);
+    test_policy(numa_allocation_policy::interleave);
+    for (std::size_t domain = 0;
+         domain != create_topology().get_number_of_numa_nodes(); ++domain)
+    {
+        test_policy(numa_allocation_policy::bind, domain);
+    }
+
+    return pika::util::report_errors();
+}
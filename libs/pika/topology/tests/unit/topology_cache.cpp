@@ -0,0 +1,110 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This test verifies that a topology loaded from the cache file given by
+// PIKA_TOPOLOGY_CACHE is the same as a topology discovered from the system,
+// and that invalid or stale cache files are regenerated.
+
+#include <pika/testing.hpp>
+#include <pika/topology/topology.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#if defined(PIKA_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+
+using pika::threads::detail::topology;
+
+std::string read_file(std::string const& filename)
+{
+    std::ifstream is(filename);
+    return std::string{
+        std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+}
+
+void check_equal(topology const& expected, topology const& actual)
+{
+    PIKA_TEST_EQ(expected.get_number_of_pus(), actual.get_number_of_pus());
+    PIKA_TEST_EQ(expected.get_number_of_cores(), actual.get_number_of_cores());
+    PIKA_TEST_EQ(
+        expected.get_number_of_sockets(), actual.get_number_of_sockets());
+    PIKA_TEST_EQ(expected.get_number_of_numa_nodes(),
+        actual.get_number_of_numa_nodes());
+    PIKA_TEST(expected.get_machine_affinity_mask() ==
+        actual.get_machine_affinity_mask());
+
+    for (std::size_t i = 0; i != expected.get_number_of_pus(); ++i)
+    {
+        PIKA_TEST_EQ(expected.get_core_number(i), actual.get_core_number(i));
+        PIKA_TEST_EQ(
+            expected.get_numa_node_number(i), actual.get_numa_node_number(i));
+        PIKA_TEST(expected.get_thread_affinity_mask(i) ==
+            actual.get_thread_affinity_mask(i));
+    }
+}
+
+int main()
+{
+#if HWLOC_API_VERSION >= 0x00020100 && defined(PIKA_HAVE_UNISTD_H)
+    std::string const cache_file =
+        "topology_cache_test." + std::to_string(getpid()) + ".xml";
+    std::remove(cache_file.c_str());
+
+    unsetenv("PIKA_TOPOLOGY_CACHE");
+    topology const uncached;
+
+    setenv("PIKA_TOPOLOGY_CACHE", cache_file.c_str(), 1);
+
+    // the first topology generates the cache file
+    {
+        topology const t;
+        check_equal(uncached, t);
+        PIKA_TEST_NEQ(read_file(cache_file).find("PikaTopologyCacheKey"),
+            std::string::npos);
+    }
+
+    // the second topology is loaded from the cache
+    {
+        topology const t;
+        check_equal(uncached, t);
+    }
+
+    // an invalid cache file is regenerated
+    {
+        std::ofstream(cache_file) << "not an hwloc topology";
+
+        topology const t;
+        check_equal(uncached, t);
+        PIKA_TEST_NEQ(read_file(cache_file).find("PikaTopologyCacheKey"),
+            std::string::npos);
+    }
+
+    // a cache file generated on a different machine is regenerated
+    {
+        std::string xml = read_file(cache_file);
+        std::string::size_type const pos = xml.find("hwloc:");
+        PIKA_TEST_NEQ(pos, std::string::npos);
+        xml.replace(pos, 6, "other:");
+        std::ofstream(cache_file) << xml;
+
+        topology const t;
+        check_equal(uncached, t);
+        xml = read_file(cache_file);
+        PIKA_TEST_EQ(xml.find("other:"), std::string::npos);
+        PIKA_TEST_NEQ(xml.find("hwloc:"), std::string::npos);
+    }
+
+    unsetenv("PIKA_TOPOLOGY_CACHE");
+    std::remove(cache_file.c_str());
+#endif
+
+    return pika::util::report_errors();
+}
@@ -0,0 +1,328 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// This benchmark measures the overheads of the sender adaptors and
+// thread_pool_scheduler in the paths most commonly used by applications. The
+// results are printed as JSON which can be compared against references by
+// tools/perftests_ci.
+
+#include <pika/config.hpp>
+#include <pika/execution.hpp>
+#include <pika/init.hpp>
+#include <pika/latch.hpp>
+#include <pika/synchronization/async_rw_mutex.hpp>
+#include <pika/testing/performance.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using pika::program_options::options_description;
+using pika::program_options::value;
+using pika::program_options::variables_map;
+
+namespace ex = pika::execution::experimental;
+namespace tt = pika::this_thread::experimental;
+
+static std::string const executor_name = "thread_pool_scheduler";
+
+///////////////////////////////////////////////////////////////////////////////
+// we use globals here to prevent the delay from being optimized away
+double global_scratch = 0;
+std::uint64_t num_iterations = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+double null_function() noexcept
+{
+    double dummy = 0.0;
+    for (std::uint64_t i = 0; i < num_iterations; ++i)
+    {
+        dummy += 1.0 / (2.0 * i + 1.0);
+    }
+    return dummy;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Scheduling and simple adaptors
+void measure_schedule(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    pika::util::perftests_report(
+        "sender overhead - schedule", executor_name, repetitions, [&]() {
+            using sender_type =
+                decltype(ex::schedule(sched) | ex::then(null_function));
+            std::vector<sender_type> senders;
+            senders.reserve(count);
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                senders.push_back(
+                    ex::schedule(sched) | ex::then(null_function));
+            }
+            tt::sync_wait(ex::when_all_vector(std::move(senders)));
+        });
+}
+
+void measure_then_chain(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    auto add = [](double x) { return x + null_function(); };
+    pika::util::perftests_report(
+        "sender overhead - then chain", executor_name, repetitions, [&]() {
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                global_scratch += tt::sync_wait(ex::schedule(sched) |
+                    ex::then(null_function) | ex::then(add) | ex::then(add) |
+                    ex::then(add) | ex::then(add) | ex::then(add) |
+                    ex::then(add) | ex::then(add));
+            }
+        });
+}
+
+void measure_transfer(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    auto add = [](double x) { return x + null_function(); };
+    pika::util::perftests_report(
+        "sender overhead - transfer", executor_name, repetitions, [&]() {
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                global_scratch += tt::sync_wait(ex::schedule(sched) |
+                    ex::then(null_function) | ex::transfer(sched) |
+                    ex::then(add));
+            }
+        });
+}
+
+void measure_bulk(int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    for (std::size_t n :
+        {std::size_t(1), std::size_t(100), std::size_t(10000),
+            std::size_t(1000000)})
+    {
+        std::vector<double> v(n);
+        auto f = [&v](std::size_t i) { v[i] = null_function(); };
+        pika::util::perftests_report(
+            "sender overhead - bulk - " + std::to_string(n), executor_name,
+            repetitions,
+            [&]() { tt::sync_wait(ex::schedule(sched) | ex::bulk(n, f)); });
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Fan-out and fan-in
+void measure_split(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    auto add = [](double x) { return x + null_function(); };
+    pika::util::perftests_report(
+        "sender overhead - split fan-out", executor_name, repetitions, [&]() {
+            auto s =
+                ex::schedule(sched) | ex::then(null_function) | ex::split();
+            std::vector<decltype(ex::transfer(s, sched) | ex::then(add))>
+                senders;
+            senders.reserve(count);
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                senders.push_back(ex::transfer(s, sched) | ex::then(add));
+            }
+            tt::sync_wait(ex::when_all_vector(std::move(senders)));
+        });
+}
+
+void measure_when_all_vector(std::uint64_t count, int repetitions)
+{
+    pika::util::perftests_report("sender overhead - when_all_vector",
+        "no-executor", repetitions, [&]() {
+            std::vector<decltype(ex::just(0.0))> senders;
+            senders.reserve(count);
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                senders.push_back(ex::just(null_function()));
+            }
+            global_scratch +=
+                tt::sync_wait(ex::when_all_vector(std::move(senders))).size();
+        });
+}
+
+void measure_ensure_started(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    pika::util::perftests_report("sender overhead - ensure_started",
+        executor_name, repetitions, [&]() {
+            using sender_type = decltype(ex::ensure_started(
+                ex::schedule(sched) | ex::then(null_function)));
+            std::vector<sender_type> senders;
+            senders.reserve(count);
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                senders.push_back(ex::ensure_started(
+                    ex::schedule(sched) | ex::then(null_function)));
+            }
+            tt::sync_wait(ex::when_all_vector(std::move(senders)));
+        });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Waiting from threads not managed by the runtime
+void measure_sync_wait_os_threads(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    std::size_t const num_os_threads = pika::get_num_worker_threads();
+    pika::util::perftests_report("sender overhead - sync_wait from OS threads",
+        executor_name, repetitions, [&]() {
+            // The latch is used to wait for the OS threads without blocking
+            // the worker thread which is needed to run the scheduled work
+            pika::latch l(num_os_threads + 1);
+            std::vector<std::thread> threads;
+            threads.reserve(num_os_threads);
+            for (std::size_t t = 0; t < num_os_threads; ++t)
+            {
+                threads.emplace_back([&, t]() {
+                    std::uint64_t const count_start =
+                        t * count / num_os_threads;
+                    std::uint64_t const count_end =
+                        (t + 1) * count / num_os_threads;
+                    for (std::uint64_t i = count_start; i < count_end; ++i)
+                    {
+                        tt::sync_wait(
+                            ex::schedule(sched) | ex::then(null_function));
+                    }
+                    l.count_down(1);
+                });
+            }
+            l.arrive_and_wait();
+            for (auto& t : threads)
+            {
+                t.join();
+            }
+        });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Synchronization and type erasure
+void measure_async_rw_mutex(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    // Each read writes to its own element, the reads of one iteration run
+    // concurrently
+    std::vector<double> results(2 * count);
+    pika::util::perftests_report("sender overhead - async_rw_mutex chain",
+        executor_name, repetitions, [&]() {
+            ex::async_rw_mutex<double> m{0.0};
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                // every readwrite access is followed by two concurrent reads
+                ex::start_detached(m.readwrite() | ex::transfer(sched) |
+                    ex::then([](auto w) { w.get() += null_function(); }));
+                for (std::uint64_t j = 0; j < 2; ++j)
+                {
+                    ex::start_detached(m.read() | ex::transfer(sched) |
+                        ex::then([&r = results[2 * i + j]](auto w) {
+                            r = w.get() * null_function();
+                        }));
+                }
+            }
+
+            // The final readwrite access waits for all the reads to finish
+            global_scratch += tt::sync_wait(m.readwrite()).get();
+            for (double r : results)
+            {
+                global_scratch += r;
+            }
+        });
+}
+
+void measure_any_sender(std::uint64_t count, int repetitions)
+{
+    ex::thread_pool_scheduler sched{};
+    pika::util::perftests_report("sender overhead - unique_any_sender",
+        executor_name, repetitions, [&]() {
+            std::vector<ex::unique_any_sender<double>> senders;
+            senders.reserve(count);
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                senders.emplace_back(
+                    ex::schedule(sched) | ex::then(null_function));
+            }
+            tt::sync_wait(ex::when_all_vector(std::move(senders)));
+        });
+
+    pika::util::perftests_report("sender overhead - any_sender",
+        executor_name, repetitions, [&]() {
+            std::vector<ex::any_sender<double>> senders;
+            senders.reserve(count);
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                ex::any_sender<double> s =
+                    ex::schedule(sched) | ex::then(null_function);
+                senders.push_back(s);
+            }
+            tt::sync_wait(ex::when_all_vector(std::move(senders)));
+        });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int pika_main(variables_map& vm)
+{
+    {
+        bool test_all = (vm.count("test-all") > 0);
+        int const repetitions = vm["repetitions"].as<int>();
+
+        num_iterations = vm["delay-iterations"].as<std::uint64_t>();
+
+        std::uint64_t const count = vm["tasks"].as<std::uint64_t>();
+        if (PIKA_UNLIKELY(0 == count))
+            throw std::logic_error("error: count of 0 tasks specified\n");
+
+        if (test_all)
+        {
+            measure_schedule(count, repetitions);
+            measure_then_chain(count, repetitions);
+            measure_transfer(count, repetitions);
+            measure_bulk(repetitions);
+            measure_split(count, repetitions);
+            measure_when_all_vector(count, repetitions);
+            measure_ensure_started(count, repetitions);
+            measure_sync_wait_os_threads(count, repetitions);
+            measure_async_rw_mutex(count, repetitions);
+            measure_any_sender(count, repetitions);
+            pika::util::perftests_print_times();
+        }
+    }
+
+    return pika::finalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    // Configure application-specific options.
+    options_description cmdline("usage: " PIKA_APPLICATION_STRING " [options]");
+
+    // clang-format off
+    cmdline.add_options()("tasks",
+        value<std::uint64_t>()->default_value(10000),
+        "number of tasks to spawn in each benchmark")
+
+        ("delay-iterations", value<std::uint64_t>()->default_value(0),
+         "number of iterations in the delay loop")
+
+        ("test-all", "run all benchmarks")
+        ("repetitions", value<int>()->default_value(1),
+         "number of repetitions of each benchmark");
+    // clang-format on
+
+    // Initialize and run pika.
+    pika::init_params init_args;
+    init_args.desc_cmdline = cmdline;
+
+    return pika::init(pika_main, argc, argv, init_args);
+}
@@ -13,6 +13,7 @@
 #include <pika/program_options.hpp>
 #include <pika/testing/performance.hpp>
 #include <pika/thread.hpp>
+#include <pika/topology/topology.hpp>
 
 #include <cstddef>
 #include <cstdint>
@@ -40,9 +41,21 @@ int main(int argc, char** argv)
 
     std::uint64_t repetitions = vm["repetitions"].as<std::uint64_t>();
 
+    // The topology is discovered only once per process, outside of the
+    // timed loop below. Time a separate discovery to show the effect of
+    // caching the topology with PIKA_TOPOLOGY_CACHE.
+    {
+        pika::chrono::detail::high_resolution_timer timer;
+        pika::threads::detail::topology topo;
+        std::cout << "topology [s]: " << timer.elapsed() << std::endl;
+    }
+
     pika::init_params init_args;
     init_args.desc_cmdline = desc_commandline;
 
+    // With --pika:warm-restart the runtime is parked by pika::stop and
+    // resumed by the following pika::start, as all starts below use the same
+    // arguments.
     pika::start(pika_main, argc, argv, init_args);
     std::uint64_t threads = pika::resource::get_num_threads("default");
     pika::stop();
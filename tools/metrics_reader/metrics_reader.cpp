@@ -0,0 +1,330 @@
+//  Copyright (c) 2023 ETH Zurich
+//
+//  SPDX-License-Identifier: BSL-1.0
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Reads the shared memory segment published by a pika application started
+// with --pika:metrics-export and prints its contents, either in a human
+// readable form or in the OpenMetrics text format.
+//
+//     pika_metrics_reader [--openmetrics] [--watch=<ms>] <shm-name>
+
+#include <pika/runtime/metrics_snapshot.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    char const* state_name(std::uint32_t state)
+    {
+        // mirrors pika::runtime_state
+        static char const* const names[] = {"invalid", "initialized",
+            "pre_startup", "startup", "pre_main", "starting", "running",
+            "suspended", "pre_sleep", "sleeping", "pre_shutdown", "shutdown",
+            "stopping", "terminating", "stopped"};
+        // runtime_state::invalid is -1
+        std::size_t const index = static_cast<std::size_t>(state + 1);
+        return index < sizeof(names) / sizeof(names[0]) ? names[index] :
+                                                          "unknown";
+    }
+
+    void print_text(pika::metrics::snapshot_header const& h)
+    {
+        using namespace pika::metrics;
+
+        std::cout << "pid: " << h.pid_ << ", sequence: " << h.sequence_.load()
+                  << ", interval: " << h.interval_ms_ << "ms\n";
+
+        snapshot_pool const* pools = get_pools(h);
+        snapshot_worker const* workers = get_workers(h);
+        for (std::uint32_t i = 0; i != h.num_pools_; ++i)
+        {
+            snapshot_pool const& p = pools[i];
+            std::cout << "pool " << p.index_ << " (" << p.name_
+                      << "): threads " << p.num_active_threads_ << "/"
+                      << p.num_threads_ << ", queue " << p.queue_length_
+                      << ", active " << p.thread_count_active_ << ", pending "
+                      << p.thread_count_pending_ << ", suspended "
+                      << p.thread_count_suspended_ << ", staged "
+                      << p.thread_count_staged_ << ", idle cores "
+                      << p.idle_core_count_ << ", utilization "
+                      << p.scheduler_utilization_ << "%\n";
+
+            for (std::uint32_t j = 0; j != p.num_threads_; ++j)
+            {
+                snapshot_worker const& w = workers[p.first_worker_ + j];
+                std::cout << "  worker " << w.local_thread_num_ << " ("
+                          << state_name(w.state_) << "): queue "
+                          << w.queue_length_ << ", pending "
+                          << w.thread_count_pending_ << ", idle loops "
+                          << w.idle_loop_count_ << ", busy loops "
+                          << w.busy_loop_count_;
+                if (h.available_ & counters_cumulative)
+                {
+                    std::cout << ", executed " << w.executed_threads_;
+                }
+                if (h.available_ & counters_idle_rates)
+                {
+                    std::cout << ", idle rate " << w.idle_rate_ / 100.0 << "%";
+                }
+                if (h.available_ & counters_stealing)
+                {
+                    std::cout << ", stolen from/to pending "
+                              << w.stolen_from_pending_ << "/"
+                              << w.stolen_to_pending_;
+                }
+                if (h.available_ & counters_queue_waittime)
+                {
+                    std::cout << ", avg wait " << w.average_thread_wait_time_;
+                }
+                std::cout << "\n";
+            }
+        }
+    }
+
+    template <typename T, typename Value>
+    void print_metric(char const* name, char const* type, char const* help,
+        pika::metrics::snapshot_header const& h, Value value)
+    {
+        using namespace pika::metrics;
+
+        std::cout << "# TYPE pika_" << name << " " << type << "\n";
+        std::cout << "# HELP pika_" << name << " " << help << "\n";
+
+        // samples of counters carry a _total suffix in OpenMetrics
+        char const* suffix = std::strcmp(type, "counter") == 0 ? "_total" : "";
+
+        snapshot_pool const* pools = get_pools(h);
+        for (std::uint32_t i = 0; i != h.num_pools_; ++i)
+        {
+            snapshot_pool const& p = pools[i];
+            if constexpr (std::is_same_v<T, snapshot_pool>)
+            {
+                std::cout << "pika_" << name << suffix << "{pid=\"" << h.pid_
+                          << "\",pool=\"" << p.name_ << "\"} " << value(p)
+                          << "\n";
+            }
+            else
+            {
+                snapshot_worker const* workers = get_workers(h);
+                for (std::uint32_t j = 0; j != p.num_threads_; ++j)
+                {
+                    snapshot_worker const& w = workers[p.first_worker_ + j];
+                    std::cout << "pika_" << name << suffix << "{pid=\""
+                              << h.pid_ << "\",pool=\"" << p.name_
+                              << "\",worker=\"" << w.local_thread_num_
+                              << "\"} " << value(w) << "\n";
+                }
+            }
+        }
+    }
+
+#define PIKA_POOL_METRIC(name, type, help, member)                             \
+    print_metric<snapshot_pool>(                                               \
+        name, type, help, h, [](snapshot_pool const& p) { return p.member; })
+
+#define PIKA_WORKER_METRIC(name, type, help, member)                           \
+    print_metric<snapshot_worker>(name, type, help, h,                         \
+        [](snapshot_worker const& w) { return w.member; })
+
+    void print_openmetrics(pika::metrics::snapshot_header const& h)
+    {
+        using namespace pika::metrics;
+
+        PIKA_POOL_METRIC("pool_threads", "gauge",
+            "Number of worker threads in the pool.", num_threads_);
+        PIKA_POOL_METRIC("pool_active_threads", "gauge",
+            "Number of worker threads which are not suspended.",
+            num_active_threads_);
+        PIKA_POOL_METRIC("pool_idle_cores", "gauge",
+            "Number of idle worker threads.", idle_core_count_);
+        PIKA_POOL_METRIC("pool_utilization_percent", "gauge",
+            "Scheduler utilization of the pool.", scheduler_utilization_);
+        PIKA_POOL_METRIC("pool_terminated_threads", "gauge",
+            "Number of terminated but not yet recycled pika threads.",
+            thread_count_terminated_);
+        PIKA_POOL_METRIC("pool_background_threads", "gauge",
+            "Number of background pika threads.", background_thread_count_);
+
+        PIKA_WORKER_METRIC("worker_queue_length", "gauge",
+            "Number of pika threads in the queues of the worker.",
+            queue_length_);
+        PIKA_WORKER_METRIC("worker_pending_threads", "gauge",
+            "Number of pending pika threads.", thread_count_pending_);
+        PIKA_WORKER_METRIC("worker_active_threads", "gauge",
+            "Number of active pika threads.", thread_count_active_);
+        PIKA_WORKER_METRIC("worker_suspended_threads", "gauge",
+            "Number of suspended pika threads.", thread_count_suspended_);
+        PIKA_WORKER_METRIC("worker_staged_threads", "gauge",
+            "Number of staged tasks.", thread_count_staged_);
+        PIKA_WORKER_METRIC("worker_idle_loops", "counter",
+            "Number of scheduling loop iterations without work.",
+            idle_loop_count_);
+        PIKA_WORKER_METRIC("worker_busy_loops", "counter",
+            "Number of scheduling loop iterations with work.",
+            busy_loop_count_);
+
+        if (h.available_ & counters_cumulative)
+        {
+            PIKA_WORKER_METRIC("worker_executed_threads", "counter",
+                "Number of executed pika threads.", executed_threads_);
+            PIKA_WORKER_METRIC("worker_executed_thread_phases", "counter",
+                "Number of executed pika thread phases.",
+                executed_thread_phases_);
+        }
+        if (h.available_ & counters_idle_rates)
+        {
+            PIKA_WORKER_METRIC("worker_idle_rate", "gauge",
+                "Idle rate of the worker in 0.01 percent.", idle_rate_);
+        }
+        if (h.available_ & counters_stealing)
+        {
+            PIKA_WORKER_METRIC("worker_pending_misses", "counter",
+                "Number of unsuccessful accesses to the pending queue.",
+                pending_misses_);
+            PIKA_WORKER_METRIC("worker_pending_accesses", "counter",
+                "Number of accesses to the pending queue.", pending_accesses_);
+            PIKA_WORKER_METRIC("worker_stolen_from_pending", "counter",
+                "Number of pika threads stolen from the pending queue.",
+                stolen_from_pending_);
+            PIKA_WORKER_METRIC("worker_stolen_to_pending", "counter",
+                "Number of pika threads stolen to the pending queue.",
+                stolen_to_pending_);
+            PIKA_WORKER_METRIC("worker_stolen_from_staged", "counter",
+                "Number of tasks stolen from the staged queue.",
+                stolen_from_staged_);
+            PIKA_WORKER_METRIC("worker_stolen_to_staged", "counter",
+                "Number of tasks stolen to the staged queue.",
+                stolen_to_staged_);
+        }
+        if (h.available_ & counters_queue_waittime)
+        {
+            PIKA_WORKER_METRIC("worker_average_thread_wait_time", "gauge",
+                "Average time pika threads spent in the pending queue.",
+                average_thread_wait_time_);
+            PIKA_WORKER_METRIC("worker_average_task_wait_time", "gauge",
+                "Average time tasks spent in the staged queue.",
+                average_task_wait_time_);
+        }
+
+        std::cout << "# EOF\n";
+    }
+
+#undef PIKA_POOL_METRIC
+#undef PIKA_WORKER_METRIC
+
+    int usage(char const* argv0)
+    {
+        std::cerr << "usage: " << argv0
+                  << " [--openmetrics] [--watch=<ms>] <shm-name>\n";
+        return EXIT_FAILURE;
+    }
+}    // namespace
+
+int main(int argc, char* argv[])
+{
+    bool openmetrics = false;
+    long watch_ms = 0;
+    std::string shm_name;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--openmetrics")
+        {
+            openmetrics = true;
+        }
+        else if (arg.rfind("--watch=", 0) == 0)
+        {
+            watch_ms = std::strtol(arg.c_str() + 8, nullptr, 10);
+        }
+        else if (arg.empty() || arg[0] == '-' || !shm_name.empty())
+        {
+            return usage(argv[0]);
+        }
+        else
+        {
+            shm_name = arg;
+        }
+    }
+
+    if (shm_name.empty())
+        return usage(argv[0]);
+    if (shm_name[0] != '/')
+        shm_name.insert(0, 1, '/');
+
+    int fd = ::shm_open(shm_name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+    {
+        std::cerr << "could not open shared memory segment " << shm_name
+                  << ": " << std::strerror(errno) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+        std::cerr << "could not stat shared memory segment " << shm_name
+                  << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return EXIT_FAILURE;
+    }
+
+    std::size_t const size = static_cast<std::size_t>(st.st_size);
+    void* segment = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (segment == MAP_FAILED)
+    {
+        std::cerr << "could not map shared memory segment " << shm_name
+                  << ": " << std::strerror(errno) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // the buffer holds a copy of the segment, use uint64_t for alignment
+    std::vector<std::uint64_t> buffer(
+        (size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+
+    int result = EXIT_SUCCESS;
+    do
+    {
+        if (!pika::metrics::read_snapshot(segment, size, buffer.data()))
+        {
+            std::cerr << "could not read a consistent snapshot from "
+                      << shm_name << " (incompatible version?)\n";
+            result = EXIT_FAILURE;
+            break;
+        }
+
+        auto const& header =
+            *reinterpret_cast<pika::metrics::snapshot_header const*>(
+                buffer.data());
+        if (openmetrics)
+            print_openmetrics(header);
+        else
+            print_text(header);
+        std::cout << std::flush;
+
+        if (watch_ms > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(watch_ms));
+        }
+    } while (watch_ms > 0);
+
+    ::munmap(segment, size);
+    return result;
+}